@@ -17,7 +17,7 @@
 
 VERSION = 1.2.1
 
-QT += concurrent core gui widgets
+QT += concurrent core gui sql widgets
 
 DEFINES += APP_VERSION=\\\"$$VERSION\\\"
 
@@ -26,23 +26,42 @@ INCLUDEPATH += $${PWD}/vendor
 
 HEADERS = \
 	$${PWD}/src/main_window.h \
+	$${PWD}/src/helpers/file_helper.h \
 	$${PWD}/src/helpers/number_helper.h \
+	$${PWD}/src/helpers/path_helper.h \
 	$${PWD}/src/lib/work_items/bulk_work_item.h \
 	$${PWD}/src/lib/work_items/bulk_get_work_item.h \
 	$${PWD}/src/lib/work_items/bulk_put_work_item.h \
+	$${PWD}/src/lib/work_items/chunk_work_item.h \
 	$${PWD}/src/lib/work_items/object_work_item.h \
+	$${PWD}/src/lib/work_items/page_work_item.h \
 	$${PWD}/src/lib/work_items/work_item.h \
+	$${PWD}/src/lib/checksum.h \
 	$${PWD}/src/lib/client.h \
+	$${PWD}/src/lib/concurrency_controller.h \
+	$${PWD}/src/lib/directory_scanner.h \
+	$${PWD}/src/lib/ds3_client_pool.h \
+	$${PWD}/src/lib/executor.h \
+	$${PWD}/src/lib/job_journal.h \
+	$${PWD}/src/lib/job_progress_publisher.h \
+	$${PWD}/src/lib/listing_cache.h \
 	$${PWD}/src/lib/logger.h \
 	$${PWD}/src/lib/mime_data.h \
+	$${PWD}/src/lib/object_compressor.h \
+	$${PWD}/src/lib/object_decompressor.h \
+	$${PWD}/src/lib/small_file_archive.h \
+	$${PWD}/src/lib/sync_manifest.h \
 	$${PWD}/src/lib/errors/ds3_error.h \
 	$${PWD}/src/lib/watchers/get_bucket_watcher.h \
+	$${PWD}/src/lib/watchers/get_listing_page_watcher.h \
 	$${PWD}/src/lib/watchers/get_service_watcher.h \
 	$${PWD}/src/lib/watchers/get_objects_watcher.h \
+	$${PWD}/src/models/ds3_browser_item.h \
 	$${PWD}/src/models/ds3_browser_model.h \
 	$${PWD}/src/models/ds3_url.h \
 	$${PWD}/src/models/host_browser_model.h \
 	$${PWD}/src/models/job.h \
+	$${PWD}/src/models/listing_page.h \
 	$${PWD}/src/models/session.h \
 	$${PWD}/src/views/browser.h \
 	$${PWD}/src/views/browser_tree_view_style.h \
@@ -61,22 +80,41 @@ HEADERS = \
 
 SOURCES = \
 	$${PWD}/src/main_window.cc \
+	$${PWD}/src/helpers/file_helper.cc \
 	$${PWD}/src/helpers/number_helper.cc \
+	$${PWD}/src/helpers/path_helper.cc \
+	$${PWD}/src/lib/checksum.cc \
 	$${PWD}/src/lib/client.cc \
+	$${PWD}/src/lib/concurrency_controller.cc \
+	$${PWD}/src/lib/directory_scanner.cc \
+	$${PWD}/src/lib/ds3_client_pool.cc \
+	$${PWD}/src/lib/executor.cc \
+	$${PWD}/src/lib/job_journal.cc \
+	$${PWD}/src/lib/job_progress_publisher.cc \
+	$${PWD}/src/lib/listing_cache.cc \
 	$${PWD}/src/lib/mime_data.cc \
+	$${PWD}/src/lib/object_compressor.cc \
+	$${PWD}/src/lib/object_decompressor.cc \
+	$${PWD}/src/lib/small_file_archive.cc \
+	$${PWD}/src/lib/sync_manifest.cc \
 	$${PWD}/src/lib/errors/ds3_error.cc \
 	$${PWD}/src/lib/watchers/get_bucket_watcher.cc \
+	$${PWD}/src/lib/watchers/get_listing_page_watcher.cc \
 	$${PWD}/src/lib/watchers/get_service_watcher.cc \
 	$${PWD}/src/lib/watchers/get_objects_watcher.cc \
 	$${PWD}/src/lib/work_items/bulk_work_item.cc \
 	$${PWD}/src/lib/work_items/bulk_get_work_item.cc \
 	$${PWD}/src/lib/work_items/bulk_put_work_item.cc \
+	$${PWD}/src/lib/work_items/chunk_work_item.cc \
 	$${PWD}/src/lib/work_items/object_work_item.cc \
+	$${PWD}/src/lib/work_items/page_work_item.cc \
 	$${PWD}/src/lib/work_items/work_item.cc \
+	$${PWD}/src/models/ds3_browser_item.cc \
 	$${PWD}/src/models/ds3_browser_model.cc \
 	$${PWD}/src/models/ds3_url.cc \
 	$${PWD}/src/models/host_browser_model.cc \
 	$${PWD}/src/models/job.cc \
+	$${PWD}/src/models/listing_page.cc \
 	$${PWD}/src/models/session.cc \
 	$${PWD}/src/views/browser.cc \
 	$${PWD}/src/views/browser_tree_view_style.cc \
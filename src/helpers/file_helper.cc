@@ -0,0 +1,77 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <QDir>
+#else
+#include <fcntl.h>
+#endif
+
+#include "helpers/file_helper.h"
+#include "lib/logger.h"
+
+qint64
+FileHelper::GetSize(const QFileInfo& fileInfo)
+{
+	qint64 size = 0;
+#ifdef Q_OS_WIN
+	// There's a bug with QFileInfo::size() where it will report the size
+	// of a shortcut's target instead of the actual shortcut.
+	// See https://bugreports.qt.io/browse/QTBUG-24831
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	QString nativePath = QDir::toNativeSeparators(fileInfo.filePath());
+	bool ok = GetFileAttributesEx((wchar_t*)nativePath.utf16(),
+				      GetFileExInfoStandard, &data);
+	if (ok) {
+		size = data.nFileSizeHigh;
+		size <<= 32;
+		size += data.nFileSizeLow;
+	} else {
+		LOG_ERROR("ERROR:       GET FILE SIZE failed for "+nativePath);
+	}
+#else
+	size = fileInfo.size();
+#endif
+	return size;
+}
+
+bool
+FileHelper::Preallocate(QFile* file, qint64 size)
+{
+	qint64 currentSize = file->size();
+	if (size > currentSize) {
+#if defined(Q_OS_LINUX)
+		// Fails on file systems that don't support it, in which case
+		// resize still sets the size
+		posix_fallocate(file->handle(), currentSize, size - currentSize);
+#elif defined(Q_OS_MAC)
+		fstore_t store;
+		store.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+		store.fst_posmode = F_PEOFPOSMODE;
+		store.fst_offset = 0;
+		store.fst_length = size - currentSize;
+		store.fst_bytesalloc = 0;
+		if (fcntl(file->handle(), F_PREALLOCATE, &store) == -1) {
+			store.fst_flags = F_ALLOCATEALL;
+			fcntl(file->handle(), F_PREALLOCATE, &store);
+		}
+#endif
+		// Windows allocates the blocks when the end of the file is
+		// moved
+	}
+	return (file->size() == size || file->resize(size));
+}
@@ -0,0 +1,35 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef FILE_HELPER_H
+#define FILE_HELPER_H
+
+#include <QFile>
+#include <QFileInfo>
+
+class FileHelper
+{
+public:
+	// The size of a file as it should be transferred.  fileInfo's
+	// cached stat data is used wherever possible.
+	static qint64 GetSize(const QFileInfo& fileInfo);
+	// Resize an open file to size, reserving its blocks on disk up front
+	// where the file system allows it, so a file that's written out of
+	// order isn't fragmented.  Returns false if it couldn't be resized.
+	static bool Preallocate(QFile* file, qint64 size);
+};
+
+#endif
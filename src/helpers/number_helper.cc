@@ -51,3 +51,23 @@ NumberHelper::ToHumanSize(uint64_t bytes)
 
 	return (QString::number(num, 'f', precision) + " " + units);
 }
+
+QString
+NumberHelper::ToHumanDuration(qint64 seconds)
+{
+	if (seconds < 0) {
+		seconds = 0;
+	}
+	qint64 hours = seconds / 3600;
+	qint64 minutes = (seconds % 3600) / 60;
+	seconds %= 60;
+
+	if (hours > 0) {
+		return (QString::number(hours) + "h " +
+			QString::number(minutes) + "m");
+	} else if (minutes > 0) {
+		return (QString::number(minutes) + "m " +
+			QString::number(seconds) + "s");
+	}
+	return (QString::number(seconds) + "s");
+}
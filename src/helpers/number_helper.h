@@ -31,6 +31,8 @@ public:
 
 	static QString ToHumanSize(uint64_t bytes);
 	static QString ToHumanRate(uint64_t bytes);
+	// The two most significant units of a duration, e.g. "1h 5m"
+	static QString ToHumanDuration(qint64 seconds);
 };
 
 inline QString
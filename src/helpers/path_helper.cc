@@ -0,0 +1,70 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "helpers/path_helper.h"
+
+// Find the bucket name part of path.  Returns false if path doesn't have
+// one, in which case PATH_REGEX wouldn't have matched either.
+static bool
+find_bucket_name(const QString& path, int* start, int* end)
+{
+	*start = path.startsWith('/') ? 1 : 0;
+	*end = path.indexOf('/', *start);
+	if (*end < 0) {
+		*end = path.size();
+	}
+	return *end > *start;
+}
+
+QStringRef
+PathHelper::GetBucketName(const QString& path)
+{
+	int start, end;
+	if (!find_bucket_name(path, &start, &end)) {
+		return QStringRef();
+	}
+	return path.midRef(start, end - start);
+}
+
+QStringRef
+PathHelper::GetObjectName(const QString& path)
+{
+	int start, end;
+	if (!find_bucket_name(path, &start, &end) || end >= path.size() - 1) {
+		// "bucket" or "bucket/"
+		return QStringRef();
+	}
+	// PATH_REGEX lets a single extra slash separate the bucket name
+	// from the object name.
+	if (path.at(end + 1) == '/') {
+		return path.midRef(end + 2);
+	}
+	return path.midRef(end + 1);
+}
+
+QStringRef
+PathHelper::GetLastPathPart(const QString& path)
+{
+	int end = path.size();
+	if (end > 0 && path.at(end - 1) == '/') {
+		end--;
+	}
+	if (end == 0 || path.at(end - 1) == '/') {
+		return QStringRef();
+	}
+	int start = path.lastIndexOf('/', end - 1) + 1;
+	return path.midRef(start);
+}
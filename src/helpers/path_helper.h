@@ -0,0 +1,84 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef PATH_HELPER_H
+#define PATH_HELPER_H
+
+#include <QString>
+#include <QStringRef>
+
+// Prefix and slash handling for DS3 "bucket/object" paths and object names.
+// These are called for every object of a listing, so they work on string
+// references into the original string rather than compiling a regular
+// expression per object.  The returned references are only valid for as
+// long as the string they were taken from.
+class PathHelper
+{
+public:
+	// Split a "/bucket/object" path the same way DS3URL::PATH_REGEX
+	// does.  An optional leading slash is ignored.
+	static QStringRef GetBucketName(const QString& path);
+	static QStringRef GetObjectName(const QString& path);
+	// The last part of path, including its trailing slash if it has one
+	static QStringRef GetLastPathPart(const QString& path);
+
+	// name without prefix if it starts with it.  prefix is matched
+	// literally.
+	static QStringRef StripPrefix(const QString& name,
+				      const QString& prefix);
+	static QStringRef StripLeadingSlash(const QString& path);
+	static QStringRef StripTrailingSlash(const QString& path);
+	// path with exactly one trailing slash if it didn't have one
+	static QString AddTrailingSlash(const QString& path);
+};
+
+inline QStringRef
+PathHelper::StripPrefix(const QString& name, const QString& prefix)
+{
+	if (!prefix.isEmpty() && name.startsWith(prefix)) {
+		return name.midRef(prefix.size());
+	}
+	return QStringRef(&name);
+}
+
+inline QStringRef
+PathHelper::StripLeadingSlash(const QString& path)
+{
+	if (path.startsWith('/')) {
+		return path.midRef(1);
+	}
+	return QStringRef(&path);
+}
+
+inline QStringRef
+PathHelper::StripTrailingSlash(const QString& path)
+{
+	if (path.endsWith('/')) {
+		return path.leftRef(path.size() - 1);
+	}
+	return QStringRef(&path);
+}
+
+inline QString
+PathHelper::AddTrailingSlash(const QString& path)
+{
+	if (path.endsWith('/')) {
+		return path;
+	}
+	return path + '/';
+}
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <string.h>
+
+#include "lib/checksum.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define CRC32C_X86
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CRC32C_X86
+#define CRC32C_TARGET
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM
+#endif
+
+// The reflected CRC32C (Castagnoli) polynomial
+static const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+// Tables for processing 8 bytes at a time.  table[0] is the classic byte at
+// a time table and table[k] is the CRC of a byte followed by k zero bytes.
+struct Crc32cTables {
+	uint32_t table[8][256];
+
+	Crc32cTables()
+	{
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+			}
+			table[0][i] = crc;
+		}
+		for (uint32_t i = 0; i < 256; i++) {
+			for (int k = 1; k < 8; k++) {
+				uint32_t prev = table[k - 1][i];
+				table[k][i] = (prev >> 8) ^ table[0][prev & 0xff];
+			}
+		}
+	}
+};
+
+static const Crc32cTables s_tables;
+
+#ifdef CRC32C_X86
+static bool
+detect_sse42()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+#endif
+}
+
+static const bool s_hasSse42 = detect_sse42();
+
+CRC32C_TARGET static uint32_t
+crc32c_sse42(uint32_t crc, const char* data, size_t size)
+{
+	while (size > 0 && ((uintptr_t)data & 7) != 0) {
+		crc = _mm_crc32_u8(crc, *data++);
+		size--;
+	}
+	uint64_t crc64 = crc;
+	while (size >= 8) {
+		uint64_t word;
+		memcpy(&word, data, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		size -= 8;
+	}
+	crc = (uint32_t)crc64;
+	while (size > 0) {
+		crc = _mm_crc32_u8(crc, *data++);
+		size--;
+	}
+	return crc;
+}
+#endif
+
+#ifdef CRC32C_ARM
+static uint32_t
+crc32c_arm(uint32_t crc, const char* data, size_t size)
+{
+	while (size > 0 && ((uintptr_t)data & 7) != 0) {
+		crc = __crc32cb(crc, *data++);
+		size--;
+	}
+	while (size >= 8) {
+		uint64_t word;
+		memcpy(&word, data, 8);
+		crc = __crc32cd(crc, word);
+		data += 8;
+		size -= 8;
+	}
+	while (size > 0) {
+		crc = __crc32cb(crc, *data++);
+		size--;
+	}
+	return crc;
+}
+#endif
+
+Checksum::Checksum(Session::ChecksumType type)
+	: m_type(type),
+	  m_crc(0),
+	  m_hash(QCryptographicHash::Md5)
+{
+}
+
+void
+Checksum::Update(const char* data, size_t size)
+{
+	if (m_type == Session::CRC32C_CHECKSUM) {
+		m_crc = Crc32c(m_crc, data, size);
+	} else if (m_type == Session::MD5_CHECKSUM) {
+		m_hash.addData(data, size);
+	}
+}
+
+QByteArray
+Checksum::GetResult() const
+{
+	QByteArray result;
+	if (m_type == Session::CRC32C_CHECKSUM) {
+		result.append((char)(m_crc >> 24));
+		result.append((char)(m_crc >> 16));
+		result.append((char)(m_crc >> 8));
+		result.append((char)m_crc);
+	} else if (m_type == Session::MD5_CHECKSUM) {
+		result = m_hash.result();
+	}
+	return result;
+}
+
+uint32_t
+Checksum::Crc32c(uint32_t crc, const char* data, size_t size)
+{
+	crc = ~crc;
+#if defined(CRC32C_X86)
+	if (s_hasSse42) {
+		return ~crc32c_sse42(crc, data, size);
+	}
+#elif defined(CRC32C_ARM)
+	return ~crc32c_arm(crc, data, size);
+#endif
+	return Crc32cTable(~crc, data, size);
+}
+
+uint32_t
+Checksum::Crc32cTable(uint32_t crc, const char* data, size_t size)
+{
+	const uint32_t (*table)[256] = s_tables.table;
+	const unsigned char* bytes = (const unsigned char*)data;
+	crc = ~crc;
+	while (size >= 8) {
+		uint32_t low = crc ^ ((uint32_t)bytes[0] |
+				      (uint32_t)bytes[1] << 8 |
+				      (uint32_t)bytes[2] << 16 |
+				      (uint32_t)bytes[3] << 24);
+		crc = table[7][low & 0xff] ^
+		      table[6][(low >> 8) & 0xff] ^
+		      table[5][(low >> 16) & 0xff] ^
+		      table[4][low >> 24] ^
+		      table[3][bytes[4]] ^
+		      table[2][bytes[5]] ^
+		      table[1][bytes[6]] ^
+		      table[0][bytes[7]];
+		bytes += 8;
+		size -= 8;
+	}
+	while (size > 0) {
+		crc = (crc >> 8) ^ table[0][(crc ^ *bytes++) & 0xff];
+		size--;
+	}
+	return ~crc;
+}
+
+bool
+Checksum::HasCrc32cInstruction()
+{
+#if defined(CRC32C_X86)
+	return s_hasSse42;
+#elif defined(CRC32C_ARM)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool
+Checksum::MatchesETag(const QByteArray& result, const QString& etag,
+		      bool* comparable)
+{
+	QByteArray value = etag.trimmed().toLatin1();
+	if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"')) {
+		value = value.mid(1, value.size() - 2);
+	}
+	QByteArray hex = result.toHex();
+	if (value.size() == hex.size()) {
+		QByteArray decoded = QByteArray::fromHex(value);
+		if (decoded.toHex() == value.toLower()) {
+			*comparable = true;
+			return (decoded == result);
+		}
+	}
+	if (value.size() == result.toBase64().size()) {
+		QByteArray decoded = QByteArray::fromBase64(value);
+		if (decoded.size() == result.size()) {
+			*comparable = true;
+			return (decoded == result);
+		}
+	}
+	*comparable = false;
+	return false;
+}
@@ -0,0 +1,69 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+
+#include "models/session.h"
+
+// Checksum, computes a CRC32C or MD5 checksum of data that's passed to it a
+// piece at a time, e.g. as an object streams to or from the server.
+//
+// CRC32C uses the CPU's CRC32 instruction where there is one, SSE4.2 on x86
+// and the CRC extension on ARMv8, and a slicing-by-8 table otherwise.
+class Checksum
+{
+public:
+	Checksum(Session::ChecksumType type);
+
+	Session::ChecksumType GetType() const;
+	void Update(const char* data, size_t size);
+	// The checksum of all of the data so far, most significant byte
+	// first, as the server expects it
+	QByteArray GetResult() const;
+
+	// Continue the CRC32C of some data, which starts at 0
+	static uint32_t Crc32c(uint32_t crc, const char* data, size_t size);
+	// The portable implementation that Crc32c falls back to
+	static uint32_t Crc32cTable(uint32_t crc, const char* data, size_t size);
+	static bool HasCrc32cInstruction();
+
+	// Whether an object's ETag, in hex or base64 and possibly quoted, is
+	// result.  comparable is set to false if the ETag isn't in a form
+	// that can be compared with result at all, e.g. because the server
+	// uses another kind of checksum or the object has several blobs.
+	static bool MatchesETag(const QByteArray& result, const QString& etag,
+				bool* comparable);
+
+private:
+	Session::ChecksumType m_type;
+	uint32_t m_crc;
+	QCryptographicHash m_hash;
+};
+
+inline Session::ChecksumType
+Checksum::GetType() const
+{
+	return m_type;
+}
+
+#endif
@@ -17,17 +17,36 @@
 #include <stdlib.h>
 #include <QtConcurrent>
 #include <QDir>
-#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QHash>
+#include <QMap>
 #include <QRegularExpression>
+#include <QSet>
+#include <QThreadPool>
 
+#include "helpers/file_helper.h"
+#include "helpers/path_helper.h"
 #include "lib/work_items/bulk_get_work_item.h"
 #include "lib/work_items/bulk_put_work_item.h"
+#include "lib/work_items/chunk_work_item.h"
 #include "lib/work_items/object_work_item.h"
+#include "lib/work_items/page_work_item.h"
+#include "lib/checksum.h"
 #include "lib/client.h"
+#include "lib/concurrency_controller.h"
+#include "lib/ds3_client_pool.h"
+#include "lib/executor.h"
+#include "lib/job_journal.h"
+#include "lib/job_progress_publisher.h"
+#include "lib/listing_cache.h"
 #include "lib/logger.h"
+#include "lib/object_compressor.h"
+#include "lib/object_decompressor.h"
+#include "lib/small_file_archive.h"
+#include "lib/sync_manifest.h"
 #include "models/ds3_url.h"
+#include "models/listing_page.h"
 #include "models/session.h"
 
 using QtConcurrent::run;
@@ -41,8 +60,98 @@ const uint64_t Client::BULK_PAGE_LIMIT = 100000;
 // 0 = don't specify it in requests and let the S3 server determine the max
 const uint32_t Client::MAX_KEYS = 0;
 
+// How often, in milliseconds, to ask the server for newly available job
+// chunks while objects of the current chunks are still being transferred.
+const unsigned long Client::CHUNK_POLL_INTERVAL = 5000;
+
+// How long, in milliseconds, a returned C SDK client is kept for reuse
+const int Client::CLIENT_POOL_IDLE_TIMEOUT = 30000;
+
+// C SDK clients kept idle for reuse in addition to one per transfer thread,
+// for the listing and job requests that run alongside transfers.
+const int Client::CLIENT_POOL_SPARE_CLIENTS = 2;
+
+// The most requests that are ever sent to the host at once
+const int Client::MAX_CLIENTS_PER_HOST = 32;
+
+// The most objects a single job transfers at once.  The session's number of
+// transfer threads is where each job starts out and its transfer controller
+// adjusts it from there.
+const int Client::MAX_TRANSFERS_PER_JOB = 16;
+
+// Listings and searches, which the user is waiting on
+const int Client::METADATA_THREADS = 4;
+// Bulk job preparation, i.e. walking the URLs and creating the DS3 jobs
+const int Client::PREP_THREADS = 2;
+// Bulk job pages being transferred.  Each page's objects are transferred by
+// the job's own transfer threads.
+const int Client::TRANSFER_THREADS = 8;
+// Creating a GET page's directories and allocating its files.  They're
+// mostly waiting on the file system, which can handle several at once.
+const int Client::RESTORE_PREP_THREADS = 8;
+
 static size_t read_from_file(void* buffer, size_t size, size_t count, void* user_data);
 static size_t write_to_file(void* buffer, size_t size, size_t count, void* user_data);
+static size_t write_to_buffer(void* buffer, size_t size, size_t count, void* user_data);
+
+// What's left of msecs, or -1 to wait forever if msecs is -1
+static int
+remaining_msecs(int msecs, const QElapsedTimer& timer)
+{
+	if (msecs < 0) {
+		return -1;
+	}
+	return (int)qMax((qint64)0, msecs - timer.elapsed());
+}
+
+// Where a PUT job's archives of small files are kept.  They're next to the
+// job's journal so they're still there if the job has to be resumed.
+static QString
+archive_dir(const QString& journalPath)
+{
+	QString path = journalPath;
+	path.chop(QString(".journal").size());
+	return path + ".archives";
+}
+
+// A ranged GET of an archive object and the members, by their position in
+// the archive's index, that it reads
+struct ArchiveRange
+{
+	uint64_t offset;
+	uint64_t length;
+	QList<int> members;
+};
+
+// Group the selected members of an archive into as few ranges as possible
+// without reading more than MAX_MEMBER_SIZE of the other members in between
+static QList<ArchiveRange>
+group_members(const QList<SmallFileArchive::Member>& members,
+	      const QList<int>& selected)
+{
+	QMap<uint64_t, int> byOffset;
+	for (int i = 0; i < selected.size(); i++) {
+		byOffset.insertMulti(members[selected[i]].offset, selected[i]);
+	}
+	QList<ArchiveRange> ranges;
+	QMap<uint64_t, int>::const_iterator mi;
+	for (mi = byOffset.constBegin(); mi != byOffset.constEnd(); mi++) {
+		const SmallFileArchive::Member& member = members[mi.value()];
+		uint64_t end = member.offset + member.size;
+		if (ranges.isEmpty() ||
+		    member.offset > ranges.last().offset + ranges.last().length +
+				    SmallFileArchive::MAX_MEMBER_SIZE) {
+			ArchiveRange range;
+			range.offset = member.offset;
+			range.length = 0;
+			ranges << range;
+		}
+		ArchiveRange& range = ranges.last();
+		range.length = qMax(range.length, end - range.offset);
+		range.members << mi.value();
+	}
+	return ranges;
+}
 
 // Simple struct to wrap a Client and an ObjectWorkItem so the C SDK can
 // send both to the file read/write callback functions.
@@ -53,6 +162,12 @@ struct ClientAndObjectWorkItem
 };
 
 Client::Client(const Session* session)
+	: m_numTransferThreads(session->GetNumTransferThreads()),
+	  m_fileIOMode(session->GetFileIOMode()),
+	  m_packSmallFiles(session->GetPackSmallFiles()),
+	  m_compressObjects(session->GetCompressObjects()),
+	  m_syncMode(session->GetSyncMode()),
+	  m_checksumType(session->GetChecksumType())
 {
 	m_creds = ds3_create_creds(session->GetAccessId().toUtf8().constData(),
 				   session->GetSecretKey().toUtf8().constData());
@@ -64,18 +179,81 @@ Client::Client(const Session* session)
 	if (!port.isEmpty() && port != "80" && port != "443") {
 		m_endpoint += ":" + port;
 	}
-
-	m_client = ds3_create_client(m_endpoint.toUtf8().constData(), m_creds);
-	QString proxy = session->GetProxy();
-	if (!proxy.isEmpty()) {
-		ds3_client_proxy(m_client, proxy.toUtf8().constData());
-	}
+	m_proxy = session->GetProxy();
+
+	int poolSize = m_numTransferThreads + CLIENT_POOL_SPARE_CLIENTS;
+	m_clientPool = new DS3ClientPool(m_endpoint, m_proxy, m_creds,
+					 poolSize,
+					 qMax(poolSize, MAX_CLIENTS_PER_HOST),
+					 CLIENT_POOL_IDLE_TIMEOUT);
+
+	m_metadataExecutor = new Executor("metadata", METADATA_THREADS,
+					  QThread::HighPriority);
+	m_prepExecutor = new Executor("prep", PREP_THREADS);
+	m_transferExecutor = new Executor("transfer", TRANSFER_THREADS,
+					  QThread::LowPriority);
+	// Compressing blocks of objects is CPU bound so there's no point in
+	// more threads than cores
+	m_codecExecutor = new Executor("codec", QThread::idealThreadCount(),
+				       QThread::LowPriority);
+	// Leave the spare clients for the requests that aren't transfers
+	m_transferController = new ConcurrencyController("session " + m_host,
+							 m_numTransferThreads, 1,
+							 MAX_CLIENTS_PER_HOST - CLIENT_POOL_SPARE_CLIENTS);
+
+	m_listingCache = new ListingCache;
+
+	m_progressPublisher = new JobProgressPublisher(this);
+	connect(m_progressPublisher, SIGNAL(JobsUpdated(const QList<Job>)),
+		this, SIGNAL(JobProgressUpdates(const QList<Job>)));
 }
 
 Client::~Client()
 {
+	LOG_DEBUG("Client pool hits: " +
+		  QString::number(m_clientPool->GetNumHits()) + ", misses: " +
+		  QString::number(m_clientPool->GetNumMisses()));
+	LogExecutor(m_metadataExecutor);
+	LogExecutor(m_prepExecutor);
+	LogExecutor(m_transferExecutor);
+	LogExecutor(m_codecExecutor);
+	delete m_metadataExecutor;
+	delete m_prepExecutor;
+	delete m_transferExecutor;
+	delete m_codecExecutor;
+	delete m_transferController;
+	delete m_clientPool;
+	LOG_DEBUG("Listing cache hits: " +
+		  QString::number(m_listingCache->GetNumHits()) + ", misses: " +
+		  QString::number(m_listingCache->GetNumMisses()));
+	delete m_listingCache;
 	ds3_free_creds(m_creds);
-	ds3_free_client(m_client);
+}
+
+bool
+Client::WaitForActiveJobs(int msecs)
+{
+	QElapsedTimer timer;
+	timer.start();
+	// Preparing a page can start transferring it and finishing a page can
+	// start preparing the next one so wait until neither executor has
+	// anything left to do.
+	do {
+		if (!m_prepExecutor->WaitForDone(remaining_msecs(msecs, timer)) ||
+		    !m_transferExecutor->WaitForDone(remaining_msecs(msecs, timer))) {
+			return false;
+		}
+	} while (!m_prepExecutor->WaitForDone(0));
+	return m_metadataExecutor->WaitForDone(remaining_msecs(msecs, timer));
+}
+
+void
+Client::LogExecutor(const Executor* executor) const
+{
+	LOG_DEBUG("Client " + executor->GetName() + " executor tasks: " +
+		  QString::number(executor->GetNumFinished()) +
+		  ", max queued: " +
+		  QString::number(executor->GetMaxNumQueued()));
 }
 
 int
@@ -98,16 +276,83 @@ Client::CancelActiveJobs()
 		Job::State state = workItem->GetState();
 		if (state != Job::CANCELING && state != Job::CANCELED &&
 		    state != Job::FINISHED) {
+			workItem->SetInterrupted(true);
 			workItem->SetState(Job::CANCELING);
 		}
 	}
 	m_bulkWorkItemsLock.unlock();
 }
 
+void
+Client::ResumeJobs()
+{
+	QStringList paths = JobJournal::GetPaths();
+	for (int i = 0; i < paths.size(); i++) {
+		JobJournal* journal = new JobJournal(paths[i]);
+		// Open fails if another Client is already resuming this job
+		if (!journal->Open()) {
+			delete journal;
+			continue;
+		}
+		if (!journal->Load()) {
+			LOG_ERROR("ERROR:       Unable to read job journal " + paths[i]);
+			journal->Remove();
+			delete journal;
+			continue;
+		}
+		if (journal->GetHost() != m_host) {
+			delete journal;
+			continue;
+		}
+
+		BulkWorkItem* workItem;
+		if (journal->GetType() == Job::GET) {
+			workItem = new BulkGetWorkItem(m_host, journal->GetURLs(),
+						       journal->GetDestination());
+		} else {
+			BulkPutWorkItem* putWorkItem;
+			putWorkItem = new BulkPutWorkItem(m_host, journal->GetURLs(),
+							  journal->GetBucketName(),
+							  journal->GetPrefix());
+			// Packed files aren't objects of their own so they
+			// can't be synced
+			putWorkItem->SetPackSmallFiles(m_packSmallFiles &&
+						       m_syncMode == Session::NO_SYNC);
+			putWorkItem->SetCompressObjects(m_compressObjects);
+			putWorkItem->SetSyncMode(m_syncMode);
+			putWorkItem->SetArchiveDir(archive_dir(paths[i]));
+			workItem = putWorkItem;
+		}
+		workItem->SetTransferConcurrency(m_numTransferThreads,
+						 qMax(m_numTransferThreads, MAX_TRANSFERS_PER_JOB));
+		workItem->Resume(journal);
+		workItem->SetJournal(journal);
+		LOG_INFO("RESUME       JOB       " + paths[i]);
+
+		m_bulkWorkItemsLock.lock();
+		m_bulkWorkItems[workItem->GetID()] = workItem;
+		m_bulkWorkItemsLock.unlock();
+		workItem->SetState(Job::QUEUED);
+		Job job = workItem->ToJob();
+		m_progressPublisher->Publish(job);
+
+		if (journal->HasPages()) {
+			m_prepExecutor->Run(this, &Client::ResumeBulk, workItem);
+		} else if (journal->GetType() == Job::GET) {
+			m_prepExecutor->Run(this, &Client::PrepareBulkGets,
+					    static_cast<BulkGetWorkItem*>(workItem));
+		} else {
+			m_prepExecutor->Run(this, &Client::PrepareBulkPuts,
+					    static_cast<BulkPutWorkItem*>(workItem));
+		}
+	}
+}
+
 QFuture<ds3_get_service_response*>
 Client::GetService()
 {
-	QFuture<ds3_get_service_response*> future = run(this, &Client::DoGetService);
+	QFuture<ds3_get_service_response*> future;
+	future = m_metadataExecutor->Run(this, &Client::DoGetService);
 	return future;
 }
 
@@ -115,22 +360,63 @@ QFuture<ds3_get_bucket_response*>
 Client::GetBucket(const QString& bucketName, const QString& prefix,
 		  const QString& marker, bool silent, const QString& delimiter)
 {
-	QFuture<ds3_get_bucket_response*> future = run(this,
-						       &Client::DoGetBucket,
-						       bucketName,
-						       prefix,
-						       delimiter,
-						       marker,
-						       silent);
+	QFuture<ds3_get_bucket_response*> future;
+	future = m_metadataExecutor->Run(this,
+					 &Client::DoGetBucket,
+					 bucketName,
+					 prefix,
+					 delimiter,
+					 marker,
+					 silent);
+	return future;
+}
+
+QFuture<ListingPage*>
+Client::GetListingPage(const QString& bucketName, const QString& prefix,
+		       const QString& marker, const QString& owner)
+{
+	QFuture<ListingPage*> future;
+	future = m_metadataExecutor->Run(this,
+					 &Client::DoGetListingPage,
+					 bucketName,
+					 prefix,
+					 marker,
+					 owner);
+	return future;
+}
+
+QFuture<ListingPage*>
+Client::GetListingPages(const QString& bucketName, const QString& prefix,
+			const QString& marker, const QString& owner)
+{
+	QFuture<ListingPage*> future;
+	future = m_metadataExecutor->Run(this,
+					 &Client::DoGetListingPages,
+					 bucketName,
+					 prefix,
+					 marker,
+					 owner);
 	return future;
 }
 
+void
+Client::InvalidateListings(const QString& bucketName, const QString& prefix)
+{
+	if (bucketName.isEmpty()) {
+		m_listingCache->Clear();
+	} else {
+		m_listingCache->InvalidatePrefix(bucketName, prefix);
+	}
+}
+
 void
 Client::CreateBucket(const QString& name)
 {
 	ds3_request* request = ds3_init_put_bucket(name.toUtf8().constData());
 	LOG_INFO("PUT          BUCKET    "+m_endpoint+"/"+name);
-	ds3_error* ds3Error = ds3_put_bucket(m_client, request);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_put_bucket(client, request);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 
 	if (ds3Error != NULL) {
@@ -145,8 +431,11 @@ Client::DeleteBucket(const QString& name)
 {
 	ds3_request* request = ds3_init_delete_bucket(name.toUtf8().constData());
 	LOG_INFO("DELETE       BUCKET    "+m_endpoint+"/"+name);
-	ds3_error* ds3Error = ds3_delete_bucket(m_client, request);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_delete_bucket(client, request);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
+	m_listingCache->InvalidateBucket(name);
 
 	if (ds3Error != NULL) {
 		DS3Error error(ds3Error);
@@ -169,9 +458,14 @@ Client::DeleteObjects(const QString& bucketName, const QStringList& objectNames)
 		bulkObj->name = ds3_str_init(objName.toUtf8().constData());
 	}
 
-	ds3_error* ds3Error = ds3_delete_objects(m_client, request, bulkObjList);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_delete_objects(client, request, bulkObjList);
+	m_clientPool->Return(client);
 
 	ds3_free_request(request);
+	for (int i = 0; i < objectNames.size(); i++) {
+		m_listingCache->Invalidate(bucketName, objectNames[i]);
+	}
 
 	if (ds3Error != NULL) {
 		DS3Error error(ds3Error);
@@ -187,8 +481,13 @@ Client::DeleteFolders(const QString& bucketName, const QStringList& folderNames)
 		ds3_request* request = ds3_init_delete_folder(bucketName.toUtf8().constData(), folderNames[i].toUtf8().constData());
 		LOG_INFO("Delete Folder " + bucketName + "/" + folderNames[i]);
 
-		ds3_error* ds3Error = ds3_delete_folder(m_client, request);
+		ds3_client* client = m_clientPool->Checkout();
+		ds3_error* ds3Error = ds3_delete_folder(client, request);
+		m_clientPool->Return(client);
 		ds3_free_request(request);
+		QString prefix = PathHelper::AddTrailingSlash(folderNames[i]);
+		m_listingCache->Invalidate(bucketName, prefix);
+		m_listingCache->InvalidatePrefix(bucketName, prefix);
 
 		if (ds3Error != NULL) {
 			DS3Error error(ds3Error);
@@ -203,13 +502,16 @@ Client::BulkGet(const QList<QUrl> urls, const QString& destination)
 {
 	BulkGetWorkItem* workItem = new BulkGetWorkItem(m_host, urls,
 							destination);
+	workItem->SetTransferConcurrency(m_numTransferThreads,
+					 qMax(m_numTransferThreads, MAX_TRANSFERS_PER_JOB));
+	StartJournal(workItem);
 	m_bulkWorkItemsLock.lock();
 	m_bulkWorkItems[workItem->GetID()] = workItem;
 	m_bulkWorkItemsLock.unlock();
 	workItem->SetState(Job::QUEUED);
 	Job job = workItem->ToJob();
-	emit JobProgressUpdate(job);
-	run(this, &Client::PrepareBulkGets, workItem);
+	m_progressPublisher->Publish(job);
+	m_prepExecutor->Run(this, &Client::PrepareBulkGets, workItem);
 }
 
 void
@@ -219,115 +521,236 @@ Client::BulkPut(const QString& bucketName,
 {
 	BulkPutWorkItem* workItem = new BulkPutWorkItem(m_host, urls,
 							bucketName, prefix);
+	workItem->SetTransferConcurrency(m_numTransferThreads,
+					 qMax(m_numTransferThreads, MAX_TRANSFERS_PER_JOB));
+	// Packed files aren't objects of their own so they can't be synced
+	workItem->SetPackSmallFiles(m_packSmallFiles &&
+				    m_syncMode == Session::NO_SYNC);
+	workItem->SetCompressObjects(m_compressObjects);
+	workItem->SetSyncMode(m_syncMode);
+	QString journalName = workItem->GetID().toString() + ".journal";
+	workItem->SetArchiveDir(archive_dir(QDir(JobJournal::GetDir()).filePath(journalName)));
+	StartJournal(workItem);
 	m_bulkWorkItemsLock.lock();
 	m_bulkWorkItems[workItem->GetID()] = workItem;
 	m_bulkWorkItemsLock.unlock();
 	workItem->SetState(Job::QUEUED);
 	Job job = workItem->ToJob();
-	emit JobProgressUpdate(job);
-	run(this, &Client::PrepareBulkPuts, workItem);
+	m_progressPublisher->Publish(job);
+	m_prepExecutor->Run(this, &Client::PrepareBulkPuts, workItem);
 }
 
-void
+bool
 Client::GetObject(const QString& bucket,
 		  const QString& object,
 		  const QString& fileName,
 		  uint64_t offset,
-		  BulkGetWorkItem* bulkGetWorkItem)
+		  uint64_t length,
+		  PageWorkItem* page)
 {
-	QDir dir(fileName);
+	// PrepareRestore already created the directories
 	if (object.endsWith("/")) {
-		if (!dir.exists()) {
-			dir.mkpath(".");
-			return;
-		}
-	} else {
-		QDir parentDir(QFileInfo(fileName).absolutePath());
-		if (!parentDir.exists()) {
-			parentDir.mkpath(".");
-		}
+		QDir().mkpath(fileName);
+		page->FinishBlob(object, offset);
+		return true;
 	}
 
-	QString jobID = bulkGetWorkItem->GetJobID();
+	bool decompress;
+	QString downloadName = GetDownloadName(page, object, fileName,
+					       &decompress);
+	if (!decompress && !page->PreallocateObjectFile(object, downloadName)) {
+		LOG_ERROR("ERROR:       GET OBJECT unable to allocate file "+downloadName);
+	}
+
+	QString jobID = page->GetJobID();
 	ds3_request* request = ds3_init_get_object_for_job(bucket.toUtf8().constData(),
 							   object.toUtf8().constData(),
 							   offset,
 							   jobID.toUtf8().constData());
 	ds3_error* ds3Error = NULL;
-	ObjectWorkItem objWorkItem(bucket, object, fileName, bulkGetWorkItem);
+	ObjectWorkItem objWorkItem(bucket, object, downloadName,
+				   page->GetBulkWorkItem());
 	ClientAndObjectWorkItem caowi;
 	caowi.client = this;
 	caowi.objectWorkItem = &objWorkItem;
-	if (objWorkItem.OpenFile(QIODevice::ReadWrite)) {
-		objWorkItem.SeekFile(offset);
-		ds3Error = ds3_get_object(m_client, request,
+	// Blobs of the same object reuse the file handles that earlier ones
+	// left open
+	QFile* file = NULL;
+	// Objects are only listed with the checksum of their data when they
+	// were uploaded in one piece
+	QString etag = page->GetETag(object);
+	if (m_checksumType != Session::NO_CHECKSUM) {
+		if (!etag.isEmpty() && page->IsSingleBlob(object)) {
+			objWorkItem.SetChecksum(new Checksum(m_checksumType));
+		} else if (offset == 0) {
+			QString reason = etag.isEmpty() ?
+					 "the server didn't list an ETag for it" :
+					 "it was split into several blobs";
+			LOG_WARNING("WARNING:     GET OBJECT "+object+" isn't verified, "+reason);
+		}
+	}
+	bool opened;
+	if (decompress) {
+		opened = objWorkItem.OpenFile(QIODevice::WriteOnly | QIODevice::Truncate);
+	} else {
+		file = page->CheckoutObjectFile(object, downloadName);
+		opened = (file != NULL);
+		if (opened) {
+			objWorkItem.UseFile(file);
+		}
+	}
+	if (opened) {
+		if (decompress) {
+			objWorkItem.SetDecompressor(new ObjectDecompressor(objWorkItem.GetFile()));
+		} else {
+			PrepareObjectFile(&objWorkItem, offset, length);
+		}
+		ds3_client* client = m_clientPool->Checkout();
+		ds3Error = ds3_get_object(client, request,
 					  &caowi, write_to_file);
+		m_clientPool->Return(client);
 	} else {
-		LOG_ERROR("ERROR:       GET OBJECT failed, unable to open file "+fileName);
+		LOG_ERROR("ERROR:       GET OBJECT failed, unable to open file "+downloadName);
 	}
-
 	ds3_free_request(request);
 
+	// Checked before the file is handed back so a blob that doesn't
+	// match can be removed instead of being left under the object's name
+	bool corrupt = false;
+	if (ds3Error == NULL && opened && objWorkItem.GetChecksum() != NULL) {
+		bool comparable;
+		QByteArray result = objWorkItem.GetChecksum()->GetResult();
+		bool matches = Checksum::MatchesETag(result, etag, &comparable);
+		if (!matches && comparable) {
+			LOG_ERROR("ERROR:       GET OBJECT checksum of "+object+
+				  " doesn't match the server's ETag "+etag+
+				  ". Removing "+downloadName);
+			corrupt = true;
+		} else if (!matches) {
+			LOG_WARNING("WARNING:     GET OBJECT "+object+" isn't verified, its ETag "+
+				    etag+" isn't a "+
+				    Session::CHECKSUM_TYPE_NAMES[m_checksumType]+" checksum");
+		}
+	}
+	if (file != NULL) {
+		objWorkItem.ReleaseFile();
+		if (corrupt) {
+			delete file;
+		} else {
+			page->ReturnObjectFile(object, file);
+		}
+	}
+
 	if (ds3Error != NULL) {
 		DS3Error error(ds3Error);
 		ds3_free_error(ds3Error);
 		throw (error);
 	}
+	if (!opened) {
+		return false;
+	}
+	if (corrupt) {
+		// Only single blob objects are verified so the file holds
+		// nothing but this blob
+		objWorkItem.GetFile()->close();
+		QFile::remove(downloadName);
+		return false;
+	}
+	if (!objWorkItem.FinishDecompressing()) {
+		LOG_ERROR("ERROR:       GET OBJECT unable to decompress "+object);
+		return false;
+	}
+	if (page->FinishBlob(object, offset)) {
+		return FinishGetObject(object, fileName);
+	}
+	return true;
 }
 
-QFuture<ds3_get_objects_response*>
+QFuture<QSharedPointer<const Listing> >
 Client::GetObjects(const QString& bucketName, const QString& name)
 {
-	QFuture<ds3_get_objects_response*> future = run(this,
-						       &Client::DoGetObjects,
-						       bucketName,
-						       name);
+	QFuture<QSharedPointer<const Listing> > future;
+	future = m_metadataExecutor->Run(this,
+					 &Client::DoGetObjects,
+					 bucketName,
+					 name);
 	return future;
 }
 
-void
+bool
 Client::PutObject(const QString& bucket,
 		  const QString& object,
 		  const QString& fileName,
 		  uint64_t offset,
 		  uint64_t length,
-		  BulkPutWorkItem* workItem)
+		  PageWorkItem* page)
 {
-	QString jobID = workItem->GetJobID();
+	BulkWorkItem* workItem = page->GetBulkWorkItem();
+	QString jobID = page->GetJobID();
 	ds3_request* request = ds3_init_put_object_for_job(bucket.toUtf8().constData(),
 							   object.toUtf8().constData(),
 							   offset, length,
 							   jobID.toUtf8().constData());
 	ds3_error* ds3Error = NULL;
+	bool sent = false;
 	QFileInfo fileInfo(fileName);
 	if (fileInfo.isDir()) {
 		// "folder" objects don't have a size nor do they have any
 		// data associated with them
-		ds3Error = ds3_put_object(m_client, request, NULL, NULL);
+		ds3_client* client = m_clientPool->Checkout();
+		ds3Error = ds3_put_object(client, request, NULL, NULL);
+		m_clientPool->Return(client);
+		sent = true;
 	} else {
 		ObjectWorkItem objWorkItem(bucket, object, fileName, workItem);
 		ClientAndObjectWorkItem caowi;
 		caowi.client = this;
 		caowi.objectWorkItem = &objWorkItem;
-		if (objWorkItem.OpenFile(QIODevice::ReadOnly)) {
-			objWorkItem.SeekFile(offset);
-			ds3Error = ds3_put_object(m_client, request,
+		if (ObjectCompressor::IsCompressed(object)) {
+			ObjectCompressor* compressor = new ObjectCompressor(fileName,
+									   m_codecExecutor);
+			compressor->SetBlockSizes(page->GetBlockSizes(object));
+			objWorkItem.SetCompressor(compressor);
+			if (compressor->Seek(offset)) {
+				ds3_client* client = m_clientPool->Checkout();
+				ds3Error = ds3_put_object(client, request,
+							  &caowi, read_from_file);
+				m_clientPool->Return(client);
+				sent = !objWorkItem.HasCodecError();
+			} else {
+				LOG_ERROR("ERROR:       PUT OBJECT failed, unable to compress file "+fileName);
+			}
+		} else if (objWorkItem.OpenFile(QIODevice::ReadOnly)) {
+			PrepareObjectFile(&objWorkItem, offset, length);
+			if (m_checksumType != Session::NO_CHECKSUM && length > 0) {
+				SetPutChecksum(&objWorkItem, request, length);
+			}
+			ds3_client* client = m_clientPool->Checkout();
+			ds3Error = ds3_put_object(client, request,
 						  &caowi, read_from_file);
+			m_clientPool->Return(client);
+			sent = true;
 		} else {
 			LOG_ERROR("ERROR:       PUT OBJECT failed, unable to open file "+fileName);
 		}
 	}
 	ds3_free_request(request);
+	m_listingCache->Invalidate(bucket, object);
 
-	// TODO Don't rely on WasCanceled to ignore "Request failed: Operation
-	// was aborted by an application callback" errors.  It would be nice
-	// if the C SDK returned the CURLcode response and we could use that
-	// instead.
-	if (ds3Error != NULL && !workItem->WasCanceled()) {
+	if (ds3Error != NULL) {
+		// TODO Don't rely on WasCanceled to ignore "Request failed:
+		// Operation was aborted by an application callback" errors.
+		// It would be nice if the C SDK returned the CURLcode
+		// response and we could use that instead.
+		if (workItem->WasCanceled()) {
+			ds3_free_error(ds3Error);
+			return false;
+		}
 		DS3Error error(ds3Error);
 		ds3_free_error(ds3Error);
 		throw (error);
 	}
+	return sent;
 }
 
 void
@@ -354,9 +777,11 @@ Client::DoGetService()
 	LOG_INFO("BULK GET     BUCKETS   "+m_endpoint);
 
 	ds3_get_service_response *response;
-	ds3_error* ds3Error = ds3_get_service(m_client,
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_get_service(client,
 					       request,
 					       &response);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 
 	if (ds3Error != NULL) {
@@ -404,9 +829,11 @@ Client::DoGetBucket(const QString& bucketName, const QString& prefix,
 		LOG_INFO(logFileMsg);
 	}
 	ds3_get_bucket_response* response;
-	ds3_error* ds3Error = ds3_get_bucket(m_client,
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_get_bucket(client,
 					     request,
 					     &response);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 
 	if (ds3Error != NULL) {
@@ -418,12 +845,74 @@ Client::DoGetBucket(const QString& bucketName, const QString& prefix,
 	return response;
 }
 
-ds3_get_objects_response*
+ListingPage*
+Client::DoGetListingPage(const QString& bucketName, const QString& prefix,
+			 const QString& marker, const QString& owner)
+{
+	QSharedPointer<const Listing> listing = GetBucketListing(bucketName, prefix,
+								 DELIMITER, marker);
+	return new ListingPage(*listing, prefix, marker, owner);
+}
+
+ListingPage*
+Client::DoGetListingPages(const QString& bucketName, const QString& prefix,
+			  const QString& marker, const QString& owner)
+{
+	// Markers are keys and the server lists keys in UTF-8 byte order
+	QByteArray lastMarker = marker.toUtf8();
+	ListingPage* pages = DoGetListingPage(bucketName, prefix, "", owner);
+	try {
+		while (pages->IsTruncated() &&
+		       (lastMarker.isEmpty() ||
+			pages->GetNextMarker().toUtf8() < lastMarker)) {
+			QString nextMarker = pages->GetNextMarker();
+			QSharedPointer<const Listing> listing;
+			listing = GetBucketListing(bucketName, prefix,
+						   DELIMITER, nextMarker);
+			pages->Append(ListingPage(*listing, prefix,
+						  nextMarker, owner));
+		}
+	}
+	catch (DS3Error&) {
+		delete pages;
+		throw;
+	}
+	return pages;
+}
+
+QSharedPointer<const Listing>
+Client::GetBucketListing(const QString& bucketName, const QString& prefix,
+			 const QString& delimiter, const QString& marker)
+{
+	QSharedPointer<const Listing> listing;
+	listing = m_listingCache->GetBucketListing(bucketName, prefix,
+						   delimiter, marker);
+	if (listing.isNull()) {
+		qint64 generation = m_listingCache->GetGeneration();
+		ds3_get_bucket_response* response = DoGetBucket(bucketName, prefix,
+								 delimiter, marker);
+		listing = QSharedPointer<const Listing>(new Listing(response));
+		ds3_free_bucket_response(response);
+		m_listingCache->InsertBucketListing(bucketName, prefix,
+						    delimiter, marker, listing,
+						    generation);
+	}
+	return listing;
+}
+
+QSharedPointer<const Listing>
 Client::DoGetObjects(const QString& bucketName, const QString& name)
 {
 	LOG_DEBUG("DoGetObjects - bucket: " + bucketName +
 		  ", name: " + name);
 
+	QSharedPointer<const Listing> listing;
+	listing = m_listingCache->GetSearchListing(bucketName, name);
+	if (!listing.isNull()) {
+		return listing;
+	}
+	qint64 generation = m_listingCache->GetGeneration();
+
 	ds3_request* request = ds3_init_get_objects();
 	ds3_request_set_bucket_name(request, bucketName.toUtf8().constData());
 	QString logMsg = "List Objects (GET " + m_endpoint + "/";
@@ -440,9 +929,11 @@ Client::DoGetObjects(const QString& bucketName, const QString& name)
 	LOG_INFO(logMsg);
 
 	ds3_get_objects_response* response;
-	ds3_error* ds3Error = ds3_get_objects(m_client,
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_get_objects(client,
 					     request,
 					     &response);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 
 	if (ds3Error != NULL) {
@@ -451,7 +942,11 @@ Client::DoGetObjects(const QString& bucketName, const QString& name)
 		throw (error);
 	}
 
-	return response;
+	listing = QSharedPointer<const Listing>(new Listing(response));
+	ds3_free_objects_response(response);
+	m_listingCache->InsertSearchListing(bucketName, name, listing,
+					    generation);
+	return listing;
 }
 
 void
@@ -459,11 +954,15 @@ Client::PrepareBulkGets(BulkGetWorkItem* workItem)
 {
 	LOG_DEBUG("PREPARE BULK OBJECT");
 
-	workItem->SetState(Job::PREPARING);
-	Job job = workItem->ToJob();
-	emit JobProgressUpdate(job);
+	// Later pages are prepared while the previous one is transferring
+	if (workItem->GetPage() == NULL) {
+		workItem->SetState(Job::PREPARING);
+		Job job = workItem->ToJob();
+		m_progressPublisher->Publish(job);
+	}
 
 	workItem->ClearObjMap();
+	workItem->ClearETags();
 
 	QString prevBucket;
 	QString destination = workItem->GetDestination();
@@ -472,7 +971,7 @@ Client::PrepareBulkGets(BulkGetWorkItem* workItem)
 	     ui != workItem->GetUrlsConstEnd();
 	     ui++) {
 		if (workItem->WasCanceled()) {
-			DeleteOrRequeueBulkWorkItem(workItem);
+			DeleteOrRequeueBulkWorkItem(workItem, true);
 			return;
 		}
 
@@ -480,9 +979,7 @@ Client::PrepareBulkGets(BulkGetWorkItem* workItem)
 
 		QUrl lastUrl = workItem->GetLastProcessedUrl();
 		if (!lastUrl.isEmpty()) {
-			QString lastUrlS = lastUrl.toString();
-			lastUrlS.replace(QRegularExpression("/$"), "");
-			lastUrlS += "/";
+			QString lastUrlS = PathHelper::AddTrailingSlash(lastUrl.toString());
 			if (url.toString().startsWith(lastUrlS)) {
 				// This URL is either the same as or a
 				// descendant of the previously processed URL.
@@ -496,70 +993,95 @@ Client::PrepareBulkGets(BulkGetWorkItem* workItem)
 		QString bucket = url.GetBucketName();
 		if (workItem->GetObjMapSize() >= BULK_PAGE_LIMIT ||
 		    (!prevBucket.isEmpty() && prevBucket != bucket)) {
-			run(this, &Client::DoBulk, workItem);
+			m_prepExecutor->Run(this, &Client::DoBulk, workItem);
 			return;
 		}
 		workItem->SetBucketName(bucket);
 
 		QString fullObjName = url.GetObjectName();
+		QString etag;
 		QString lastPathPart = url.GetLastPathPart();
 		QString filePath = QDir::cleanPath(destination + "/" + lastPathPart);
+		if (!url.IsBucketOrFolder()) {
+			filePath = ObjectCompressor::RemoveSuffix(filePath);
+		}
 		if (url.IsBucketOrFolder()) {
 			QString prefix = fullObjName;
-			ds3_get_bucket_response* getBucketRes;
-			getBucketRes = workItem->GetGetBucketResponse();
-			size_t i = workItem->GetGetBucketResponseIterator();
+			QSharedPointer<const Listing> listing = workItem->GetListing();
+			int i = workItem->GetListingIterator();
 			do {
 				if (workItem->WasCanceled()) {
-					DeleteOrRequeueBulkWorkItem(workItem);
+					DeleteOrRequeueBulkWorkItem(workItem, true);
 					return;
 				}
-				if (getBucketRes == NULL ||
-				    (getBucketRes != NULL && i >= getBucketRes->num_objects)) {
+				if (listing.isNull() || i >= listing->objects.size()) {
 					QString marker;
-					if (getBucketRes != NULL) {
-						marker = QString::fromUtf8(getBucketRes->next_marker->value);
+					if (!listing.isNull()) {
+						marker = listing->nextMarker;
 					}
-					getBucketRes = DoGetBucket(bucket, prefix,
+					listing = GetBucketListing(bucket, prefix,
 								   "", marker);
 					i = 0;
 				}
-				if (getBucketRes->num_objects == 0) {
+				if (listing->objects.isEmpty()) {
 					workItem->AppendDirsToCreate(filePath);
 				}
-				for (; i < getBucketRes->num_objects; i++) {
+				for (; i < listing->objects.size(); i++) {
 					if (workItem->WasCanceled()) {
-						DeleteOrRequeueBulkWorkItem(workItem);
+						DeleteOrRequeueBulkWorkItem(workItem, true);
 						return;
 					}
 					if (workItem->GetObjMapSize() >= BULK_PAGE_LIMIT) {
-						workItem->SetGetBucketResponse(getBucketRes);
-						workItem->SetGetBucketResponseIterator(i);
-						run(this, &Client::DoBulk, workItem);
+						workItem->SetListing(listing);
+						workItem->SetListingIterator(i);
+						m_prepExecutor->Run(this, &Client::DoBulk, workItem);
 						return;
 					}
-					ds3_object rawObject = getBucketRes->objects[i];
-					QString subFullObjName = QString::fromUtf8(rawObject.name->value);
-					QString objNameMinusPrefix = subFullObjName;
-					objNameMinusPrefix.replace(QRegularExpression("^" + prefix), "");
+					const Listing::Object& object = listing->objects[i];
+					const QString& subFullObjName = object.name;
+					QString objNameMinusPrefix = PathHelper::StripPrefix(subFullObjName, prefix).toString();
 					QString subFilePath = QDir::cleanPath(destination + "/" +
 									      lastPathPart + "/" +
 									      objNameMinusPrefix);
+					subFilePath = ObjectCompressor::RemoveSuffix(subFilePath);
 					if (subFullObjName.endsWith("/")) {
 						workItem->AppendDirsToCreate(subFilePath);
+					} else if (SmallFileArchive::IsIndex(subFullObjName)) {
+						// Archives are unpacked whole so their
+						// indexes aren't needed
+						continue;
+					} else if (workItem->IsObjectDone(subFullObjName)) {
+						continue;
 					} else if (QFile(subFilePath).exists()) {
 						LOG_ERROR("ERROR:       "+subFilePath+" already exists. Skipping");
 					} else {
 						workItem->InsertObjMap(subFullObjName, subFilePath);
+						if (!object.etag.isEmpty()) {
+							workItem->InsertETag(subFullObjName,
+									     object.etag);
+						}
 					}
 				}
-			} while (getBucketRes->is_truncated);
-			workItem->SetGetBucketResponseIterator(0);
-			workItem->SetGetBucketResponse(NULL);
+			} while (listing->truncated);
+			workItem->SetListingIterator(0);
+			workItem->SetListing(QSharedPointer<const Listing>());
+			if (!fullObjName.isEmpty()) {
+				GetPackedMembers(workItem, bucket, fullObjName,
+						 filePath);
+			}
+		} else if (workItem->IsObjectDone(fullObjName)) {
+			// Already transferred before the job was resumed
 		} else if (QFile(filePath).exists()) {
 			LOG_ERROR("ERROR:       "+filePath+" already exists. Skipping");
-		} else {
+		} else if (FindObject(bucket, fullObjName, &etag)) {
 			workItem->InsertObjMap(fullObjName, filePath);
+			if (!etag.isEmpty()) {
+				workItem->InsertETag(fullObjName, etag);
+			}
+		} else if (!GetPackedMembers(workItem, bucket, fullObjName,
+					     filePath)) {
+			LOG_ERROR("ERROR:       GET OBJECT failed, " + bucket + "/" +
+				  fullObjName + " doesn't exist");
 		}
 
 		prevBucket = bucket;
@@ -567,11 +1089,188 @@ Client::PrepareBulkGets(BulkGetWorkItem* workItem)
 	}
 
 	if (workItem->GetObjMapSize() > 0) {
-		run(this, &Client::DoBulk, workItem);
+		m_prepExecutor->Run(this, &Client::DoBulk, workItem);
 	} else {
 		CreateBulkGetDirs(workItem);
-		DeleteOrRequeueBulkWorkItem(workItem);
+		DeleteOrRequeueBulkWorkItem(workItem, true);
+	}
+}
+
+bool
+Client::FindObject(const QString& bucketName, const QString& objName,
+		   QString* etag)
+{
+	// The object, if there is one, is listed first
+	QSharedPointer<const Listing> listing;
+	try {
+		listing = GetBucketListing(bucketName, objName, DELIMITER, "");
+	}
+	catch (DS3Error& e) {
+		LOG_WARNING("WARNING:     Unable to list " + bucketName + "/" +
+			    objName + " (" + e.ToString() + ").  Assuming it exists.");
+		return true;
+	}
+	if (listing->objects.isEmpty() ||
+	    listing->objects.first().name != objName) {
+		return false;
+	}
+	*etag = listing->objects.first().etag;
+	return true;
+}
+
+bool
+Client::GetPackedMembers(BulkGetWorkItem* workItem, const QString& bucketName,
+			 const QString& objName, const QString& filePath)
+{
+	// Archives hold the files under the directory that they're in, which
+	// is the directory that was PUT, so the archives that objName can be
+	// in are in the folders above it.  Archives at or under a folder are
+	// listed with it and downloaded whole.
+	QStringList dirs;
+	dirs << "";
+	for (int i = objName.indexOf('/');
+	     i >= 0 && i < objName.size() - 1;
+	     i = objName.indexOf('/', i + 1)) {
+		dirs << objName.left(i + 1);
+	}
+	QList<Listing::Object> indexes;
+	for (int i = 0; i < dirs.size(); i++) {
+		QString prefix = dirs[i] + SmallFileArchive::NAME_PREFIX;
+		QString marker;
+		bool truncated = true;
+		while (truncated) {
+			QSharedPointer<const Listing> listing;
+			try {
+				listing = GetBucketListing(bucketName, prefix,
+							   DELIMITER, marker);
+			}
+			catch (DS3Error& e) {
+				LOG_ERROR("ERROR:       Unable to list the archives in " +
+					  bucketName + "/" + dirs[i] + ", " +
+					  e.ToString());
+				break;
+			}
+			for (int j = 0; j < listing->objects.size(); j++) {
+				if (SmallFileArchive::IsIndex(listing->objects[j].name)) {
+					indexes << listing->objects[j];
+				}
+			}
+			marker = listing->nextMarker;
+			truncated = listing->truncated && !marker.isEmpty();
+		}
+	}
+
+	bool isFolder = objName.endsWith("/");
+	QString root = PathHelper::AddTrailingSlash(filePath);
+	bool found = false;
+	for (int i = 0; i < indexes.size(); i++) {
+		if (workItem->WasCanceled()) {
+			break;
+		}
+		const Listing::Object& index = indexes[i];
+		QList<SmallFileArchive::Member> members;
+		if (!workItem->GetArchiveIndex(index.name, &members)) {
+			QByteArray data;
+			try {
+				data = DoGetObjectRange(bucketName, index.name,
+							0, index.size);
+			}
+			catch (DS3Error& e) {
+				LOG_ERROR("ERROR:       GET OBJECT failed, " +
+					  index.name + ", " + e.ToString());
+				continue;
+			}
+			if (!SmallFileArchive::ReadIndex(data, &members)) {
+				LOG_ERROR("ERROR:       Unable to read archive index " +
+					  index.name);
+				continue;
+			}
+			workItem->InsertArchiveIndex(index.name, members);
+		}
+
+		QString archiveName = SmallFileArchive::GetArchiveName(index.name);
+		QString relName = objName.mid(archiveName.lastIndexOf('/') + 1);
+		QList<int> selected;
+		// By member
+		QHash<int, QString> fileNames;
+		for (int j = 0; j < members.size(); j++) {
+			const QString& name = members[j].name;
+			QString fileName;
+			if (!isFolder && name == relName) {
+				fileName = filePath;
+			} else if (isFolder && name.startsWith(relName)) {
+				fileName = QDir::cleanPath(root + name.mid(relName.size()));
+				if (!fileName.startsWith(root)) {
+					continue;
+				}
+			} else {
+				continue;
+			}
+			found = true;
+			if (QFile(fileName).exists()) {
+				LOG_ERROR("ERROR:       "+fileName+" already exists. Skipping");
+				continue;
+			}
+			fileNames.insert(j, fileName);
+			selected << j;
+		}
+
+		QList<ArchiveRange> ranges = group_members(members, selected);
+		for (int j = 0; j < ranges.size(); j++) {
+			if (workItem->WasCanceled()) {
+				break;
+			}
+			const ArchiveRange& range = ranges[j];
+			QByteArray data;
+			try {
+				data = DoGetObjectRange(bucketName, archiveName,
+							range.offset, range.length);
+			}
+			catch (DS3Error& e) {
+				LOG_ERROR("ERROR:       GET OBJECT failed, " +
+					  archiveName + ", " + e.ToString());
+				continue;
+			}
+			for (int k = 0; k < range.members.size(); k++) {
+				int m = range.members[k];
+				if (!SmallFileArchive::ExtractMember(data, range.offset,
+								     members[m],
+								     fileNames.value(m))) {
+					LOG_ERROR("ERROR:       Unable to extract " +
+						  fileNames.value(m) + " from archive " +
+						  archiveName);
+				}
+			}
+		}
+	}
+	return found;
+}
+
+QByteArray
+Client::DoGetObjectRange(const QString& bucketName, const QString& objName,
+			 uint64_t offset, uint64_t length)
+{
+	QByteArray data;
+	if (length == 0) {
+		return data;
 	}
+	ds3_request* request = ds3_init_get_object(bucketName.toUtf8().constData(),
+						   objName.toUtf8().constData(),
+						   length);
+	ds3_request_set_byte_range(request, offset, offset + length - 1);
+	data.reserve(length);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_get_object(client, request,
+					     &data, write_to_buffer);
+	m_clientPool->Return(client);
+	ds3_free_request(request);
+
+	if (ds3Error != NULL) {
+		DS3Error error(ds3Error);
+		ds3_free_error(ds3Error);
+		throw (error);
+	}
+	return data;
 }
 
 void
@@ -579,31 +1278,32 @@ Client::PrepareBulkPuts(BulkPutWorkItem* workItem)
 {
 	LOG_DEBUG("PREPARE BULK PUTS");
 
-	workItem->SetState(Job::PREPARING);
-	Job job = workItem->ToJob();
-	emit JobProgressUpdate(job);
+	// Later pages are prepared while the previous one is transferring
+	if (workItem->GetPage() == NULL) {
+		workItem->SetState(Job::PREPARING);
+		Job job = workItem->ToJob();
+		m_progressPublisher->Publish(job);
+	}
 
 	workItem->ClearObjMap();
+	workItem->ClearFileSizes();
 	QString normPrefix = workItem->GetPrefix();
 	if (!normPrefix.isEmpty()) {
-		normPrefix.replace(QRegularExpression("/$"), "");
-		normPrefix += "/";
+		normPrefix = PathHelper::AddTrailingSlash(normPrefix);
 	}
 
 	for (QList<QUrl>::const_iterator& ui(workItem->GetUrlsIterator());
 	     ui != workItem->GetUrlsConstEnd();
 	     ui++) {
 		if (workItem->WasCanceled()) {
-			DeleteOrRequeueBulkWorkItem(workItem);
+			DeleteOrRequeueBulkWorkItem(workItem, true);
 			return;
 		}
 		QUrl url(*ui);
 
 		QUrl lastUrl = workItem->GetLastProcessedUrl();
 		if (!lastUrl.isEmpty()) {
-			QString lastUrlS = lastUrl.toString();
-			lastUrlS.replace(QRegularExpression("/$"), "");
-			lastUrlS += "/";
+			QString lastUrlS = PathHelper::AddTrailingSlash(lastUrl.toString());
 			if (url.toString().startsWith(lastUrlS)) {
 				// This URL is either the same as or a
 				// descendant of the previously processed URL.
@@ -615,7 +1315,7 @@ Client::PrepareBulkPuts(BulkPutWorkItem* workItem)
 		}
 
 		if (workItem->GetObjMapSize() >= BULK_PAGE_LIMIT) {
-			run(this, &Client::DoBulk, workItem);
+			m_prepExecutor->Run(this, &Client::DoBulk, workItem);
 			return;
 		}
 		QString filePath = url.toLocalFile();
@@ -625,44 +1325,106 @@ Client::PrepareBulkPuts(BulkPutWorkItem* workItem)
 		QFileInfo fileInfo(filePath);
 		QString fileName = fileInfo.fileName();
 		QString objName = normPrefix + fileName;
+		uint64_t fileSize = 0;
+		bool sendObject = true;
+		QList<qint64> blockSizes;
 		if (fileInfo.isDir()) {
 			objName += "/";
 
-			// An existing DirIterator must have been caused by
+			// An existing DirectoryScanner must have been caused by
 			// a previous BulkPut "page" that returned early while
-			// iterating over files under this URL.  Thus, take
-			// over where it left off.
-			QDirIterator* di = workItem->GetDirIterator();
-			if (di == NULL) {
-				di = workItem->GetDirIterator(filePath);
+			// reading the files under this URL.  Thus, take over
+			// where it left off.  The scanner keeps walking the
+			// tree while pages are sent and transferred.
+			DirectoryScanner* scanner = workItem->GetDirectoryScanner();
+			if (scanner == NULL) {
+				if (workItem->GetSyncMode() != Session::NO_SYNC) {
+					StartSync(workItem, objName);
+				}
+				scanner = workItem->StartDirectoryScanner(filePath);
 			}
-			while (di->hasNext()) {
+			DirectoryScanner::Entry entry;
+			while (true) {
 				if (workItem->WasCanceled()) {
-					DeleteOrRequeueBulkWorkItem(workItem);
+					DeleteOrRequeueBulkWorkItem(workItem, true);
 					return;
 				}
 				if (workItem->GetObjMapSize() >= BULK_PAGE_LIMIT) {
-					run(this, &Client::DoBulk, workItem);
+					m_prepExecutor->Run(this, &Client::DoBulk, workItem);
 					return;
 				}
-				QString subFilePath = di->next();
-				QFileInfo subFileInfo = di->fileInfo();
-				QString subFileName = subFilePath;
-				subFileName.replace(QRegularExpression("^" + filePath + "/"), "");
-				QString subObjName = objName + subFileName;
-				if (subFileInfo.isDir()) {
+				if (!scanner->Next(&entry)) {
+					break;
+				}
+				if (workItem->GetSyncManifest() != NULL &&
+				    !SyncEntry(workItem, objName, entry)) {
+					continue;
+				}
+				if (!entry.isDir &&
+				    workItem->PackSmallFile(objName,
+							    entry.relativePath,
+							    entry.path,
+							    entry.size)) {
+					continue;
+				}
+				QString subObjName = objName + entry.relativePath;
+				if (entry.isDir) {
 					subObjName += "/";
 				}
-				workItem->InsertObjMap(subObjName, subFilePath);
+				uint64_t size = entry.size;
+				QList<qint64> blockSizes;
+				if (!entry.isDir && workItem->IsCompressingObjects()) {
+					PrepareCompressedPut(entry.path, &subObjName,
+							     &size, &blockSizes);
+				}
+				if (!workItem->IsObjectDone(subObjName)) {
+					workItem->InsertObjMap(subObjName, entry.path);
+					workItem->InsertFileSize(subObjName, size);
+					if (!blockSizes.isEmpty()) {
+						workItem->InsertBlockSizes(subObjName,
+									   blockSizes);
+					}
+					if (workItem->GetSyncManifest() != NULL) {
+						workItem->InsertSyncedObject(subObjName,
+									     entry.relativePath);
+					}
+				} else if (workItem->GetSyncManifest() != NULL) {
+					workItem->GetSyncManifest()->Commit(entry.relativePath);
+				}
+			}
+			workItem->DeleteDirectoryScanner();
+			SyncManifest* manifest = workItem->GetSyncManifest();
+			uint64_t size;
+			if (manifest != NULL &&
+			    manifest->GetServerObjectSize(objName, &size)) {
+				sendObject = false;
+			}
+			FinishSync(workItem, filePath);
+			if (!workItem->FinishArchive()) {
+				LOG_ERROR("ERROR:       Unable to archive the small files under " +
+					  filePath + ".  Sending them as separate objects.");
+			}
+		} else {
+			fileSize = FileHelper::GetSize(fileInfo);
+			if (workItem->IsCompressingObjects()) {
+				PrepareCompressedPut(filePath, &objName, &fileSize,
+						     &blockSizes);
+			}
+		}
+		if (sendObject && !workItem->IsObjectDone(objName)) {
+			workItem->InsertObjMap(objName, filePath);
+			workItem->InsertFileSize(objName, fileSize);
+			if (!blockSizes.isEmpty()) {
+				workItem->InsertBlockSizes(objName, blockSizes);
 			}
-			workItem->DeleteDirIterator();
 		}
-		workItem->InsertObjMap(objName, filePath);
 		workItem->SetLastProcessedUrl(*ui);
 	}
 
 	if (workItem->GetObjMapSize() > 0) {
-		run(this, &Client::DoBulk, workItem);
+		m_prepExecutor->Run(this, &Client::DoBulk, workItem);
+	} else {
+		DeleteOrRequeueBulkWorkItem(workItem, true);
 	}
 }
 
@@ -671,10 +1433,16 @@ Client::DoBulk(BulkWorkItem* workItem)
 {
 	LOG_DEBUG("DO BULK");
 
-	workItem->SetState(Job::INPROGRESS);
-	workItem->SetTransferStartIfNull();
-	Job job = workItem->ToJob();
-	emit JobProgressUpdate(job);
+	if (workItem->WasCanceled()) {
+		DeleteOrRequeueBulkWorkItem(workItem, true);
+		return;
+	}
+	if (workItem->GetPage() == NULL) {
+		workItem->SetState(Job::INPROGRESS);
+		workItem->SetTransferStartIfNull();
+		Job job = workItem->ToJob();
+		m_progressPublisher->Publish(job);
+	}
 
 	uint64_t numFiles = workItem->GetObjMapSize();
 	ds3_bulk_object_list *bulkObjList = ds3_init_bulk_object_list(numFiles);
@@ -688,13 +1456,16 @@ Client::DoBulk(BulkWorkItem* workItem)
 	     hi++) {
 		ds3_bulk_object* bulkObj = &bulkObjList->list[i];
 		QString objName = hi.key();
-		QString filePath = hi.value();
-		QFileInfo fileInfo(filePath);
 		bulkObj->name = ds3_str_init(objName.toUtf8().constData());
 		if (!isGet) {
+			// The size was found while preparing the page
+			BulkPutWorkItem* putWorkItem = static_cast<BulkPutWorkItem*>(workItem);
 			uint64_t fileSize = 0;
-			if (!fileInfo.isDir()) {
-				fileSize = GetFileSize(filePath);
+			if (!putWorkItem->GetFileSize(objName, &fileSize)) {
+				QFileInfo fileInfo(hi.value());
+				if (!fileInfo.isDir()) {
+					fileSize = FileHelper::GetSize(fileInfo);
+				}
 			}
 			bulkObj->length = fileSize;
 			bulkObj->offset = 0;
@@ -710,11 +1481,11 @@ Client::DoBulk(BulkWorkItem* workItem)
 		request = ds3_init_put_bulk(bucketName.toUtf8().constData(), bulkObjList);
 	}
 	ds3_bulk_response *response = NULL;
-	ds3_error* ds3Error = ds3_bulk(m_client, request, &response);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_bulk(client, request, &response);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 	ds3_free_bulk_object_list(bulkObjList);
-	workItem->SetResponse(response);
-	workItem->SetNumChunksProcessed(0);
 
 	if (ds3Error != NULL) {
 		DS3Error error(ds3Error);
@@ -741,23 +1512,156 @@ Client::DoBulk(BulkWorkItem* workItem)
 			}
 			errorFileMsg += ".  Canceling job.";
 			LOG_ERROR(errorFileMsg);
-			workItem->SetResponse(NULL);
-			DeleteOrRequeueBulkWorkItem(workItem);
+			if (response != NULL) {
+				ds3_free_bulk_response(response);
+			}
+			workItem->ClearObjMap();
+			BulkPutWorkItem* putWorkItem = static_cast<BulkPutWorkItem*>(workItem);
+			putWorkItem->ClearFileSizes();
+			putWorkItem->ClearBlockSizes();
+			DeleteOrRequeueBulkWorkItem(workItem, true);
 			return;
 		}
 	}
 
+	// The page takes over the objects so the next page can be prepared
+	// while this one is being transferred
+	PageWorkItem* page = new PageWorkItem(workItem,
+					      bucketName,
+					      workItem->GetObjMap(),
+					      workItem->GetNumURLsProcessed(),
+					      workItem->GetLastProcessedUrl(),
+					      response);
+	workItem->ClearObjMap();
+	if (isGet) {
+		BulkGetWorkItem* getWorkItem = static_cast<BulkGetWorkItem*>(workItem);
+		page->SetETags(getWorkItem->GetETags());
+		getWorkItem->ClearETags();
+	} else {
+		BulkPutWorkItem* putWorkItem = static_cast<BulkPutWorkItem*>(workItem);
+		putWorkItem->ClearFileSizes();
+		page->SetBlockSizes(putWorkItem->GetBlockSizes());
+		putWorkItem->ClearBlockSizes();
+	}
+
+	JobJournal* journal = workItem->GetJournal();
+	if (journal != NULL) {
+		journal->WritePage(page);
+	}
+
 	if (isGet) {
-		CreateBulkGetDirs(static_cast<BulkGetWorkItem*>(workItem));
+		PrepareRestore(static_cast<BulkGetWorkItem*>(workItem), page);
 	}
 
-	if (response == NULL || (response != NULL && response->list_size == 0)) {
-		DeleteOrRequeueBulkWorkItem(workItem);
+	// workItem can't finish while it has a page so it's safe to start
+	// preparing the next page before transferring this one.
+	bool current = workItem->AddPage(page);
+	DeleteOrRequeueBulkWorkItem(workItem);
+	if (current) {
+		m_transferExecutor->Run(this, &Client::ProcessJobChunk, page);
+	}
+}
+
+void
+Client::StartJournal(BulkWorkItem* workItem)
+{
+	QString fileName = workItem->GetID().toString() + ".journal";
+	JobJournal* journal = new JobJournal(QDir(JobJournal::GetDir()).filePath(fileName));
+	if (!journal->Open()) {
+		LOG_WARNING("WARNING:     Unable to create job journal " +
+			    journal->GetPath() + ".  The job won't be resumable.");
+		delete journal;
 		return;
 	}
+	journal->WriteJob(workItem);
+	workItem->SetJournal(journal);
+}
 
-	ProcessJobChunk(workItem);
-	LOG_INFO("BULK JOB     Complete");
+// Re-attach to the DS3 jobs of the pages that were created but hadn't
+// finished when the application exited.  The server still knows which of
+// their chunks are left.
+void
+Client::ResumeBulk(BulkWorkItem* workItem)
+{
+	LOG_DEBUG("RESUME BULK");
+
+	JobJournal* journal = workItem->GetJournal();
+	const QList<JobJournal::Page>& journalPages = journal->GetPages();
+	QList<PageWorkItem*> pages;
+	for (int i = 0; i < journalPages.size(); i++) {
+		const JobJournal::Page& journalPage = journalPages[i];
+		ds3_request* request = ds3_init_get_job(journalPage.jobID.toUtf8().constData());
+		ds3_bulk_response* response = NULL;
+		ds3_client* client = m_clientPool->Checkout();
+		ds3_error* ds3Error = ds3_get_job(client, request, &response);
+		m_clientPool->Return(client);
+		ds3_free_request(request);
+
+		if (ds3Error != NULL) {
+			DS3Error error(ds3Error);
+			ds3_free_error(ds3Error);
+			LOG_ERROR("ERROR:       Unable to resume job " +
+				  journalPage.jobID + ", " + error.ToString() +
+				  ".  Starting the page over.");
+			break;
+		}
+		PageWorkItem* page = new PageWorkItem(workItem,
+						      journalPage.bucketName,
+						      journalPage.objMap,
+						      journalPage.numURLsProcessed,
+						      journalPage.lastProcessedUrl,
+						      response);
+		page->SetDone(journalPage.chunksDone, journalPage.blobsDone);
+		page->SetETags(journalPage.etags);
+		pages << page;
+	}
+
+	bool isGet = workItem->GetType() == Job::GET;
+	if (pages.size() < journalPages.size()) {
+		qDeleteAll(pages);
+		// Start over from the end of the last finished page.  GET
+		// files of the unfinished pages could be incomplete and would
+		// otherwise be skipped since they already exist.
+		if (isGet) {
+			for (int i = 0; i < journalPages.size(); i++) {
+				const QHash<QString, QString>& objMap = journalPages[i].objMap;
+				QHash<QString, QString>::const_iterator hi;
+				for (hi = objMap.constBegin();
+				     hi != objMap.constEnd();
+				     hi++) {
+					if (QFileInfo(hi.value()).isFile()) {
+						QFile::remove(hi.value());
+					}
+					QFile::remove(hi.value() + ObjectDecompressor::PART_SUFFIX);
+				}
+			}
+		}
+		workItem->Resume(journal, false);
+		if (isGet) {
+			PrepareBulkGets(static_cast<BulkGetWorkItem*>(workItem));
+		} else {
+			PrepareBulkPuts(static_cast<BulkPutWorkItem*>(workItem));
+		}
+		return;
+	}
+
+	workItem->SetState(Job::INPROGRESS);
+	workItem->SetTransferStartIfNull();
+	Job job = workItem->ToJob();
+	m_progressPublisher->Publish(job);
+
+	PageWorkItem* current = NULL;
+	for (int i = 0; i < pages.size(); i++) {
+		if (isGet) {
+			PrepareRestore(static_cast<BulkGetWorkItem*>(workItem),
+				       pages[i]);
+		}
+		if (workItem->AddPage(pages[i])) {
+			current = pages[i];
+		}
+	}
+	DeleteOrRequeueBulkWorkItem(workItem);
+	m_transferExecutor->Run(this, &Client::ProcessJobChunk, current);
 }
 
 void
@@ -772,98 +1676,578 @@ Client::CreateBulkGetDirs(BulkGetWorkItem* workItem)
 	workItem->ClearDirsToCreate();
 }
 
+// Runs on PrepareRestore's thread pool
+static void
+create_dirs(const QStringList& dirs)
+{
+	QDir root;
+	for (int i = 0; i < dirs.size(); i++) {
+		if (!root.mkpath(dirs[i])) {
+			LOG_ERROR("ERROR:       Unable to create directory " + dirs[i]);
+		}
+	}
+}
+
+// Runs on PrepareRestore's thread pool
+static void
+preallocate_files(const QList<QPair<QString, qint64> >& files)
+{
+	for (int i = 0; i < files.size(); i++) {
+		QFile file(files[i].first);
+		if (!file.open(QIODevice::ReadWrite) ||
+		    !FileHelper::Preallocate(&file, files[i].second)) {
+			LOG_ERROR("ERROR:       GET OBJECT unable to allocate file " +
+				  files[i].first);
+		}
+	}
+}
+
 void
-Client::ProcessJobChunk(BulkWorkItem* workItem)
+Client::PrepareRestore(BulkGetWorkItem* workItem, PageWorkItem* page)
 {
-	LOG_DEBUG("PROCESS GET  JOB CHUNK");
+	QSet<QString> dirSet;
+	for (int i = 0; i < workItem->GetDirsToCreateSize(); i++) {
+		dirSet << QDir::cleanPath(workItem->GetDirsToCreateAt(i));
+	}
+	workItem->ClearDirsToCreate();
 
-	// If the get available chunks response doesn't include any objects, it
-	// means the server isn't ready yet (e.g. it could still be transferring
-	// objects off tape and into cache).  In this situation, we have to
-	// wait and try again.
-	ds3_get_available_chunks_response* chunksResponse = NULL;
-	size_t numChunks = 0;
-	while (numChunks == 0) {
-		if (workItem->WasCanceled()) {
-			ds3_free_available_chunks_response(chunksResponse);
-			DeleteOrRequeueBulkWorkItem(workItem);
-			return;
+	QList<QPair<QString, qint64> > files;
+	QHash<QString, QString>::const_iterator oi;
+	for (oi = page->GetObjMapConstBegin();
+	     oi != page->GetObjMapConstEnd();
+	     oi++) {
+		if (oi.key().endsWith("/")) {
+			dirSet << QDir::cleanPath(oi.value());
+			continue;
+		}
+		dirSet << QFileInfo(oi.value()).absolutePath();
+		bool decompress;
+		QString downloadName = GetDownloadName(page, oi.key(),
+						       oi.value(), &decompress);
+		uint64_t size;
+		if (!decompress && page->StartPreallocation(oi.key(), &size)) {
+			files << qMakePair(downloadName, (qint64)size);
+		}
+	}
+
+	// mkpath creates the parents of a directory anyway so only the
+	// directories that aren't the parent of another one are needed
+	QStringList dirs = dirSet.toList();
+	dirs.sort();
+	QStringList leafDirs;
+	for (int i = 0; i < dirs.size(); i++) {
+		if (i + 1 < dirs.size() && dirs[i + 1].startsWith(dirs[i] + "/")) {
+			continue;
+		}
+		leafDirs << dirs[i];
+	}
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(RESTORE_PREP_THREADS);
+	QList<QStringList> dirSlices;
+	for (int i = 0; i < leafDirs.size(); i++) {
+		if (dirSlices.size() < RESTORE_PREP_THREADS) {
+			dirSlices << QStringList();
+		}
+		dirSlices[i % RESTORE_PREP_THREADS] << leafDirs[i];
+	}
+	for (int i = 0; i < dirSlices.size(); i++) {
+		QtConcurrent::run(&pool, create_dirs, dirSlices[i]);
+	}
+	pool.waitForDone();
+
+	// Every file's directory exists now
+	QList<QList<QPair<QString, qint64> > > fileSlices;
+	for (int i = 0; i < files.size(); i++) {
+		if (fileSlices.size() < RESTORE_PREP_THREADS) {
+			fileSlices << QList<QPair<QString, qint64> >();
+		}
+		fileSlices[i % RESTORE_PREP_THREADS] << files[i];
+	}
+	for (int i = 0; i < fileSlices.size(); i++) {
+		QtConcurrent::run(&pool, preallocate_files, fileSlices[i]);
+	}
+	pool.waitForDone();
+	LOG_DEBUG("PREPARE RESTORE created " + QString::number(leafDirs.size()) +
+		  " directories and allocated " + QString::number(files.size()) +
+		  " files");
+}
+
+QString
+Client::GetDownloadName(PageWorkItem* page, const QString& object,
+			const QString& fileName, bool* decompress)
+{
+	// A compressed object that's in a single blob is decompressed as it
+	// downloads.  Otherwise its blobs can arrive in any order so they're
+	// saved as is and the whole object is decompressed once they're in.
+	bool compressed = ObjectCompressor::IsCompressed(object);
+	*decompress = compressed && page->IsSingleBlob(object);
+	if (compressed && !*decompress) {
+		return fileName + ObjectDecompressor::PART_SUFFIX;
+	}
+	return fileName;
+}
+
+void
+Client::StartSync(BulkPutWorkItem* workItem, const QString& dirObjName)
+{
+	QString bucketName = workItem->GetBucketName();
+	QString path = SyncManifest::GetPath(m_host, bucketName, dirObjName);
+	SyncManifest* manifest = workItem->StartSyncManifest(path);
+	if (manifest == NULL) {
+		LOG_WARNING("WARNING:     Unable to open sync manifest " + path +
+			    ".  Uploading every file under " + dirObjName + ".");
+		return;
+	}
+
+	// Page through every object under the directory, not just its
+	// immediate children.  This bypasses the listing cache since
+	// skipping a file that another client just deleted would lose it.
+	manifest->ClearServerObjects();
+	QString marker;
+	try {
+		bool truncated = true;
+		while (truncated) {
+			if (workItem->WasCanceled()) {
+				break;
+			}
+			ds3_get_bucket_response* response;
+			response = DoGetBucket(bucketName, dirObjName, "",
+					       marker, true);
+			for (size_t i = 0; i < response->num_objects; i++) {
+				ds3_object* object = &response->objects[i];
+				marker = QString::fromUtf8(object->name->value);
+				manifest->AddServerObject(marker, object->size);
+			}
+			if (response->next_marker != NULL) {
+				marker = QString::fromUtf8(response->next_marker->value);
+			}
+			truncated = response->is_truncated && !marker.isEmpty();
+			ds3_free_bucket_response(response);
 		}
+	}
+	catch (DS3Error& e) {
+		LOG_WARNING("WARNING:     Unable to list " + bucketName + "/" +
+			    dirObjName + " (" + e.ToString() +
+			    ").  Uploading every file under it.");
+		workItem->DeleteSyncManifest();
+		return;
+	}
+	if (!manifest->Flush()) {
+		workItem->DeleteSyncManifest();
+	}
+}
+
+bool
+Client::SyncEntry(BulkPutWorkItem* workItem, const QString& dirObjName,
+		  const DirectoryScanner::Entry& entry)
+{
+	SyncManifest* manifest = workItem->GetSyncManifest();
+	QString objName = dirObjName + entry.relativePath;
+	uint64_t serverSize;
+	if (entry.isDir) {
+		return !manifest->GetServerObjectSize(objName + "/", &serverSize);
+	}
+
+	// The file's record is only committed once it's known to be on the
+	// server, either already or after it's sent
+	SyncManifest::Status status = manifest->Compare(entry.relativePath,
+							entry.path,
+							entry.size,
+							entry.modified);
+	// The file could have been sent compressed or not
+	QString serverName = objName;
+	if (!manifest->GetServerObjectSize(serverName, &serverSize)) {
+		serverName += ObjectCompressor::SUFFIX;
+		if (!manifest->GetServerObjectSize(serverName, &serverSize)) {
+			return true;
+		}
+	}
+	// A file that isn't in the manifest yet was likely uploaded before
+	// syncing was turned on
+	if (status == SyncManifest::UNCHANGED ||
+	    (status == SyncManifest::NEW && serverName == objName &&
+	     serverSize == entry.size)) {
+		manifest->Commit(entry.relativePath);
+		return false;
+	}
+	if (!DeleteChangedObject(workItem->GetBucketName(), serverName)) {
+		// Left as it was so the file is tried again next time
+		manifest->Discard(entry.relativePath);
+		return false;
+	}
+	return true;
+}
+
+void
+Client::FinishSync(BulkPutWorkItem* workItem, const QString& filePath)
+{
+	SyncManifest* manifest = workItem->GetSyncManifest();
+	if (manifest == NULL) {
+		return;
+	}
+	LOG_INFO("SYNC         " + filePath + ", " +
+		 QString::number(manifest->GetNumUnchanged()) +
+		 " unchanged files skipped");
+	workItem->FinishSyncManifest();
+}
+
+bool
+Client::DeleteChangedObject(const QString& bucketName, const QString& objName)
+{
+	LOG_INFO("DELETE       OBJECT    " + bucketName + "/" + objName +
+		 " to replace it");
+	ds3_request* request = ds3_init_delete_object(bucketName.toUtf8().constData(),
+						      objName.toUtf8().constData());
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_delete_object(client, request);
+	m_clientPool->Return(client);
+	ds3_free_request(request);
+	m_listingCache->Invalidate(bucketName, objName);
+
+	if (ds3Error != NULL) {
+		DS3Error error(ds3Error);
+		ds3_free_error(ds3Error);
+		LOG_ERROR("ERROR:       Unable to replace changed object " +
+			  bucketName + "/" + objName + ", " + error.ToString());
+		return false;
+	}
+	return true;
+}
+
+void
+Client::PrepareCompressedPut(const QString& filePath, QString* objName,
+			     uint64_t* size, QList<qint64>* blockSizes)
+{
+	ObjectCompressor compressor(filePath, m_codecExecutor);
+	uint64_t compressedSize;
+	if (!compressor.GetCompressedSize(&compressedSize)) {
+		LOG_WARNING("WARNING:     Unable to compress " + filePath +
+			    ".  Sending it uncompressed.");
+		return;
+	}
+	// Already compressed data, or a file too small for compression to
+	// make up for the gzip headers, is stored as is so GETs don't have
+	// to decompress it
+	if (compressedSize >= *size) {
+		LOG_DEBUG("PREPARE COMPRESSED PUT " + filePath +
+			  " doesn't compress.  Sending it uncompressed.");
+		return;
+	}
+	*objName += ObjectCompressor::SUFFIX;
+	*size = compressedSize;
+	*blockSizes = compressor.GetBlockSizes();
+}
+
+bool
+Client::FinishGetObject(const QString& object, const QString& fileName)
+{
+	QString partName = fileName + ObjectDecompressor::PART_SUFFIX;
+	if (ObjectCompressor::IsCompressed(object) && QFile::exists(partName)) {
+		if (!ObjectDecompressor::DecompressFile(partName, fileName)) {
+			LOG_ERROR("ERROR:       GET OBJECT unable to decompress "+object);
+			return false;
+		}
+		QFile::remove(partName);
+	}
+	if (SmallFileArchive::IsArchive(object)) {
+		return ExtractArchive(fileName);
+	}
+	return true;
+}
+
+void
+Client::FinishPutObject(PageWorkItem* page, const QString& object)
+{
+	BulkWorkItem* workItem = page->GetBulkWorkItem();
+	static_cast<BulkPutWorkItem*>(workItem)->FinishSyncedObject(object);
+}
+
+// The checksum header has to be sent before the blob's data so the blob is
+// read once for it up front.  With a memory-mapped file that's a pass over
+// pages that the upload then reuses.
+void
+Client::SetPutChecksum(ObjectWorkItem* objWorkItem, ds3_request* request,
+		       uint64_t length)
+{
+	Checksum checksum(m_checksumType);
+	if (!objWorkItem->ComputeChecksum(&checksum, length)) {
+		LOG_WARNING("WARNING:     Unable to compute the checksum of " +
+			    objWorkItem->GetObjectName() +
+			    ".  Sending it without one.");
+		return;
+	}
+	QByteArray value = checksum.GetResult().toBase64();
+	if (m_checksumType == Session::CRC32C_CHECKSUM) {
+		ds3_request_set_crc32c(request, value.constData());
+	} else {
+		ds3_request_set_md5(request, value.constData());
+	}
+}
+
+bool
+Client::ExtractArchive(const QString& fileName)
+{
+	QStringList skipped;
+	QString dir = QFileInfo(fileName).absolutePath();
+	if (!SmallFileArchive::Extract(fileName, dir, &skipped)) {
+		LOG_ERROR("ERROR:       Unable to extract archive " + fileName);
+		return false;
+	}
+	for (int i = 0; i < skipped.size(); i++) {
+		LOG_ERROR("ERROR:       " + QDir(dir).filePath(skipped[i]) +
+			  " already exists. Skipping");
+	}
+	QFile::remove(fileName);
+	return true;
+}
+
+void
+Client::ProcessJobChunk(PageWorkItem* page)
+{
+	LOG_DEBUG("PROCESS GET  JOB CHUNK");
+
+	BulkWorkItem* workItem = page->GetBulkWorkItem();
+
+	// Start the transfer threads right away.  They take objects out of
+	// chunkWorkItem as soon as the chunks they belong to are added below.
+	// Since the blobs of a large object are spread across several chunks,
+	// a single object can be downloaded by several threads at once.
+	ChunkWorkItem chunkWorkItem;
+	size_t numChunksDone = chunkWorkItem.SkipChunks(page->GetResponse(),
+							page->GetChunksDone());
+	page->IncNumChunksProcessed(numChunksDone);
+	QThreadPool* pool = workItem->GetTransferThreadPool();
+	uint64_t numThreads = qMin((uint64_t)pool->maxThreadCount(),
+				   qMax((uint64_t)1, page->GetNumBlobs()));
+	QList<QFuture<void> > transfers;
+	for (uint64_t i = 0; i < numThreads; i++) {
+		transfers << run(pool, this, &Client::TransferObjects,
+				 page, &chunkWorkItem);
+	}
+
+	// Keep asking the server for the next chunks while the current ones
+	// are still transferring so the transfer threads never sit idle
+	// waiting on the next round trip.  If the get available chunks
+	// response doesn't include any new chunks, it means the server isn't
+	// ready yet (e.g. it could still be transferring objects off tape and
+	// into cache).
+	size_t numChunks = page->GetResponse()->list_size;
+	while (chunkWorkItem.GetNumChunks() < numChunks &&
+	       !workItem->WasCanceled()) {
 		uint64_t retryAfter = 60;
-		QString errMsg;
+		size_t numAdded = 0;
 		try {
-			chunksResponse = GetAvailableJobChunks(workItem);
-			numChunks = chunksResponse->object_list->list_size;
+			ds3_get_available_chunks_response* chunksResponse;
+			chunksResponse = GetAvailableJobChunks(page);
 			retryAfter = chunksResponse->retry_after;
+			size_t numEmptyChunks = 0;
+			numAdded = chunkWorkItem.AddChunks(chunksResponse,
+							   &numEmptyChunks);
+			page->IncNumChunksProcessed(numEmptyChunks);
 		}
 		catch (DS3Error& e) {
 			LOG_ERROR("ERROR:       GET JOB CHUNKS failed, "+e.ToString());
+		}
+		if (numAdded > 0) {
+			LOG_DEBUG("Queued " + QString::number(numAdded) +
+				  " job chunks");
+		}
+		if (chunkWorkItem.GetNumChunks() < numChunks) {
+			WaitForJobChunks(workItem, &chunkWorkItem, retryAfter);
+		}
+	}
+
+	chunkWorkItem.Close();
+	for (int i = 0; i < transfers.size(); i++) {
+		transfers[i].waitForFinished();
+	}
 
+	if (workItem->GetType() == Job::GET && !workItem->WasCanceled()) {
+		QStringList objNames = page->GetUnfinishedObjects();
+		for (int i = 0; i < objNames.size(); i++) {
+			int numBlobs = page->GetUnfinishedBlobs(objNames[i]).size();
+			LOG_ERROR("ERROR:       GET OBJECT incomplete, "+objNames[i]+
+				  " - "+QString::number(numBlobs)+
+				  " blob(s) not downloaded");
 		}
-		if (numChunks == 0) {
-			ds3_free_available_chunks_response(chunksResponse);
-			LOG_INFO("BULK GET     JOB CHUNK Not ready. Sleeping for " +
-				  QString::number(retryAfter) + " seconds.");
-			QThread::sleep(retryAfter);
+	}
+
+	if (!workItem->WasCanceled()) {
+		if (page->IsFinished()) {
+			JobJournal* journal = workItem->GetJournal();
+			if (journal != NULL) {
+				journal->WritePageDone(page->GetJobID());
+			}
+			LOG_INFO("BULK JOB     Complete");
+		} else {
+			LOG_DEBUG("Page not finished. num chunks processed: " +
+				  QString::number(page->GetNumChunksProcessed()));
 		}
 	}
 
-	QString bucketName = workItem->GetBucketName();
+	// The next page was most likely created while this one was being
+	// transferred.  Don't touch workItem after starting it since it
+	// could finish, and delete workItem, at any time.
+	PageWorkItem* nextPage = workItem->FinishPage();
+	DeleteOrRequeueBulkWorkItem(workItem);
+	if (nextPage != NULL) {
+		m_transferExecutor->Run(this, &Client::ProcessJobChunk, nextPage);
+	}
+}
+
+// Wait before asking the server for more job chunks.  As long as objects are
+// still being transferred, the server is asked again as soon as one of the
+// chunks finishes (and thus frees up cache) or CHUNK_POLL_INTERVAL elapses.
+// Otherwise, wait the retryAfter seconds the server asked for.
+void
+Client::WaitForJobChunks(BulkWorkItem* workItem,
+			 ChunkWorkItem* chunkWorkItem,
+			 uint64_t retryAfter)
+{
+	if (chunkWorkItem->GetNumActiveChunks() > 0) {
+		chunkWorkItem->WaitForFinishedChunk(CHUNK_POLL_INTERVAL);
+		return;
+	}
+
+	// Before the first chunk, retry after only means the server is still
+	// staging the job.  Past that, it means the server ran out of cache
+	// for our transfers.
+	if (chunkWorkItem->GetNumChunks() > 0) {
+		workItem->GetTransferController()->ReportRetryAfter(retryAfter);
+		m_transferController->ReportRetryAfter(retryAfter);
+	}
+
+	LOG_INFO("BULK GET     JOB CHUNK Not ready. Sleeping for " +
+		  QString::number(retryAfter) + " seconds.");
+	for (uint64_t i = 0; i < retryAfter; i++) {
+		if (workItem->WasCanceled()) {
+			return;
+		}
+		QThread::sleep(1);
+	}
+}
+
+void
+Client::TransferObjects(PageWorkItem* page, ChunkWorkItem* chunkWorkItem)
+{
+	BulkWorkItem* workItem = page->GetBulkWorkItem();
+	QString bucketName = page->GetBucketName();
+	QString jobID = page->GetJobID();
 	bool isGet = workItem->GetType() == Job::GET;
 	QString op = isGet ? "GET" : "PUT";
-	// TODO PUT multiple objects at once.  Start the next chunk as soon
-	//      as the number of objects left to put is less than the size
-	//      of the "put objects" thread pool.
-	ds3_bulk_response* bulkResponse = chunksResponse->object_list;
-	for (size_t chunk = 0; chunk < numChunks; chunk++) {
-		ds3_bulk_object_list* list = bulkResponse->list[chunk];
-		for (uint64_t i = 0; i < list->size;  i++) {
-			if (workItem->WasCanceled()) {
-				DeleteOrRequeueBulkWorkItem(workItem);
-				return;
-			}
-			ds3_bulk_object* bulkObj = &(list->list[i]);
-			QString objName = QString::fromUtf8(bulkObj->name->value);
-			QString filePath = workItem->GetObjMapValue(objName);
-			uint64_t offset = bulkObj->offset;
-			try {
-				if (isGet) {
-					Client::GetObject(bucketName, objName,
-							  filePath, offset,
-							  static_cast<BulkGetWorkItem*>(workItem));
+	JobJournal* journal = workItem->GetJournal();
+	ds3_bulk_object* bulkObj;
+	size_t chunk;
+	while (chunkWorkItem->TakeNextObject(&bulkObj, &chunk)) {
+		if (workItem->WasCanceled()) {
+			break;
+		}
+		QString objName = QString::fromUtf8(bulkObj->name->value);
+		QString filePath = page->GetObjMapValue(objName);
+		uint64_t offset = bulkObj->offset;
+		uint64_t length = bulkObj->length;
+		// Whether the blob itself succeeded, and whether it counts as
+		// transferred, which a blob that was canceled midway doesn't
+		bool succeeded = false;
+		bool transferred = false;
+		bool acquired = false;
+		try {
+			if (page->IsBlobDone(objName, offset)) {
+				// Transferred before the job was resumed
+				if (page->FinishBlob(objName, offset)) {
+					if (isGet) {
+						FinishGetObject(objName, filePath);
+					} else {
+						FinishPutObject(page, objName);
+					}
+				}
+				succeeded = true;
+			} else if (!AcquireTransfer(workItem)) {
+				// Canceled while waiting for a transfer slot
+				break;
+			} else if (isGet) {
+				acquired = true;
+				succeeded = GetObject(bucketName, objName, filePath,
+						      offset, length, page);
+				if (succeeded) {
 					LOG_FILE(QString("     GET     OBJECT    ")+"/"+bucketName+"/"+objName+"->"+filePath);
-				} else {
-					uint64_t length = bulkObj->length;
-					Client::PutObject(bucketName, objName,
-							  filePath, offset,
-							  length,
-							  static_cast<BulkPutWorkItem*>(workItem));
+				}
+			} else {
+				acquired = true;
+				succeeded = PutObject(bucketName, objName, filePath,
+						      offset, length, page);
+				if (succeeded) {
 					LOG_FILE(QString("     PUT     OBJECT    ")+filePath+"->"+"/"+bucketName+"/"+objName);
 				}
 			}
-			catch (DS3Error& e) {
-				LOG_ERROR("ERROR:       " + op + " OBJECT failed, "+objName+
-					  "\" - "+e.ToString());
+			// Only blobs that are really on the server, or on disk,
+			// are journaled so the others are retried on resume
+			transferred = succeeded && !workItem->WasCanceled();
+		}
+		catch (DS3Error& e) {
+			LOG_ERROR("ERROR:       " + op + " OBJECT failed, "+objName+
+				  "\" - "+e.ToString());
+		}
+		// The controllers see every failure, including the ones on
+		// this side, but not the transfers that cancellation aborted
+		if (acquired) {
+			ReleaseTransfer(workItem, succeeded ? length : 0,
+					succeeded || workItem->WasCanceled());
+		}
+		if (transferred && journal != NULL) {
+			journal->WriteBlob(jobID, objName, offset);
+		}
+		if (transferred && !isGet && page->FinishBlob(objName, offset)) {
+			FinishPutObject(page, objName);
+		}
+		if (chunkWorkItem->FinishObject(chunk, transferred)) {
+			page->IncNumChunksProcessed();
+			// Chunks with failed objects aren't recorded so they'll
+			// be retried if the job is resumed.
+			if (journal != NULL && !chunkWorkItem->DidChunkFail(chunk)) {
+				journal->WriteChunk(jobID, chunkWorkItem->GetChunkID(chunk));
 			}
 		}
-		workItem->IncNumChunksProcessed();
 	}
-	ds3_free_available_chunks_response(chunksResponse);
+}
 
-	if (workItem->IsPageFinished()) {
-		DeleteOrRequeueBulkWorkItem(workItem);
-	} else {
-		run(this, &Client::ProcessJobChunk, workItem);
+// Wait for both the job's and the session's transfer controllers to allow
+// another transfer.  Returns false if the job was canceled while waiting.
+bool
+Client::AcquireTransfer(BulkWorkItem* workItem)
+{
+	ConcurrencyController* jobController = workItem->GetTransferController();
+	while (!jobController->Acquire(CHUNK_POLL_INTERVAL)) {
+		if (workItem->WasCanceled()) {
+			return false;
+		}
+	}
+	while (!m_transferController->Acquire(CHUNK_POLL_INTERVAL)) {
+		if (workItem->WasCanceled()) {
+			jobController->Release();
+			return false;
+		}
 	}
+	return true;
+}
+
+void
+Client::ReleaseTransfer(BulkWorkItem* workItem, uint64_t bytes, bool succeeded)
+{
+	m_transferController->Release(bytes, succeeded);
+	workItem->GetTransferController()->Release(bytes, succeeded);
 }
 
 ds3_get_available_chunks_response*
-Client::GetAvailableJobChunks(BulkWorkItem* workItem)
+Client::GetAvailableJobChunks(PageWorkItem* page)
 {
-	ds3_bulk_response *response = workItem->GetResponse();
+	ds3_bulk_response *response = page->GetResponse();
 	ds3_request* request = ds3_init_get_available_chunks(response->job_id->value);
 	ds3_get_available_chunks_response* chunkResponse;
-	ds3_error* ds3Error = ds3_get_available_chunks(m_client, request, &chunkResponse);
+	ds3_client* client = m_clientPool->Checkout();
+	ds3_error* ds3Error = ds3_get_available_chunks(client, request, &chunkResponse);
+	m_clientPool->Return(client);
 	ds3_free_request(request);
 
 	if (ds3Error != NULL) {
@@ -876,37 +2260,55 @@ Client::GetAvailableJobChunks(BulkWorkItem* workItem)
 }
 
 void
-Client::DeleteOrRequeueBulkWorkItem(BulkWorkItem* workItem)
+Client::DeleteOrRequeueBulkWorkItem(BulkWorkItem* workItem, bool donePreparing)
 {
-	if (workItem->WasCanceled()) {
-		LOG_INFO("BULK GET     JOB       Canceled");
-		workItem->SetState(Job::CANCELED);
-		Job job = workItem->ToJob();
-		emit JobProgressUpdate(job);
-		DeleteBulkWorkItem(workItem);
-	} else if (workItem->IsPageFinished()) {
-		if (workItem->IsFinished()) {
+	BulkWorkItem::PageAction action = workItem->NextPageAction(donePreparing);
+	if (action == BulkWorkItem::PREPARE_PAGE) {
+		LOG_DEBUG("More bulk pages to go.  Starting PrepareBulk{Gets,Puts} again.");
+		if (workItem->GetType() == Job::GET) {
+			m_prepExecutor->Run(this,
+					    &Client::PrepareBulkGets,
+					    static_cast<BulkGetWorkItem*>(workItem));
+		} else {
+			m_prepExecutor->Run(this,
+					    &Client::PrepareBulkPuts,
+					    static_cast<BulkPutWorkItem*>(workItem));
+		}
+	} else if (action == BulkWorkItem::FINISH_WORK_ITEM) {
+		if (workItem->GetType() == Job::PUT) {
+			// The synced files' records are written out before
+			// the job is seen as done
+			static_cast<BulkPutWorkItem*>(workItem)->DeleteSyncManifests();
+		}
+		JobJournal* journal = workItem->GetJournal();
+		if (workItem->WasCanceled()) {
+			LOG_INFO("BULK GET     JOB       Canceled");
+			workItem->SetState(Job::CANCELED);
+			if (journal != NULL && !workItem->WasInterrupted()) {
+				journal->Remove();
+			}
+		} else {
 			LOG_DEBUG("Finished with bulk work item.  Deleting it.");
 			workItem->SetState(Job::FINISHED);
-			Job job = workItem->ToJob();
-			emit JobProgressUpdate(job);
-			DeleteBulkWorkItem(workItem);
-		} else {
-			LOG_DEBUG("More bulk pages to go.  Starting PrepareBulk{Gets,Puts} again.");
-			if (workItem->GetType() == Job::GET) {
-				run(this,
-				    &Client::PrepareBulkGets,
-				    static_cast<BulkGetWorkItem*>(workItem));
-			} else {
-				run(this,
-				    &Client::PrepareBulkPuts,
-				    static_cast<BulkPutWorkItem*>(workItem));
+			if (journal != NULL) {
+				journal->Remove();
 			}
 		}
-	} else {
-		LOG_DEBUG("Page not finished. num chunks processed: " +
-			  QString::number(workItem->GetNumChunksProcessed()));
+		Job job = workItem->ToJob();
+		m_progressPublisher->Publish(job);
+		DeleteBulkWorkItem(workItem);
+	}
+}
+
+void
+Client::PrepareObjectFile(ObjectWorkItem* objWorkItem,
+			  uint64_t offset, uint64_t length)
+{
+	if (m_fileIOMode == Session::MAPPED_FILE_IO &&
+	    objWorkItem->MapFile(offset, length)) {
+		return;
 	}
+	objWorkItem->SeekFile(offset);
 }
 
 void
@@ -918,31 +2320,6 @@ Client::DeleteBulkWorkItem(BulkWorkItem* workItem)
 	m_bulkWorkItemsLock.unlock();
 }
 
-qint64
-Client::GetFileSize(const QString& path)
-{
-	qint64 size = 0;
-#ifdef Q_OS_WIN
-	// There's a bug with QFileInfo::size() where it will report the size
-	// of a shortcut's target instead of the actual shortcut.
-	// See https://bugreports.qt.io/browse/QTBUG-24831
-	WIN32_FILE_ATTRIBUTE_DATA data;
-	QString nativePath = QDir::toNativeSeparators(path);
-	bool ok = GetFileAttributesEx((wchar_t*)nativePath.utf16(),
-				      GetFileExInfoStandard, &data);
-	if (ok) {
-		size = data.nFileSizeHigh;
-		size <<= 32;
-		size += data.nFileSizeLow;
-	} else {
-		LOG_ERROR("ERROR:       GET FILE SIZE failed for "+nativePath);
-	}
-#else
-	size = QFileInfo(path).size();
-#endif
-	return size;
-}
-
 static size_t
 read_from_file(void* buffer, size_t size, size_t count, void* user_data)
 {
@@ -962,9 +2339,12 @@ Client::ReadFile(ObjectWorkItem* workItem, char* buffer,
 	}
 
 	size_t bytesRead = workItem->ReadFile(buffer, size, count);
-	if (bulkWorkItem != NULL && bulkWorkItem->IsJobUpdateReady()) {
+	if (bytesRead == 0 && workItem->HasCodecError()) {
+		return DS3_READFUNC_ABORT;
+	}
+	if (bulkWorkItem != NULL && workItem->IsJobUpdateReady()) {
 		Job job = bulkWorkItem->ToJob();
-		emit JobProgressUpdate(job);
+		m_progressPublisher->Publish(job);
 	}
 	return bytesRead;
 }
@@ -978,6 +2358,16 @@ write_to_file(void* buffer, size_t size, size_t count, void* user_data)
 	return client->WriteFile(workItem, (char*)buffer, size, count);
 }
 
+// Collects the data of a GET that's read into memory in the QByteArray
+// that user_data points to
+static size_t
+write_to_buffer(void* buffer, size_t size, size_t count, void* user_data)
+{
+	QByteArray* data = static_cast<QByteArray*>(user_data);
+	data->append((const char*)buffer, size * count);
+	return size * count;
+}
+
 size_t
 Client::WriteFile(ObjectWorkItem* workItem, char* buffer,
 		  size_t size, size_t count)
@@ -988,9 +2378,9 @@ Client::WriteFile(ObjectWorkItem* workItem, char* buffer,
 	}
 
 	size_t bytesWritten = workItem->WriteFile(buffer, size, count);
-	if (bulkWorkItem != NULL && bulkWorkItem->IsJobUpdateReady()) {
+	if (bulkWorkItem != NULL && workItem->IsJobUpdateReady()) {
 		Job job = bulkWorkItem->ToJob();
-		emit JobProgressUpdate(job);
+		m_progressPublisher->Publish(job);
 	}
 	return bytesWritten;
 }
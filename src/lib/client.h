@@ -17,25 +17,37 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include <QByteArray>
 #include <QFuture>
 #include <QHash>
 #include <QList>
 #include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
 #include <QUuid>
 #include <QUrl>
 
 #include <ds3.h>
 
+#include "lib/directory_scanner.h"
 #include "lib/errors/ds3_error.h"
 #include "models/job.h"
+#include "models/session.h"
 
 class BulkWorkItem;
 class BulkGetWorkItem;
 class BulkPutWorkItem;
+class ChunkWorkItem;
+class ConcurrencyController;
+class DS3ClientPool;
+class Executor;
+class JobProgressPublisher;
+class ListingCache;
+class ListingPage;
 class ObjectWorkItem;
-class Session;
+class PageWorkItem;
+struct Listing;
 
 class Client : public QObject
 {
@@ -45,14 +57,35 @@ public:
 	static const QString DELIMITER;
 	static const uint64_t BULK_PAGE_LIMIT;
 	static const uint32_t MAX_KEYS;
+	static const unsigned long CHUNK_POLL_INTERVAL;
+	static const int CLIENT_POOL_IDLE_TIMEOUT;
+	static const int CLIENT_POOL_SPARE_CLIENTS;
+	static const int MAX_CLIENTS_PER_HOST;
+	static const int MAX_TRANSFERS_PER_JOB;
+	static const int METADATA_THREADS;
+	static const int PREP_THREADS;
+	static const int TRANSFER_THREADS;
+	static const int RESTORE_PREP_THREADS;
 
 	Client(const Session* session);
 	~Client();
 
 	QString GetEndpoint() const;
+	const DS3ClientPool* GetClientPool() const;
+	const Executor* GetMetadataExecutor() const;
+	const Executor* GetPrepExecutor() const;
+	const Executor* GetTransferExecutor() const;
 
 	int GetNumActiveJobs() const;
+	// Cancel all jobs because the application is closing.  Their
+	// journals are kept so they can be resumed by ResumeJobs.
 	void CancelActiveJobs();
+	// Wait up to msecs, or forever if -1, for every job and request
+	// thread to finish.  Returns false if it timed out.
+	bool WaitForActiveJobs(int msecs = -1);
+	// Resume the jobs, for this Client's host, that didn't finish the
+	// last time the application ran.
+	void ResumeJobs();
 
 	QFuture<ds3_get_service_response*> GetService();
 	QFuture<ds3_get_bucket_response*> GetBucket(const QString& bucketName,
@@ -60,8 +93,26 @@ public:
 						    const QString& marker,
 						    bool silent = false,
 						    const QString& delimiter = "/");
-	QFuture<ds3_get_objects_response*> GetObjects(const QString& bucketName,
-						      const QString& name);
+	QFuture<QSharedPointer<const Listing> > GetObjects(const QString& bucketName,
+							   const QString& name);
+	// GetBucket for the browser, with the response already converted
+	// into the rows of a bucket or folder whose children owner owns
+	QFuture<ListingPage*> GetListingPage(const QString& bucketName,
+					     const QString& prefix,
+					     const QString& marker,
+					     const QString& owner);
+	// Every page of prefix, up to the one that the listing was
+	// truncated after at marker or to the end if marker is empty,
+	// listed again and converted into one ListingPage
+	QFuture<ListingPage*> GetListingPages(const QString& bucketName,
+					      const QString& prefix,
+					      const QString& marker,
+					      const QString& owner);
+	// Forget the cached listings of prefix and of everything under it,
+	// or every cached listing if bucketName is empty, so they're listed
+	// again the next time they're needed
+	void InvalidateListings(const QString& bucketName = QString(),
+				const QString& prefix = QString());
 
 	void CreateBucket(const QString& name);
 	void DeleteBucket(const QString& name);
@@ -74,24 +125,31 @@ public:
 		     const QString& prefix,
 		     const QList<QUrl> urls);
 
-	void GetObject(const QString& bucket,
+	// Transfer one blob.  Both throw a DS3Error if the request failed
+	// and return false, after logging why, if the blob failed on this
+	// side, e.g. its file couldn't be opened or its data didn't match
+	// its checksum.
+	bool GetObject(const QString& bucket,
 		       const QString& object,
 		       const QString& fileName,
 		       uint64_t offset,
-		       BulkGetWorkItem* bulkGetWorkItem);
-	void PutObject(const QString& bucket,
+		       uint64_t length,
+		       PageWorkItem* page);
+	bool PutObject(const QString& bucket,
 		       const QString& object,
 		       const QString& fileName,
 		       uint64_t offset,
 		       uint64_t length,
-		       BulkPutWorkItem* bulkPutWorkItem);
+		       PageWorkItem* page);
 
 public slots:
 	// Cancel an in-progress BulkGet or BulkPut request.
 	void CancelBulkJob(QUuid workItemID);
 
 signals:
-	void JobProgressUpdate(const Job job);
+	// The latest state of the jobs that changed, at most
+	// JobProgressPublisher::PUBLISH_INTERVAL milliseconds apart
+	void JobProgressUpdates(const QList<Job> jobs);
 
 private:
 	ds3_get_service_response* DoGetService();
@@ -100,25 +158,143 @@ private:
 					     const QString& delimiter,
 					     const QString& marker,
 					     bool silent = false);
-	ds3_get_objects_response* DoGetObjects(const QString& bucketName,
-					       const QString& name);
+	// The listing from the cache or, if it isn't cached, from
+	// DoGetBucket
+	QSharedPointer<const Listing> GetBucketListing(const QString& bucketName,
+						       const QString& prefix,
+						       const QString& delimiter,
+						       const QString& marker);
+	QSharedPointer<const Listing> DoGetObjects(const QString& bucketName,
+						   const QString& name);
+	ListingPage* DoGetListingPage(const QString& bucketName,
+				      const QString& prefix,
+				      const QString& marker,
+				      const QString& owner);
+	ListingPage* DoGetListingPages(const QString& bucketName,
+				       const QString& prefix,
+				       const QString& marker,
+				       const QString& owner);
 	void PrepareBulkGets(BulkGetWorkItem* workItem);
+	// Whether objName is an object of its own rather than a file that
+	// was packed into an archive.  etag is set to the ETag it's listed
+	// with, if any.
+	bool FindObject(const QString& bucketName, const QString& objName,
+			QString* etag);
+	// Extract the files that were packed into the archives of objName's
+	// parent folders, and that are under objName if it's a folder or
+	// are objName itself otherwise, into filePath.  Only the members'
+	// byte ranges of the archives are downloaded.  Returns false if
+	// there weren't any such files.
+	bool GetPackedMembers(BulkGetWorkItem* workItem,
+			      const QString& bucketName,
+			      const QString& objName,
+			      const QString& filePath);
+	// Download length bytes of an object, starting at offset, into
+	// memory.  Throws a DS3Error if the request failed.
+	QByteArray DoGetObjectRange(const QString& bucketName,
+				    const QString& objName,
+				    uint64_t offset, uint64_t length);
 	void PrepareBulkPuts(BulkPutWorkItem* workItem);
 	void DoBulk(BulkWorkItem* workItem);
+	void StartJournal(BulkWorkItem* workItem);
+	void ResumeBulk(BulkWorkItem* workItem);
 
 	void CreateBulkGetDirs(BulkGetWorkItem* workItem);
-	void ProcessJobChunk(BulkWorkItem* workItem);
-	ds3_get_available_chunks_response* GetAvailableJobChunks(BulkWorkItem* workItem);
+	// Create every directory that a GET page's objects need, once each,
+	// and allocate every file to its full size before any blob is
+	// downloaded
+	void PrepareRestore(BulkGetWorkItem* workItem, PageWorkItem* page);
+	// The file a GET object's blobs are written to and whether it's
+	// decompressed as it downloads
+	QString GetDownloadName(PageWorkItem* page, const QString& object,
+				const QString& fileName, bool* decompress);
+	// Open the sync manifest of the directory object dirObjName and list
+	// the objects under it on the server.  If either fails, the directory
+	// is uploaded without syncing.
+	void StartSync(BulkPutWorkItem* workItem, const QString& dirObjName);
+	// Whether a directory entry that's being synced needs to be sent.
+	// The server doesn't let objects be replaced so the object of a
+	// changed file is deleted first.
+	bool SyncEntry(BulkPutWorkItem* workItem, const QString& dirObjName,
+		       const DirectoryScanner::Entry& entry);
+	void FinishSync(BulkPutWorkItem* workItem, const QString& filePath);
+	bool DeleteChangedObject(const QString& bucketName,
+				 const QString& objName);
+	// Measure the compressed size of a file that's about to be PUT
+	// and, if compressing it makes it smaller, change its object's name
+	// and size to those of the compressed object.  blockSizes is set to
+	// the compressed size of each of the file's blocks so PutObject
+	// doesn't have to measure them again, or left empty if the file is
+	// sent as is.
+	void PrepareCompressedPut(const QString& filePath, QString* objName,
+				  uint64_t* size, QList<qint64>* blockSizes);
+	// Called once every blob of a GET object has been downloaded.
+	// Returns false if the object couldn't be decompressed or extracted.
+	bool FinishGetObject(const QString& object, const QString& fileName);
+	// Called once every blob of a PUT object has been sent
+	void FinishPutObject(PageWorkItem* page, const QString& object);
+	// Send the checksum of the blob that objWorkItem's file is positioned
+	// at with its PUT request
+	void SetPutChecksum(ObjectWorkItem* objWorkItem, ds3_request* request,
+			    uint64_t length);
+	// Unpack a downloaded archive of small files next to it and remove
+	// the archive
+	bool ExtractArchive(const QString& fileName);
+	void ProcessJobChunk(PageWorkItem* page);
+	void WaitForJobChunks(BulkWorkItem* workItem,
+			      ChunkWorkItem* chunkWorkItem,
+			      uint64_t retryAfter);
+	void TransferObjects(PageWorkItem* page,
+			     ChunkWorkItem* chunkWorkItem);
+	ds3_get_available_chunks_response* GetAvailableJobChunks(PageWorkItem* page);
+	bool AcquireTransfer(BulkWorkItem* workItem);
+	void ReleaseTransfer(BulkWorkItem* workItem, uint64_t bytes,
+			     bool succeeded);
 
-	void DeleteOrRequeueBulkWorkItem(BulkWorkItem* workItem);
+	// Prepare the next page, finish the work item or leave it to the
+	// other threads that are still working on it.  donePreparing
+	// signifies that the caller stopped preparing a page without
+	// creating one.
+	void DeleteOrRequeueBulkWorkItem(BulkWorkItem* workItem,
+					 bool donePreparing = false);
 	void DeleteBulkWorkItem(BulkWorkItem* workItem);
+	void LogExecutor(const Executor* executor) const;
 
-	qint64 GetFileSize(const QString& path);
+	// Position objWorkItem's file at the start of the object's data,
+	// mapping that part of the file if the session uses memory-mapped
+	// file I/O.
+	void PrepareObjectFile(ObjectWorkItem* objWorkItem,
+			       uint64_t offset, uint64_t length);
 
 	QString m_host;
 	QString m_endpoint;
+	QString m_proxy;
 	ds3_creds* m_creds;
-	ds3_client* m_client;
+	// Every request checks a C SDK client out of the pool for as long
+	// as the request takes.
+	DS3ClientPool* m_clientPool;
+	// Listings and searches, bulk job preparation, and bulk job pages
+	// each run on their own threads so one can't starve the others.
+	Executor* m_metadataExecutor;
+	Executor* m_prepExecutor;
+	Executor* m_transferExecutor;
+	// Compresses and decompresses blocks of objects for the transfers
+	Executor* m_codecExecutor;
+	// Limits the object transfers of all of the session's jobs.  Each
+	// job also has its own.
+	ConcurrencyController* m_transferController;
+	// Coalesces the job updates from every thread into one signal per
+	// GUI frame
+	JobProgressPublisher* m_progressPublisher;
+	// The recent listings and searches.  The session's own PUTs and
+	// deletes forget the ones that they change.
+	ListingCache* m_listingCache;
+	int m_numTransferThreads;
+	Session::FileIOMode m_fileIOMode;
+	bool m_packSmallFiles;
+	bool m_compressObjects;
+	Session::SyncMode m_syncMode;
+	Session::ChecksumType m_checksumType;
 	QHash<QUuid, BulkWorkItem*> m_bulkWorkItems;
 	mutable QMutex m_bulkWorkItemsLock;
 
@@ -138,4 +314,28 @@ Client::GetEndpoint() const
 	return m_endpoint;
 }
 
+inline const DS3ClientPool*
+Client::GetClientPool() const
+{
+	return m_clientPool;
+}
+
+inline const Executor*
+Client::GetMetadataExecutor() const
+{
+	return m_metadataExecutor;
+}
+
+inline const Executor*
+Client::GetPrepExecutor() const
+{
+	return m_prepExecutor;
+}
+
+inline const Executor*
+Client::GetTransferExecutor() const
+{
+	return m_transferExecutor;
+}
+
 #endif
@@ -0,0 +1,226 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "helpers/number_helper.h"
+#include "lib/concurrency_controller.h"
+#include "lib/logger.h"
+
+// How long, in milliseconds, each throughput sample lasts
+const qint64 ConcurrencyController::SAMPLE_INTERVAL = 2000;
+
+// More failed transfers than this in a window is taken as a sign that the
+// server is overloaded
+const double ConcurrencyController::MAX_ERROR_RATE = 0.1;
+
+// The throughput increase an additional transfer has to bring to be kept
+const double ConcurrencyController::MIN_GAIN = 0.05;
+
+// Windows to wait, after an increase didn't pay off or the limit was
+// lowered, before trying a higher limit again
+const int ConcurrencyController::HOLD_WINDOWS = 5;
+
+ConcurrencyController::ConcurrencyController(const QString& name, int limit,
+					     int minLimit, int maxLimit)
+	: m_name(name),
+	  m_minLimit(qMax(1, minLimit)),
+	  m_maxLimit(qMax(m_minLimit, maxLimit)),
+	  m_limit(qBound(m_minLimit, limit, m_maxLimit)),
+	  m_numInFlight(0),
+	  m_windowStart(-1),
+	  m_windowBytes(0),
+	  m_windowTransfers(0),
+	  m_windowFailures(0),
+	  m_windowRetryAfter(0),
+	  m_lastThroughput(-1),
+	  m_probe(PROBING),
+	  m_holdWindows(0)
+{
+	m_clock.start();
+}
+
+int
+ConcurrencyController::GetLimit() const
+{
+	m_lock.lock();
+	int limit = m_limit;
+	m_lock.unlock();
+	return limit;
+}
+
+int
+ConcurrencyController::GetNumInFlight() const
+{
+	m_lock.lock();
+	int numInFlight = m_numInFlight;
+	m_lock.unlock();
+	return numInFlight;
+}
+
+bool
+ConcurrencyController::Acquire(unsigned long msecs)
+{
+	QElapsedTimer timer;
+	timer.start();
+	bool acquired = true;
+	m_lock.lock();
+	while (m_numInFlight >= m_limit) {
+		unsigned long wait = ULONG_MAX;
+		if (msecs != ULONG_MAX) {
+			qint64 elapsed = timer.elapsed();
+			if ((unsigned long)elapsed >= msecs) {
+				acquired = false;
+				break;
+			}
+			wait = msecs - elapsed;
+		}
+		m_released.wait(&m_lock, wait);
+	}
+	if (acquired) {
+		m_numInFlight++;
+	}
+	m_lock.unlock();
+	return acquired;
+}
+
+void
+ConcurrencyController::Release()
+{
+	m_lock.lock();
+	m_numInFlight--;
+	m_released.wakeOne();
+	m_lock.unlock();
+}
+
+void
+ConcurrencyController::Release(uint64_t bytes, bool succeeded)
+{
+	Release(bytes, succeeded, m_clock.elapsed());
+}
+
+void
+ConcurrencyController::Release(uint64_t bytes, bool succeeded, qint64 now)
+{
+	m_lock.lock();
+	m_numInFlight--;
+	if (m_windowStart < 0) {
+		m_windowStart = now;
+	}
+	m_windowTransfers++;
+	if (succeeded) {
+		m_windowBytes += bytes;
+	} else {
+		m_windowFailures++;
+	}
+	Adjust(now);
+	m_released.wakeAll();
+	m_lock.unlock();
+}
+
+void
+ConcurrencyController::ReportRetryAfter(uint64_t seconds)
+{
+	ReportRetryAfter(seconds, m_clock.elapsed());
+}
+
+void
+ConcurrencyController::ReportRetryAfter(uint64_t seconds, qint64 now)
+{
+	m_lock.lock();
+	if (m_windowStart < 0) {
+		m_windowStart = now;
+	}
+	m_windowRetryAfter = qMax(m_windowRetryAfter, seconds);
+	Adjust(now);
+	m_lock.unlock();
+}
+
+// Must be called with m_lock held
+void
+ConcurrencyController::Adjust(qint64 now)
+{
+	qint64 elapsed = now - m_windowStart;
+	if (m_windowStart < 0 || elapsed < SAMPLE_INTERVAL) {
+		return;
+	}
+
+	double throughput = (m_windowBytes * 1000.0) / elapsed;
+	double errorRate = 0;
+	if (m_windowTransfers > 0) {
+		errorRate = (double)m_windowFailures / m_windowTransfers;
+	}
+
+	if (errorRate > MAX_ERROR_RATE) {
+		SetLimit(m_limit / 2,
+			 QString::number((int)(errorRate * 100)) + "% of transfers failed",
+			 throughput);
+		m_probe = HOLDING;
+		m_holdWindows = HOLD_WINDOWS;
+	} else if (m_windowRetryAfter > 0) {
+		SetLimit(m_limit / 2,
+			 "server asked to retry after " +
+			 QString::number(m_windowRetryAfter) + " seconds",
+			 throughput);
+		m_probe = HOLDING;
+		m_holdWindows = HOLD_WINDOWS;
+	} else if (m_windowTransfers == 0) {
+		// Nothing finished (e.g. a few large objects) so there's
+		// nothing to compare.  Keep the window open.
+		return;
+	} else if (m_probe == PROBING) {
+		if (m_limit >= m_maxLimit) {
+			m_probe = HOLDING;
+			m_holdWindows = HOLD_WINDOWS;
+		} else if (m_lastThroughput < 0 ||
+			   throughput >= m_lastThroughput * (1 + MIN_GAIN)) {
+			SetLimit(m_limit + 1, "throughput went up", throughput);
+		} else {
+			SetLimit(m_limit - 1, "more transfers didn't help",
+				 throughput);
+			m_probe = HOLDING;
+			m_holdWindows = HOLD_WINDOWS;
+		}
+	} else if (--m_holdWindows <= 0) {
+		if (m_limit < m_maxLimit) {
+			m_probe = PROBING;
+			SetLimit(m_limit + 1, "probing for more throughput",
+				 throughput);
+		} else {
+			m_holdWindows = HOLD_WINDOWS;
+		}
+	}
+
+	m_lastThroughput = throughput;
+	m_windowStart = now;
+	m_windowBytes = 0;
+	m_windowTransfers = 0;
+	m_windowFailures = 0;
+	m_windowRetryAfter = 0;
+}
+
+// Must be called with m_lock held
+void
+ConcurrencyController::SetLimit(int limit, const QString& reason,
+				double throughput)
+{
+	limit = qBound(m_minLimit, limit, m_maxLimit);
+	if (limit == m_limit) {
+		return;
+	}
+	LOG_INFO("TRANSFERS    " + m_name + " " + QString::number(m_limit) +
+		 " -> " + QString::number(limit) + " in flight, " + reason +
+		 " (" + NumberHelper::ToHumanRate((uint64_t)throughput) + ")");
+	m_limit = limit;
+}
@@ -0,0 +1,118 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef CONCURRENCY_CONTROLLER_H
+#define CONCURRENCY_CONTROLLER_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+// ConcurrencyController, limits how many object transfers are in flight at
+// once and tunes that limit from what the transfers achieve.  Every
+// SAMPLE_INTERVAL it compares the window's throughput with the previous
+// one's:
+//
+//   - If more than MAX_ERROR_RATE of the window's transfers failed or the
+//     server asked us to retry later, the limit is halved.
+//   - If the last increase raised throughput by at least MIN_GAIN, the
+//     limit is raised by one again.  Otherwise the increase is undone and
+//     the limit is held for HOLD_WINDOWS windows before probing again.
+//
+// Every change is logged.  Client keeps one controller per job and one for
+// the whole session and a transfer needs a slot from both.
+class ConcurrencyController
+{
+public:
+	static const qint64 SAMPLE_INTERVAL;
+	static const double MAX_ERROR_RATE;
+	static const double MIN_GAIN;
+	static const int HOLD_WINDOWS;
+
+	ConcurrencyController(const QString& name, int limit,
+			      int minLimit, int maxLimit);
+
+	const QString& GetName() const;
+	int GetLimit() const;
+	int GetMinLimit() const;
+	int GetMaxLimit() const;
+	int GetNumInFlight() const;
+
+	// Wait up to msecs for the number of transfers in flight to drop
+	// below the limit and take a slot.  Returns false if it timed out.
+	bool Acquire(unsigned long msecs = ULONG_MAX);
+	// Give back a slot without a transfer having been attempted
+	void Release();
+	// Give back a slot and record the result of the transfer.  now is
+	// the number of milliseconds since some fixed point in time.
+	void Release(uint64_t bytes, bool succeeded);
+	void Release(uint64_t bytes, bool succeeded, qint64 now);
+	// The server has no cache available and asked us to retry after
+	// the given number of seconds
+	void ReportRetryAfter(uint64_t seconds);
+	void ReportRetryAfter(uint64_t seconds, qint64 now);
+
+private:
+	enum Probe { PROBING, HOLDING };
+
+	void Adjust(qint64 now);
+	void SetLimit(int limit, const QString& reason, double throughput);
+
+	const QString m_name;
+	const int m_minLimit;
+	const int m_maxLimit;
+	int m_limit;
+	int m_numInFlight;
+
+	// The current window
+	qint64 m_windowStart;
+	uint64_t m_windowBytes;
+	int m_windowTransfers;
+	int m_windowFailures;
+	uint64_t m_windowRetryAfter;
+
+	// Throughput, in bytes per second, of the previous window or -1
+	double m_lastThroughput;
+	Probe m_probe;
+	int m_holdWindows;
+
+	QElapsedTimer m_clock;
+	mutable QMutex m_lock;
+	QWaitCondition m_released;
+};
+
+inline const QString&
+ConcurrencyController::GetName() const
+{
+	return m_name;
+}
+
+inline int
+ConcurrencyController::GetMinLimit() const
+{
+	return m_minLimit;
+}
+
+inline int
+ConcurrencyController::GetMaxLimit() const
+{
+	return m_maxLimit;
+}
+
+#endif
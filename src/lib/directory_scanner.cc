@@ -0,0 +1,146 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QtConcurrent>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include "helpers/file_helper.h"
+#include "lib/directory_scanner.h"
+
+using QtConcurrent::run;
+
+// Walking is mostly spent waiting on the file system so it pays off to
+// have more walkers than cores on network and SSD storage.
+const int DirectoryScanner::DEFAULT_NUM_WALKERS = 8;
+const int DirectoryScanner::DEFAULT_MAX_QUEUE_SIZE = 10000;
+
+DirectoryScanner::DirectoryScanner(const QString& root,
+				   int numWalkers,
+				   int maxQueueSize)
+	: m_root(root),
+	  m_numWalkers(numWalkers),
+	  m_maxQueueSize(maxQueueSize),
+	  m_numBusyWalkers(0),
+	  m_canceled(false)
+{
+	m_walkers.setMaxThreadCount(m_numWalkers);
+	m_dirs.push("");
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+	Cancel();
+	m_walkers.waitForDone();
+}
+
+void
+DirectoryScanner::Start()
+{
+	for (int i = 0; i < m_numWalkers; i++) {
+		run(&m_walkers, this, &DirectoryScanner::Walk);
+	}
+}
+
+void
+DirectoryScanner::Cancel()
+{
+	m_lock.lock();
+	m_canceled = true;
+	m_dirAvailable.wakeAll();
+	m_entryAvailable.wakeAll();
+	m_spaceAvailable.wakeAll();
+	m_lock.unlock();
+}
+
+bool
+DirectoryScanner::Next(Entry* entry)
+{
+	bool found = false;
+	m_lock.lock();
+	while (m_entries.isEmpty() && !IsDone() && !m_canceled) {
+		m_entryAvailable.wait(&m_lock);
+	}
+	if (!m_entries.isEmpty()) {
+		*entry = m_entries.dequeue();
+		m_spaceAvailable.wakeOne();
+		found = true;
+	}
+	m_lock.unlock();
+	return found;
+}
+
+void
+DirectoryScanner::Walk()
+{
+	m_lock.lock();
+	while (true) {
+		while (m_dirs.isEmpty() && !IsDone() && !m_canceled) {
+			m_dirAvailable.wait(&m_lock);
+		}
+		if (m_canceled || IsDone()) {
+			break;
+		}
+		QString relativeDir = m_dirs.pop();
+		m_numBusyWalkers++;
+		m_lock.unlock();
+
+		// Each QFileInfo caches its stat so nothing is stat'ed twice
+		QDir dir(relativeDir.isEmpty() ? m_root : m_root + "/" + relativeDir);
+		QFileInfoList fileInfos = dir.entryInfoList(QDir::AllDirs | QDir::Files |
+							    QDir::Hidden | QDir::Readable |
+							    QDir::System | QDir::NoDotAndDotDot,
+							    QDir::NoSort);
+
+		m_lock.lock();
+		for (int i = 0; i < fileInfos.size() && !m_canceled; i++) {
+			const QFileInfo& fileInfo = fileInfos[i];
+			Entry entry;
+			if (relativeDir.isEmpty()) {
+				entry.relativePath = fileInfo.fileName();
+			} else {
+				entry.relativePath = relativeDir + "/" + fileInfo.fileName();
+			}
+			entry.path = fileInfo.filePath();
+			entry.isDir = fileInfo.isDir();
+			entry.size = 0;
+			entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+			if (!entry.isDir) {
+				m_lock.unlock();
+				entry.size = FileHelper::GetSize(fileInfo);
+				m_lock.lock();
+			}
+
+			while (m_entries.size() >= m_maxQueueSize && !m_canceled) {
+				m_spaceAvailable.wait(&m_lock);
+			}
+			m_entries.enqueue(entry);
+			m_entryAvailable.wakeOne();
+			// Don't follow symlinks to directories
+			if (entry.isDir && !fileInfo.isSymLink()) {
+				m_dirs.push(entry.relativePath);
+				m_dirAvailable.wakeOne();
+			}
+		}
+		m_numBusyWalkers--;
+		if (IsDone()) {
+			m_dirAvailable.wakeAll();
+			m_entryAvailable.wakeAll();
+		}
+	}
+	m_lock.unlock();
+}
@@ -0,0 +1,98 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef DIRECTORY_SCANNER_H
+#define DIRECTORY_SCANNER_H
+
+#include <stdint.h>
+#include <QMutex>
+#include <QQueue>
+#include <QStack>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+// DirectoryScanner, walks a local directory tree with several threads at
+// once.  Each walker takes a directory off a shared stack, lists it, and
+// pushes every entry onto a bounded queue that the consumer reads from
+// with Next while the walk is still going on.  Subdirectories are pushed
+// back onto the stack for any idle walker to pick up.  Entries are
+// returned in no particular order.
+class DirectoryScanner
+{
+public:
+	static const int DEFAULT_NUM_WALKERS;
+	static const int DEFAULT_MAX_QUEUE_SIZE;
+
+	struct Entry {
+		// Path relative to the root directory, always using "/"
+		QString relativePath;
+		QString path;
+		bool isDir;
+		// Always 0 for directories
+		uint64_t size;
+		// Milliseconds since the epoch
+		qint64 modified;
+	};
+
+	DirectoryScanner(const QString& root,
+			 int numWalkers = DEFAULT_NUM_WALKERS,
+			 int maxQueueSize = DEFAULT_MAX_QUEUE_SIZE);
+	// Cancels the walk if it's still in progress
+	~DirectoryScanner();
+
+	const QString& GetRoot() const;
+
+	void Start();
+	void Cancel();
+	// Get the next entry, waiting for the walkers if necessary.  Returns
+	// false once every entry has been returned.
+	bool Next(Entry* entry);
+
+private:
+	void Walk();
+	bool IsDone() const;
+
+	QString m_root;
+	int m_numWalkers;
+	int m_maxQueueSize;
+	QThreadPool m_walkers;
+
+	QMutex m_lock;
+	// Directories, relative to m_root, that still need to be listed
+	QStack<QString> m_dirs;
+	int m_numBusyWalkers;
+	QQueue<Entry> m_entries;
+	bool m_canceled;
+	QWaitCondition m_dirAvailable;
+	QWaitCondition m_entryAvailable;
+	QWaitCondition m_spaceAvailable;
+};
+
+inline const QString&
+DirectoryScanner::GetRoot() const
+{
+	return m_root;
+}
+
+// Must be called with m_lock held
+inline bool
+DirectoryScanner::IsDone() const
+{
+	return (m_dirs.isEmpty() && m_numBusyWalkers == 0);
+}
+
+#endif
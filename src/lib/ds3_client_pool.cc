@@ -0,0 +1,146 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/ds3_client_pool.h"
+
+DS3ClientPool::DS3ClientPool(const QString& endpoint,
+			     const QString& proxy,
+			     ds3_creds* creds,
+			     int size,
+			     int maxClients,
+			     int idleTimeout)
+	: m_endpoint(endpoint),
+	  m_proxy(proxy),
+	  m_creds(creds),
+	  m_size(size),
+	  m_maxClients(maxClients),
+	  m_idleTimeout(idleTimeout),
+	  m_numCheckedOut(0),
+	  m_numHits(0),
+	  m_numMisses(0)
+{
+}
+
+DS3ClientPool::~DS3ClientPool()
+{
+	for (int i = 0; i < m_idleClients.size(); i++) {
+		ds3_free_client(m_idleClients[i].client);
+	}
+}
+
+ds3_client*
+DS3ClientPool::Checkout()
+{
+	ds3_client* client = NULL;
+	m_lock.lock();
+	FreeExpiredClients();
+	while (m_idleClients.isEmpty() && m_numCheckedOut >= m_maxClients) {
+		m_clientReturned.wait(&m_lock);
+		FreeExpiredClients();
+	}
+	if (!m_idleClients.isEmpty()) {
+		client = m_idleClients.takeFirst().client;
+		m_numHits++;
+	} else {
+		m_numMisses++;
+	}
+	m_numCheckedOut++;
+	m_lock.unlock();
+
+	// Creating a client doesn't need the lock
+	if (client == NULL) {
+		client = CreateClient();
+	}
+	return client;
+}
+
+void
+DS3ClientPool::Return(ds3_client* client)
+{
+	m_lock.lock();
+	m_numCheckedOut--;
+	if (m_idleClients.size() < m_size) {
+		IdleClient idleClient;
+		idleClient.client = client;
+		idleClient.idleTime.start();
+		m_idleClients.prepend(idleClient);
+		client = NULL;
+	}
+	m_clientReturned.wakeOne();
+	m_lock.unlock();
+
+	if (client != NULL) {
+		ds3_free_client(client);
+	}
+}
+
+int
+DS3ClientPool::GetNumIdle() const
+{
+	m_lock.lock();
+	int numIdle = m_idleClients.size();
+	m_lock.unlock();
+	return numIdle;
+}
+
+int
+DS3ClientPool::GetNumCheckedOut() const
+{
+	m_lock.lock();
+	int numCheckedOut = m_numCheckedOut;
+	m_lock.unlock();
+	return numCheckedOut;
+}
+
+uint64_t
+DS3ClientPool::GetNumHits() const
+{
+	m_lock.lock();
+	uint64_t numHits = m_numHits;
+	m_lock.unlock();
+	return numHits;
+}
+
+uint64_t
+DS3ClientPool::GetNumMisses() const
+{
+	m_lock.lock();
+	uint64_t numMisses = m_numMisses;
+	m_lock.unlock();
+	return numMisses;
+}
+
+ds3_client*
+DS3ClientPool::CreateClient() const
+{
+	ds3_client* client = ds3_create_client(m_endpoint.toUtf8().constData(),
+					       m_creds);
+	if (!m_proxy.isEmpty()) {
+		ds3_client_proxy(client, m_proxy.toUtf8().constData());
+	}
+	return client;
+}
+
+// Idle clients are ordered most recently returned first so the expired
+// ones are always at the end.  Must be called with m_lock held.
+void
+DS3ClientPool::FreeExpiredClients()
+{
+	while (!m_idleClients.isEmpty() &&
+	       m_idleClients.last().idleTime.hasExpired(m_idleTimeout)) {
+		ds3_free_client(m_idleClients.takeLast().client);
+	}
+}
@@ -0,0 +1,97 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef DS3_CLIENT_POOL_H
+#define DS3_CLIENT_POOL_H
+
+#include <stdint.h>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include <ds3.h>
+
+// DS3ClientPool, a pool of C SDK clients, and thus HTTP connections, to a
+// single DS3 host that every Client request checks one out of instead of
+// sharing a single C SDK client between threads.  Returned clients are kept
+// idle, most recently used first, for up to idleTimeout milliseconds so
+// back to back requests reuse a warm connection.  At most maxClients are
+// ever checked out at once; Checkout blocks until one is returned.
+class DS3ClientPool
+{
+public:
+	// The creds must outlive the pool
+	DS3ClientPool(const QString& endpoint,
+		      const QString& proxy,
+		      ds3_creds* creds,
+		      int size,
+		      int maxClients,
+		      int idleTimeout);
+	~DS3ClientPool();
+
+	ds3_client* Checkout();
+	void Return(ds3_client* client);
+
+	// Maximum number of idle clients kept
+	int GetSize() const;
+	int GetMaxClients() const;
+	int GetNumIdle() const;
+	int GetNumCheckedOut() const;
+	// Checkouts that reused an idle client
+	uint64_t GetNumHits() const;
+	// Checkouts that had to create a new client
+	uint64_t GetNumMisses() const;
+
+private:
+	struct IdleClient
+	{
+		ds3_client* client;
+		QElapsedTimer idleTime;
+	};
+
+	ds3_client* CreateClient() const;
+	void FreeExpiredClients();
+
+	const QString m_endpoint;
+	const QString m_proxy;
+	ds3_creds* m_creds;
+	const int m_size;
+	const int m_maxClients;
+	const int m_idleTimeout;
+
+	QList<IdleClient> m_idleClients;
+	int m_numCheckedOut;
+	uint64_t m_numHits;
+	uint64_t m_numMisses;
+	mutable QMutex m_lock;
+	QWaitCondition m_clientReturned;
+};
+
+inline int
+DS3ClientPool::GetSize() const
+{
+	return m_size;
+}
+
+inline int
+DS3ClientPool::GetMaxClients() const
+{
+	return m_maxClients;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/executor.h"
+
+Executor::Executor(const QString& name, int maxThreads,
+		   QThread::Priority priority)
+	: m_name(name),
+	  m_priority(priority),
+	  m_numQueued(0),
+	  m_maxNumQueued(0),
+	  m_numActive(0),
+	  m_numFinished(0)
+{
+	m_pool.setMaxThreadCount(maxThreads);
+}
+
+int
+Executor::GetNumQueued() const
+{
+	m_lock.lock();
+	int numQueued = m_numQueued;
+	m_lock.unlock();
+	return numQueued;
+}
+
+int
+Executor::GetMaxNumQueued() const
+{
+	m_lock.lock();
+	int maxNumQueued = m_maxNumQueued;
+	m_lock.unlock();
+	return maxNumQueued;
+}
+
+int
+Executor::GetNumActive() const
+{
+	m_lock.lock();
+	int numActive = m_numActive;
+	m_lock.unlock();
+	return numActive;
+}
+
+uint64_t
+Executor::GetNumFinished() const
+{
+	m_lock.lock();
+	uint64_t numFinished = m_numFinished;
+	m_lock.unlock();
+	return numFinished;
+}
+
+void
+Executor::TaskQueued()
+{
+	m_lock.lock();
+	m_numQueued++;
+	m_maxNumQueued = qMax(m_maxNumQueued, m_numQueued);
+	m_lock.unlock();
+}
+
+void
+Executor::TaskStarted()
+{
+	m_lock.lock();
+	m_numQueued--;
+	m_numActive++;
+	m_lock.unlock();
+	// Pool threads are only ever shared between tasks of the same
+	// executor so this only changes the priority the first time.
+	QThread* thread = QThread::currentThread();
+	if (m_priority != QThread::InheritPriority &&
+	    thread->priority() != m_priority) {
+		thread->setPriority(m_priority);
+	}
+}
+
+void
+Executor::TaskFinished()
+{
+	m_lock.lock();
+	m_numActive--;
+	m_numFinished++;
+	m_lock.unlock();
+}
+
+Executor::ActiveTask::ActiveTask(Executor* executor)
+	: m_executor(executor)
+{
+	m_executor->TaskStarted();
+}
+
+Executor::ActiveTask::~ActiveTask()
+{
+	m_executor->TaskFinished();
+}
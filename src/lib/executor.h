@@ -0,0 +1,364 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <stdint.h>
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+// Executor, a named, independently sized thread pool that Client runs one
+// kind of work on (e.g. listings or bulk job preparation) so that kind of
+// work never waits behind another in a shared pool.  Its threads run at the
+// executor's priority and it keeps track of how many tasks are waiting for
+// a thread and how many are running.
+//
+// Run works like QtConcurrent::run for member functions with up to five
+// arguments.
+class Executor
+{
+public:
+	Executor(const QString& name, int maxThreads,
+		 QThread::Priority priority = QThread::InheritPriority);
+
+	QString GetName() const;
+	int GetMaxThreads() const;
+	QThread::Priority GetPriority() const;
+
+	// Tasks that are waiting for a thread
+	int GetNumQueued() const;
+	// The most tasks that have ever waited for a thread at once
+	int GetMaxNumQueued() const;
+	// Tasks that are running
+	int GetNumActive() const;
+	uint64_t GetNumFinished() const;
+
+	// Wait up to msecs, or forever if -1, for every task to finish.
+	// Returns false if it timed out.
+	bool WaitForDone(int msecs = -1);
+
+	template <typename T, typename Class>
+	QFuture<T> Run(Class* object, T (Class::*fn)());
+	template <typename T, typename Class,
+		  typename P1, typename A1>
+	QFuture<T> Run(Class* object, T (Class::*fn)(P1), const A1& a1);
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2>
+	QFuture<T> Run(Class* object, T (Class::*fn)(P1, P2),
+		       const A1& a1, const A2& a2);
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3>
+	QFuture<T> Run(Class* object, T (Class::*fn)(P1, P2, P3),
+		       const A1& a1, const A2& a2, const A3& a3);
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3,
+		  typename P4, typename A4>
+	QFuture<T> Run(Class* object, T (Class::*fn)(P1, P2, P3, P4),
+		       const A1& a1, const A2& a2, const A3& a3, const A4& a4);
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3,
+		  typename P4, typename A4,
+		  typename P5, typename A5>
+	QFuture<T> Run(Class* object, T (Class::*fn)(P1, P2, P3, P4, P5),
+		       const A1& a1, const A2& a2, const A3& a3, const A4& a4,
+		       const A5& a5);
+
+	// Marks a task as running for as long as it's in scope, even if
+	// the task throws.  Only meant to be used by Run's calls.
+	class ActiveTask
+	{
+	public:
+		ActiveTask(Executor* executor);
+		~ActiveTask();
+
+	private:
+		Executor* m_executor;
+	};
+
+private:
+	// QtConcurrent::run functors that call a member function with the
+	// stored arguments.
+	template <typename T, typename Class>
+	struct Call0
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)();
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)();
+		}
+	};
+
+	template <typename T, typename Class,
+		  typename P1, typename A1>
+	struct Call1
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)(P1);
+		A1 a1;
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)(a1);
+		}
+	};
+
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2>
+	struct Call2
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)(P1, P2);
+		A1 a1;
+		A2 a2;
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)(a1, a2);
+		}
+	};
+
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3>
+	struct Call3
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)(P1, P2, P3);
+		A1 a1;
+		A2 a2;
+		A3 a3;
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)(a1, a2, a3);
+		}
+	};
+
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3,
+		  typename P4, typename A4>
+	struct Call4
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)(P1, P2, P3, P4);
+		A1 a1;
+		A2 a2;
+		A3 a3;
+		A4 a4;
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)(a1, a2, a3, a4);
+		}
+	};
+
+	template <typename T, typename Class,
+		  typename P1, typename A1,
+		  typename P2, typename A2,
+		  typename P3, typename A3,
+		  typename P4, typename A4,
+		  typename P5, typename A5>
+	struct Call5
+	{
+		typedef T result_type;
+		Executor* executor;
+		Class* object;
+		T (Class::*fn)(P1, P2, P3, P4, P5);
+		A1 a1;
+		A2 a2;
+		A3 a3;
+		A4 a4;
+		A5 a5;
+		T operator()() {
+			ActiveTask task(executor);
+			return (object->*fn)(a1, a2, a3, a4, a5);
+		}
+	};
+
+	template <typename Functor>
+	QFuture<typename Functor::result_type> Queue(const Functor& call);
+	void TaskQueued();
+	void TaskStarted();
+	void TaskFinished();
+
+	const QString m_name;
+	const QThread::Priority m_priority;
+	QThreadPool m_pool;
+
+	int m_numQueued;
+	int m_maxNumQueued;
+	int m_numActive;
+	uint64_t m_numFinished;
+	mutable QMutex m_lock;
+};
+
+inline QString
+Executor::GetName() const
+{
+	return m_name;
+}
+
+inline int
+Executor::GetMaxThreads() const
+{
+	return m_pool.maxThreadCount();
+}
+
+inline QThread::Priority
+Executor::GetPriority() const
+{
+	return m_priority;
+}
+
+inline bool
+Executor::WaitForDone(int msecs)
+{
+	return m_pool.waitForDone(msecs);
+}
+
+template <typename Functor>
+QFuture<typename Functor::result_type>
+Executor::Queue(const Functor& call)
+{
+	TaskQueued();
+	return QtConcurrent::run(&m_pool, call);
+}
+
+template <typename T, typename Class>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)())
+{
+	Call0<T, Class> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	return Queue(call);
+}
+
+template <typename T, typename Class,
+	  typename P1, typename A1>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)(P1), const A1& a1)
+{
+	Call1<T, Class, P1, A1> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	call.a1 = a1;
+	return Queue(call);
+}
+
+template <typename T, typename Class,
+	  typename P1, typename A1,
+	  typename P2, typename A2>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)(P1, P2),
+	      const A1& a1, const A2& a2)
+{
+	Call2<T, Class, P1, A1, P2, A2> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	call.a1 = a1;
+	call.a2 = a2;
+	return Queue(call);
+}
+
+template <typename T, typename Class,
+	  typename P1, typename A1,
+	  typename P2, typename A2,
+	  typename P3, typename A3>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)(P1, P2, P3),
+	      const A1& a1, const A2& a2, const A3& a3)
+{
+	Call3<T, Class, P1, A1, P2, A2, P3, A3> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	call.a1 = a1;
+	call.a2 = a2;
+	call.a3 = a3;
+	return Queue(call);
+}
+
+template <typename T, typename Class,
+	  typename P1, typename A1,
+	  typename P2, typename A2,
+	  typename P3, typename A3,
+	  typename P4, typename A4>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)(P1, P2, P3, P4),
+	      const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+{
+	Call4<T, Class, P1, A1, P2, A2, P3, A3, P4, A4> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	call.a1 = a1;
+	call.a2 = a2;
+	call.a3 = a3;
+	call.a4 = a4;
+	return Queue(call);
+}
+
+template <typename T, typename Class,
+	  typename P1, typename A1,
+	  typename P2, typename A2,
+	  typename P3, typename A3,
+	  typename P4, typename A4,
+	  typename P5, typename A5>
+QFuture<T>
+Executor::Run(Class* object, T (Class::*fn)(P1, P2, P3, P4, P5),
+	      const A1& a1, const A2& a2, const A3& a3, const A4& a4,
+	      const A5& a5)
+{
+	Call5<T, Class, P1, A1, P2, A2, P3, A3, P4, A4, P5, A5> call;
+	call.executor = this;
+	call.object = object;
+	call.fn = fn;
+	call.a1 = a1;
+	call.a2 = a2;
+	call.a3 = a3;
+	call.a4 = a4;
+	call.a5 = a5;
+	return Queue(call);
+}
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <QDir>
+#include <QStandardPaths>
+
+#include "lib/job_journal.h"
+#include "lib/work_items/bulk_get_work_item.h"
+#include "lib/work_items/bulk_put_work_item.h"
+#include "lib/work_items/page_work_item.h"
+
+const int JobJournal::SYNC_RECORDS = 1000;
+const qint64 JobJournal::SYNC_INTERVAL = 2000;
+
+static void
+sync_file(QFile* file)
+{
+	file->flush();
+#ifdef Q_OS_WIN
+	_commit(file->handle());
+#else
+	fsync(file->handle());
+#endif
+}
+
+QString
+JobJournal::GetDir()
+{
+	QString dataDir = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+	return QDir::cleanPath(dataDir + "/journals");
+}
+
+QStringList
+JobJournal::GetPaths()
+{
+	QDir dir(GetDir());
+	QStringList paths;
+	QStringList fileNames = dir.entryList(QStringList("*.journal"),
+					      QDir::Files, QDir::Name);
+	for (int i = 0; i < fileNames.size(); i++) {
+		paths << dir.filePath(fileNames[i]);
+	}
+	return paths;
+}
+
+JobJournal::JobJournal(const QString& path)
+	: m_path(path),
+	  m_file(path),
+	  m_lockFile(path + ".lock"),
+	  m_numUnsyncedRecords(0),
+	  m_type(Job::GET),
+	  m_numURLsDone(0)
+{
+}
+
+JobJournal::~JobJournal()
+{
+	Close();
+}
+
+bool
+JobJournal::Open()
+{
+	QDir().mkpath(QFileInfo(m_path).absolutePath());
+	// Only consider the lock stale if the process that held it is gone.
+	// Work items can easily run longer than any fixed stale time.
+	m_lockFile.setStaleLockTime(0);
+	if (!m_lockFile.tryLock(0)) {
+		return false;
+	}
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		m_lockFile.unlock();
+		return false;
+	}
+	m_lastSync.start();
+	return true;
+}
+
+void
+JobJournal::Close()
+{
+	m_lock.lock();
+	if (m_file.isOpen()) {
+		sync_file(&m_file);
+		m_file.close();
+		m_lockFile.unlock();
+	}
+	m_lock.unlock();
+}
+
+void
+JobJournal::Remove()
+{
+	Close();
+	QFile::remove(m_path);
+}
+
+void
+JobJournal::WriteJob(BulkWorkItem* workItem)
+{
+	QString destination;
+	QString bucketName;
+	QString prefix;
+	if (workItem->GetType() == Job::GET) {
+		destination = workItem->GetDestination();
+	} else {
+		BulkPutWorkItem* putWorkItem = static_cast<BulkPutWorkItem*>(workItem);
+		bucketName = putWorkItem->GetBucketName();
+		prefix = putWorkItem->GetPrefix();
+	}
+	WriteRecord(QStringList() << "JOB"
+				  << QString::number(workItem->GetType())
+				  << workItem->GetHost()
+				  << destination
+				  << bucketName
+				  << prefix);
+	QList<QUrl> urls = workItem->GetURLs();
+	for (int i = 0; i < urls.size(); i++) {
+		WriteRecord(QStringList() << "URL" << urls[i].toString());
+	}
+	Sync();
+}
+
+// Pages are only ever written by the thread that prepares them, one at a
+// time, so a page's OBJECT and ETAG records always belong to the last PAGE
+// record.  Records of the page that is being transferred can be interleaved
+// with them.
+void
+JobJournal::WritePage(PageWorkItem* page)
+{
+	QString jobID = page->GetJobID();
+	WriteRecord(QStringList() << "PAGE"
+				  << jobID
+				  << page->GetBucketName()
+				  << QString::number(page->GetNumURLsProcessed())
+				  << page->GetLastProcessedUrl().toString());
+	QHash<QString, QString>::const_iterator hi;
+	for (hi = page->GetObjMapConstBegin();
+	     hi != page->GetObjMapConstEnd();
+	     hi++) {
+		WriteRecord(QStringList() << "OBJECT" << hi.key() << hi.value());
+	}
+	const QHash<QString, QString>& etags = page->GetETags();
+	for (hi = etags.constBegin(); hi != etags.constEnd(); hi++) {
+		WriteRecord(QStringList() << "ETAG" << hi.key() << hi.value());
+	}
+	// A page is only resumable if all of its objects made it to disk
+	WriteRecord(QStringList() << "PAGE_READY" << jobID, true);
+}
+
+void
+JobJournal::WritePageDone(const QString& jobID)
+{
+	WriteRecord(QStringList() << "PAGE_DONE" << jobID, true);
+}
+
+void
+JobJournal::WriteChunk(const QString& jobID, const QString& chunkID)
+{
+	WriteRecord(QStringList() << "CHUNK" << jobID << chunkID, true);
+}
+
+void
+JobJournal::WriteBlob(const QString& jobID, const QString& objName,
+		      uint64_t offset)
+{
+	WriteRecord(QStringList() << "BLOB" << jobID
+				  << QString::number(offset) << objName);
+}
+
+void
+JobJournal::Sync()
+{
+	m_lock.lock();
+	if (m_file.isOpen()) {
+		sync_file(&m_file);
+		m_numUnsyncedRecords = 0;
+		m_lastSync.restart();
+	}
+	m_lock.unlock();
+}
+
+// Each record is a single line of tab separated, percent-encoded fields
+// with the record type as the first field.
+void
+JobJournal::WriteRecord(const QStringList& fields, bool sync)
+{
+	QByteArray line;
+	for (int i = 0; i < fields.size(); i++) {
+		if (i > 0) {
+			line += '\t';
+		}
+		line += QUrl::toPercentEncoding(fields[i]);
+	}
+	line += '\n';
+
+	m_lock.lock();
+	if (m_file.isOpen()) {
+		m_file.write(line);
+		m_numUnsyncedRecords++;
+		if (sync || m_numUnsyncedRecords >= SYNC_RECORDS ||
+		    m_lastSync.elapsed() >= SYNC_INTERVAL) {
+			sync_file(&m_file);
+			m_numUnsyncedRecords = 0;
+			m_lastSync.restart();
+		}
+	}
+	m_lock.unlock();
+}
+
+bool
+JobJournal::Load()
+{
+	QFile file(m_path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	bool haveJob = false;
+	// A page's records are only applied once its PAGE_READY record has
+	// been read.
+	bool inPage = false;
+	Page page;
+	while (!file.atEnd()) {
+		QByteArray line = file.readLine();
+		if (!line.endsWith('\n')) {
+			// The application exited while writing this record
+			break;
+		}
+		line.chop(1);
+		QList<QByteArray> rawFields = line.split('\t');
+		QStringList fields;
+		for (int i = 0; i < rawFields.size(); i++) {
+			fields << QUrl::fromPercentEncoding(rawFields[i]);
+		}
+		QString type = fields.takeFirst();
+
+		if (type == "JOB" && fields.size() == 5) {
+			m_type = static_cast<Job::Type>(fields[0].toInt());
+			m_host = fields[1];
+			m_destination = fields[2];
+			m_bucketName = fields[3];
+			m_prefix = fields[4];
+			haveJob = true;
+		} else if (type == "URL" && fields.size() == 1) {
+			m_urls << QUrl(fields[0]);
+		} else if (type == "PAGE" && fields.size() == 4) {
+			inPage = true;
+			page = Page();
+			page.jobID = fields[0];
+			page.bucketName = fields[1];
+			page.numURLsProcessed = fields[2].toInt();
+			page.lastProcessedUrl = QUrl(fields[3]);
+		} else if (type == "OBJECT" && fields.size() == 2 && inPage) {
+			page.objMap.insert(fields[0], fields[1]);
+		} else if (type == "ETAG" && fields.size() == 2 && inPage) {
+			page.etags.insert(fields[0], fields[1]);
+		} else if (type == "PAGE_READY" && fields.size() == 1 &&
+			   inPage && fields[0] == page.jobID) {
+			inPage = false;
+			m_pages << page;
+		} else if (type == "CHUNK" && fields.size() == 2) {
+			Page* chunkPage = FindPage(fields[0]);
+			if (chunkPage != NULL) {
+				chunkPage->chunksDone << fields[1];
+			}
+		} else if (type == "BLOB" && fields.size() == 3) {
+			Page* blobPage = FindPage(fields[0]);
+			if (blobPage != NULL) {
+				blobPage->blobsDone << BlobKey(fields[2], fields[1].toULongLong());
+			}
+		} else if (type == "PAGE_DONE" && fields.size() == 1) {
+			// Pages finish in the order they were created
+			Page* donePage = FindPage(fields[0]);
+			if (donePage == NULL) {
+				continue;
+			}
+			m_numURLsDone = donePage->numURLsProcessed;
+			m_lastUrlDone = donePage->lastProcessedUrl;
+			QHash<QString, QString>::const_iterator hi;
+			for (hi = donePage->objMap.constBegin();
+			     hi != donePage->objMap.constEnd();
+			     hi++) {
+				m_objectsDone << hi.key();
+			}
+			for (int i = 0; i < m_pages.size(); i++) {
+				if (m_pages[i].jobID == fields[0]) {
+					m_pages.removeAt(i);
+					break;
+				}
+			}
+		}
+	}
+	file.close();
+
+	return haveJob && !m_urls.isEmpty();
+}
+
+JobJournal::Page*
+JobJournal::FindPage(const QString& jobID)
+{
+	for (int i = 0; i < m_pages.size(); i++) {
+		if (m_pages[i].jobID == jobID) {
+			return &m_pages[i];
+		}
+	}
+	return NULL;
+}
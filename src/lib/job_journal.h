@@ -0,0 +1,226 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef JOB_JOURNAL_H
+#define JOB_JOURNAL_H
+
+#include <stdint.h>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QLockFile>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+#include "models/job.h"
+
+class BulkWorkItem;
+class PageWorkItem;
+
+// JobJournal, an append-only, on-disk record of a BulkWorkItem's progress.
+// It records the drag/drop operation itself, every bulk page (DS3 job) that
+// was created along with the objects in it, and every blob and job chunk
+// that finished transferring.  If the application exits before the work item
+// finishes, the journal is left behind so the work item can later be resumed
+// by re-attaching to the server-side DS3 job and only transferring the blobs
+// that are left.
+class JobJournal
+{
+public:
+	// Records are written out, and synced to disk, in batches of
+	// SYNC_RECORDS records or every SYNC_INTERVAL milliseconds,
+	// whichever comes first.
+	static const int SYNC_RECORDS;
+	static const qint64 SYNC_INTERVAL;
+
+	// A bulk page (DS3 job) that was created but hadn't finished
+	struct Page {
+		QString jobID;
+		QString bucketName;
+		int numURLsProcessed;
+		QUrl lastProcessedUrl;
+		QHash<QString, QString> objMap;
+		QSet<QString> chunksDone;
+		// Keys are created by BlobKey
+		QSet<QString> blobsDone;
+		// The ETags of GET objects so resumed downloads are still
+		// verified
+		QHash<QString, QString> etags;
+	};
+
+	static QString GetDir();
+	// All journals that were left behind by unfinished work items
+	static QStringList GetPaths();
+
+	JobJournal(const QString& path);
+	~JobJournal();
+
+	const QString& GetPath() const;
+
+	// Lock the journal so no other Client can resume the same work item
+	// and open it for appending.
+	bool Open();
+	void Close();
+	// Close and delete the journal.  Used once its work item is either
+	// finished or was canceled by the user.
+	void Remove();
+
+	void WriteJob(BulkWorkItem* workItem);
+	// Records of a page are tagged with its job ID since the next
+	// page is created while the current one is being transferred.
+	void WritePage(PageWorkItem* page);
+	void WritePageDone(const QString& jobID);
+	void WriteChunk(const QString& jobID, const QString& chunkID);
+	void WriteBlob(const QString& jobID, const QString& objName,
+		       uint64_t offset);
+	void Sync();
+
+	// Replay a journal that was left behind.  Returns false if it
+	// doesn't contain a valid work item.
+	bool Load();
+
+	Job::Type GetType() const;
+	const QString& GetHost() const;
+	const QList<QUrl>& GetURLs() const;
+	// Where the GET objects are being saved to
+	const QString& GetDestination() const;
+	// Where the PUT objects are being saved to
+	const QString& GetBucketName() const;
+	const QString& GetPrefix() const;
+
+	// The URL position that bulk page preparation must continue from
+	// if there aren't any unfinished pages to re-attach to.
+	int GetNumURLsDone() const;
+	const QUrl& GetLastUrlDone() const;
+	// Objects that were part of a page that has finished
+	const QSet<QString>& GetObjectsDone() const;
+
+	// The unfinished pages in the order they were created.  There are
+	// at most two of them, the one that was being transferred and the
+	// one that was created while it was being transferred.
+	bool HasPages() const;
+	const QList<Page>& GetPages() const;
+
+	static QString BlobKey(const QString& objName, uint64_t offset);
+
+private:
+	void WriteRecord(const QStringList& fields, bool sync = false);
+	Page* FindPage(const QString& jobID);
+
+	QString m_path;
+	QFile m_file;
+	QLockFile m_lockFile;
+	QMutex m_lock;
+	int m_numUnsyncedRecords;
+	QElapsedTimer m_lastSync;
+
+	Job::Type m_type;
+	QString m_host;
+	QList<QUrl> m_urls;
+	QString m_destination;
+	QString m_bucketName;
+	QString m_prefix;
+
+	int m_numURLsDone;
+	QUrl m_lastUrlDone;
+	QSet<QString> m_objectsDone;
+
+	QList<Page> m_pages;
+};
+
+inline const QString&
+JobJournal::GetPath() const
+{
+	return m_path;
+}
+
+inline Job::Type
+JobJournal::GetType() const
+{
+	return m_type;
+}
+
+inline const QString&
+JobJournal::GetHost() const
+{
+	return m_host;
+}
+
+inline const QList<QUrl>&
+JobJournal::GetURLs() const
+{
+	return m_urls;
+}
+
+inline const QString&
+JobJournal::GetDestination() const
+{
+	return m_destination;
+}
+
+inline const QString&
+JobJournal::GetBucketName() const
+{
+	return m_bucketName;
+}
+
+inline const QString&
+JobJournal::GetPrefix() const
+{
+	return m_prefix;
+}
+
+inline int
+JobJournal::GetNumURLsDone() const
+{
+	return m_numURLsDone;
+}
+
+inline const QUrl&
+JobJournal::GetLastUrlDone() const
+{
+	return m_lastUrlDone;
+}
+
+inline const QSet<QString>&
+JobJournal::GetObjectsDone() const
+{
+	return m_objectsDone;
+}
+
+inline bool
+JobJournal::HasPages() const
+{
+	return !m_pages.isEmpty();
+}
+
+inline const QList<JobJournal::Page>&
+JobJournal::GetPages() const
+{
+	return m_pages;
+}
+
+inline QString
+JobJournal::BlobKey(const QString& objName, uint64_t offset)
+{
+	return QString::number(offset) + ":" + objName;
+}
+
+#endif
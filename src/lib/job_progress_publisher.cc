@@ -0,0 +1,150 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/job_progress_publisher.h"
+
+// Publish at most 10 times a second
+const int JobProgressPublisher::PUBLISH_INTERVAL = 100;
+
+// Weight of the latest interval's rate in a job's smoothed rate
+const double JobProgressPublisher::RATE_SMOOTHING = 0.2;
+
+JobProgressPublisher::JobProgressPublisher(QObject* parent)
+	: QObject(parent),
+	  m_started(false)
+{
+	m_timer = new QTimer(this);
+	m_timer->setInterval(PUBLISH_INTERVAL);
+	connect(m_timer, SIGNAL(timeout()), this, SLOT(Flush()));
+	m_clock.start();
+}
+
+void
+JobProgressPublisher::Publish(const Job& job)
+{
+	m_pendingJobsLock.lock();
+	QHash<QUuid, Job>::iterator pending = m_pendingJobs.find(job.GetID());
+	if (pending == m_pendingJobs.end()) {
+		m_pendingJobs.insert(job.GetID(), job);
+	} else if (!pending->IsFinished() && !pending->WasCanceled()) {
+		// A transfer thread's progress update can race the update
+		// that finishes the job.  Never let it undo the finish.
+		*pending = job;
+	}
+	bool start = !m_started;
+	m_started = true;
+	m_pendingJobsLock.unlock();
+
+	if (start) {
+		// The timer can only be started from the thread it lives in
+		QMetaObject::invokeMethod(this, "Start", Qt::QueuedConnection);
+	}
+}
+
+void
+JobProgressPublisher::Start()
+{
+	if (!m_timer->isActive()) {
+		m_timer->start();
+	}
+	// Publish the first update of a job right away
+	Flush();
+}
+
+void
+JobProgressPublisher::Flush()
+{
+	Flush(m_clock.elapsed());
+}
+
+void
+JobProgressPublisher::Flush(qint64 now)
+{
+	m_pendingJobsLock.lock();
+	QHash<QUuid, Job> pendingJobs;
+	pendingJobs.swap(m_pendingJobs);
+	m_pendingJobsLock.unlock();
+
+	QHash<QUuid, Job>::const_iterator pending;
+	for (pending = pendingJobs.constBegin(); pending != pendingJobs.constEnd(); pending++) {
+		QHash<QUuid, TrackedJob>::iterator tracked = m_trackedJobs.find(pending.key());
+		if (tracked == m_trackedJobs.end()) {
+			TrackedJob newJob;
+			newJob.lastBytesTransferred = pending->GetBytesTransferred();
+			newJob.lastSample = now;
+			newJob.rate = -1;
+			tracked = m_trackedJobs.insert(pending.key(), newJob);
+		}
+		tracked->job = *pending;
+	}
+
+	QList<Job> jobs;
+	QHash<QUuid, TrackedJob>::iterator tracked = m_trackedJobs.begin();
+	while (tracked != m_trackedJobs.end()) {
+		Job& job = tracked->job;
+		uint64_t bytesTransferred = job.GetBytesTransferred();
+		qint64 elapsed = now - tracked->lastSample;
+		if (elapsed > 0 && job.GetState() == Job::INPROGRESS) {
+			double bytes = 0;
+			if (bytesTransferred > tracked->lastBytesTransferred) {
+				bytes = bytesTransferred - tracked->lastBytesTransferred;
+			}
+			double rate = (bytes * 1000) / elapsed;
+			if (tracked->rate < 0) {
+				tracked->rate = rate;
+			} else {
+				tracked->rate = RATE_SMOOTHING * rate +
+						(1 - RATE_SMOOTHING) * tracked->rate;
+			}
+			tracked->lastBytesTransferred = bytesTransferred;
+			tracked->lastSample = now;
+		}
+
+		if (tracked->rate >= 0) {
+			job.SetRate(static_cast<uint64_t>(tracked->rate));
+			if (tracked->rate >= 1 && job.GetSize() > bytesTransferred) {
+				double bytesLeft = job.GetSize() - bytesTransferred;
+				job.SetSecondsLeft(static_cast<qint64>(bytesLeft / tracked->rate));
+			} else if (job.GetSize() <= bytesTransferred) {
+				job.SetSecondsLeft(0);
+			}
+		}
+		// Jobs that aren't transferring only change when published
+		if (job.GetState() == Job::INPROGRESS ||
+		    pendingJobs.contains(tracked.key())) {
+			jobs << job;
+		}
+
+		if (job.IsFinished() || job.WasCanceled()) {
+			tracked = m_trackedJobs.erase(tracked);
+		} else {
+			tracked++;
+		}
+	}
+
+	if (m_trackedJobs.isEmpty()) {
+		m_pendingJobsLock.lock();
+		if (m_pendingJobs.isEmpty()) {
+			m_timer->stop();
+			m_started = false;
+		}
+		m_pendingJobsLock.unlock();
+	}
+
+	if (!jobs.isEmpty()) {
+		emit JobsUpdated(jobs);
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef JOB_PROGRESS_PUBLISHER_H
+#define JOB_PROGRESS_PUBLISHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <QUuid>
+
+#include "models/job.h"
+
+// JobProgressPublisher, collects the job updates Client's threads publish
+// and hands the latest state of every job to the GUI in a single
+// JobsUpdated signal PUBLISH_INTERVAL milliseconds apart, no matter how
+// often the jobs were updated in between.  Each job's rate is smoothed
+// over those intervals so the rate and time left shown to the user follow
+// recent throughput rather than the average since the transfer started.
+//
+// The publisher must live in the GUI thread.  Publish can be called from
+// any thread.
+class JobProgressPublisher : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const int PUBLISH_INTERVAL;
+	static const double RATE_SMOOTHING;
+
+	JobProgressPublisher(QObject* parent = 0);
+
+	void Publish(const Job& job);
+
+	// Set the rates of the jobs published since the last flush and emit
+	// JobsUpdated with every job that is still being tracked.  now is
+	// the number of milliseconds since some fixed point in time.
+	void Flush(qint64 now);
+
+public slots:
+	void Flush();
+
+signals:
+	void JobsUpdated(const QList<Job> jobs);
+
+private slots:
+	void Start();
+
+private:
+	struct TrackedJob
+	{
+		Job job;
+		uint64_t lastBytesTransferred;
+		qint64 lastSample;
+		double rate;
+	};
+
+	// Jobs published since the last flush.  Only the latest update of
+	// each job is kept.
+	QHash<QUuid, Job> m_pendingJobs;
+	bool m_started;
+	QMutex m_pendingJobsLock;
+
+	QHash<QUuid, TrackedJob> m_trackedJobs;
+	QTimer* m_timer;
+	QElapsedTimer m_clock;
+};
+
+#endif
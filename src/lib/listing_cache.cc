@@ -0,0 +1,330 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/listing_cache.h"
+
+// Long enough to make going back into a folder free, short enough that
+// other clients' changes show up without a manual refresh
+const int ListingCache::DEFAULT_TTL = 30000;
+// About a hundred full get bucket pages
+const int ListingCache::DEFAULT_MAX_COST = 100000;
+
+static QString
+to_qstring(const ds3_str* str)
+{
+	if (str == NULL) {
+		return QString();
+	}
+	return QString::fromUtf8(str->value);
+}
+
+static QString
+owner_name(const ds3_owner* owner)
+{
+	if (owner == NULL) {
+		return QString();
+	}
+	return to_qstring(owner->name);
+}
+
+// QString::startsWith is false for a null string and an empty prefix
+static bool
+starts_with(const QString& str, const QString& prefix)
+{
+	return prefix.isEmpty() || str.startsWith(prefix);
+}
+
+Listing::Listing()
+	: truncated(false)
+{
+}
+
+Listing::Listing(const ds3_get_bucket_response* response)
+	: truncated(response->is_truncated),
+	  nextMarker(to_qstring(response->next_marker))
+{
+	objects.reserve((int)response->num_objects);
+	for (size_t i = 0; i < response->num_objects; i++) {
+		const ds3_object& rawObject = response->objects[i];
+		Object object;
+		object.name = to_qstring(rawObject.name);
+		object.size = rawObject.size;
+		object.lastModified = to_qstring(rawObject.last_modified);
+		object.etag = to_qstring(rawObject.etag);
+		object.owner = owner_name(rawObject.owner);
+		objects << object;
+	}
+
+	commonPrefixes.reserve((int)response->num_common_prefixes);
+	for (size_t i = 0; i < response->num_common_prefixes; i++) {
+		commonPrefixes << to_qstring(response->common_prefixes[i]);
+	}
+}
+
+Listing::Listing(const ds3_get_objects_response* response)
+	: truncated(false)
+{
+	objects.reserve((int)response->num_objects);
+	for (size_t i = 0; i < response->num_objects; i++) {
+		const ds3_search_object* rawObject = response->objects[i];
+		Object object;
+		object.name = to_qstring(rawObject->name);
+		object.size = rawObject->size;
+		object.lastModified = to_qstring(rawObject->last_modified);
+		object.owner = owner_name(rawObject->owner);
+		objects << object;
+	}
+}
+
+ListingCache::ListingCache(int ttl, int maxCost)
+	: m_ttl(ttl),
+	  m_maxCost(maxCost),
+	  m_nextSequence(0),
+	  m_generation(0),
+	  m_cost(0),
+	  m_hits(0),
+	  m_misses(0)
+{
+	m_clock.start();
+}
+
+qint64
+ListingCache::GetGeneration() const
+{
+	m_lock.lock();
+	qint64 generation = m_generation;
+	m_lock.unlock();
+	return generation;
+}
+
+QSharedPointer<const Listing>
+ListingCache::GetBucketListing(const QString& bucket, const QString& prefix,
+			       const QString& delimiter, const QString& marker)
+{
+	QStringList key;
+	key << "b" << bucket << prefix << delimiter << marker;
+	return Get(key.join("\n"));
+}
+
+void
+ListingCache::InsertBucketListing(const QString& bucket, const QString& prefix,
+				  const QString& delimiter, const QString& marker,
+				  QSharedPointer<const Listing> listing,
+				  qint64 generation)
+{
+	QStringList key;
+	key << "b" << bucket << prefix << delimiter << marker;
+	Entry entry;
+	entry.bucket = bucket;
+	entry.prefix = prefix;
+	entry.search = false;
+	entry.listing = listing;
+	Insert(key.join("\n"), entry, generation);
+}
+
+QSharedPointer<const Listing>
+ListingCache::GetSearchListing(const QString& bucket, const QString& name)
+{
+	QStringList key;
+	key << "s" << bucket << name;
+	return Get(key.join("\n"));
+}
+
+void
+ListingCache::InsertSearchListing(const QString& bucket, const QString& name,
+				  QSharedPointer<const Listing> listing,
+				  qint64 generation)
+{
+	QStringList key;
+	key << "s" << bucket << name;
+	Entry entry;
+	entry.bucket = bucket;
+	entry.search = true;
+	entry.listing = listing;
+	Insert(key.join("\n"), entry, generation);
+}
+
+void
+ListingCache::Invalidate(const QString& bucket, const QString& objName)
+{
+	InvalidateMatching(bucket, objName, true);
+}
+
+void
+ListingCache::InvalidatePrefix(const QString& bucket, const QString& prefix)
+{
+	InvalidateMatching(bucket, prefix, false);
+}
+
+void
+ListingCache::InvalidateBucket(const QString& bucket)
+{
+	InvalidateMatching(bucket, QString(), false);
+}
+
+void
+ListingCache::Clear()
+{
+	m_lock.lock();
+	m_entries.clear();
+	m_bucketKeys.clear();
+	m_insertionOrder.clear();
+	m_cost = 0;
+	m_generation++;
+	m_lock.unlock();
+}
+
+int
+ListingCache::GetCost() const
+{
+	m_lock.lock();
+	int cost = m_cost;
+	m_lock.unlock();
+	return cost;
+}
+
+int
+ListingCache::GetNumHits() const
+{
+	m_lock.lock();
+	int hits = m_hits;
+	m_lock.unlock();
+	return hits;
+}
+
+int
+ListingCache::GetNumMisses() const
+{
+	m_lock.lock();
+	int misses = m_misses;
+	m_lock.unlock();
+	return misses;
+}
+
+QSharedPointer<const Listing>
+ListingCache::Get(const QString& key)
+{
+	QSharedPointer<const Listing> listing;
+	m_lock.lock();
+	QHash<QString, Entry>::const_iterator entry(m_entries.constFind(key));
+	if (entry != m_entries.constEnd()) {
+		if (entry->expires > m_clock.elapsed()) {
+			listing = entry->listing;
+		} else {
+			Remove(key);
+		}
+	}
+	if (listing.isNull()) {
+		m_misses++;
+	} else {
+		m_hits++;
+	}
+	m_lock.unlock();
+	return listing;
+}
+
+void
+ListingCache::Insert(const QString& key, const Entry& entry,
+		     qint64 generation)
+{
+	int cost = entry.listing->objects.size() +
+		   entry.listing->commonPrefixes.size() + 1;
+	if (cost > m_maxCost) {
+		return;
+	}
+
+	m_lock.lock();
+	if (generation != -1 && generation != m_generation) {
+		m_lock.unlock();
+		return;
+	}
+	Remove(key);
+	qint64 now = m_clock.elapsed();
+	// Make room by dropping the expired entries and then the oldest
+	// ones, a quarter of the cache at a time so a full cache doesn't
+	// evict on every insert
+	if (m_cost + cost > m_maxCost) {
+		int target = qMin(m_maxCost - cost, m_maxCost * 3 / 4);
+		while (!m_insertionOrder.isEmpty()) {
+			QString oldest = m_insertionOrder.constBegin().value();
+			if (m_cost <= target &&
+			    m_entries.constFind(oldest)->expires > now) {
+				break;
+			}
+			Remove(oldest);
+		}
+	}
+	Entry& newEntry = m_entries[key];
+	newEntry = entry;
+	newEntry.expires = now + m_ttl;
+	newEntry.sequence = m_nextSequence++;
+	newEntry.cost = cost;
+	m_bucketKeys[entry.bucket].insert(key);
+	m_insertionOrder.insert(newEntry.sequence, key);
+	m_cost += cost;
+	m_lock.unlock();
+}
+
+void
+ListingCache::InvalidateMatching(const QString& bucket, const QString& name,
+				 bool ancestors)
+{
+	m_lock.lock();
+	m_generation++;
+	QHash<QString, QSet<QString> >::const_iterator keys(m_bucketKeys.constFind(bucket));
+	if (keys == m_bucketKeys.constEnd()) {
+		m_lock.unlock();
+		return;
+	}
+	QStringList toRemove;
+	for (QSet<QString>::const_iterator key = keys->constBegin();
+	     key != keys->constEnd();
+	     key++) {
+		const Entry& entry = m_entries.constFind(*key).value();
+		bool matches;
+		if (entry.search) {
+			matches = true;
+		} else if (ancestors) {
+			matches = starts_with(name, entry.prefix);
+		} else {
+			matches = starts_with(entry.prefix, name);
+		}
+		if (matches) {
+			toRemove << *key;
+		}
+	}
+	for (int i = 0; i < toRemove.size(); i++) {
+		Remove(toRemove[i]);
+	}
+	m_lock.unlock();
+}
+
+void
+ListingCache::Remove(const QString& key)
+{
+	QHash<QString, Entry>::iterator entry(m_entries.find(key));
+	if (entry == m_entries.end()) {
+		return;
+	}
+	m_cost -= entry->cost;
+	m_insertionOrder.remove(entry->sequence);
+	QHash<QString, QSet<QString> >::iterator keys(m_bucketKeys.find(entry->bucket));
+	keys->remove(key);
+	if (keys->isEmpty()) {
+		m_bucketKeys.erase(keys);
+	}
+	m_entries.erase(entry);
+}
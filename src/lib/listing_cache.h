@@ -0,0 +1,145 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef LISTING_CACHE_H
+#define LISTING_CACHE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+#include <ds3.h>
+
+// Listing, a get bucket or get objects response copied out of the C SDK's
+// structures so it can be shared by every thread that reads it
+struct Listing {
+	struct Object {
+		QString name;
+		uint64_t size;
+		// Empty if the server didn't report it
+		QString lastModified;
+		QString etag;
+		QString owner;
+	};
+
+	Listing();
+	Listing(const ds3_get_bucket_response* response);
+	Listing(const ds3_get_objects_response* response);
+
+	QList<Object> objects;
+	QStringList commonPrefixes;
+	bool truncated;
+	QString nextMarker;
+};
+
+// ListingCache, the listings that a session's Client got recently.  Each
+// one expires ttl milliseconds after it was inserted and the oldest are
+// evicted once the cache holds more than maxCost objects and common
+// prefixes.  The Client forgets the listings that its own PUTs and deletes
+// change.
+class ListingCache
+{
+public:
+	static const int DEFAULT_TTL;
+	static const int DEFAULT_MAX_COST;
+
+	ListingCache(int ttl = DEFAULT_TTL, int maxCost = DEFAULT_MAX_COST);
+
+	// Changes whenever a listing is invalidated
+	qint64 GetGeneration() const;
+
+	// The unexpired get bucket listing of prefix that started after
+	// marker, or NULL
+	QSharedPointer<const Listing> GetBucketListing(const QString& bucket,
+						       const QString& prefix,
+						       const QString& delimiter,
+						       const QString& marker);
+	// Insert a listing unless the generation, from before it was
+	// requested, shows that something was invalidated while it was in
+	// flight and so it could already be out of date.  -1 always
+	// inserts it.
+	void InsertBucketListing(const QString& bucket,
+				 const QString& prefix,
+				 const QString& delimiter,
+				 const QString& marker,
+				 QSharedPointer<const Listing> listing,
+				 qint64 generation = -1);
+	// The unexpired get objects listing of the objects whose names
+	// match name, or NULL
+	QSharedPointer<const Listing> GetSearchListing(const QString& bucket,
+						       const QString& name);
+	void InsertSearchListing(const QString& bucket,
+				 const QString& name,
+				 QSharedPointer<const Listing> listing,
+				 qint64 generation = -1);
+
+	// Forget every listing that objName could be in because it was just
+	// created or deleted
+	void Invalidate(const QString& bucket, const QString& objName);
+	// Forget the listings of prefix and of everything under it
+	void InvalidatePrefix(const QString& bucket, const QString& prefix);
+	void InvalidateBucket(const QString& bucket);
+	void Clear();
+
+	int GetCost() const;
+	int GetNumHits() const;
+	int GetNumMisses() const;
+
+private:
+	struct Entry {
+		QString bucket;
+		// Empty for searches
+		QString prefix;
+		bool search;
+		QSharedPointer<const Listing> listing;
+		qint64 expires;
+		qint64 sequence;
+		int cost;
+	};
+
+	QSharedPointer<const Listing> Get(const QString& key);
+	void Insert(const QString& key, const Entry& entry, qint64 generation);
+	// Forget the bucket's searches and the listings whose prefixes
+	// start with, or if ancestors, are the start of, name
+	void InvalidateMatching(const QString& bucket, const QString& name,
+				bool ancestors);
+	void Remove(const QString& key);
+
+	const int m_ttl;
+	const int m_maxCost;
+	QHash<QString, Entry> m_entries;
+	// The keys of each bucket's entries so invalidating one bucket
+	// doesn't have to look at all of them
+	QHash<QString, QSet<QString> > m_bucketKeys;
+	// Every key by when it was inserted, oldest first.  Since every
+	// entry lives for m_ttl, that's also the order they expire in.
+	QMap<qint64, QString> m_insertionOrder;
+	qint64 m_nextSequence;
+	qint64 m_generation;
+	int m_cost;
+	int m_hits;
+	int m_misses;
+	QElapsedTimer m_clock;
+	mutable QMutex m_lock;
+};
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <string.h>
+#include <zlib.h>
+#include <QFile>
+#include <QFileInfo>
+
+#include "lib/executor.h"
+#include "lib/object_compressor.h"
+
+const QString ObjectCompressor::SUFFIX = ".ds3z";
+
+// Large enough for deflate to find most of the redundancy in text and
+// small enough that a few blocks per transfer keep memory use low
+const qint64 ObjectCompressor::BLOCK_SIZE = 1024 * 1024;
+
+// zlib's fastest level.  Higher levels gain a few percent on typical text
+// data for several times the CPU time.
+const int ObjectCompressor::COMPRESSION_LEVEL = 1;
+
+// Blocks compressed ahead of the one being sent
+const int ObjectCompressor::MAX_BLOCKS_AHEAD = 4;
+
+// Window bits that make zlib write a gzip header and trailer
+static const int GZIP_WINDOW_BITS = 15 + 16;
+
+ObjectCompressor::ObjectCompressor(const QString& fileName, Executor* executor)
+	: m_fileName(fileName),
+	  m_executor(executor),
+	  m_fileSize(-1),
+	  m_numBlocks(0),
+	  m_nextBlock(0),
+	  m_blockPos(0)
+{
+}
+
+ObjectCompressor::~ObjectCompressor()
+{
+	while (!m_queue.isEmpty()) {
+		m_queue.dequeue().waitForFinished();
+	}
+}
+
+bool
+ObjectCompressor::IsCompressed(const QString& objName)
+{
+	return objName.endsWith(SUFFIX);
+}
+
+QString
+ObjectCompressor::RemoveSuffix(const QString& objName)
+{
+	if (!IsCompressed(objName)) {
+		return objName;
+	}
+	return objName.left(objName.size() - SUFFIX.size());
+}
+
+QByteArray
+ObjectCompressor::CompressBlock(const QByteArray& data)
+{
+	z_stream stream;
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	if (deflateInit2(&stream, COMPRESSION_LEVEL, Z_DEFLATED,
+			 GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return QByteArray();
+	}
+	QByteArray compressed(deflateBound(&stream, data.size()), '\0');
+	stream.next_in = (Bytef*)data.constData();
+	stream.avail_in = data.size();
+	stream.next_out = (Bytef*)compressed.data();
+	stream.avail_out = compressed.size();
+	int ret = deflate(&stream, Z_FINISH);
+	compressed.resize(stream.total_out);
+	deflateEnd(&stream);
+	if (ret != Z_STREAM_END) {
+		return QByteArray();
+	}
+	return compressed;
+}
+
+bool
+ObjectCompressor::Open()
+{
+	if (m_fileSize < 0) {
+		QFileInfo fileInfo(m_fileName);
+		if (!fileInfo.isFile()) {
+			return false;
+		}
+		m_fileSize = fileInfo.size();
+		m_numBlocks = (m_fileSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	}
+	return true;
+}
+
+bool
+ObjectCompressor::GetCompressedSize(uint64_t* size)
+{
+	if (!Open() || !MeasureBlocks(m_numBlocks - 1)) {
+		return false;
+	}
+	*size = 0;
+	for (int i = 0; i < m_blockSizes.size(); i++) {
+		*size += m_blockSizes[i];
+	}
+	return true;
+}
+
+bool
+ObjectCompressor::MeasureBlocks(qint64 block)
+{
+	QQueue<QFuture<QByteArray> > measuring;
+	qint64 next = m_blockSizes.size();
+	bool ok = true;
+	while (ok && m_blockSizes.size() <= block) {
+		while (next <= block && measuring.size() < MAX_BLOCKS_AHEAD) {
+			measuring << m_executor->Run(this, &ObjectCompressor::ReadAndCompressBlock,
+						     next++);
+		}
+		QByteArray compressed = measuring.dequeue().result();
+		ok = !compressed.isEmpty();
+		if (ok) {
+			m_blockSizes << compressed.size();
+		}
+	}
+	while (!measuring.isEmpty()) {
+		measuring.dequeue().waitForFinished();
+	}
+	return ok;
+}
+
+bool
+ObjectCompressor::Seek(uint64_t offset)
+{
+	if (!Open()) {
+		return false;
+	}
+	while (!m_queue.isEmpty()) {
+		m_queue.dequeue().waitForFinished();
+	}
+	m_block.clear();
+	m_blockPos = 0;
+
+	// Find the block that offset is in
+	uint64_t start = 0;
+	qint64 block = 0;
+	for (; block < m_numBlocks; block++) {
+		if (block >= m_blockSizes.size() && !MeasureBlocks(block)) {
+			return false;
+		}
+		if (offset < start + m_blockSizes[block]) {
+			break;
+		}
+		start += m_blockSizes[block];
+	}
+	m_nextBlock = block;
+	if (block < m_numBlocks) {
+		QueueBlocks();
+		m_block = m_queue.dequeue().result();
+		m_nextBlock++;
+		m_blockPos = offset - start;
+		if (m_block.isEmpty()) {
+			return false;
+		}
+	}
+	QueueBlocks();
+	return true;
+}
+
+void
+ObjectCompressor::QueueBlocks()
+{
+	qint64 block = m_nextBlock + m_queue.size();
+	while (block < m_numBlocks && m_queue.size() < MAX_BLOCKS_AHEAD) {
+		m_queue << m_executor->Run(this, &ObjectCompressor::ReadAndCompressBlock,
+					   block++);
+	}
+}
+
+qint64
+ObjectCompressor::Read(char* data, qint64 maxSize)
+{
+	if (m_fileSize < 0 && !Seek(0)) {
+		return -1;
+	}
+	qint64 numRead = 0;
+	while (numRead < maxSize) {
+		if (m_blockPos >= m_block.size()) {
+			if (m_queue.isEmpty()) {
+				break;
+			}
+			m_block = m_queue.dequeue().result();
+			m_nextBlock++;
+			m_blockPos = 0;
+			if (m_block.isEmpty()) {
+				return -1;
+			}
+			QueueBlocks();
+		}
+		qint64 size = qMin(maxSize - numRead,
+				   (qint64)m_block.size() - m_blockPos);
+		memcpy(data + numRead, m_block.constData() + m_blockPos, size);
+		numRead += size;
+		m_blockPos += size;
+	}
+	return numRead;
+}
+
+// Runs on the executor's threads.  Each block is read with its own file
+// handle so any number of them can be read at once.
+QByteArray
+ObjectCompressor::ReadAndCompressBlock(qint64 block)
+{
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadOnly) || !file.seek(block * BLOCK_SIZE)) {
+		return QByteArray();
+	}
+	QByteArray data = file.read(qMin(BLOCK_SIZE, m_fileSize - block * BLOCK_SIZE));
+	if (data.size() != qMin(BLOCK_SIZE, m_fileSize - block * BLOCK_SIZE)) {
+		return QByteArray();
+	}
+	return CompressBlock(data);
+}
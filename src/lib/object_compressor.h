@@ -0,0 +1,108 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef OBJECT_COMPRESSOR_H
+#define OBJECT_COMPRESSOR_H
+
+#include <stdint.h>
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+#include <QQueue>
+#include <QString>
+
+class Executor;
+
+// ObjectCompressor, produces the gzip compressed data of a file as it's
+// being PUT, without ever holding more than a few blocks of it in memory.
+// The file is split into BLOCK_SIZE blocks which are each compressed into
+// their own gzip member on the executor's threads, several blocks ahead of
+// the one being sent.  The members back to back make a regular gzip file.
+//
+// Every block is compressed the same way each time so the compressed size
+// found while preparing a job is exactly what's sent later, and a blob that
+// starts part way into the compressed data can be produced by compressing
+// from the block that it starts in.
+//
+// Compressed objects are named with SUFFIX so GETs know to decompress them.
+// The SDK's GETs don't return the response's headers, so object metadata
+// would cost a HEAD request per object.  The suffix is visible to users and
+// other S3 clients, which the session dialog tells them.
+class ObjectCompressor
+{
+public:
+	static const QString SUFFIX;
+	static const qint64 BLOCK_SIZE;
+	static const int COMPRESSION_LEVEL;
+	static const int MAX_BLOCKS_AHEAD;
+
+	ObjectCompressor(const QString& fileName, Executor* executor);
+	// Waits for the blocks that are still being compressed
+	~ObjectCompressor();
+
+	static bool IsCompressed(const QString& objName);
+	// objName or a file path without SUFFIX
+	static QString RemoveSuffix(const QString& objName);
+	static QByteArray CompressBlock(const QByteArray& data);
+
+	// The size of all of the file's compressed data.  Returns false if
+	// the file couldn't be read.
+	bool GetCompressedSize(uint64_t* size);
+	// The compressed size of each of the file's blocks, as measured so
+	// far.  Handing the sizes that GetCompressedSize found to a later
+	// compressor of the same file lets it Seek without compressing every
+	// block before offset again.
+	const QList<qint64>& GetBlockSizes() const;
+	void SetBlockSizes(const QList<qint64>& sizes);
+	// Start reading at offset of the compressed data
+	bool Seek(uint64_t offset);
+	// Returns the number of bytes read, 0 at the end of the data, or -1
+	// if the file couldn't be read.
+	qint64 Read(char* data, qint64 maxSize);
+
+private:
+	bool Open();
+	// Find the compressed size of every block up to and including block
+	bool MeasureBlocks(qint64 block);
+	void QueueBlocks();
+	QByteArray ReadAndCompressBlock(qint64 block);
+
+	QString m_fileName;
+	Executor* m_executor;
+	qint64 m_fileSize;
+	qint64 m_numBlocks;
+	// The compressed sizes of the first blocks that have been measured
+	QList<qint64> m_blockSizes;
+
+	qint64 m_nextBlock;
+	QQueue<QFuture<QByteArray> > m_queue;
+	QByteArray m_block;
+	qint64 m_blockPos;
+};
+
+inline const QList<qint64>&
+ObjectCompressor::GetBlockSizes() const
+{
+	return m_blockSizes;
+}
+
+inline void
+ObjectCompressor::SetBlockSizes(const QList<qint64>& sizes)
+{
+	m_blockSizes = sizes;
+}
+
+#endif
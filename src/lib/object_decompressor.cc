@@ -0,0 +1,128 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QFile>
+
+#include "lib/object_decompressor.h"
+
+const QString ObjectDecompressor::PART_SUFFIX = ".ds3z.part";
+
+const int ObjectDecompressor::BUFFER_SIZE = 256 * 1024;
+
+// Window bits that make zlib expect a gzip header and trailer
+static const int GZIP_WINDOW_BITS = 15 + 16;
+
+ObjectDecompressor::ObjectDecompressor(QIODevice* output)
+	: m_output(output),
+	  m_failed(false),
+	  m_memberEnded(true),
+	  m_buffer(BUFFER_SIZE, '\0')
+{
+	m_stream.zalloc = Z_NULL;
+	m_stream.zfree = Z_NULL;
+	m_stream.opaque = Z_NULL;
+	m_stream.next_in = Z_NULL;
+	m_stream.avail_in = 0;
+	m_initialized = (inflateInit2(&m_stream, GZIP_WINDOW_BITS) == Z_OK);
+}
+
+ObjectDecompressor::~ObjectDecompressor()
+{
+	if (m_initialized) {
+		inflateEnd(&m_stream);
+	}
+}
+
+bool
+ObjectDecompressor::Write(const char* data, qint64 size)
+{
+	if (!m_initialized || m_failed) {
+		return false;
+	}
+	m_stream.next_in = (Bytef*)data;
+	m_stream.avail_in = size;
+	while (m_stream.avail_in > 0) {
+		if (m_memberEnded) {
+			inflateReset(&m_stream);
+			m_memberEnded = false;
+		}
+		m_stream.next_out = (Bytef*)m_buffer.data();
+		m_stream.avail_out = m_buffer.size();
+		int ret = inflate(&m_stream, Z_NO_FLUSH);
+		if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+			m_failed = true;
+			return false;
+		}
+		qint64 numInflated = m_buffer.size() - m_stream.avail_out;
+		if (numInflated > 0 &&
+		    m_output->write(m_buffer.constData(), numInflated) != numInflated) {
+			m_failed = true;
+			return false;
+		}
+		if (ret == Z_STREAM_END) {
+			m_memberEnded = true;
+		}
+	}
+	return true;
+}
+
+bool
+ObjectDecompressor::Finish()
+{
+	if (!m_initialized || m_failed) {
+		return false;
+	}
+	// Flush whatever is left of the last member
+	for (;;) {
+		if (m_memberEnded) {
+			return true;
+		}
+		m_stream.next_out = (Bytef*)m_buffer.data();
+		m_stream.avail_out = m_buffer.size();
+		int ret = inflate(&m_stream, Z_FINISH);
+		qint64 numInflated = m_buffer.size() - m_stream.avail_out;
+		if (numInflated > 0 &&
+		    m_output->write(m_buffer.constData(), numInflated) != numInflated) {
+			return false;
+		}
+		if (ret == Z_STREAM_END) {
+			m_memberEnded = true;
+		} else if (numInflated == 0) {
+			// Truncated
+			return false;
+		}
+	}
+}
+
+bool
+ObjectDecompressor::DecompressFile(const QString& source,
+				   const QString& destination)
+{
+	QFile in(source);
+	QFile out(destination);
+	if (!in.open(QIODevice::ReadOnly) ||
+	    !out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	ObjectDecompressor decompressor(&out);
+	QByteArray data;
+	while (!(data = in.read(BUFFER_SIZE)).isEmpty()) {
+		if (!decompressor.Write(data.constData(), data.size())) {
+			return false;
+		}
+	}
+	return decompressor.Finish();
+}
@@ -0,0 +1,60 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef OBJECT_DECOMPRESSOR_H
+#define OBJECT_DECOMPRESSOR_H
+
+#include <zlib.h>
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+// ObjectDecompressor, decompresses the data of an object that
+// ObjectCompressor compressed, as it's being downloaded, into a file.  The
+// data is a series of gzip members which are decompressed one after
+// another.
+class ObjectDecompressor
+{
+public:
+	// What a compressed object that is downloaded in several blobs is
+	// saved as until all of them are in and it can be decompressed
+	static const QString PART_SUFFIX;
+	static const int BUFFER_SIZE;
+
+	ObjectDecompressor(QIODevice* output);
+	~ObjectDecompressor();
+
+	// Decompress the next size bytes of compressed data.  Returns false
+	// if the data is corrupt or the output couldn't be written.
+	bool Write(const char* data, qint64 size);
+	// Whether all of the data has been written and ended at the end of
+	// a gzip member
+	bool Finish();
+
+	static bool DecompressFile(const QString& source,
+				   const QString& destination);
+
+private:
+	QIODevice* m_output;
+	z_stream m_stream;
+	bool m_initialized;
+	bool m_failed;
+	// Whether the last gzip member ended and the next one hasn't started
+	bool m_memberEnded;
+	QByteArray m_buffer;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFileInfo>
+#include <QUuid>
+
+#include "helpers/path_helper.h"
+#include "lib/small_file_archive.h"
+#include "quazip/quazipfile.h"
+#include "quazip/quazipnewinfo.h"
+
+// Files this small cost more in per-request overhead than in transferring
+// their data
+const uint64_t SmallFileArchive::MAX_MEMBER_SIZE = 64 * 1024;
+
+// Large enough to cut the number of requests by three orders of magnitude
+// for the smallest files while keeping each archive a single job chunk
+const uint64_t SmallFileArchive::MAX_ARCHIVE_SIZE = 64 * 1024 * 1024;
+
+// Keeps the archives' central directories, which are held in memory while
+// an archive is being created, bounded
+const int SmallFileArchive::MAX_MEMBERS = 16384;
+
+const QString SmallFileArchive::NAME_PREFIX = ".ds3archive-";
+const QString SmallFileArchive::NAME_SUFFIX = ".zip";
+const QString SmallFileArchive::INDEX_SUFFIX = ".index";
+
+// Member names are UTF-8 so they match the object names they replace
+static const char* FILE_NAME_CODEC = "UTF-8";
+
+SmallFileArchive::SmallFileArchive(const QString& path)
+	: m_path(path),
+	  m_file(path),
+	  m_size(0)
+{
+	m_zip.setIoDevice(&m_file);
+	m_zip.setFileNameCodec(FILE_NAME_CODEC);
+}
+
+SmallFileArchive::~SmallFileArchive()
+{
+	if (m_zip.isOpen()) {
+		m_zip.close();
+	}
+}
+
+bool
+SmallFileArchive::IsFull(uint64_t size) const
+{
+	return (m_members.size() >= MAX_MEMBERS ||
+		(!m_members.isEmpty() && m_size + size > MAX_ARCHIVE_SIZE));
+}
+
+bool
+SmallFileArchive::Open()
+{
+	QDir().mkpath(QFileInfo(m_path).absolutePath());
+	return m_zip.open(QuaZip::mdCreate);
+}
+
+bool
+SmallFileArchive::Add(const QString& name, const QString& filePath)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QByteArray data = file.readAll();
+	file.close();
+
+	QuaZipFile zipFile(&m_zip);
+	QuaZipNewInfo info(name, filePath);
+	// Stored, rather than deflated, so the member's data is a contiguous
+	// byte range of the archive
+	if (!zipFile.open(QIODevice::WriteOnly, info, NULL, 0, 0, 0)) {
+		return false;
+	}
+	// The local file header has been written so this is where the data
+	// starts
+	Member member;
+	member.name = name;
+	member.offset = m_file.pos();
+	member.size = data.size();
+	zipFile.write(data);
+	zipFile.close();
+	if (zipFile.getZipError() != ZIP_OK) {
+		return false;
+	}
+	m_members << member;
+	m_size = m_file.pos();
+	return true;
+}
+
+bool
+SmallFileArchive::Close()
+{
+	m_zip.close();
+	if (m_zip.getZipError() != ZIP_OK) {
+		return false;
+	}
+	m_size = QFileInfo(m_path).size();
+
+	QFile index(GetIndexPath());
+	if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	for (int i = 0; i < m_members.size(); i++) {
+		const Member& member = m_members[i];
+		QByteArray line = QByteArray::number((qulonglong)member.offset) + "\t" +
+				  QByteArray::number((qulonglong)member.size) + "\t" +
+				  member.name.toUtf8() + "\n";
+		if (index.write(line) != line.size()) {
+			return false;
+		}
+	}
+	return index.flush();
+}
+
+bool
+SmallFileArchive::CanPack(const QString& name, uint64_t size)
+{
+	// The index is tab and newline delimited
+	return (size < MAX_MEMBER_SIZE &&
+		!name.contains('\t') && !name.contains('\n'));
+}
+
+QString
+SmallFileArchive::CreateObjectName(const QString& dirObjName)
+{
+	QString id = QUuid::createUuid().toString().mid(1, 36);
+	return dirObjName + NAME_PREFIX + id + NAME_SUFFIX;
+}
+
+bool
+SmallFileArchive::IsArchive(const QString& objName)
+{
+	QString name = objName.mid(objName.lastIndexOf('/') + 1);
+	return (name.startsWith(NAME_PREFIX) && name.endsWith(NAME_SUFFIX));
+}
+
+bool
+SmallFileArchive::IsIndex(const QString& objName)
+{
+	return (objName.endsWith(INDEX_SUFFIX) &&
+		IsArchive(objName.left(objName.size() - INDEX_SUFFIX.size())));
+}
+
+QString
+SmallFileArchive::GetArchiveName(const QString& indexObjName)
+{
+	return indexObjName.left(indexObjName.size() - INDEX_SUFFIX.size());
+}
+
+bool
+SmallFileArchive::ReadIndex(const QByteArray& index, QList<Member>* members)
+{
+	QList<QByteArray> lines = index.split('\n');
+	// The last line ends with a newline too
+	if (!lines.last().isEmpty()) {
+		return false;
+	}
+	lines.removeLast();
+	for (int i = 0; i < lines.size(); i++) {
+		QList<QByteArray> fields = lines[i].split('\t');
+		if (fields.size() != 3) {
+			return false;
+		}
+		Member member;
+		bool offsetOK, sizeOK;
+		member.offset = fields[0].toULongLong(&offsetOK);
+		member.size = fields[1].toULongLong(&sizeOK);
+		member.name = QString::fromUtf8(fields[2]);
+		if (!offsetOK || !sizeOK) {
+			return false;
+		}
+		*members << member;
+	}
+	return true;
+}
+
+bool
+SmallFileArchive::ExtractMember(const QByteArray& data, uint64_t dataOffset,
+				const Member& member,
+				const QString& fileName)
+{
+	if (member.offset < dataOffset ||
+	    member.offset + member.size > dataOffset + data.size()) {
+		return false;
+	}
+	QDir().mkpath(QFileInfo(fileName).absolutePath());
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	qint64 size = member.size;
+	if (file.write(data.constData() + (member.offset - dataOffset), size) != size) {
+		file.close();
+		file.remove();
+		return false;
+	}
+	return true;
+}
+
+bool
+SmallFileArchive::Extract(const QString& archivePath, const QString& dir,
+			  QStringList* skipped)
+{
+	QuaZip zip(archivePath);
+	zip.setFileNameCodec(FILE_NAME_CODEC);
+	if (!zip.open(QuaZip::mdUnzip)) {
+		return false;
+	}
+	QString root = PathHelper::AddTrailingSlash(QDir::cleanPath(dir));
+	bool ok = true;
+	for (bool more = zip.goToFirstFile(); more && ok; more = zip.goToNextFile()) {
+		QString name = zip.getCurrentFileName();
+		QString fileName = QDir::cleanPath(root + name);
+		if (!fileName.startsWith(root) || QFileInfo(fileName).exists()) {
+			*skipped << name;
+			continue;
+		}
+		QDir().mkpath(QFileInfo(fileName).absolutePath());
+		QuaZipFile zipFile(&zip);
+		QFile file(fileName);
+		ok = zipFile.open(QIODevice::ReadOnly) &&
+		     file.open(QIODevice::WriteOnly);
+		if (ok) {
+			QByteArray data = zipFile.readAll();
+			ok = (file.write(data) == data.size() &&
+			      zipFile.getZipError() == UNZ_OK);
+		}
+		zipFile.close();
+	}
+	zip.close();
+	return ok;
+}
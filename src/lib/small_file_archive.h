@@ -0,0 +1,130 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef SMALL_FILE_ARCHIVE_H
+#define SMALL_FILE_ARCHIVE_H
+
+#include <stdint.h>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "quazip/quazip.h"
+
+// SmallFileArchive, a zip archive that many small files are packed into so
+// they can be PUT as a single object instead of one request per file.
+// Members are stored uncompressed so each one is a contiguous byte range of
+// the archive.  A sidecar index object, next to the archive object, lists
+// every member's name, offset and size so the members under a folder, or a
+// single member, can be read out of the archive with ranged GETs instead of
+// downloading all of it.
+//
+// Archive objects are named <directory>/.ds3archive-<id>.zip and their
+// indexes <directory>/.ds3archive-<id>.zip.index.  Member names are relative
+// to <directory>.  A GET of <directory> itself, or of anything above it,
+// downloads and unpacks the whole archive.
+class SmallFileArchive
+{
+public:
+	static const uint64_t MAX_MEMBER_SIZE;
+	static const uint64_t MAX_ARCHIVE_SIZE;
+	static const int MAX_MEMBERS;
+	static const QString NAME_PREFIX;
+	static const QString NAME_SUFFIX;
+	static const QString INDEX_SUFFIX;
+
+	struct Member {
+		QString name;
+		// Where the member's data starts in the archive
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	SmallFileArchive(const QString& path);
+	// Closes the archive if it's still open
+	~SmallFileArchive();
+
+	const QString& GetPath() const;
+	QString GetIndexPath() const;
+	// The archive's size so far
+	uint64_t GetSize() const;
+	int GetNumMembers() const;
+	// Whether another member of size bytes would exceed MAX_ARCHIVE_SIZE
+	// or MAX_MEMBERS
+	bool IsFull(uint64_t size) const;
+
+	bool Open();
+	bool Add(const QString& name, const QString& filePath);
+	// Finish the archive and write its index next to it
+	bool Close();
+
+	// Whether a file can be packed into an archive rather than being
+	// sent as its own object
+	static bool CanPack(const QString& name, uint64_t size);
+	static QString CreateObjectName(const QString& dirObjName);
+	static bool IsArchive(const QString& objName);
+	static bool IsIndex(const QString& objName);
+
+	// The archive object that an index object is for
+	static QString GetArchiveName(const QString& indexObjName);
+
+	static bool ReadIndex(const QByteArray& index, QList<Member>* members);
+	// Copy a member's byte range into fileName.  data is the part of the
+	// archive that starts at dataOffset and it must hold all of the
+	// member.
+	static bool ExtractMember(const QByteArray& data, uint64_t dataOffset,
+				  const Member& member,
+				  const QString& fileName);
+	// Extract every member into dir.  Members that would overwrite an
+	// existing file, or that would land outside of dir, are skipped and
+	// added to skipped.
+	static bool Extract(const QString& archivePath, const QString& dir,
+			    QStringList* skipped);
+
+private:
+	QString m_path;
+	QFile m_file;
+	QuaZip m_zip;
+	QList<Member> m_members;
+	uint64_t m_size;
+};
+
+inline const QString&
+SmallFileArchive::GetPath() const
+{
+	return m_path;
+}
+
+inline QString
+SmallFileArchive::GetIndexPath() const
+{
+	return m_path + INDEX_SUFFIX;
+}
+
+inline uint64_t
+SmallFileArchive::GetSize() const
+{
+	return m_size;
+}
+
+inline int
+SmallFileArchive::GetNumMembers() const
+{
+	return m_members.size();
+}
+
+#endif
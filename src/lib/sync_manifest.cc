@@ -0,0 +1,313 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUuid>
+#include <QVariant>
+
+#include "lib/logger.h"
+#include "lib/sync_manifest.h"
+
+// The number of changed records, or server objects, that are buffered before
+// they're written out
+const int SyncManifest::FLUSH_ROWS = 10000;
+
+QString
+SyncManifest::GetDir()
+{
+	QString dataDir = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+	return QDir::cleanPath(dataDir + "/manifests");
+}
+
+QString
+SyncManifest::GetPath(const QString& host, const QString& bucketName,
+		      const QString& prefix)
+{
+	QString key = host + "\n" + bucketName + "\n" + prefix;
+	QByteArray hash = QCryptographicHash::hash(key.toUtf8(),
+						   QCryptographicHash::Sha1);
+	return QDir(GetDir()).filePath(QString::fromLatin1(hash.toHex()) + ".manifest");
+}
+
+SyncManifest::SyncManifest(const QString& path, bool compareContents)
+	: m_path(path),
+	  m_compareContents(compareContents),
+	  m_connectionPrefix("sync-" + QUuid::createUuid().toString() + "-"),
+	  m_open(false),
+	  m_numUnchanged(0)
+{
+}
+
+SyncManifest::~SyncManifest()
+{
+	Close();
+}
+
+bool
+SyncManifest::Open()
+{
+	if (!QDir().mkpath(QFileInfo(m_path).path())) {
+		return false;
+	}
+	m_open = true;
+	QSqlDatabase db = Database();
+	if (!db.isOpen()) {
+		Close();
+		return false;
+	}
+	QSqlQuery query(db);
+	bool ok = query.exec("CREATE TABLE IF NOT EXISTS files ("
+			     "path TEXT PRIMARY KEY, size INTEGER, "
+			     "modified INTEGER, hash BLOB)") &&
+		  query.exec("CREATE TABLE IF NOT EXISTS server_objects ("
+			     "name TEXT PRIMARY KEY, size INTEGER)");
+	if (!ok) {
+		LOG_ERROR("ERROR:       Unable to create sync manifest " +
+			  m_path + ": " + query.lastError().text());
+		Close();
+	}
+	return ok;
+}
+
+void
+SyncManifest::Close()
+{
+	if (m_open) {
+		Flush();
+	}
+	m_open = false;
+	m_connectionsLock.lock();
+	for (int i = 0; i < m_connections.size(); i++) {
+		QSqlDatabase::removeDatabase(m_connections[i]);
+	}
+	m_connections.clear();
+	m_connectionsLock.unlock();
+}
+
+QSqlDatabase
+SyncManifest::Database()
+{
+	QString name = m_connectionPrefix +
+		       QString::number((quintptr)QThread::currentThread());
+	m_connectionsLock.lock();
+	QSqlDatabase db;
+	if (m_connections.contains(name)) {
+		db = QSqlDatabase::database(name);
+	} else {
+		db = QSqlDatabase::addDatabase("QSQLITE", name);
+		db.setDatabaseName(m_path);
+		if (db.open()) {
+			// The manifest can always be rebuilt by uploading
+			// again so it isn't worth syncing every transaction
+			QSqlQuery query(db);
+			query.exec("PRAGMA synchronous = OFF");
+		} else {
+			LOG_ERROR("ERROR:       Unable to open sync manifest " +
+				  m_path + ": " + db.lastError().text());
+		}
+		m_connections << name;
+	}
+	m_connectionsLock.unlock();
+	return db;
+}
+
+void
+SyncManifest::ClearServerObjects()
+{
+	m_serverObjects.clear();
+	QSqlQuery query(Database());
+	if (!query.exec("DELETE FROM server_objects")) {
+		LOG_ERROR("ERROR:       Unable to clear sync manifest " +
+			  m_path + ": " + query.lastError().text());
+	}
+}
+
+void
+SyncManifest::AddServerObject(const QString& name, uint64_t size)
+{
+	ServerObject object;
+	object.name = name;
+	object.size = size;
+	m_serverObjects << object;
+	if (m_serverObjects.size() >= FLUSH_ROWS) {
+		FlushServerObjects();
+	}
+}
+
+bool
+SyncManifest::GetServerObjectSize(const QString& name, uint64_t* size)
+{
+	if (!m_serverObjects.isEmpty()) {
+		FlushServerObjects();
+	}
+	QSqlQuery query(Database());
+	query.prepare("SELECT size FROM server_objects WHERE name = ?");
+	query.addBindValue(name);
+	if (!query.exec() || !query.next()) {
+		return false;
+	}
+	*size = query.value(0).toULongLong();
+	return true;
+}
+
+SyncManifest::Status
+SyncManifest::Compare(const QString& relativePath, const QString& path,
+		      uint64_t size, qint64 modified)
+{
+	m_recordsLock.lock();
+	bool flush = m_records.size() >= FLUSH_ROWS;
+	m_recordsLock.unlock();
+	if (flush) {
+		Flush();
+	}
+
+	QSqlQuery query(Database());
+	query.prepare("SELECT size, modified, hash FROM files WHERE path = ?");
+	query.addBindValue(relativePath);
+	Status status = NEW;
+	Record record;
+	record.relativePath = relativePath;
+	record.size = size;
+	record.modified = modified;
+	if (query.exec() && query.next()) {
+		uint64_t oldSize = query.value(0).toULongLong();
+		qint64 oldModified = query.value(1).toLongLong();
+		QByteArray oldHash = query.value(2).toByteArray();
+		if (oldSize == size && oldModified == modified) {
+			m_numUnchanged++;
+			return UNCHANGED;
+		}
+		status = CHANGED;
+		if (m_compareContents && oldSize == size && !oldHash.isEmpty()) {
+			// Only the time changed, e.g. the file was copied
+			// again or touched
+			record.hash = HashFile(path);
+			if (record.hash == oldHash) {
+				status = UNCHANGED;
+				m_numUnchanged++;
+			}
+		}
+	}
+	if (m_compareContents && record.hash.isEmpty()) {
+		record.hash = HashFile(path);
+	}
+	m_recordsLock.lock();
+	m_pending.insert(relativePath, record);
+	m_recordsLock.unlock();
+	return status;
+}
+
+void
+SyncManifest::Commit(const QString& relativePath)
+{
+	m_recordsLock.lock();
+	QHash<QString, Record>::iterator ri = m_pending.find(relativePath);
+	if (ri != m_pending.end()) {
+		m_records << ri.value();
+		m_pending.erase(ri);
+	}
+	m_recordsLock.unlock();
+}
+
+void
+SyncManifest::Discard(const QString& relativePath)
+{
+	m_recordsLock.lock();
+	m_pending.remove(relativePath);
+	m_recordsLock.unlock();
+}
+
+bool
+SyncManifest::Flush()
+{
+	if (!FlushServerObjects()) {
+		return false;
+	}
+	m_recordsLock.lock();
+	QList<Record> records = m_records;
+	m_records.clear();
+	m_recordsLock.unlock();
+	if (records.isEmpty()) {
+		return true;
+	}
+	QSqlDatabase db = Database();
+	db.transaction();
+	QSqlQuery query(db);
+	query.prepare("INSERT OR REPLACE INTO files (path, size, modified, hash) "
+		      "VALUES (?, ?, ?, ?)");
+	bool ok = true;
+	for (int i = 0; ok && i < records.size(); i++) {
+		const Record& record = records[i];
+		query.bindValue(0, record.relativePath);
+		query.bindValue(1, (qulonglong)record.size);
+		query.bindValue(2, record.modified);
+		query.bindValue(3, record.hash);
+		ok = query.exec();
+	}
+	if (ok) {
+		ok = db.commit();
+	} else {
+		LOG_ERROR("ERROR:       Unable to update sync manifest " +
+			  m_path + ": " + query.lastError().text());
+		db.rollback();
+	}
+	return ok;
+}
+
+bool
+SyncManifest::FlushServerObjects()
+{
+	if (m_serverObjects.isEmpty()) {
+		return true;
+	}
+	QSqlDatabase db = Database();
+	db.transaction();
+	QSqlQuery query(db);
+	query.prepare("INSERT OR REPLACE INTO server_objects (name, size) "
+		      "VALUES (?, ?)");
+	bool ok = true;
+	for (int i = 0; ok && i < m_serverObjects.size(); i++) {
+		query.bindValue(0, m_serverObjects[i].name);
+		query.bindValue(1, (qulonglong)m_serverObjects[i].size);
+		ok = query.exec();
+	}
+	if (ok) {
+		ok = db.commit();
+	} else {
+		LOG_ERROR("ERROR:       Unable to update sync manifest " +
+			  m_path + ": " + query.lastError().text());
+		db.rollback();
+	}
+	m_serverObjects.clear();
+	return ok;
+}
+
+QByteArray
+SyncManifest::HashFile(const QString& path)
+{
+	QFile file(path);
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+		return QByteArray();
+	}
+	return hash.result();
+}
@@ -0,0 +1,135 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef SYNC_MANIFEST_H
+#define SYNC_MANIFEST_H
+
+#include <stdint.h>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+// SyncManifest, the local record of the files under a folder that were last
+// uploaded to a bucket and prefix, along with a listing of the objects that
+// are on the server under that prefix now.  Together they let a sync upload
+// send only the files that are new or changed since the last one.
+//
+// Both are kept in an SQLite database on disk rather than in memory since a
+// folder can have tens of millions of files.  Changes are buffered and
+// written FLUSH_ROWS at a time in a single transaction.
+//
+// A file's record only changes once the file is on the server.  Compare
+// holds the file's new state until Commit, which the transfer threads call
+// for each object that was sent, or Discard.
+//
+// SQLite connections can only be used from the thread that opened them so
+// each thread that uses the manifest gets its own.  Other than Commit, the
+// manifest must still only be used by one thread at a time.
+class SyncManifest
+{
+public:
+	enum Status { NEW, CHANGED, UNCHANGED };
+
+	static const int FLUSH_ROWS;
+
+	static QString GetDir();
+	// The manifest of the files uploaded to prefix, which is either empty
+	// or ends with "/", in the bucket on host
+	static QString GetPath(const QString& host, const QString& bucketName,
+			       const QString& prefix);
+
+	// compareContents means files whose size is the same but whose
+	// modification time changed are compared by an MD5 hash of their
+	// contents as well.  Otherwise they are considered changed.
+	SyncManifest(const QString& path, bool compareContents);
+	~SyncManifest();
+
+	const QString& GetPath() const;
+	bool Open();
+	void Close();
+
+	// Replace the listing of the objects on the server
+	void ClearServerObjects();
+	void AddServerObject(const QString& name, uint64_t size);
+	// Returns false if there's no such object on the server
+	bool GetServerObjectSize(const QString& name, uint64_t* size);
+
+	// Compare the file at relativePath with its record.  The file's
+	// current size and modification time (milliseconds since the epoch)
+	// are held until they're committed, or discarded, if its record
+	// needs to change.
+	Status Compare(const QString& relativePath, const QString& path,
+		       uint64_t size, qint64 modified);
+	// Record the file's state from Compare now that it's on the server
+	void Commit(const QString& relativePath);
+	void Discard(const QString& relativePath);
+	int GetNumUnchanged() const;
+
+	// Write out the buffered changes.  Returns false if they couldn't
+	// be.
+	bool Flush();
+
+private:
+	struct Record {
+		QString relativePath;
+		uint64_t size;
+		qint64 modified;
+		QByteArray hash;
+	};
+
+	struct ServerObject {
+		QString name;
+		uint64_t size;
+	};
+
+	static QByteArray HashFile(const QString& path);
+	QSqlDatabase Database();
+	bool FlushServerObjects();
+
+	QString m_path;
+	bool m_compareContents;
+	QString m_connectionPrefix;
+	// The connections that have been opened, one per thread
+	QStringList m_connections;
+	QMutex m_connectionsLock;
+	bool m_open;
+
+	// The records that are waiting for their files to be sent, and
+	// the ones that are waiting to be written out
+	QHash<QString, Record> m_pending;
+	QList<Record> m_records;
+	QMutex m_recordsLock;
+	QList<ServerObject> m_serverObjects;
+	int m_numUnchanged;
+};
+
+inline const QString&
+SyncManifest::GetPath() const
+{
+	return m_path;
+}
+
+inline int
+SyncManifest::GetNumUnchanged() const
+{
+	return m_numUnchanged;
+}
+
+#endif
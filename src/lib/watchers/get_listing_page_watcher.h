@@ -0,0 +1,58 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef GET_LISTING_PAGE_WATCHER_H
+#define GET_LISTING_PAGE_WATCHER_H
+
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QModelIndex>
+#include <QPersistentModelIndex>
+#include <QString>
+
+class ListingPage;
+
+class GetListingPageWatcher : public QFutureWatcher<ListingPage*>
+{
+public:
+	GetListingPageWatcher(const QModelIndex& parentModelIndex,
+			      const QString& bucketName,
+			      QObject* parent = 0);
+
+	// Invalid if the parent's row was removed while it was listed
+	const QModelIndex& GetParentModelIndex() const;
+	const QString& GetBucketName() const;
+
+private:
+	// Persistent since a refresh can move or remove the row while it's
+	// listed
+	const QPersistentModelIndex m_parentModelIndex;
+	const QString m_bucketName;
+};
+
+inline const QModelIndex&
+GetListingPageWatcher::GetParentModelIndex() const
+{
+	return m_parentModelIndex;
+}
+
+inline const QString&
+GetListingPageWatcher::GetBucketName() const
+{
+	return m_bucketName;
+}
+
+#endif
@@ -20,11 +20,12 @@
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QModelIndex>
+#include <QSharedPointer>
 #include <QString>
 
-#include <ds3.h>
+#include "lib/listing_cache.h"
 
-class GetObjectsWatcher : public QFutureWatcher<ds3_get_objects_response*>
+class GetObjectsWatcher : public QFutureWatcher<QSharedPointer<const Listing> >
 {
 public:
 	GetObjectsWatcher(const QModelIndex& parentModelIndex,
@@ -16,28 +16,32 @@
 
 #include "lib/work_items/bulk_get_work_item.h"
 
+// A few full archives' worth
+const int BulkGetWorkItem::MAX_CACHED_MEMBERS = 4 * SmallFileArchive::MAX_MEMBERS;
+
 BulkGetWorkItem::BulkGetWorkItem(const QString& host,
 				 const QList<QUrl> urls,
 				 const QString& destination)
 	: BulkWorkItem(host, urls),
 	  m_destination(destination),
-	  m_getBucketResponse(NULL),
-	  m_getBucketResponseIterator(0)
-{
-}
-
-BulkGetWorkItem::~BulkGetWorkItem()
+	  m_listingIterator(0),
+	  m_numCachedMembers(0)
 {
-	if (m_getBucketResponse != NULL) {
-		ds3_free_bucket_response(m_getBucketResponse);
-	}
 }
 
 void
-BulkGetWorkItem::SetGetBucketResponse(ds3_get_bucket_response* response)
+BulkGetWorkItem::InsertArchiveIndex(const QString& indexObjName,
+				    const QList<SmallFileArchive::Member>& members)
 {
-	if (m_getBucketResponse != response && m_getBucketResponse != NULL) {
-		ds3_free_bucket_response(m_getBucketResponse);
+	if (m_archiveIndexes.contains(indexObjName)) {
+		return;
+	}
+	while (!m_archiveIndexOrder.isEmpty() &&
+	       m_numCachedMembers + members.size() > MAX_CACHED_MEMBERS) {
+		QString oldest = m_archiveIndexOrder.takeFirst();
+		m_numCachedMembers -= m_archiveIndexes.take(oldest).size();
 	}
-	m_getBucketResponse = response;
+	m_archiveIndexes.insert(indexObjName, members);
+	m_archiveIndexOrder << indexObjName;
+	m_numCachedMembers += members.size();
 }
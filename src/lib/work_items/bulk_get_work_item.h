@@ -17,12 +17,14 @@
 #ifndef BULK_GET_WORK_ITEM_H
 #define BULK_GET_WORK_ITEM_H
 
+#include <QHash>
 #include <QList>
+#include <QSharedPointer>
 #include <QString>
 #include <QUrl>
 
-#include <ds3.h>
-
+#include "lib/listing_cache.h"
+#include "lib/small_file_archive.h"
 #include "lib/work_items/bulk_work_item.h"
 
 // BulkGetWorkItem, a container class that stores all data necessary to perform
@@ -33,39 +35,60 @@ public:
 	BulkGetWorkItem(const QString& host,
 			const QList<QUrl> urls,
 			const QString& destination);
-	~BulkGetWorkItem();
 
 	const QString GetDestination() const;
 	Job::Type GetType() const;
 
-	ds3_get_bucket_response* GetGetBucketResponse() const;
-	size_t GetGetBucketResponseIterator() const;
+	QSharedPointer<const Listing> GetListing() const;
+	int GetListingIterator() const;
 
-	void SetGetBucketResponse(ds3_get_bucket_response* response);
-	void SetGetBucketResponseIterator(size_t i);
+	void SetListing(QSharedPointer<const Listing> listing);
+	void SetListingIterator(int i);
 
 	void AppendDirsToCreate(const QString& dir);
 	int GetDirsToCreateSize() const;
 	const QString& GetDirsToCreateAt(int i) const;
 	void ClearDirsToCreate();
 
+	// The ETags that listing the page's folders found, by object name
+	void InsertETag(const QString& objName, const QString& etag);
+	const QHash<QString, QString>& GetETags() const;
+	void ClearETags();
+
+	// The indexes of small file archives that were downloaded while
+	// preparing the job, by index object name, since the folders of a
+	// job usually share their parents' archives.  Once they hold more
+	// than MAX_CACHED_MEMBERS, the oldest are forgotten.
+	static const int MAX_CACHED_MEMBERS;
+	bool GetArchiveIndex(const QString& indexObjName,
+			     QList<SmallFileArchive::Member>* members) const;
+	void InsertArchiveIndex(const QString& indexObjName,
+				const QList<SmallFileArchive::Member>& members);
+
 private:
 	QString m_destination;
 
 	// When a bulk get includes a bucket/folder, we must get all the
 	// descdent objects first.  This opens the possibility of having
-	// to paginate the GET bucket requests.  Thus, the last response is
+	// to paginate the GET bucket requests.  Thus, the last listing is
 	// saved in case we need to break the multiple GET bucket requests
 	// across multiple bulk get requests.
-	ds3_get_bucket_response* m_getBucketResponse;
+	QSharedPointer<const Listing> m_listing;
 
-	// The current m_getbucketResponse->objects position
-	size_t m_getBucketResponseIterator;
+	// The current m_listing->objects position
+	int m_listingIterator;
 
 	// Explicit "folder" objects that need to be created.  This is
 	// populated during PrepareBulkGets so dir creation can be delayed
 	// until we know the actual bulk get request was successful.
 	QList<QString> m_dirsToCreate;
+
+	QHash<QString, QString> m_etags;
+
+	QHash<QString, QList<SmallFileArchive::Member> > m_archiveIndexes;
+	// m_archiveIndexes' keys, oldest first
+	QList<QString> m_archiveIndexOrder;
+	int m_numCachedMembers;
 };
 
 inline const QString
@@ -80,22 +103,28 @@ BulkGetWorkItem::GetType() const
 	return Job::GET;
 }
 
-inline ds3_get_bucket_response*
-BulkGetWorkItem::GetGetBucketResponse() const
+inline QSharedPointer<const Listing>
+BulkGetWorkItem::GetListing() const
+{
+	return m_listing;
+}
+
+inline int
+BulkGetWorkItem::GetListingIterator() const
 {
-	return m_getBucketResponse;
+	return m_listingIterator;
 }
 
-inline size_t
-BulkGetWorkItem::GetGetBucketResponseIterator() const
+inline void
+BulkGetWorkItem::SetListing(QSharedPointer<const Listing> listing)
 {
-	return m_getBucketResponseIterator;
+	m_listing = listing;
 }
 
 inline void
-BulkGetWorkItem::SetGetBucketResponseIterator(size_t i)
+BulkGetWorkItem::SetListingIterator(int i)
 {
-	m_getBucketResponseIterator = i;
+	m_listingIterator = i;
 }
 
 inline void
@@ -122,4 +151,35 @@ BulkGetWorkItem::ClearDirsToCreate()
 	m_dirsToCreate.clear();
 }
 
+inline void
+BulkGetWorkItem::InsertETag(const QString& objName, const QString& etag)
+{
+	m_etags.insert(objName, etag);
+}
+
+inline const QHash<QString, QString>&
+BulkGetWorkItem::GetETags() const
+{
+	return m_etags;
+}
+
+inline void
+BulkGetWorkItem::ClearETags()
+{
+	m_etags.clear();
+}
+
+inline bool
+BulkGetWorkItem::GetArchiveIndex(const QString& indexObjName,
+				 QList<SmallFileArchive::Member>* members) const
+{
+	QHash<QString, QList<SmallFileArchive::Member> >::const_iterator ai;
+	ai = m_archiveIndexes.constFind(indexObjName);
+	if (ai == m_archiveIndexes.constEnd()) {
+		return false;
+	}
+	*members = ai.value();
+	return true;
+}
+
 #endif
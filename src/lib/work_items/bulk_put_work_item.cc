@@ -14,6 +14,10 @@
  * *****************************************************************************
  */
 
+#include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+
 #include "lib/work_items/bulk_put_work_item.h"
 
 BulkPutWorkItem::BulkPutWorkItem(const QString& host,
@@ -22,27 +26,153 @@ BulkPutWorkItem::BulkPutWorkItem(const QString& host,
 				 const QString& prefix)
 	: BulkWorkItem(host, urls),
 	  m_prefix(prefix),
-	  m_dirIterator(NULL)
+	  m_directoryScanner(NULL),
+	  m_syncMode(Session::NO_SYNC),
+	  m_syncManifest(NULL),
+	  m_packSmallFiles(false),
+	  m_compressObjects(false),
+	  m_archive(NULL)
 {
 	  m_bucketName = bucketName;
 }
 
 BulkPutWorkItem::~BulkPutWorkItem()
 {
-	DeleteDirIterator();
+	DeleteDirectoryScanner();
+	DeleteSyncManifests();
+	delete m_archive;
+	if (!m_archiveDir.isEmpty() && !WasInterrupted()) {
+		QDir(m_archiveDir).removeRecursively();
+	}
+}
+
+void
+BulkPutWorkItem::DeleteDirectoryScanner()
+{
+	if (m_directoryScanner != NULL) {
+		delete m_directoryScanner;
+		m_directoryScanner = NULL;
+	}
+}
+
+SyncManifest*
+BulkPutWorkItem::StartSyncManifest(const QString& path)
+{
+	DeleteSyncManifest();
+	m_syncManifest = new SyncManifest(path, m_syncMode == Session::SYNC_BY_CONTENT);
+	if (!m_syncManifest->Open()) {
+		DeleteSyncManifest();
+	}
+	return m_syncManifest;
+}
+
+void
+BulkPutWorkItem::DeleteSyncManifest()
+{
+	if (m_syncManifest != NULL) {
+		delete m_syncManifest;
+		m_syncManifest = NULL;
+	}
 }
 
 void
-BulkPutWorkItem::DeleteDirIterator()
+BulkPutWorkItem::FinishSyncManifest()
 {
-	if (m_dirIterator != NULL) {
-		delete m_dirIterator;
-		m_dirIterator = NULL;
+	if (m_syncManifest != NULL) {
+		m_finishedSyncManifests << m_syncManifest;
+		m_syncManifest = NULL;
 	}
 }
 
+void
+BulkPutWorkItem::InsertSyncedObject(const QString& objName,
+				    const QString& relativePath)
+{
+	m_syncedObjectsLock.lock();
+	m_syncedObjects.insert(objName, qMakePair(m_syncManifest, relativePath));
+	m_syncedObjectsLock.unlock();
+}
+
+void
+BulkPutWorkItem::FinishSyncedObject(const QString& objName)
+{
+	m_syncedObjectsLock.lock();
+	QPair<SyncManifest*, QString> synced = m_syncedObjects.take(objName);
+	m_syncedObjectsLock.unlock();
+	if (synced.first != NULL) {
+		synced.first->Commit(synced.second);
+	}
+}
+
+void
+BulkPutWorkItem::DeleteSyncManifests()
+{
+	DeleteSyncManifest();
+	m_syncedObjectsLock.lock();
+	m_syncedObjects.clear();
+	m_syncedObjectsLock.unlock();
+	qDeleteAll(m_finishedSyncManifests);
+	m_finishedSyncManifests.clear();
+}
+
 bool
-BulkPutWorkItem::IsFinished() const
+BulkPutWorkItem::PackSmallFile(const QString& dirObjName,
+			       const QString& memberName,
+			       const QString& filePath,
+			       uint64_t size)
 {
-	return (BulkWorkItem::IsFinished() && m_dirIterator == NULL);
+	if (!m_packSmallFiles || m_archiveDir.isEmpty() ||
+	    !SmallFileArchive::CanPack(memberName, size)) {
+		return false;
+	}
+	if (m_archive != NULL &&
+	    (m_archiveDirObjName != dirObjName || m_archive->IsFull(size))) {
+		FinishArchive();
+	}
+	if (m_archive == NULL) {
+		m_archiveDirObjName = dirObjName;
+		m_archiveObjName = SmallFileArchive::CreateObjectName(dirObjName);
+		QString id = QUuid::createUuid().toString().mid(1, 36);
+		m_archive = new SmallFileArchive(QDir(m_archiveDir).filePath(id + SmallFileArchive::NAME_SUFFIX));
+		if (!m_archive->Open()) {
+			delete m_archive;
+			m_archive = NULL;
+			return false;
+		}
+	}
+	if (!m_archive->Add(memberName, filePath)) {
+		return false;
+	}
+	m_archiveFiles.insert(dirObjName + memberName, filePath);
+	return true;
+}
+
+bool
+BulkPutWorkItem::FinishArchive()
+{
+	if (m_archive == NULL) {
+		return true;
+	}
+	bool ok = m_archive->Close();
+	if (ok) {
+		QString indexObjName = m_archiveObjName + SmallFileArchive::INDEX_SUFFIX;
+		InsertObjMap(m_archiveObjName, m_archive->GetPath());
+		InsertFileSize(m_archiveObjName, m_archive->GetSize());
+		InsertObjMap(indexObjName, m_archive->GetIndexPath());
+		InsertFileSize(indexObjName, QFileInfo(m_archive->GetIndexPath()).size());
+	} else {
+		QHash<QString, QString>::const_iterator fi;
+		for (fi = m_archiveFiles.constBegin();
+		     fi != m_archiveFiles.constEnd();
+		     fi++) {
+			InsertObjMap(fi.key(), fi.value());
+			InsertFileSize(fi.key(), QFileInfo(fi.value()).size());
+		}
+		QFile::remove(m_archive->GetPath());
+		QFile::remove(m_archive->GetIndexPath());
+	}
+	delete m_archive;
+	m_archive = NULL;
+	m_archiveFiles.clear();
+	return ok;
 }
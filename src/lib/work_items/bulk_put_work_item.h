@@ -17,15 +17,20 @@
 #ifndef BULK_PUT_WORK_ITEM_H
 #define BULK_PUT_WORK_ITEM_H
 
+#include <stdint.h>
 #include <QDir>
-#include <QDirIterator>
 #include <QHash>
 #include <QList>
 #include <QMutex>
+#include <QPair>
 #include <QString>
 #include <QUrl>
 
+#include "lib/directory_scanner.h"
+#include "lib/small_file_archive.h"
+#include "lib/sync_manifest.h"
 #include "lib/work_items/bulk_work_item.h"
+#include "models/session.h"
 
 // BulkPutWorkItem, a container class that stores all data necessary to perform
 // a DS3 bulk put operation.
@@ -43,15 +48,93 @@ public:
 	const QString GetDestination() const;
 	const QString& GetPrefix() const;
 
-	QDirIterator* GetDirIterator() const;
-	QDirIterator* GetDirIterator(const QString& filePath);
-	void DeleteDirIterator();
+	// The scanner for the directory URL that is currently being
+	// prepared.  It keeps walking in the background while a page is
+	// being transferred.
+	DirectoryScanner* GetDirectoryScanner() const;
+	DirectoryScanner* StartDirectoryScanner(const QString& filePath);
+	void DeleteDirectoryScanner();
 
-	bool IsFinished() const;
+	// Whether only the files in directory URLs that are new or changed
+	// since they were last uploaded are sent
+	Session::SyncMode GetSyncMode() const;
+	void SetSyncMode(Session::SyncMode mode);
+	// The manifest of the directory URL that is currently being
+	// prepared if it's being synced.  StartSyncManifest returns NULL if
+	// the manifest couldn't be opened.
+	SyncManifest* GetSyncManifest() const;
+	SyncManifest* StartSyncManifest(const QString& path);
+	void DeleteSyncManifest();
+	// Done preparing the current manifest's directory.  The manifest is
+	// kept until the work item is deleted so the files that are still
+	// being sent can be recorded.
+	void FinishSyncManifest();
+	// The object objName is the file at relativePath in the current
+	// manifest.  FinishSyncedObject commits the file's record once the
+	// whole object has been sent.
+	void InsertSyncedObject(const QString& objName,
+				const QString& relativePath);
+	void FinishSyncedObject(const QString& objName);
+	// Write out and close every manifest, including the finished ones
+	void DeleteSyncManifests();
+
+	// File sizes of the current page's objects, as found while preparing
+	// the page, so DoBulk doesn't have to stat every file again
+	bool GetFileSize(const QString& objName, uint64_t* size) const;
+	void InsertFileSize(const QString& objName, uint64_t size);
+	void ClearFileSizes();
+	// The compressed block sizes of the current page's
+	// ObjectCompressor::SUFFIX objects, as measured while preparing the
+	// page, so their files aren't measured again when they're sent
+	void InsertBlockSizes(const QString& objName, const QList<qint64>& sizes);
+	const QHash<QString, QList<qint64> >& GetBlockSizes() const;
+	void ClearBlockSizes();
+
+	// Whether small files under directory URLs are packed into archive
+	// objects instead of being sent one object per file
+	bool IsPackingSmallFiles() const;
+	void SetPackSmallFiles(bool pack);
+	// Whether files are compressed into ObjectCompressor::SUFFIX objects
+	// when that makes them smaller
+	bool IsCompressingObjects() const;
+	void SetCompressObjects(bool compress);
+	// Where the archives are created.  They're kept until the job
+	// finishes, or is canceled, so an interrupted job can be resumed.
+	void SetArchiveDir(const QString& dir);
+	// Pack a file into the current archive of the directory object
+	// dirObjName, starting a new archive if necessary.  Once an archive
+	// is full, it's added, along with its index, to the current page.
+	// Returns false if the file must be sent as its own object instead.
+	bool PackSmallFile(const QString& dirObjName,
+			   const QString& memberName,
+			   const QString& filePath,
+			   uint64_t size);
+	// Add the current archive, if any, and its index to the current
+	// page.  If the archive couldn't be finished, its files are added
+	// as their own objects instead and false is returned.
+	bool FinishArchive();
 
 private:
 	QString m_prefix;
-	QDirIterator* m_dirIterator;
+	DirectoryScanner* m_directoryScanner;
+	Session::SyncMode m_syncMode;
+	SyncManifest* m_syncManifest;
+	QList<SyncManifest*> m_finishedSyncManifests;
+	// The manifest and relative path of each synced object that hasn't
+	// been sent yet
+	QHash<QString, QPair<SyncManifest*, QString> > m_syncedObjects;
+	QMutex m_syncedObjectsLock;
+	QHash<QString, uint64_t> m_fileSizes;
+	QHash<QString, QList<qint64> > m_blockSizes;
+
+	bool m_packSmallFiles;
+	bool m_compressObjects;
+	QString m_archiveDir;
+	SmallFileArchive* m_archive;
+	QString m_archiveDirObjName;
+	QString m_archiveObjName;
+	// The object names and paths of the files in m_archive
+	QHash<QString, QString> m_archiveFiles;
 };
 
 inline Job::Type
@@ -72,22 +155,109 @@ BulkPutWorkItem::GetPrefix() const
 	return m_prefix;
 }
 
-inline QDirIterator*
-BulkPutWorkItem::GetDirIterator() const
+inline DirectoryScanner*
+BulkPutWorkItem::GetDirectoryScanner() const
+{
+	return m_directoryScanner;
+}
+
+inline DirectoryScanner*
+BulkPutWorkItem::StartDirectoryScanner(const QString& filePath)
+{
+	DeleteDirectoryScanner();
+	m_directoryScanner = new DirectoryScanner(filePath);
+	m_directoryScanner->Start();
+	return m_directoryScanner;
+}
+
+inline Session::SyncMode
+BulkPutWorkItem::GetSyncMode() const
+{
+	return m_syncMode;
+}
+
+inline void
+BulkPutWorkItem::SetSyncMode(Session::SyncMode mode)
+{
+	m_syncMode = mode;
+}
+
+inline SyncManifest*
+BulkPutWorkItem::GetSyncManifest() const
+{
+	return m_syncManifest;
+}
+
+inline bool
+BulkPutWorkItem::GetFileSize(const QString& objName, uint64_t* size) const
+{
+	QHash<QString, uint64_t>::const_iterator fi = m_fileSizes.constFind(objName);
+	if (fi == m_fileSizes.constEnd()) {
+		return false;
+	}
+	*size = fi.value();
+	return true;
+}
+
+inline void
+BulkPutWorkItem::InsertFileSize(const QString& objName, uint64_t size)
+{
+	m_fileSizes.insert(objName, size);
+}
+
+inline void
+BulkPutWorkItem::ClearFileSizes()
+{
+	m_fileSizes.clear();
+}
+
+inline void
+BulkPutWorkItem::InsertBlockSizes(const QString& objName,
+				  const QList<qint64>& sizes)
+{
+	m_blockSizes.insert(objName, sizes);
+}
+
+inline const QHash<QString, QList<qint64> >&
+BulkPutWorkItem::GetBlockSizes() const
+{
+	return m_blockSizes;
+}
+
+inline void
+BulkPutWorkItem::ClearBlockSizes()
+{
+	m_blockSizes.clear();
+}
+
+inline bool
+BulkPutWorkItem::IsPackingSmallFiles() const
+{
+	return m_packSmallFiles;
+}
+
+inline void
+BulkPutWorkItem::SetPackSmallFiles(bool pack)
+{
+	m_packSmallFiles = pack;
+}
+
+inline bool
+BulkPutWorkItem::IsCompressingObjects() const
+{
+	return m_compressObjects;
+}
+
+inline void
+BulkPutWorkItem::SetCompressObjects(bool compress)
 {
-	return m_dirIterator;
+	m_compressObjects = compress;
 }
 
-inline QDirIterator*
-BulkPutWorkItem::GetDirIterator(const QString& filePath)
+inline void
+BulkPutWorkItem::SetArchiveDir(const QString& dir)
 {
-	DeleteDirIterator();
-	m_dirIterator = new QDirIterator(filePath,
-					 QDir::AllDirs | QDir::Files |
-					 QDir::Hidden | QDir::Readable |
-					 QDir::System | QDir::NoDotAndDotDot,
-					 QDirIterator::Subdirectories);
-	return m_dirIterator;
+	m_archiveDir = dir;
 }
 
 #endif
@@ -16,103 +16,174 @@
 
 #include <QMap>
 
+#include "lib/concurrency_controller.h"
+#include "lib/job_journal.h"
 #include "lib/work_items/bulk_work_item.h"
+#include "lib/work_items/page_work_item.h"
 #include "models/job.h"
 
 const uint64_t BulkWorkItem::UPDATE_THRESHOLD = 100 * 1024;
 
+// Enough for the most transfer threads a session allows without sharing
+const int BulkWorkItem::NUM_PROGRESS_COUNTERS;
+
 BulkWorkItem::BulkWorkItem(const QString& host, const QList<QUrl> urls)
 	: WorkItem(),
 	  m_state(Job::INITIALIZING),
 	  m_host(host),
 	  m_urls(urls),
 	  m_urlsIterator(m_urls.constBegin()),
-	  m_bytesTransferred(0),
-	  m_bytesTransferredSinceLastJobUpdate(0),
-	  m_response(NULL),
-	  m_numChunksProcessed(0)
+	  m_nextProgressCounter(0),
+	  m_transferController(NULL),
+	  m_page(NULL),
+	  m_nextPage(NULL),
+	  // A new work item starts out preparing its first page
+	  m_preparing(true),
+	  m_finishing(false),
+	  m_interrupted(false),
+	  m_journal(NULL)
 {
 	SortURLsByBucket();
+	m_urlPaths = Job::JoinURLs(m_urls);
 }
 
 BulkWorkItem::~BulkWorkItem()
 {
-	if (m_response != NULL) {
-		ds3_free_bulk_response(m_response);
-	}
+	delete m_page;
+	delete m_nextPage;
+	delete m_journal;
+	delete m_transferController;
 }
 
-uint64_t
-BulkWorkItem::GetBytesTransferred() const
+void
+BulkWorkItem::SetTransferConcurrency(int numTransfers, int maxTransfers)
 {
-	m_bytesTransferredLock.lock();
-	uint64_t bytesTransferred = m_bytesTransferred;
-	m_bytesTransferredLock.unlock();
-	return bytesTransferred;
+	m_transferThreadPool.setMaxThreadCount(maxTransfers);
+	delete m_transferController;
+	m_transferController = new ConcurrencyController("job " + GetID().toString(),
+							 numTransfers, 1,
+							 maxTransfers);
 }
 
 void
-BulkWorkItem::UpdateBytesTransferred(size_t bytes)
+BulkWorkItem::SetJournal(JobJournal* journal)
 {
-	m_bytesTransferredLock.lock();
-	m_bytesTransferred += bytes;
-	m_bytesTransferredSinceLastJobUpdate += bytes;
-	m_bytesTransferredLock.unlock();
+	if (m_journal != journal) {
+		delete m_journal;
+	}
+	m_journal = journal;
 }
 
-const QString
-BulkWorkItem::GetJobID() const
+void
+BulkWorkItem::Resume(const JobJournal* journal, bool withPages)
 {
-	QString jobID;
-	if (m_response != NULL) {
-		jobID = QString(m_response->job_id->value);
+	m_objectsDone = journal->GetObjectsDone();
+	const QList<JobJournal::Page>& pages = journal->GetPages();
+	if (!withPages || pages.isEmpty()) {
+		SetNumURLsProcessed(journal->GetNumURLsDone());
+		SetLastProcessedUrl(journal->GetLastUrlDone());
+		return;
 	}
-	return jobID;
-}
 
-uint64_t
-BulkWorkItem::GetSize() const
-{
-	uint64_t size = 0;
-	if (m_response != NULL) {
-		size = m_response->original_size_in_bytes;
+	// Continue preparing from where the last page that was created
+	// stopped
+	SetNumURLsProcessed(pages.last().numURLsProcessed);
+	SetLastProcessedUrl(pages.last().lastProcessedUrl);
+	SetBucketName(pages.last().bucketName);
+	for (int i = 0; i < pages.size(); i++) {
+		const QHash<QString, QString>& objMap = pages[i].objMap;
+		QHash<QString, QString>::const_iterator hi;
+		for (hi = objMap.constBegin(); hi != objMap.constEnd(); hi++) {
+			m_objectsDone << hi.key();
+		}
 	}
-	return size;
 }
 
 bool
-BulkWorkItem::IsJobUpdateReady()
+BulkWorkItem::AddPage(PageWorkItem* page)
 {
-	bool ready = false;
-	m_bytesTransferredLock.lock();
-	if (m_bytesTransferredSinceLastJobUpdate > UPDATE_THRESHOLD) {
-		ready = true;
-		m_bytesTransferredSinceLastJobUpdate = 0;
+	m_pagesLock.lock();
+	m_preparing = false;
+	bool current = (m_page == NULL);
+	if (current) {
+		m_page = page;
+	} else {
+		m_nextPage = page;
 	}
-	m_bytesTransferredLock.unlock();
-	return ready;
+	m_pagesLock.unlock();
+	return current;
 }
 
+PageWorkItem*
+BulkWorkItem::FinishPage()
+{
+	m_pagesLock.lock();
+	delete m_page;
+	m_page = m_nextPage;
+	m_nextPage = NULL;
+	PageWorkItem* page = m_page;
+	m_pagesLock.unlock();
+	return page;
+}
 
-bool
-BulkWorkItem::IsPageFinished() const
+BulkWorkItem::PageAction
+BulkWorkItem::NextPageAction(bool donePreparing)
+{
+	PageAction action = WAIT_FOR_PAGES;
+	m_pagesLock.lock();
+	if (donePreparing) {
+		m_preparing = false;
+	}
+	// Only one page is ever created ahead of the one being transferred
+	if (!m_preparing && m_nextPage == NULL && !WasCanceled() &&
+	    m_urlsIterator != GetUrlsConstEnd()) {
+		m_preparing = true;
+		action = PREPARE_PAGE;
+	} else if (!m_preparing && m_page == NULL && !m_finishing) {
+		m_finishing = true;
+		action = FINISH_WORK_ITEM;
+	}
+	m_pagesLock.unlock();
+	return action;
+}
+
+uint64_t
+BulkWorkItem::GetBytesTransferred() const
 {
-	bool finished = true;
-	m_responseLock.lock();
-	if (m_response != NULL) {
-		size_t numChunks = m_response->list_size;
-		finished = numChunks == m_numChunksProcessed;
+	uint64_t bytesTransferred = 0;
+	for (int i = 0; i < NUM_PROGRESS_COUNTERS; i++) {
+		bytesTransferred += m_progressCounters[i].bytes.loadAcquire();
 	}
-	m_responseLock.unlock();
-	return finished;
+	return bytesTransferred;
+}
+
+int
+BulkWorkItem::GetProgressCounter()
+{
+	int counter = m_nextProgressCounter.fetchAndAddRelaxed(1);
+	return (counter & 0x7fffffff) % NUM_PROGRESS_COUNTERS;
 }
 
 bool
-BulkWorkItem::IsFinished() const
+BulkWorkItem::UpdateBytesTransferred(int counter, size_t bytes)
 {
-	return (IsPageFinished() && m_urlsIterator == GetUrlsConstEnd());
+	quint64 before = m_progressCounters[counter].bytes.fetchAndAddRelease(bytes);
+	return ((before / UPDATE_THRESHOLD) != ((before + bytes) / UPDATE_THRESHOLD));
 }
 
+uint64_t
+BulkWorkItem::GetSize() const
+{
+	uint64_t size = 0;
+	m_pagesLock.lock();
+	if (m_page != NULL) {
+		size = m_page->GetSize();
+	}
+	m_pagesLock.unlock();
+	return size;
+}
+
+
 const Job
 BulkWorkItem::ToJob() const
 {
@@ -123,10 +194,13 @@ BulkWorkItem::ToJob() const
 	job.SetTransferStart(GetTransferStart());
 	job.SetState(GetState());
 	job.SetHost(GetHost());
-	job.SetURLs(GetURLs());
+	job.SetURLs(m_urlPaths);
 	job.SetDestination(GetDestination());
 	job.SetSize(GetSize());
 	job.SetBytesTransferred(GetBytesTransferred());
+	if (m_transferController != NULL) {
+		job.SetTransferLimit(m_transferController->GetLimit());
+	}
 	return job;
 }
 
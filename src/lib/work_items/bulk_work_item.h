@@ -18,9 +18,14 @@
 #define BULK_WORK_ITEM_H
 
 #include <stdlib.h>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QHash>
 #include <QList>
+#include <QSet>
 #include <QString>
 #include <QMutex>
+#include <QThreadPool>
 #include <QUrl>
 
 #include <ds3.h>
@@ -28,17 +33,27 @@
 #include "lib/work_items/work_item.h"
 #include "models/job.h"
 
+class ConcurrencyController;
+class JobJournal;
+class PageWorkItem;
+
 class BulkWorkItem : public WorkItem
 {
 public:
 	static const uint64_t UPDATE_THRESHOLD;
+	static const int NUM_PROGRESS_COUNTERS = 16;
+
+	// What a thread should do next once it's done with its part of the
+	// work item, i.e. preparing or transferring a page
+	enum PageAction {
+		WAIT_FOR_PAGES,
+		PREPARE_PAGE,
+		FINISH_WORK_ITEM
+	};
 
 	BulkWorkItem(const QString& host, const QList<QUrl> urls);
 	virtual ~BulkWorkItem();
 
-	// The S3 server assigned ID for this job.  This isn't valid until
-	// a ds3_bulk_response response, with a valid job ID, has been set.
-	const QString GetJobID() const;
 	virtual Job::Type GetType() const = 0;
 	Job::State GetState() const;
 	const QString& GetHost() const;
@@ -47,45 +62,89 @@ public:
 	QList<QUrl>::const_iterator& GetUrlsIterator();
 	const QList<QUrl>::const_iterator GetUrlsConstEnd() const;
 	const QUrl& GetLastProcessedUrl() const;
+	int GetNumURLsProcessed() const;
+	void SetNumURLsProcessed(int numURLs);
 	virtual const QString GetDestination() const = 0;
+	// Size of the page that is currently being transferred
 	uint64_t GetSize() const;
+	// The sum of all progress counters
 	uint64_t GetBytesTransferred() const;
-	void UpdateBytesTransferred(size_t bytes);
-	size_t GetNumChunksProcessed() const;
-
+	// Each transfer thread adds the bytes it transfers to its own
+	// progress counter so the libcurl read/write callbacks never
+	// contend on a lock.  Counters are handed out round robin and can
+	// be shared if there are more threads than counters.
+	int GetProgressCounter();
 	// Used to throttle the number of job updates Client emits to prevent
 	// the main GUI thread from getting flooded with job update requests.
-	// This is probably only necessary during the Client::{Read,Write}File
-	// methods.
-	bool IsJobUpdateReady();
+	// Returns true if the counter just passed another UPDATE_THRESHOLD
+	// bytes and a job update should be emitted.
+	bool UpdateBytesTransferred(int counter, size_t bytes);
+
+	// Thread pool that this job's objects are transferred in.  Its max
+	// thread count is the most objects that are ever transferred at
+	// once.  The transfer controller decides how many of those threads
+	// actually transfer at any given time.
+	QThreadPool* GetTransferThreadPool();
+	ConcurrencyController* GetTransferController();
+	// Start out transferring numTransfers objects at once and never
+	// more than maxTransfers
+	void SetTransferConcurrency(int numTransfers, int maxTransfers);
 
 	bool WasCanceled() const;
+	// Whether or not the work item was canceled because the application
+	// is closing rather than by the user.  Its journal is kept so it can
+	// be resumed later.
+	bool WasInterrupted() const;
+	void SetInterrupted(bool interrupted);
+
+	// The journal that this work item's progress is recorded in.  NULL
+	// if it couldn't be created.  BulkWorkItem takes ownership of it.
+	JobJournal* GetJournal() const;
+	void SetJournal(JobJournal* journal);
+
+	// Restore the progress recorded in a journal that was left behind.
+	// Objects of pages that had already finished, as well as the
+	// objects of the pages that were created but hadn't finished, are
+	// skipped when preparing the remaining pages.  If withPages is
+	// false, the unfinished pages are ignored and will be prepared
+	// again.
+	void Resume(const JobJournal* journal, bool withPages = true);
+	bool IsObjectDone(const QString& objName) const;
+
 	// A large drag/drop operation might have to be split up amonst
-	// several DS3 Bulk GET/PUT jobs.  Each one of these DS3 jobs
-	// represents a page.  IsPageFinished() signifies whether or not
-	// the current DS3 Bulk GET/PUT "page" job is finished or not.
-	// Note that each page could be split up amongst one or more
-	// DS3 job chunks.
-	bool IsPageFinished() const;
-	// Signifies whether or not the entire work item as a whole is finished.
-	// In other words, if an entire drag/drop operation is complete.
-	bool IsFinished() const;
+	// several DS3 Bulk GET/PUT jobs, or pages.  The next page is
+	// prepared, and its DS3 job created, while the current page is still
+	// being transferred.  Pages are transferred one at a time in the
+	// order they were created.
+	//
+	// The page that is currently being transferred, if any
+	PageWorkItem* GetPage() const;
+	// Add a page whose DS3 job was just created and stop preparing.
+	// Returns true if it's now the current page and needs to be
+	// transferred.  Otherwise, it's transferred once the current page
+	// is finished.  BulkWorkItem takes ownership of page.
+	bool AddPage(PageWorkItem* page);
+	// Delete the current page once it's done being transferred.  Returns
+	// the next page, which is now the current page, or NULL if there
+	// isn't one yet.
+	PageWorkItem* FinishPage();
+	// Decide what the calling thread should do next.  donePreparing
+	// signifies that the caller was preparing a page but stopped
+	// without adding one.  Only one thread is ever told to prepare the
+	// next page or to finish the work item.
+	PageAction NextPageAction(bool donePreparing = false);
 
 	void SetBucketName(const QString& bucketName);
 	void SetLastProcessedUrl(const QUrl& url);
-	void SetNumChunksProcessed(int chunks);
-	void IncNumChunksProcessed(int chunks = 1);
 
+	// Objects of the page that is being prepared
 	void ClearObjMap();
+	const QHash<QString, QString>& GetObjMap() const;
 	QHash<QString, QString>::const_iterator GetObjMapConstBegin() const;
 	QHash<QString, QString>::const_iterator GetObjMapConstEnd() const;
 	uint64_t GetObjMapSize() const;
-	const QString GetObjMapValue(const QString& objName) const;
 	void InsertObjMap(const QString& objName, const QString& filePath);
 
-	ds3_bulk_response* GetResponse() const;
-	void SetResponse(ds3_bulk_response* response);
-
 	void SetState(Job::State state);
 
 	const Job ToJob() const;
@@ -93,22 +152,41 @@ public:
 protected:
 	void SortURLsByBucket();
 
+	struct ProgressCounter
+	{
+		QAtomicInteger<quint64> bytes;
+		// Keep each counter on its own cache line
+		char padding[64 - sizeof(QAtomicInteger<quint64>)];
+	};
+
 	Job::State m_state;
 	mutable QMutex m_stateLock;
 	QString m_host;
 	QString m_bucketName;
 	QList<QUrl> m_urls;
+	// The paths of m_urls as a Job reports them.  Joined once instead
+	// of for every job update.
+	QString m_urlPaths;
 	QUrl m_lastProcessedUrl;
 	QList<QUrl>::const_iterator m_urlsIterator;
-	uint64_t m_bytesTransferred;
-	mutable QMutex m_bytesTransferredLock;
-	// Used to throttle the number of job updates Client emits to prevent
-	// the main GUI thread from getting flooded with job update requests.
-	uint64_t m_bytesTransferredSinceLastJobUpdate;
+	ProgressCounter m_progressCounters[NUM_PROGRESS_COUNTERS];
+	QAtomicInt m_nextProgressCounter;
 	QHash<QString, QString> m_objMap;
-	ds3_bulk_response* m_response;
-	mutable QMutex m_responseLock;
-	size_t m_numChunksProcessed;
+	QThreadPool m_transferThreadPool;
+	ConcurrencyController* m_transferController;
+
+	// The page being transferred and the page, if any, that was created
+	// while it was being transferred
+	PageWorkItem* m_page;
+	PageWorkItem* m_nextPage;
+	// Whether or not a thread is preparing the next page
+	bool m_preparing;
+	bool m_finishing;
+	mutable QMutex m_pagesLock;
+
+	bool m_interrupted;
+	JobJournal* m_journal;
+	QSet<QString> m_objectsDone;
 };
 
 inline const QString&
@@ -147,13 +225,28 @@ BulkWorkItem::GetLastProcessedUrl() const
 	return m_lastProcessedUrl;
 }
 
-inline size_t
-BulkWorkItem::GetNumChunksProcessed() const
+inline int
+BulkWorkItem::GetNumURLsProcessed() const
+{
+	return m_urlsIterator - m_urls.constBegin();
+}
+
+inline void
+BulkWorkItem::SetNumURLsProcessed(int numURLs)
 {
-	m_responseLock.lock();
-	size_t chunks = m_numChunksProcessed;
-	m_responseLock.unlock();
-	return chunks;
+	m_urlsIterator = m_urls.constBegin() + numURLs;
+}
+
+inline QThreadPool*
+BulkWorkItem::GetTransferThreadPool()
+{
+	return &m_transferThreadPool;
+}
+
+inline ConcurrencyController*
+BulkWorkItem::GetTransferController()
+{
+	return m_transferController;
 }
 
 inline bool
@@ -163,33 +256,49 @@ BulkWorkItem::WasCanceled() const
 	return (state == Job::CANCELING || state == Job::CANCELED);
 }
 
+inline bool
+BulkWorkItem::WasInterrupted() const
+{
+	return m_interrupted;
+}
 
 inline void
-BulkWorkItem::SetBucketName(const QString& bucketName)
+BulkWorkItem::SetInterrupted(bool interrupted)
 {
-	m_bucketName = bucketName;
+	m_interrupted = interrupted;
 }
 
-inline void
-BulkWorkItem::SetLastProcessedUrl(const QUrl& url)
+inline JobJournal*
+BulkWorkItem::GetJournal() const
 {
-	m_lastProcessedUrl = url;
+	return m_journal;
+}
+
+inline bool
+BulkWorkItem::IsObjectDone(const QString& objName) const
+{
+	return m_objectsDone.contains(objName);
+}
+
+inline PageWorkItem*
+BulkWorkItem::GetPage() const
+{
+	m_pagesLock.lock();
+	PageWorkItem* page = m_page;
+	m_pagesLock.unlock();
+	return page;
 }
 
 inline void
-BulkWorkItem::SetNumChunksProcessed(int chunks)
+BulkWorkItem::SetBucketName(const QString& bucketName)
 {
-	m_responseLock.lock();
-	m_numChunksProcessed = chunks;
-	m_responseLock.unlock();
+	m_bucketName = bucketName;
 }
 
 inline void
-BulkWorkItem::IncNumChunksProcessed(int chunks)
+BulkWorkItem::SetLastProcessedUrl(const QUrl& url)
 {
-	m_responseLock.lock();
-	m_numChunksProcessed += chunks;
-	m_responseLock.unlock();
+	m_lastProcessedUrl = url;
 }
 
 inline void
@@ -198,6 +307,12 @@ BulkWorkItem::ClearObjMap()
 	m_objMap.clear();
 }
 
+inline const QHash<QString, QString>&
+BulkWorkItem::GetObjMap() const
+{
+	return m_objMap;
+}
+
 inline QHash<QString,QString>::const_iterator
 BulkWorkItem::GetObjMapConstBegin() const
 {
@@ -216,12 +331,6 @@ BulkWorkItem::GetObjMapSize() const
 	return (uint64_t)m_objMap.size();
 }
 
-inline const QString
-BulkWorkItem::GetObjMapValue(const QString& objName) const
-{
-	return m_objMap[objName];
-}
-
 inline void
 BulkWorkItem::InsertObjMap(const QString& objName, const QString& filePath)
 {
@@ -237,23 +346,6 @@ BulkWorkItem::GetState() const
 	return state;
 }
 
-inline ds3_bulk_response*
-BulkWorkItem::GetResponse() const
-{
-	m_responseLock.lock();
-	ds3_bulk_response* response = m_response;
-	m_responseLock.unlock();
-	return response;
-}
-
-inline void
-BulkWorkItem::SetResponse(ds3_bulk_response* response)
-{
-	m_responseLock.lock();
-	m_response = response;
-	m_responseLock.unlock();
-}
-
 inline void
 BulkWorkItem::SetState(Job::State state)
 {
@@ -0,0 +1,194 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/work_items/chunk_work_item.h"
+
+ChunkWorkItem::ChunkWorkItem()
+	: WorkItem(),
+	  m_closed(false),
+	  m_nextChunk(0),
+	  m_nextObject(0),
+	  m_numActiveChunks(0)
+{
+}
+
+ChunkWorkItem::~ChunkWorkItem()
+{
+	for (int i = 0; i < m_responses.size(); i++) {
+		ds3_free_available_chunks_response(m_responses[i]);
+	}
+}
+
+size_t
+ChunkWorkItem::AddChunks(ds3_get_available_chunks_response* response,
+			 size_t* numEmptyChunks)
+{
+	size_t numAdded = 0;
+	*numEmptyChunks = 0;
+	ds3_bulk_response* bulkResponse = response->object_list;
+	m_lock.lock();
+	for (size_t chunk = 0; chunk < bulkResponse->list_size; chunk++) {
+		ds3_bulk_object_list* list = bulkResponse->list[chunk];
+		// The server keeps reporting a chunk as available until all of
+		// its objects have been transferred.
+		QString chunkID = GetChunkID(list);
+		if (m_chunkIDs.contains(chunkID)) {
+			continue;
+		}
+		m_chunkIDs << chunkID;
+		m_chunks << list;
+		m_numObjectsRemaining << list->size;
+		m_chunkFailed << false;
+		if (list->size == 0) {
+			(*numEmptyChunks)++;
+		} else {
+			m_numActiveChunks++;
+		}
+		numAdded++;
+	}
+	if (numAdded > 0) {
+		m_responses << response;
+		m_objectAdded.wakeAll();
+	}
+	m_lock.unlock();
+
+	if (numAdded == 0) {
+		ds3_free_available_chunks_response(response);
+	}
+	return numAdded;
+}
+
+size_t
+ChunkWorkItem::SkipChunks(ds3_bulk_response* response,
+			  const QSet<QString>& chunkIDs)
+{
+	size_t numSkipped = 0;
+	m_lock.lock();
+	for (size_t chunk = 0; chunk < response->list_size; chunk++) {
+		QString chunkID = GetChunkID(response->list[chunk]);
+		if (chunkIDs.contains(chunkID) && !m_chunkIDs.contains(chunkID)) {
+			m_chunkIDs << chunkID;
+			numSkipped++;
+		}
+	}
+	m_lock.unlock();
+	return numSkipped;
+}
+
+size_t
+ChunkWorkItem::GetNumChunks() const
+{
+	m_lock.lock();
+	size_t numChunks = m_chunkIDs.size();
+	m_lock.unlock();
+	return numChunks;
+}
+
+QString
+ChunkWorkItem::GetChunkID(size_t chunk) const
+{
+	m_lock.lock();
+	QString chunkID = GetChunkID(m_chunks[chunk]);
+	m_lock.unlock();
+	return chunkID;
+}
+
+QString
+ChunkWorkItem::GetChunkID(ds3_bulk_object_list* list)
+{
+	if (list->chunk_id != NULL) {
+		return QString::fromUtf8(list->chunk_id->value);
+	}
+	return QString::number(list->chunk_number);
+}
+
+size_t
+ChunkWorkItem::GetNumActiveChunks() const
+{
+	m_lock.lock();
+	size_t numActiveChunks = m_numActiveChunks;
+	m_lock.unlock();
+	return numActiveChunks;
+}
+
+bool
+ChunkWorkItem::TakeNextObject(ds3_bulk_object** bulkObj, size_t* chunk)
+{
+	bool taken = false;
+	m_lock.lock();
+	while (!taken) {
+		while (m_nextChunk < m_chunks.size()) {
+			ds3_bulk_object_list* list = m_chunks[m_nextChunk];
+			if (m_nextObject < list->size) {
+				*bulkObj = &(list->list[m_nextObject]);
+				*chunk = m_nextChunk;
+				m_nextObject++;
+				taken = true;
+				break;
+			}
+			m_nextChunk++;
+			m_nextObject = 0;
+		}
+		if (taken || m_closed) {
+			break;
+		}
+		m_objectAdded.wait(&m_lock);
+	}
+	m_lock.unlock();
+	return taken;
+}
+
+bool
+ChunkWorkItem::FinishObject(size_t chunk, bool succeeded)
+{
+	m_lock.lock();
+	if (!succeeded) {
+		m_chunkFailed[chunk] = true;
+	}
+	uint64_t remaining = --m_numObjectsRemaining[chunk];
+	if (remaining == 0) {
+		m_numActiveChunks--;
+		m_chunkFinished.wakeAll();
+	}
+	m_lock.unlock();
+	return (remaining == 0);
+}
+
+bool
+ChunkWorkItem::DidChunkFail(size_t chunk) const
+{
+	m_lock.lock();
+	bool failed = m_chunkFailed[chunk];
+	m_lock.unlock();
+	return failed;
+}
+
+void
+ChunkWorkItem::WaitForFinishedChunk(unsigned long msecs)
+{
+	m_lock.lock();
+	m_chunkFinished.wait(&m_lock, msecs);
+	m_lock.unlock();
+}
+
+void
+ChunkWorkItem::Close()
+{
+	m_lock.lock();
+	m_closed = true;
+	m_objectAdded.wakeAll();
+	m_lock.unlock();
+}
@@ -0,0 +1,96 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef CHUNK_WORK_ITEM_H
+#define CHUNK_WORK_ITEM_H
+
+#include <stdint.h>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+
+#include <ds3.h>
+
+#include "lib/work_items/work_item.h"
+
+// ChunkWorkItem, a queue of the objects of all DS3 job chunks that the
+// server has made available for the current bulk page.  Client keeps
+// adding newly allocated chunks to it while the transfer threads are
+// still taking objects out of it so transfers never have to wait on the
+// next GetAvailableJobChunks round trip.  It keeps track of how many
+// objects of each chunk are still outstanding so a chunk is only
+// considered processed once every one of its objects has been
+// transferred.
+class ChunkWorkItem : public WorkItem
+{
+public:
+	ChunkWorkItem();
+	~ChunkWorkItem();
+
+	// Queue every chunk in the response that hasn't been queued before.
+	// ChunkWorkItem takes ownership of the response.  Returns the number
+	// of newly queued chunks.  Chunks without any objects are never
+	// handed out and are thus counted in numEmptyChunks.
+	size_t AddChunks(ds3_get_available_chunks_response* response,
+			 size_t* numEmptyChunks);
+	// Treat the chunks in response whose IDs are in chunkIDs as already
+	// transferred.  Used when resuming a job.  Returns the number of
+	// chunks skipped.
+	size_t SkipChunks(ds3_bulk_response* response,
+			  const QSet<QString>& chunkIDs);
+	// Number of chunks either added or skipped
+	size_t GetNumChunks() const;
+	QString GetChunkID(size_t chunk) const;
+	static QString GetChunkID(ds3_bulk_object_list* list);
+	// Number of chunks that still have objects that haven't finished
+	size_t GetNumActiveChunks() const;
+
+	// Get the next object that hasn't been handed to a transfer thread
+	// yet, waiting for more chunks to be added if necessary.  Returns
+	// false once the queue has been closed and all objects have been
+	// handed out.
+	bool TakeNextObject(ds3_bulk_object** bulkObj, size_t* chunk);
+	// Mark an object of the specified chunk as done.  Returns true if
+	// it was the last outstanding object of that chunk.
+	bool FinishObject(size_t chunk, bool succeeded = true);
+	// Whether or not any object of the chunk failed to transfer
+	bool DidChunkFail(size_t chunk) const;
+	// Wait until a chunk finishes or msecs have elapsed
+	void WaitForFinishedChunk(unsigned long msecs);
+	// No more chunks will be added.  Wakes up all waiting transfer
+	// threads.
+	void Close();
+
+private:
+	QList<ds3_get_available_chunks_response*> m_responses;
+	QList<ds3_bulk_object_list*> m_chunks;
+	QSet<QString> m_chunkIDs;
+	bool m_closed;
+	mutable QMutex m_lock;
+	QWaitCondition m_objectAdded;
+	QWaitCondition m_chunkFinished;
+	// Chunk and object (within that chunk) that will be handed out next
+	int m_nextChunk;
+	uint64_t m_nextObject;
+	// Number of objects, per chunk, that haven't been finished yet
+	QList<uint64_t> m_numObjectsRemaining;
+	QList<bool> m_chunkFailed;
+	size_t m_numActiveChunks;
+};
+
+#endif
@@ -14,8 +14,16 @@
  * *****************************************************************************
  */
 
+#include <string.h>
+
 #include "lib/work_items/bulk_work_item.h"
 #include "lib/work_items/object_work_item.h"
+#include "lib/checksum.h"
+#include "lib/object_compressor.h"
+#include "lib/object_decompressor.h"
+
+// How much of an unmapped file ComputeChecksum reads at a time
+const int ObjectWorkItem::CHECKSUM_BUFFER_SIZE = 1024 * 1024;
 
 ObjectWorkItem::ObjectWorkItem(const QString& bucketName,
 			       const QString& objectName,
@@ -24,22 +32,90 @@ ObjectWorkItem::ObjectWorkItem(const QString& bucketName,
 	: WorkItem(),
 	  m_bucketName(bucketName),
 	  m_objectName(objectName),
-	  m_file(fileName),
-	  m_bulkWorkItem(bulkWorkItem)
+	  m_ownFile(fileName),
+	  m_file(&m_ownFile),
+	  m_bulkWorkItem(bulkWorkItem),
+	  m_progressCounter(0),
+	  m_jobUpdateReady(false),
+	  m_map(NULL),
+	  m_mapSize(0),
+	  m_mapPos(0),
+	  m_compressor(NULL),
+	  m_decompressor(NULL),
+	  m_codecError(false),
+	  m_checksum(NULL)
 {
+	if (m_bulkWorkItem != NULL) {
+		m_progressCounter = m_bulkWorkItem->GetProgressCounter();
+	}
 }
 
 ObjectWorkItem::~ObjectWorkItem()
 {
-	m_file.close();
+	delete m_compressor;
+	delete m_decompressor;
+	delete m_checksum;
+	ReleaseFile();
+	m_ownFile.close();
+}
+
+void
+ObjectWorkItem::ReleaseFile()
+{
+	if (m_map != NULL) {
+		m_file->unmap(m_map);
+		m_map = NULL;
+	}
+	if (m_file != &m_ownFile) {
+		m_file->flush();
+		m_file = &m_ownFile;
+	}
+}
+
+bool
+ObjectWorkItem::MapFile(uint64_t offset, uint64_t length)
+{
+	if (length == 0) {
+		return false;
+	}
+
+	uint64_t end = offset + length;
+	if ((m_file->openMode() & QIODevice::WriteOnly) &&
+	    (uint64_t)m_file->size() < end) {
+		if (!m_file->resize(end)) {
+			return false;
+		}
+	}
+
+	m_map = m_file->map(offset, length);
+	if (m_map == NULL) {
+		return false;
+	}
+	m_mapSize = length;
+	m_mapPos = 0;
+	return true;
 }
 
 size_t
 ObjectWorkItem::ReadFile(char* data, size_t size, size_t count)
 {
-	size_t bytesRead = m_file.read(data, size * count);
+	size_t bytesRead;
+	if (m_compressor != NULL) {
+		qint64 numRead = m_compressor->Read(data, size * count);
+		m_codecError = (numRead < 0);
+		bytesRead = qMax((qint64)0, numRead);
+	} else if (m_map != NULL) {
+		bytesRead = qMin((uint64_t)(size * count), m_mapSize - m_mapPos);
+		memcpy(data, m_map + m_mapPos, bytesRead);
+		m_mapPos += bytesRead;
+	} else {
+		bytesRead = m_file->read(data, size * count);
+	}
 	if (m_bulkWorkItem != NULL) {
-		m_bulkWorkItem->UpdateBytesTransferred(bytesRead);
+		if (m_bulkWorkItem->UpdateBytesTransferred(m_progressCounter,
+							   bytesRead)) {
+			m_jobUpdateReady = true;
+		}
 	}
 	return bytesRead;
 }
@@ -47,9 +123,62 @@ ObjectWorkItem::ReadFile(char* data, size_t size, size_t count)
 size_t
 ObjectWorkItem::WriteFile(char* data, size_t size, size_t count)
 {
-	size_t bytesWritten = m_file.write(data, size * count);
+	size_t bytesWritten;
+	if (m_checksum != NULL) {
+		m_checksum->Update(data, size * count);
+	}
+	if (m_decompressor != NULL) {
+		m_codecError = !m_decompressor->Write(data, size * count);
+		bytesWritten = m_codecError ? 0 : size * count;
+	} else if (m_map != NULL) {
+		bytesWritten = qMin((uint64_t)(size * count), m_mapSize - m_mapPos);
+		memcpy(m_map + m_mapPos, data, bytesWritten);
+		m_mapPos += bytesWritten;
+	} else {
+		bytesWritten = m_file->write(data, size * count);
+	}
 	if (m_bulkWorkItem != NULL) {
-		m_bulkWorkItem->UpdateBytesTransferred(bytesWritten);
+		if (m_bulkWorkItem->UpdateBytesTransferred(m_progressCounter,
+							   bytesWritten)) {
+			m_jobUpdateReady = true;
+		}
 	}
 	return bytesWritten;
 }
+
+bool
+ObjectWorkItem::ComputeChecksum(Checksum* checksum, uint64_t length)
+{
+	if (m_map != NULL) {
+		if (length > m_mapSize - m_mapPos) {
+			return false;
+		}
+		checksum->Update((const char*)m_map + m_mapPos, length);
+		return true;
+	}
+
+	qint64 start = m_file->pos();
+	QByteArray buffer(CHECKSUM_BUFFER_SIZE, 0);
+	bool ok = true;
+	while (length > 0) {
+		qint64 toRead = qMin(length, (uint64_t)buffer.size());
+		qint64 numRead = m_file->read(buffer.data(), toRead);
+		if (numRead <= 0) {
+			ok = false;
+			break;
+		}
+		checksum->Update(buffer.constData(), numRead);
+		length -= numRead;
+	}
+	return m_file->seek(start) && ok;
+}
+
+bool
+ObjectWorkItem::FinishDecompressing()
+{
+	if (m_decompressor == NULL) {
+		return true;
+	}
+	m_codecError = !m_decompressor->Finish();
+	return !m_codecError;
+}
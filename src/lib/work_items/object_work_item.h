@@ -17,6 +17,7 @@
 #ifndef OBJECT_WORK_ITEM_H
 #define OBJECT_WORK_ITEM_H
 
+#include <stdint.h>
 #include <QFile>
 #include <QIODevice>
 #include <QString>
@@ -24,6 +25,9 @@
 #include "lib/work_items/work_item.h"
 
 class BulkWorkItem;
+class Checksum;
+class ObjectCompressor;
+class ObjectDecompressor;
 
 // ObjectWorkItem, a container class used to pass information about a
 // GET/PUT object request to the methods that actually read/write the
@@ -32,6 +36,8 @@ class BulkWorkItem;
 class ObjectWorkItem : public WorkItem
 {
 public:
+	static const int CHECKSUM_BUFFER_SIZE;
+
 	ObjectWorkItem(const QString& bucketName,
 		       const QString& objectName,
 		       const QString& fileName,
@@ -44,15 +50,64 @@ public:
 	BulkWorkItem* GetBulkWorkItem() const;
 
 	bool OpenFile(QIODevice::OpenMode mode);
+	// Use a file that the caller already opened, and still owns,
+	// instead of opening fileName.  ReleaseFile stops using it, and
+	// unmaps it, so the caller can hand it to another ObjectWorkItem.
+	void UseFile(QFile* file);
+	void ReleaseFile();
 	bool SeekFile(uint64_t pos);
+	// Map the part of the already opened file that this object covers
+	// into memory so ReadFile/WriteFile copy straight to/from the mapped
+	// pages instead of going through QFile's buffering.  When the file
+	// is opened for writing, it is grown to fit the object if
+	// necessary.  Returns false if the file couldn't be mapped, in which
+	// case regular file I/O continues to be used.
+	bool MapFile(uint64_t offset, uint64_t length);
+	bool IsFileMapped() const;
+	// Read the file through compressor, or write it through
+	// decompressor, instead of reading/writing its data as is.  The
+	// object takes ownership of them.
+	void SetCompressor(ObjectCompressor* compressor);
+	void SetDecompressor(ObjectDecompressor* decompressor);
+	// Whether the compressor or decompressor failed
+	bool HasCodecError() const;
+	// Whether everything written through the decompressor decompressed
+	// completely
+	bool FinishDecompressing();
+	// Add the data that WriteFile receives, as it comes from the server,
+	// to checksum.  The object takes ownership of it.
+	void SetChecksum(Checksum* checksum);
+	Checksum* GetChecksum() const;
+	// Add the next length bytes that ReadFile would send to checksum
+	// without moving the read position.  Returns false if they couldn't
+	// all be read.
+	bool ComputeChecksum(Checksum* checksum, uint64_t length);
 	size_t ReadFile(char* data, size_t size, size_t count);
 	size_t WriteFile(char* data, size_t size, size_t count);
+	// Whether the bulk work item's progress passed another update
+	// threshold since the last time this was called.
+	bool IsJobUpdateReady();
 
 private:
 	QString m_bucketName;
 	QString m_objectName;
-	QFile m_file;
+	QFile m_ownFile;
+	// m_ownFile or the caller's file
+	QFile* m_file;
 	BulkWorkItem* m_bulkWorkItem;
+	// The bulk work item progress counter this object's bytes are
+	// added to
+	int m_progressCounter;
+	bool m_jobUpdateReady;
+	// The mapped part of m_file, if any, and the current read/write
+	// position within it.
+	uchar* m_map;
+	uint64_t m_mapSize;
+	uint64_t m_mapPos;
+	ObjectCompressor* m_compressor;
+	ObjectDecompressor* m_decompressor;
+	bool m_codecError;
+	Checksum* m_checksum;
 };
 
 inline const QString&
@@ -70,7 +125,7 @@ ObjectWorkItem::GetObjectName() const
 inline QFile*
 ObjectWorkItem::GetFile()
 {
-	return &m_file;
+	return m_file;
 }
 
 inline BulkWorkItem*
@@ -82,13 +137,63 @@ ObjectWorkItem::GetBulkWorkItem() const
 inline bool
 ObjectWorkItem::OpenFile(QIODevice::OpenMode mode)
 {
-	return m_file.open(mode);
+	return m_file->open(mode);
+}
+
+inline void
+ObjectWorkItem::UseFile(QFile* file)
+{
+	m_file = file;
 }
 
 inline bool
 ObjectWorkItem::SeekFile(uint64_t pos)
 {
-	return m_file.seek(pos);
+	return m_file->seek(pos);
+}
+
+inline bool
+ObjectWorkItem::IsFileMapped() const
+{
+	return (m_map != NULL);
+}
+
+inline void
+ObjectWorkItem::SetCompressor(ObjectCompressor* compressor)
+{
+	m_compressor = compressor;
+}
+
+inline void
+ObjectWorkItem::SetDecompressor(ObjectDecompressor* decompressor)
+{
+	m_decompressor = decompressor;
+}
+
+inline bool
+ObjectWorkItem::HasCodecError() const
+{
+	return m_codecError;
+}
+
+inline void
+ObjectWorkItem::SetChecksum(Checksum* checksum)
+{
+	m_checksum = checksum;
+}
+
+inline Checksum*
+ObjectWorkItem::GetChecksum() const
+{
+	return m_checksum;
+}
+
+inline bool
+ObjectWorkItem::IsJobUpdateReady()
+{
+	bool ready = m_jobUpdateReady;
+	m_jobUpdateReady = false;
+	return ready;
 }
 
 #endif
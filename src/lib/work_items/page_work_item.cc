@@ -0,0 +1,264 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QFile>
+
+#include "helpers/file_helper.h"
+#include "lib/job_journal.h"
+#include "lib/work_items/bulk_work_item.h"
+#include "lib/work_items/page_work_item.h"
+
+// Enough for the objects whose blobs are spread over several chunks without
+// running out of file handles
+const int PageWorkItem::MAX_IDLE_FILES = 256;
+
+PageWorkItem::PageWorkItem(BulkWorkItem* bulkWorkItem,
+			   const QString& bucketName,
+			   const QHash<QString, QString>& objMap,
+			   int numURLsProcessed,
+			   const QUrl& lastProcessedUrl,
+			   ds3_bulk_response* response)
+	: WorkItem(),
+	  m_bulkWorkItem(bulkWorkItem),
+	  m_bucketName(bucketName),
+	  m_objMap(objMap),
+	  m_numURLsProcessed(numURLsProcessed),
+	  m_lastProcessedUrl(lastProcessedUrl),
+	  m_response(response),
+	  m_numChunksProcessed(0),
+	  m_numIdleFiles(0)
+{
+	InitBlobs();
+}
+
+PageWorkItem::~PageWorkItem()
+{
+	if (m_response != NULL) {
+		ds3_free_bulk_response(m_response);
+	}
+	QHash<QString, ObjectBlobs>::iterator oi;
+	for (oi = m_blobs.begin(); oi != m_blobs.end(); oi++) {
+		qDeleteAll(oi.value().idleFiles);
+	}
+}
+
+const QString
+PageWorkItem::GetJobID() const
+{
+	QString jobID;
+	if (m_response != NULL) {
+		jobID = QString(m_response->job_id->value);
+	}
+	return jobID;
+}
+
+uint64_t
+PageWorkItem::GetSize() const
+{
+	uint64_t size = 0;
+	if (m_response != NULL) {
+		size = m_response->original_size_in_bytes;
+	}
+	return size;
+}
+
+uint64_t
+PageWorkItem::GetNumBlobs() const
+{
+	uint64_t numBlobs = 0;
+	if (m_response != NULL) {
+		for (size_t chunk = 0; chunk < m_response->list_size; chunk++) {
+			numBlobs += m_response->list[chunk]->size;
+		}
+	}
+	return numBlobs;
+}
+
+bool
+PageWorkItem::IsFinished() const
+{
+	size_t numChunks = m_response == NULL ? 0 : m_response->list_size;
+	return numChunks == GetNumChunksProcessed();
+}
+
+void
+PageWorkItem::SetDone(const QSet<QString>& chunksDone,
+		      const QSet<QString>& blobsDone)
+{
+	m_chunksDone = chunksDone;
+	m_blobsDone = blobsDone;
+}
+
+bool
+PageWorkItem::IsBlobDone(const QString& objName, uint64_t offset) const
+{
+	return m_blobsDone.contains(JobJournal::BlobKey(objName, offset));
+}
+
+void
+PageWorkItem::InitBlobs()
+{
+	m_blobsLock.lock();
+	m_blobs.clear();
+	size_t numChunks = m_response == NULL ? 0 : m_response->list_size;
+	for (size_t chunk = 0; chunk < numChunks; chunk++) {
+		ds3_bulk_object_list* list = m_response->list[chunk];
+		for (uint64_t i = 0; i < list->size; i++) {
+			ds3_bulk_object* bulkObj = &(list->list[i]);
+			QString objName = QString::fromUtf8(bulkObj->name->value);
+			ObjectBlobs& blobs = m_blobs[objName];
+			if (blobs.finished.isEmpty()) {
+				blobs.size = 0;
+				blobs.preallocated = false;
+			}
+			blobs.size = qMax(blobs.size,
+					  bulkObj->offset + bulkObj->length);
+			blobs.finished.insert(bulkObj->offset, false);
+		}
+	}
+	m_blobsLock.unlock();
+}
+
+bool
+PageWorkItem::PreallocateObjectFile(const QString& objName,
+				    const QString& filePath)
+{
+	bool ok = true;
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName) && !m_blobs[objName].preallocated) {
+		ObjectBlobs& blobs = m_blobs[objName];
+		QFile file(filePath);
+		ok = file.open(QIODevice::ReadWrite) &&
+		     FileHelper::Preallocate(&file, blobs.size);
+		blobs.preallocated = ok;
+	}
+	m_blobsLock.unlock();
+	return ok;
+}
+
+bool
+PageWorkItem::StartPreallocation(const QString& objName, uint64_t* size)
+{
+	bool start = false;
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName) && !m_blobs[objName].preallocated) {
+		ObjectBlobs& blobs = m_blobs[objName];
+		blobs.preallocated = true;
+		*size = blobs.size;
+		start = true;
+	}
+	m_blobsLock.unlock();
+	return start;
+}
+
+QFile*
+PageWorkItem::CheckoutObjectFile(const QString& objName,
+				 const QString& filePath)
+{
+	QFile* file = NULL;
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName) && !m_blobs[objName].idleFiles.isEmpty()) {
+		file = m_blobs[objName].idleFiles.takeLast();
+		m_numIdleFiles--;
+	}
+	m_blobsLock.unlock();
+	if (file == NULL) {
+		file = new QFile(filePath);
+		if (!file->open(QIODevice::ReadWrite)) {
+			delete file;
+			file = NULL;
+		}
+	}
+	return file;
+}
+
+void
+PageWorkItem::ReturnObjectFile(const QString& objName, QFile* file)
+{
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName) && m_numIdleFiles < MAX_IDLE_FILES &&
+	    m_blobs[objName].finished.values().contains(false)) {
+		m_blobs[objName].idleFiles << file;
+		m_numIdleFiles++;
+		file = NULL;
+	}
+	m_blobsLock.unlock();
+	delete file;
+}
+
+bool
+PageWorkItem::IsSingleBlob(const QString& objName) const
+{
+	m_blobsLock.lock();
+	bool single = (m_blobs.value(objName).finished.size() == 1);
+	m_blobsLock.unlock();
+	return single;
+}
+
+bool
+PageWorkItem::FinishBlob(const QString& objName, uint64_t offset)
+{
+	bool objectFinished = false;
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName)) {
+		QMap<uint64_t, bool>& finished = m_blobs[objName].finished;
+		if (!finished.value(offset, true)) {
+			finished[offset] = true;
+			objectFinished = !finished.values().contains(false);
+		}
+		if (objectFinished) {
+			QList<QFile*>& idleFiles = m_blobs[objName].idleFiles;
+			m_numIdleFiles -= idleFiles.size();
+			qDeleteAll(idleFiles);
+			idleFiles.clear();
+		}
+	}
+	m_blobsLock.unlock();
+	return objectFinished;
+}
+
+QStringList
+PageWorkItem::GetUnfinishedObjects() const
+{
+	QStringList objNames;
+	m_blobsLock.lock();
+	QHash<QString, ObjectBlobs>::const_iterator oi;
+	for (oi = m_blobs.constBegin(); oi != m_blobs.constEnd(); oi++) {
+		if (oi.value().finished.values().contains(false)) {
+			objNames << oi.key();
+		}
+	}
+	m_blobsLock.unlock();
+	return objNames;
+}
+
+QList<uint64_t>
+PageWorkItem::GetUnfinishedBlobs(const QString& objName) const
+{
+	QList<uint64_t> offsets;
+	m_blobsLock.lock();
+	if (m_blobs.contains(objName)) {
+		const QMap<uint64_t, bool>& finished = m_blobs[objName].finished;
+		QMap<uint64_t, bool>::const_iterator bi;
+		for (bi = finished.constBegin(); bi != finished.constEnd(); bi++) {
+			if (!bi.value()) {
+				offsets << bi.key();
+			}
+		}
+	}
+	m_blobsLock.unlock();
+	return offsets;
+}
@@ -0,0 +1,271 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef PAGE_WORK_ITEM_H
+#define PAGE_WORK_ITEM_H
+
+#include <stdint.h>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+#include <ds3.h>
+
+#include "lib/work_items/work_item.h"
+
+class BulkWorkItem;
+
+// The blobs that the server split an object into, keyed by offset, and
+// whether or not each one of them has been transferred
+struct ObjectBlobs {
+	uint64_t size;
+	bool preallocated;
+	QMap<uint64_t, bool> finished;
+	// Open files of the object that no blob is writing to right now
+	QList<QFile*> idleFiles;
+};
+
+// PageWorkItem, a container class that stores all data necessary to transfer
+// one page of a BulkWorkItem.  A large drag/drop operation might have to be
+// split up amongst several DS3 Bulk GET/PUT jobs.  Each one of these DS3 jobs
+// represents a page.  The next page is prepared, and its DS3 job created,
+// while the current one is still being transferred so a BulkWorkItem can
+// have two pages at once.
+class PageWorkItem : public WorkItem
+{
+public:
+	// PageWorkItem takes ownership of response
+	PageWorkItem(BulkWorkItem* bulkWorkItem,
+		     const QString& bucketName,
+		     const QHash<QString, QString>& objMap,
+		     int numURLsProcessed,
+		     const QUrl& lastProcessedUrl,
+		     ds3_bulk_response* response);
+	~PageWorkItem();
+
+	BulkWorkItem* GetBulkWorkItem() const;
+	// The S3 server assigned ID for this page's job.  Empty if there
+	// isn't a response.
+	const QString GetJobID() const;
+	const QString& GetBucketName() const;
+	// The position in the BulkWorkItem's URLs that preparing this page
+	// stopped at
+	int GetNumURLsProcessed() const;
+	const QUrl& GetLastProcessedUrl() const;
+	uint64_t GetSize() const;
+	ds3_bulk_response* GetResponse() const;
+	// Number of objects, or parts (blobs) of objects, in all of the
+	// page's job chunks
+	uint64_t GetNumBlobs() const;
+
+	QHash<QString, QString>::const_iterator GetObjMapConstBegin() const;
+	QHash<QString, QString>::const_iterator GetObjMapConstEnd() const;
+	uint64_t GetObjMapSize() const;
+	const QString GetObjMapValue(const QString& objName) const;
+
+	// Note that each page could be split up amongst one or more DS3
+	// job chunks.
+	size_t GetNumChunksProcessed() const;
+	void IncNumChunksProcessed(int chunks = 1);
+	bool IsFinished() const;
+
+	// Blobs and job chunks that had already finished before the page
+	// was resumed.  They aren't transferred again.
+	void SetDone(const QSet<QString>& chunksDone,
+		     const QSet<QString>& blobsDone);
+	bool IsBlobDone(const QString& objName, uint64_t offset) const;
+	const QSet<QString>& GetChunksDone() const;
+
+	// The most files PageWorkItem keeps open between blobs
+	static const int MAX_IDLE_FILES;
+
+	// The blobs of a GET object can be in different job chunks and are
+	// thus downloaded in parallel into the same file.
+	//
+	// Grow/shrink the object's file to the object's full size the first
+	// time any of its blobs is about to be written so every blob can be
+	// written at its own offset.  Returns false if the file couldn't be
+	// resized.
+	bool PreallocateObjectFile(const QString& objName,
+				   const QString& filePath);
+	// Claim the preallocation of the object's file so it can be done
+	// ahead of time, outside of PreallocateObjectFile.  Returns false if
+	// it was already done.  size is the object's full size.
+	bool StartPreallocation(const QString& objName, uint64_t* size);
+	// An open file to write a blob of the object into, reusing one that
+	// an earlier blob of the object left open if there is one.  NULL if
+	// the file couldn't be opened.  Every file must be returned, and is
+	// closed once the object's last blob finishes.
+	QFile* CheckoutObjectFile(const QString& objName,
+				  const QString& filePath);
+	void ReturnObjectFile(const QString& objName, QFile* file);
+	// Whether the server sent the object in one piece
+	bool IsSingleBlob(const QString& objName) const;
+	// Returns true if that was the object's last unfinished blob.  Both
+	// GET and PUT objects' blobs are tracked.
+	bool FinishBlob(const QString& objName, uint64_t offset);
+	// Objects that still have blobs that haven't been downloaded
+	QStringList GetUnfinishedObjects() const;
+	QList<uint64_t> GetUnfinishedBlobs(const QString& objName) const;
+
+	// The ETags the server listed for the page's GET objects.  Set
+	// before the page starts transferring.
+	void SetETags(const QHash<QString, QString>& etags);
+	const QHash<QString, QString>& GetETags() const;
+	QString GetETag(const QString& objName) const;
+	// The compressed block sizes that preparing the page measured for
+	// its PUT objects that are sent compressed.  Empty for any other
+	// object, or if the page was resumed from its journal.
+	void SetBlockSizes(const QHash<QString, QList<qint64> >& sizes);
+	QList<qint64> GetBlockSizes(const QString& objName) const;
+
+private:
+	void InitBlobs();
+
+	BulkWorkItem* m_bulkWorkItem;
+	QString m_bucketName;
+	QHash<QString, QString> m_objMap;
+	int m_numURLsProcessed;
+	QUrl m_lastProcessedUrl;
+	ds3_bulk_response* m_response;
+	size_t m_numChunksProcessed;
+	mutable QMutex m_numChunksProcessedLock;
+
+	QSet<QString> m_chunksDone;
+	QSet<QString> m_blobsDone;
+
+	QHash<QString, ObjectBlobs> m_blobs;
+	int m_numIdleFiles;
+	mutable QMutex m_blobsLock;
+
+	QHash<QString, QString> m_etags;
+	QHash<QString, QList<qint64> > m_blockSizes;
+};
+
+inline void
+PageWorkItem::SetETags(const QHash<QString, QString>& etags)
+{
+	m_etags = etags;
+}
+
+inline const QHash<QString, QString>&
+PageWorkItem::GetETags() const
+{
+	return m_etags;
+}
+
+inline QString
+PageWorkItem::GetETag(const QString& objName) const
+{
+	return m_etags.value(objName);
+}
+
+inline void
+PageWorkItem::SetBlockSizes(const QHash<QString, QList<qint64> >& sizes)
+{
+	m_blockSizes = sizes;
+}
+
+inline QList<qint64>
+PageWorkItem::GetBlockSizes(const QString& objName) const
+{
+	return m_blockSizes.value(objName);
+}
+
+inline BulkWorkItem*
+PageWorkItem::GetBulkWorkItem() const
+{
+	return m_bulkWorkItem;
+}
+
+inline const QString&
+PageWorkItem::GetBucketName() const
+{
+	return m_bucketName;
+}
+
+inline int
+PageWorkItem::GetNumURLsProcessed() const
+{
+	return m_numURLsProcessed;
+}
+
+inline const QUrl&
+PageWorkItem::GetLastProcessedUrl() const
+{
+	return m_lastProcessedUrl;
+}
+
+inline ds3_bulk_response*
+PageWorkItem::GetResponse() const
+{
+	return m_response;
+}
+
+inline QHash<QString,QString>::const_iterator
+PageWorkItem::GetObjMapConstBegin() const
+{
+	return m_objMap.constBegin();
+}
+
+inline QHash<QString,QString>::const_iterator
+PageWorkItem::GetObjMapConstEnd() const
+{
+	return m_objMap.constEnd();
+}
+
+inline uint64_t
+PageWorkItem::GetObjMapSize() const
+{
+	return (uint64_t)m_objMap.size();
+}
+
+inline const QString
+PageWorkItem::GetObjMapValue(const QString& objName) const
+{
+	return m_objMap.value(objName);
+}
+
+inline size_t
+PageWorkItem::GetNumChunksProcessed() const
+{
+	m_numChunksProcessedLock.lock();
+	size_t chunks = m_numChunksProcessed;
+	m_numChunksProcessedLock.unlock();
+	return chunks;
+}
+
+inline void
+PageWorkItem::IncNumChunksProcessed(int chunks)
+{
+	m_numChunksProcessedLock.lock();
+	m_numChunksProcessed += chunks;
+	m_numChunksProcessedLock.unlock();
+}
+
+inline const QSet<QString>&
+PageWorkItem::GetChunksDone() const
+{
+	return m_chunksDone;
+}
+
+#endif
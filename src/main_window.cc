@@ -16,11 +16,11 @@
 
 #include <QApplication>
 #include <QDialogButtonBox>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QMenuBar>
 #include <QSettings>
-#include <QThreadPool>
 
 #include "global.h"
 #include "lib/logger.h"
@@ -94,7 +94,9 @@ MainWindow::closeEvent(QCloseEvent* event)
 		QString title = "Active Jobs In Progress";
 		QString msg = "There are active jobs still in progress.  " \
 			      "Are you sure wish to cancel those jobs and " \
-			      "quit the applcation?";
+			      "quit the applcation?  They will be resumed " \
+			      "the next time a session to the same host " \
+			      "is started.";
 		QMessageBox::StandardButton ret;
 		ret = QMessageBox::warning(this, title, msg,
 					   QMessageBox::Ok |
@@ -155,10 +157,14 @@ MainWindow::CancelActiveJobs()
 	for (int i = 0; i < m_sessionViews.size(); i++) {
 		m_sessionViews[i]->CancelActiveJobs();
 	}
-	// All jobs are currently run via QtConcurrent::run, which uses
-	// the global thread pool.  This will need to be modified if certain
-	// job tasks are ever switched to using a custom thread pool.
-	bool ret = QThreadPool::globalInstance()->waitForDone(CANCEL_JOBS_TIMEOUT_IN_MS);
+	// Each session's Client runs its jobs on its own executors
+	QElapsedTimer timer;
+	timer.start();
+	bool ret = true;
+	for (int i = 0; i < m_sessionViews.size() && ret; i++) {
+		int remaining = CANCEL_JOBS_TIMEOUT_IN_MS - timer.elapsed();
+		ret = m_sessionViews[i]->WaitForActiveJobs(qMax(0, remaining));
+	}
 	if (!ret) {
 		LOG_ERROR("ERROR:       TIMED OUT waiting for all jobs to stop");
 	}
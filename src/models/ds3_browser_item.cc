@@ -0,0 +1,392 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDateTime>
+
+#include "helpers/number_helper.h"
+#include "models/ds3_browser_item.h"
+
+static const QString REST_TIMESTAMP_FORMAT = "yyyy-MM-ddThh:mm:ss.000Z";
+static const QString VIEW_TIMESTAMP_FORMAT = "MMMM d, yyyy h:mm AP";
+
+const QString DS3BrowserItem::ITEMKIND_BUCKET = "Bucket";
+const QString DS3BrowserItem::ITEMKIND_OBJECT = "Object";
+const QString DS3BrowserItem::ITEMKIND_FOLDER = "Folder";
+
+const qint64 DS3BrowserItem::NOT_APPLICABLE = -1;
+const qint64 DS3BrowserItem::NO_TIMESTAMP = -2;
+
+qint64
+DS3BrowserItem::ToTimestamp(const char* restTimestamp)
+{
+	return ToTimestamp(QString::fromUtf8(restTimestamp));
+}
+
+qint64
+DS3BrowserItem::ToTimestamp(const QString& restTimestamp)
+{
+	QDateTime dt = QDateTime::fromString(restTimestamp,
+					     REST_TIMESTAMP_FORMAT);
+	if (!dt.isValid()) {
+		return NO_TIMESTAMP;
+	}
+	return dt.toMSecsSinceEpoch();
+}
+
+DS3BrowserItem::DS3BrowserItem(const QString& bucketName,
+			       const QString& prefix,
+			       DS3BrowserItem* parent,
+			       int row)
+	: m_canFetchMore(true),
+	  m_fetching(false),
+	  m_listsBuckets(true),
+	  m_bucketName(bucketName),
+	  m_pagesToPrefetch(0),
+	  m_parent(parent),
+	  m_prefix(prefix),
+	  m_row(row),
+	  m_numNameChars(0)
+{
+}
+
+DS3BrowserItem::~DS3BrowserItem()
+{
+	qDeleteAll(m_childItems);
+}
+
+QString
+DS3BrowserItem::GetOwner() const
+{
+	QString owner;
+	if (m_parent != NULL) {
+		owner = m_parent->GetChildOwner(m_row);
+	}
+	return owner;
+}
+
+void
+DS3BrowserItem::Reset()
+{
+	qDeleteAll(m_childItems);
+	m_childItems.clear();
+	m_kinds.clear();
+	m_names.clear();
+	m_numNameChars = 0;
+	m_nameStarts.clear();
+	m_nameSizes.clear();
+	m_owners.clear();
+	m_ownerIDs.clear();
+	m_sizes.clear();
+	m_createds.clear();
+	m_canFetchMore = true;
+	m_nextMarker = QString();
+	m_pagesToPrefetch = 0;
+}
+
+void
+DS3BrowserItem::AppendChild(Kind kind,
+			    const QString& name,
+			    const QString& owner,
+			    qint64 size,
+			    qint64 created)
+{
+	m_kinds << static_cast<quint8>(kind);
+	m_nameStarts << m_names.size();
+	m_nameSizes << name.size();
+	m_names += name;
+	m_numNameChars += name.size();
+	m_ownerIDs << InternOwner(owner);
+	m_sizes << size;
+	m_createds << created;
+}
+
+void
+DS3BrowserItem::AppendChildren(const DS3BrowserItem& rows)
+{
+	int nameOffset = m_names.size();
+	int start = GetChildCount();
+	m_kinds += rows.m_kinds;
+	m_names += rows.m_names;
+	m_numNameChars += rows.m_numNameChars;
+	m_nameStarts += rows.m_nameStarts;
+	m_nameSizes += rows.m_nameSizes;
+	m_sizes += rows.m_sizes;
+	m_createds += rows.m_createds;
+
+	QVector<int> ownerIDs(rows.m_owners.size());
+	for (int i = 0; i < rows.m_owners.size(); i++) {
+		ownerIDs[i] = InternOwner(rows.m_owners.at(i));
+	}
+	m_ownerIDs.reserve(m_ownerIDs.size() + rows.m_ownerIDs.size());
+	for (int i = 0; i < rows.m_ownerIDs.size(); i++) {
+		m_ownerIDs << ownerIDs.at(rows.m_ownerIDs.at(i));
+	}
+	if (nameOffset > 0) {
+		int* nameStarts = m_nameStarts.data();
+		for (int i = start; i < m_nameStarts.size(); i++) {
+			nameStarts[i] += nameOffset;
+		}
+	}
+}
+
+void
+DS3BrowserItem::ReserveChildren(int count)
+{
+	int size = GetChildCount() + count;
+	m_kinds.reserve(size);
+	m_nameStarts.reserve(size);
+	m_nameSizes.reserve(size);
+	m_ownerIDs.reserve(size);
+	m_sizes.reserve(size);
+	m_createds.reserve(size);
+}
+
+void
+DS3BrowserItem::InsertChildren(int row, const DS3BrowserItem& rows,
+			       int first, int count)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	m_kinds.insert(row, count, 0);
+	m_nameStarts.insert(row, count, 0);
+	m_nameSizes.insert(row, count, 0);
+	m_ownerIDs.insert(row, count, 0);
+	m_sizes.insert(row, count, 0);
+	m_createds.insert(row, count, 0);
+	for (int i = 0; i < count; i++) {
+		int from = first + i;
+		int to = row + i;
+		m_kinds[to] = rows.m_kinds.at(from);
+		m_nameStarts[to] = m_names.size();
+		m_nameSizes[to] = rows.m_nameSizes.at(from);
+		m_names += rows.m_names.midRef(rows.m_nameStarts.at(from),
+					       rows.m_nameSizes.at(from));
+		m_numNameChars += rows.m_nameSizes.at(from);
+		m_ownerIDs[to] = InternOwner(rows.GetChildOwner(from));
+		m_sizes[to] = rows.m_sizes.at(from);
+		m_createds[to] = rows.m_createds.at(from);
+	}
+
+	if (m_childItems.isEmpty()) {
+		return;
+	}
+	QHash<int, DS3BrowserItem*> childItems;
+	QHash<int, DS3BrowserItem*>::const_iterator it;
+	for (it = m_childItems.constBegin(); it != m_childItems.constEnd(); ++it) {
+		DS3BrowserItem* item = it.value();
+		if (item->m_row >= row) {
+			item->m_row += count;
+		}
+		childItems.insert(item->m_row, item);
+	}
+	m_childItems = childItems;
+}
+
+void
+DS3BrowserItem::RemoveChild(int row)
+{
+	RemoveChildren(row, 1);
+}
+
+// The columns are simply shifted.  The removed names are left in the arena
+// until CompactNames finds more of them than of the remaining ones, so a
+// refresh that removes rows again and again only copies the arena once its
+// size has doubled.
+void
+DS3BrowserItem::RemoveChildren(int row, int count)
+{
+	count = qMin(count, GetChildCount() - row);
+	if (count <= 0) {
+		return;
+	}
+
+	for (int i = row; i < row + count; i++) {
+		m_numNameChars -= m_nameSizes.at(i);
+	}
+	m_kinds.remove(row, count);
+	m_nameStarts.remove(row, count);
+	m_nameSizes.remove(row, count);
+	m_ownerIDs.remove(row, count);
+	m_sizes.remove(row, count);
+	m_createds.remove(row, count);
+	CompactNames();
+
+	if (m_childItems.isEmpty()) {
+		return;
+	}
+	QHash<int, DS3BrowserItem*> childItems;
+	QHash<int, DS3BrowserItem*>::const_iterator it;
+	for (it = m_childItems.constBegin(); it != m_childItems.constEnd(); ++it) {
+		DS3BrowserItem* item = it.value();
+		if (item->m_row >= row + count) {
+			item->m_row -= count;
+		} else if (item->m_row >= row) {
+			delete item;
+			continue;
+		}
+		childItems.insert(item->m_row, item);
+	}
+	m_childItems = childItems;
+}
+
+bool
+DS3BrowserItem::UpdateChild(int row, const DS3BrowserItem& rows, int rowsRow)
+{
+	int ownerID = InternOwner(rows.GetChildOwner(rowsRow));
+	qint64 size = rows.m_sizes.at(rowsRow);
+	qint64 created = rows.m_createds.at(rowsRow);
+	if (m_ownerIDs.at(row) == ownerID && m_sizes.at(row) == size &&
+	    m_createds.at(row) == created) {
+		return false;
+	}
+	m_ownerIDs[row] = ownerID;
+	m_sizes[row] = size;
+	m_createds[row] = created;
+	return true;
+}
+
+QVariant
+DS3BrowserItem::GetChildData(int row, int column) const
+{
+	Kind kind = GetChildKind(row);
+	switch (kind) {
+	case PAGE_BREAK:
+		return column == NAME ? QVariant("Click to load more") : QVariant();
+	case LOADING:
+		return column == NAME ? QVariant("Loading ...") : QVariant();
+	case NO_SEARCH_RESULTS:
+		return column == NAME ? QVariant("There are currently no items to display") : QVariant();
+	default:
+		break;
+	}
+
+	QVariant data;
+	qint64 value;
+	switch (column) {
+	case NAME:
+		data = GetChildName(row);
+		break;
+	case OWNER:
+		data = GetChildOwner(row);
+		break;
+	case SIZE_COL:
+		value = m_sizes.at(row);
+		if (value == NOT_APPLICABLE) {
+			data = "--";
+		} else {
+			data = NumberHelper::ToHumanSize(value);
+		}
+		break;
+	case KIND:
+		if (kind == BUCKET) {
+			data = ITEMKIND_BUCKET;
+		} else if (kind == FOLDER) {
+			data = ITEMKIND_FOLDER;
+		} else {
+			data = ITEMKIND_OBJECT;
+		}
+		break;
+	case CREATED:
+		value = m_createds.at(row);
+		if (value == NOT_APPLICABLE) {
+			data = "--";
+		} else if (value == NO_TIMESTAMP) {
+			data = QString();
+		} else {
+			QDateTime dt = QDateTime::fromMSecsSinceEpoch(value);
+			data = dt.toString(VIEW_TIMESTAMP_FORMAT);
+		}
+		break;
+	}
+	return data;
+}
+
+QString
+DS3BrowserItem::GetChildBucketName(int row) const
+{
+	if (m_listsBuckets && m_parent == NULL && GetChildKind(row) == BUCKET) {
+		return GetChildName(row);
+	}
+	return m_bucketName;
+}
+
+QString
+DS3BrowserItem::GetChildPath(int row) const
+{
+	QString path = "/" + GetChildBucketName(row);
+	if (GetChildKind(row) == BUCKET) {
+		return path;
+	}
+
+	if (m_prefix.isEmpty()) {
+		path += "/";
+	} else {
+		path += "/" + m_prefix;
+	}
+	path += GetChildName(row);
+	return path;
+}
+
+DS3BrowserItem*
+DS3BrowserItem::GetChildItem(int row)
+{
+	DS3BrowserItem* item = m_childItems.value(row);
+	if (item == NULL) {
+		QString bucketName = GetChildBucketName(row);
+		QString prefix;
+		if (GetChildKind(row) != BUCKET) {
+			prefix = m_prefix + GetChildName(row) + "/";
+		}
+		item = new DS3BrowserItem(bucketName, prefix, this, row);
+		m_childItems.insert(row, item);
+	}
+	return item;
+}
+
+int
+DS3BrowserItem::InternOwner(const QString& owner)
+{
+	// Every child in a listing has the same owner so check the last
+	// one before searching.
+	int id = m_owners.size() - 1;
+	if (id < 0 || m_owners.at(id) != owner) {
+		id = m_owners.indexOf(owner);
+		if (id < 0) {
+			id = m_owners.size();
+			m_owners << owner;
+		}
+	}
+	return id;
+}
+
+void
+DS3BrowserItem::CompactNames()
+{
+	if (m_names.size() - m_numNameChars <= m_numNameChars) {
+		return;
+	}
+	QString names;
+	names.reserve(m_numNameChars);
+	int* nameStarts = m_nameStarts.data();
+	for (int i = 0; i < m_nameStarts.size(); i++) {
+		int start = nameStarts[i];
+		nameStarts[i] = names.size();
+		names += m_names.midRef(start, m_nameSizes.at(i));
+	}
+	m_names = names;
+}
@@ -0,0 +1,272 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef DS3_BROWSER_ITEM_H
+#define DS3_BROWSER_ITEM_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+// The root of a DS3BrowserModel or one of its buckets or folders.
+// Listings can hold millions of objects so an item doesn't create an item
+// per child.  Instead, it keeps its children in columns: their names in one
+// string arena, their sizes and timestamps in packed arrays and their
+// owners interned.  Child items are only created when something needs one,
+// e.g. when a folder is expanded, and the QVariants the model shows are
+// only created when the view asks for them.
+class DS3BrowserItem
+{
+public:
+	// Must match DS3BrowserModel's header
+	enum Column { NAME, OWNER, SIZE_COL, KIND, CREATED, COUNT };
+	enum Kind { BUCKET, FOLDER, OBJECT,
+		    PAGE_BREAK, LOADING, NO_SEARCH_RESULTS };
+
+	static const QString ITEMKIND_BUCKET;
+	static const QString ITEMKIND_OBJECT;
+	static const QString ITEMKIND_FOLDER;
+
+	// A size or timestamp that doesn't apply to the child, e.g. a
+	// folder's size, and is shown as "--"
+	static const qint64 NOT_APPLICABLE;
+	// A timestamp that the server didn't send and is shown as empty
+	static const qint64 NO_TIMESTAMP;
+
+	// Convert a DS3 REST timestamp to what AppendChild expects
+	static qint64 ToTimestamp(const char* restTimestamp);
+	static qint64 ToTimestamp(const QString& restTimestamp);
+
+	DS3BrowserItem(const QString& bucketName = QString(),
+		       const QString& prefix = QString(),
+		       DS3BrowserItem* parent = NULL,
+		       int row = 0);
+	~DS3BrowserItem();
+
+	// The bucket that this item's children are in
+	QString GetBucketName() const;
+	// The object name prefix of this item's children
+	QString GetPrefix() const;
+	QString GetOwner() const;
+	DS3BrowserItem* GetParent() const;
+	int GetRow() const;
+	bool GetCanFetchMore() const;
+	bool IsFetching() const;
+	QString GetNextMarker() const;
+	// How many more pages of this item's children to fetch, one after
+	// the other, without waiting for the view to come near the end
+	int GetPagesToPrefetch() const;
+	void Reset();
+
+	void SetCanFetchMore(bool canFetchMore);
+	void SetFetching(bool fetching);
+	void SetListsBuckets(bool listsBuckets);
+	void SetNextMarker(const QString nextMarker);
+	void SetPagesToPrefetch(int pages);
+
+	void AppendChild(Kind kind,
+			 const QString& name = QString(),
+			 const QString& owner = QString(),
+			 qint64 size = NOT_APPLICABLE,
+			 qint64 created = NOT_APPLICABLE);
+	// Append every child of rows, an item that isn't part of a model,
+	// e.g. one that a listing was converted into on another thread
+	void AppendChildren(const DS3BrowserItem& rows);
+	void ReserveChildren(int count);
+	// Insert count of rows' children, starting at first, before row
+	void InsertChildren(int row, const DS3BrowserItem& rows,
+			    int first, int count);
+	void RemoveChild(int row);
+	void RemoveChildren(int row, int count);
+	// Give the child at row the owner, size and timestamp of rows'
+	// child at rowsRow.  Returns false if they were already the same.
+	bool UpdateChild(int row, const DS3BrowserItem& rows, int rowsRow);
+	int GetChildCount() const;
+	// The characters in the names arena, including those of removed
+	// children that haven't been compacted away yet
+	int GetNamesSize() const;
+	Kind GetChildKind(int row) const;
+	bool IsChildBucketOrFolder(int row) const;
+	QString GetChildName(int row) const;
+	QString GetChildOwner(int row) const;
+	QVariant GetChildData(int row, int column) const;
+	QString GetChildBucketName(int row) const;
+	QString GetChildFullName(int row) const;
+	QString GetChildPath(int row) const;
+	// The item for the child at row, which is created the first time
+	// it's asked for.
+	DS3BrowserItem* GetChildItem(int row);
+
+private:
+	// m_canFetchMore only represents what DS3BrowserModel should report
+	// for canFetchMore and not necessarily if the previous get
+	// children request was truncated or not.
+	bool m_canFetchMore;
+	bool m_fetching;
+	// Whether this item's bucket kind children are real buckets or, as
+	// in search results, full paths to them.
+	bool m_listsBuckets;
+	const QString m_bucketName;
+	QString m_nextMarker;
+	int m_pagesToPrefetch;
+	DS3BrowserItem* m_parent;
+	const QString m_prefix;
+	int m_row;
+
+	// Child columns.  A child's name is the m_nameSizes[row]
+	// characters of m_names starting at m_nameStarts[row].  Removed
+	// children's names stay in m_names until they outnumber the
+	// m_numNameChars characters of the remaining ones.
+	QVector<quint8> m_kinds;
+	QString m_names;
+	int m_numNameChars;
+	QVector<int> m_nameStarts;
+	QVector<int> m_nameSizes;
+	QStringList m_owners;
+	QVector<int> m_ownerIDs;
+	QVector<qint64> m_sizes;
+	QVector<qint64> m_createds;
+
+	QHash<int, DS3BrowserItem*> m_childItems;
+
+	int InternOwner(const QString& owner);
+	void CompactNames();
+};
+
+inline QString
+DS3BrowserItem::GetBucketName() const
+{
+	return m_bucketName;
+}
+
+inline QString
+DS3BrowserItem::GetPrefix() const
+{
+	return m_prefix;
+}
+
+inline DS3BrowserItem*
+DS3BrowserItem::GetParent() const
+{
+	return m_parent;
+}
+
+inline int
+DS3BrowserItem::GetRow() const
+{
+	return m_row;
+}
+
+inline bool
+DS3BrowserItem::GetCanFetchMore() const
+{
+	return m_canFetchMore;
+}
+
+inline bool
+DS3BrowserItem::IsFetching() const
+{
+	return m_fetching;
+}
+
+inline QString
+DS3BrowserItem::GetNextMarker() const
+{
+	return m_nextMarker;
+}
+
+inline int
+DS3BrowserItem::GetNamesSize() const
+{
+	return m_names.size();
+}
+
+inline int
+DS3BrowserItem::GetPagesToPrefetch() const
+{
+	return m_pagesToPrefetch;
+}
+
+inline void
+DS3BrowserItem::SetCanFetchMore(bool canFetchMore)
+{
+	m_canFetchMore = canFetchMore;
+}
+
+inline void
+DS3BrowserItem::SetFetching(bool fetching)
+{
+	m_fetching = fetching;
+}
+
+inline void
+DS3BrowserItem::SetListsBuckets(bool listsBuckets)
+{
+	m_listsBuckets = listsBuckets;
+}
+
+inline void
+DS3BrowserItem::SetNextMarker(const QString nextMarker)
+{
+	m_nextMarker = nextMarker;
+}
+
+inline void
+DS3BrowserItem::SetPagesToPrefetch(int pages)
+{
+	m_pagesToPrefetch = pages;
+}
+
+inline int
+DS3BrowserItem::GetChildCount() const
+{
+	return m_kinds.size();
+}
+
+inline DS3BrowserItem::Kind
+DS3BrowserItem::GetChildKind(int row) const
+{
+	return static_cast<Kind>(m_kinds.at(row));
+}
+
+inline bool
+DS3BrowserItem::IsChildBucketOrFolder(int row) const
+{
+	Kind kind = GetChildKind(row);
+	return (kind == BUCKET || kind == FOLDER);
+}
+
+inline QString
+DS3BrowserItem::GetChildName(int row) const
+{
+	return m_names.mid(m_nameStarts.at(row), m_nameSizes.at(row));
+}
+
+inline QString
+DS3BrowserItem::GetChildOwner(int row) const
+{
+	return m_owners.at(m_ownerIDs.at(row));
+}
+
+inline QString
+DS3BrowserItem::GetChildFullName(int row) const
+{
+	return (m_prefix + GetChildName(row));
+}
+
+#endif
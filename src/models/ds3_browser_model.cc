@@ -14,333 +14,44 @@
  * *****************************************************************************
  */
 
-#include <QDateTime>
 #include <QFuture>
+#include <QHash>
 #include <QIcon>
 #include <QModelIndex>
-#include <QRegularExpression>
-#include <QSet>
+#include <QScrollBar>
+#include <QTimer>
+#include <QVector>
 
-#include "helpers/number_helper.h"
+#include "helpers/path_helper.h"
 #include "lib/client.h"
 #include "lib/logger.h"
 #include "lib/mime_data.h"
 #include "lib/errors/ds3_error.h"
-#include "lib/watchers/get_bucket_watcher.h"
+#include "lib/watchers/get_listing_page_watcher.h"
 #include "lib/watchers/get_objects_watcher.h"
+#include "models/ds3_browser_item.h"
 #include "models/ds3_browser_model.h"
 #include "models/ds3_url.h"
+#include "models/listing_page.h"
 
-// Must match m_rootItem->m_data;
-enum Column { NAME, OWNER, SIZE_COL, KIND, CREATED, COUNT };
+// Must match DS3BrowserItem::Column
+static const char* COLUMN_NAMES[] = { "Name", "Owner", "Size", "Kind", "Created" };
 
-static const QString REST_TIMESTAMP_FORMAT = "yyyy-MM-ddThh:mm:ss.000Z";
-static const QString VIEW_TIMESTAMP_FORMAT = "MMMM d, yyyy h:mm AP";
+// How many pages of a listing are fetched in a row once the view comes near
+// its end, so scrolling doesn't stop at every page
+const int DS3BrowserModel::PREFETCH_PAGES = 2;
+// How close, in rows, the view has to come to the end of a listing that has
+// more pages for them to be fetched
+const int DS3BrowserModel::PREFETCH_ROWS = 500;
+// Past this many runs of inserted or removed rows, a diff refresh replaces
+// all of the children since every run moves the rows after it
+const int DS3BrowserModel::MAX_DIFF_RANGES = 100;
 
-static const QString ITEMKIND_BUCKET = "Bucket";
-static const QString ITEMKIND_OBJECT = "Object";
-static const QString ITEMKIND_FOLDER = "Folder";
-
-//
-// DS3BrowserItem
-//
-
-class DS3BrowserItem
-{
-public:
-	DS3BrowserItem(const QList<QVariant>& data,
-		       QString bucketName = QString(),
-		       QString prefix = QString(),
-		       DS3BrowserItem* parent = 0);
-	virtual ~DS3BrowserItem();
-
-	void AppendChild(DS3BrowserItem* item);
-	bool GetCanFetchMore() const;
-	QString GetBucketName() const;
-	DS3BrowserItem* GetChild(int row) const;
-	void RemoveChild(int row);
-	int GetChildCount() const;
-	int GetColumnCount() const;
-	QVariant GetData(int column) const;
-	QString GetNextMarker() const;
-	QString GetPrefix() const;
-	int GetRow() const;
-	DS3BrowserItem* GetParent() const;
-	virtual bool IsLoadingItem() const;
-	virtual bool IsPageBreak() const;
-	virtual bool IsNoSearchResultsItem() const;
-	bool IsFetching() const;
-	void Reset();
-	QString GetFullName() const;
-	QString GetPath() const;
-
-	void SetCanFetchMore(bool canFetchMore);
-	void SetFetching(bool fetching);
-	void SetNextMarker(const QString nextMarker);
-
-protected:
-	// m_canFetchMore only represents what DS3BrowserModel should report
-	// for canFetchMore and not necessarily if the previous get
-	// children request was truncated or not.
-	bool m_canFetchMore;
-	bool m_fetching;
-	QList<DS3BrowserItem*> m_children;
-	// List of data to show in the table.  Each item in the list
-	// directly corresponds to a column.
-	QList<QVariant> m_data;
-	// So object items so they can easily keep track of what
-	// bucket they're in.  For bucket items, this is the same as
-	// m_data[0];
-	const QString m_bucketName;
-	QString m_nextMarker;
-	DS3BrowserItem* m_parent;
-	// All parent folder object names, not including the bucket name
-	const QString m_prefix;
-
-	QList<DS3BrowserItem*> GetChildren() const;
-};
-
-DS3BrowserItem::DS3BrowserItem(const QList<QVariant>& data,
-			       QString bucketName,
-			       QString prefix,
-			       DS3BrowserItem* parent)
-	: m_canFetchMore(true),
-	  m_fetching(false),
-	  m_data(data),
-	  m_bucketName(bucketName),
-	  m_parent(parent),
-	  m_prefix(prefix)
-{
-}
-
-DS3BrowserItem::~DS3BrowserItem()
-{
-	qDeleteAll(m_children);
-}
-
-void
-DS3BrowserItem::AppendChild(DS3BrowserItem* item)
-{
-	m_children << item;
-}
-
-inline QString
-DS3BrowserItem::GetBucketName() const
-{
-	return m_bucketName;
-}
-
-inline bool
-DS3BrowserItem::GetCanFetchMore() const
-{
-	return m_canFetchMore;
-}
-
-DS3BrowserItem*
-DS3BrowserItem::GetChild(int row) const
-{
-	return GetChildren().value(row);
-}
-
-void
-DS3BrowserItem::RemoveChild(int row)
-{
-	if (row < m_children.count()) {
-		DS3BrowserItem* item = m_children.at(row);
-		m_children.removeAt(row);
-		delete item;
-	}
-}
-
-int
-DS3BrowserItem::GetChildCount() const
-{
-	return GetChildren().count();	
-}
-
-inline QString
-DS3BrowserItem::GetNextMarker() const
-{
-	return m_nextMarker;
-}
-
-inline QString
-DS3BrowserItem::GetPrefix() const
-{
-	return m_prefix;
-}
-
-int
-DS3BrowserItem::GetRow() const
-{
-	if (m_parent) {
-		return m_parent->GetChildren().indexOf(const_cast<DS3BrowserItem*>(this));
-	}
-
-	return 0;
-}
-
-int
-DS3BrowserItem::GetColumnCount() const
-{
-	return m_data.count();
-}
-
-QVariant
-DS3BrowserItem::GetData(int column) const
-{
-	QVariant data = m_data.value(column);
-	if (column == SIZE_COL && data != "Size" && data != "--") {
-		qulonglong size = data.toULongLong();
-		data = QVariant(NumberHelper::ToHumanSize(size));
-	}
-	return data;
-}
-
-inline DS3BrowserItem*
-DS3BrowserItem::GetParent() const
-{
-	return m_parent;
-}
-
-inline bool
-DS3BrowserItem::IsLoadingItem() const
-{
-	return false;
-}
-
-inline bool
-DS3BrowserItem::IsPageBreak() const
-{
-	return false;
-}
-
-inline bool
-DS3BrowserItem::IsNoSearchResultsItem() const
-{
-	return false;
-}
-
-inline bool
-DS3BrowserItem::IsFetching() const
-{
-	return m_fetching;
-}
-
-void
-DS3BrowserItem::Reset()
-{
-	qDeleteAll(m_children);
-	m_children.clear();
-	m_canFetchMore = true;
-	m_nextMarker = QString();
-}
-
-QString
-DS3BrowserItem::GetFullName() const
-{
-	return (m_prefix + GetData(NAME).toString());
-}
-
-QString
-DS3BrowserItem::GetPath() const
-{
-	QString path = "/" + m_bucketName;
-	if (GetData(KIND) == ITEMKIND_BUCKET) {
-		return path;
-	}
-
-	if (m_prefix.isEmpty()) {
-		path += "/";
-	} else {
-		path += "/" + m_prefix;
-	}
-	path += GetData(NAME).toString();
-	return path;
-}
-
-QList<DS3BrowserItem*>
-DS3BrowserItem::GetChildren() const
-{
-	return m_children;
-}
-
-inline void
-DS3BrowserItem::SetCanFetchMore(bool canFetchMore)
-{
-	m_canFetchMore = canFetchMore;
-}
-
-inline void
-DS3BrowserItem::SetFetching(bool fetching)
-{
-	m_fetching = fetching;
-}
-
-inline void
-DS3BrowserItem::SetNextMarker(const QString nextMarker)
-{
-	m_nextMarker = nextMarker;
-}
-
-class PageBreakItem : public DS3BrowserItem
-{
-public:
-	PageBreakItem(DS3BrowserItem* parent = 0);
-
-	bool IsPageBreak() const;
-};
-
-PageBreakItem::PageBreakItem(DS3BrowserItem* parent)
-	: DS3BrowserItem(QList<QVariant>(), "", "", parent)
-{
-	m_data << "Click to load more";
-}
-
-inline bool
-PageBreakItem::IsPageBreak() const
-{
-	return true;
-}
-
-class LoadingItem : public DS3BrowserItem
-{
-public:
-	LoadingItem(DS3BrowserItem* parent = 0);
-
-	bool IsLoadingItem() const;
-};
-
-LoadingItem::LoadingItem(DS3BrowserItem* parent)
-	: DS3BrowserItem(QList<QVariant>(), "", "", parent)
-{
-	m_data << "Loading ...";
-}
-
-inline bool
-LoadingItem::IsLoadingItem() const
-{
-	return true;
-}
-
-class NoSearchResultsItem : public DS3BrowserItem
+// What identifies a child across listings
+static QString
+diff_key(const DS3BrowserItem& item, int row)
 {
-public:
-	NoSearchResultsItem(DS3BrowserItem* parent = 0);
-
-	bool IsNoSearchResultsItem() const;
-};
-
-NoSearchResultsItem::NoSearchResultsItem(DS3BrowserItem* parent)
-	: DS3BrowserItem(QList<QVariant>(), "", "", parent)
-{
-	m_data << "There are currently no items to display";
-}
-
-inline bool
-NoSearchResultsItem::IsNoSearchResultsItem() const
-{
-	return true;
+	return QChar('0' + item.GetChildKind(row)) + item.GetChildName(row);
 }
 
 //
@@ -349,12 +60,10 @@ NoSearchResultsItem::IsNoSearchResultsItem() const
 
 DS3BrowserModel::DS3BrowserModel(Client* client, QObject* parent)
 	: QAbstractItemModel(parent),
-	  m_client(client)
+	  m_client(client),
+	  m_view(NULL)
 {
-	// Headers must match DS3BrowserModel::Column
-	QList<QVariant> column_names;
-	column_names << "Name" << "Owner" << "Size" << "Kind" << "Created";
-	m_rootItem = new DS3BrowserItem(column_names);
+	m_rootItem = new DS3BrowserItem;
 }
 
 DS3BrowserModel::~DS3BrowserModel()
@@ -365,59 +74,48 @@ DS3BrowserModel::~DS3BrowserModel()
 bool
 DS3BrowserModel::canFetchMore(const QModelIndex& parent) const
 {
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 	return parentItem->GetCanFetchMore();
 }
 
 int
-DS3BrowserModel::columnCount(const QModelIndex& parent) const
+DS3BrowserModel::columnCount(const QModelIndex& /*parent*/) const
 {
-	DS3BrowserItem* item;
-	if (parent.isValid()) {
-		item = IndexToItem(parent);
-	} else {
-		item = m_rootItem;
-	}
-	return item->GetColumnCount();
+	return DS3BrowserItem::COUNT;
 }
 
 QVariant
 DS3BrowserModel::data(const QModelIndex &index, int role) const
 {
-	DS3BrowserItem* item;
 	QVariant data;
 
 	if (!index.isValid()) {
 		return data;
 	}
 
-	item = IndexToItem(index);
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
+	int row = index.row();
 	int column = index.column();
+	DS3BrowserItem::Kind kind = parentItem->GetChildKind(row);
 
 	switch (role)
 	{
 	case Qt::DisplayRole:
-		data = item->GetData(column);
+		data = parentItem->GetChildData(row, column);
 		if (column == 0 &&
-		    (item->IsPageBreak() ||
-		     item->IsLoadingItem() ||
-		     item->IsNoSearchResultsItem())) {
+		    (kind == DS3BrowserItem::PAGE_BREAK ||
+		     kind == DS3BrowserItem::LOADING ||
+		     kind == DS3BrowserItem::NO_SEARCH_RESULTS)) {
 			m_view->setFirstColumnSpanned(index.row(), index.parent(), true);
 		}
 		break;
 	case Qt::DecorationRole:
-		if (column == NAME) {
-			QVariant kind = item->GetData(KIND);
-			if (kind == ITEMKIND_BUCKET) {
+		if (column == DS3BrowserItem::NAME) {
+			if (kind == DS3BrowserItem::BUCKET) {
 				data = QIcon(":/resources/icons/bucket.png");
-			} else if (kind == ITEMKIND_FOLDER) {
+			} else if (kind == DS3BrowserItem::FOLDER) {
 				data = QIcon(":/resources/icons/files.png");
-			} else if (kind == ITEMKIND_OBJECT) {
+			} else if (kind == DS3BrowserItem::OBJECT) {
 				data = QIcon(":/resources/icons/file.png");
 			}
 		}
@@ -439,11 +137,7 @@ DS3BrowserModel::dropMimeData(const QMimeData* data,
 
 	DS3BrowserItem* parent = IndexToItem(parentIndex);
 	QString bucketName = parent->GetBucketName();
-	QString prefix = parent->GetPrefix();
-	if (parent->GetData(KIND) != ITEMKIND_BUCKET) {
-		prefix += parent->GetData(NAME).toString();
-	}
-	prefix.replace(QRegularExpression("^/"), "");
+	QString prefix = PathHelper::StripLeadingSlash(parent->GetPrefix()).toString();
 	QList<QUrl> urls = data->urls();
 	m_client->BulkPut(bucketName, prefix, urls);
 	return true;
@@ -454,10 +148,8 @@ DS3BrowserModel::flags(const QModelIndex& index) const
 {
 	Qt::ItemFlags flags = QAbstractItemModel::flags(index);
 	if (index.isValid()) {
-		DS3BrowserItem* item = IndexToItem(index);
-		QVariant kind = item->GetData(KIND);
 		flags |= Qt::ItemIsDragEnabled;
-		if (kind == ITEMKIND_BUCKET || kind == ITEMKIND_FOLDER) {
+		if (IsBucketOrFolder(index)) {
 			flags |= Qt::ItemIsDropEnabled;
 		}
 	}
@@ -468,24 +160,17 @@ void
 DS3BrowserModel::fetchMore(const QModelIndex& parent)
 {
 	bool parentIsValid = parent.isValid();
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 
 	int lastRow = parentItem->GetChildCount() - 1;
 
-	DS3BrowserItem* loadingItem = new LoadingItem(parentItem);
 	int loadingItemRow = lastRow >= 0 ? lastRow : 0;
 	beginInsertRows(parent, loadingItemRow, loadingItemRow);
-	parentItem->AppendChild(loadingItem);
+	parentItem->AppendChild(DS3BrowserItem::LOADING);
 	endInsertRows();
 
 	if (lastRow >= 0) {
-		DS3BrowserItem* lastChildItem = parentItem->GetChild(lastRow);
-		if (lastChildItem->IsPageBreak()) {
+		if (parentItem->GetChildKind(lastRow) == DS3BrowserItem::PAGE_BREAK) {
 			removeRow(lastRow, parent);
 		}
 	}
@@ -512,9 +197,7 @@ DS3BrowserModel::hasChildren(const QModelIndex& parent) const
 		return true;
 	}
 
-	DS3BrowserItem* item = IndexToItem(parent);
-	QVariant kind = item->GetData(KIND);
-	return (kind == ITEMKIND_BUCKET || kind == ITEMKIND_FOLDER);
+	return IsBucketOrFolder(parent);
 }
 
 QVariant
@@ -522,12 +205,15 @@ DS3BrowserModel::headerData(int section,
 			    Qt::Orientation /*orientation*/,
 			    int role) const
 {
-	if (role == Qt::DisplayRole) {
-		return m_rootItem->GetData(section);
+	if (role == Qt::DisplayRole &&
+	    section >= 0 && section < DS3BrowserItem::COUNT) {
+		return COLUMN_NAMES[section];
 	}
 	return QVariant();
 }
 
+// Rows aren't items of their own so an index points to the item that
+// holds its row instead.
 QModelIndex
 DS3BrowserModel::index(int row, int column, const QModelIndex &parent) const
 {
@@ -535,20 +221,8 @@ DS3BrowserModel::index(int row, int column, const QModelIndex &parent) const
 		return QModelIndex();
 	}
 
-	DS3BrowserItem* parentItem;
-
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
-
-	DS3BrowserItem* childItem = parentItem->GetChild(row);
-	if (childItem) {
-		return createIndex(row, column, childItem);
-	} else {
-		return QModelIndex();
-	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
+	return createIndex(row, column, parentItem);
 }
 
 QMimeData*
@@ -563,10 +237,8 @@ DS3BrowserModel::mimeData(const QModelIndexList& indexes) const
 	for (int i = 0; i < indexes.size(); i++) {
 		QModelIndex index = indexes.at(i);
 		if (index.column() == 0) {
-			DS3BrowserItem* item = IndexToItem(index);
-			QString path = item->GetPath();
-			QVariant kind = item->GetData(KIND);
-			if (kind == ITEMKIND_FOLDER && !path.endsWith("/")) {
+			QString path = GetPath(index);
+			if (IsFolder(index) && !path.endsWith("/")) {
 				path += "/";
 			}
 			DS3URL url(endpoint, path);
@@ -593,14 +265,13 @@ DS3BrowserModel::parent(const QModelIndex& index) const
 		return QModelIndex();
 	}
 
-	DS3BrowserItem* childItem = IndexToItem(index);
-	DS3BrowserItem* parentItem = childItem->GetParent();
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
 
 	if (parentItem == m_rootItem) {
 		return QModelIndex();
 	}
 
-	return createIndex(parentItem->GetRow(), 0, parentItem);
+	return createIndex(parentItem->GetRow(), 0, parentItem->GetParent());
 }
 
 bool
@@ -610,17 +281,12 @@ DS3BrowserModel::removeRows(int row, int count, const QModelIndex& parent)
 		return false;
 	}
 
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 
 	beginRemoveRows(parent, row, row + count - 1);
 
 	for (int i = 0; i < count; i++) {
-		parentItem->RemoveChild(row + i);
+		parentItem->RemoveChild(row);
 	}
 
 	endRemoveRows();
@@ -631,60 +297,58 @@ DS3BrowserModel::removeRows(int row, int count, const QModelIndex& parent)
 int
 DS3BrowserModel::rowCount(const QModelIndex &parent) const
 {
-	DS3BrowserItem* parentItem;
 	if (parent.column() > 0) {
 		return 0;
 	}
 
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
-
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 	return parentItem->GetChildCount();
 }
 
 bool
 DS3BrowserModel::IsBucket(const QModelIndex& index) const
 {
-	DS3BrowserItem* item = IndexToItem(index);
-	QVariant kind = item->GetData(KIND);
-	return (kind == ITEMKIND_BUCKET);
+	if (!index.isValid()) {
+		return false;
+	}
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
+	return (parentItem->GetChildKind(index.row()) == DS3BrowserItem::BUCKET);
 }
 
 bool
 DS3BrowserModel::IsFolder(const QModelIndex& index) const
 {
-	DS3BrowserItem* item = IndexToItem(index);
-	QVariant kind = item->GetData(KIND);
-	return (kind == ITEMKIND_FOLDER);
+	if (!index.isValid()) {
+		return false;
+	}
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
+	return (parentItem->GetChildKind(index.row()) == DS3BrowserItem::FOLDER);
 }
 
 bool
 DS3BrowserModel::IsBucketOrFolder(const QModelIndex& index) const
 {
-	DS3BrowserItem* item = IndexToItem(index);
-	QVariant kind = item->GetData(KIND);
-	return (kind == ITEMKIND_BUCKET || kind == ITEMKIND_FOLDER);
+	if (!index.isValid()) {
+		return false;
+	}
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
+	return parentItem->IsChildBucketOrFolder(index.row());
 }
 
 bool
 DS3BrowserModel::IsPageBreak(const QModelIndex& index) const
 {
-	DS3BrowserItem* item = IndexToItem(index);
-	return item->IsPageBreak();
+	if (!index.isValid()) {
+		return false;
+	}
+	DS3BrowserItem* parentItem = IndexToParentItem(index);
+	return (parentItem->GetChildKind(index.row()) == DS3BrowserItem::PAGE_BREAK);
 }
 
 bool
 DS3BrowserModel::IsFetching(const QModelIndex& parent) const
 {
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 	return parentItem->IsFetching();
 }
 
@@ -692,9 +356,9 @@ QString
 DS3BrowserModel::GetBucketName(const QModelIndex& index) const
 {
 	QString name;
-	DS3BrowserItem* item = IndexToItem(index);
-	if (item != NULL) {
-		name = item->GetBucketName();
+	if (index.isValid()) {
+		DS3BrowserItem* parentItem = IndexToParentItem(index);
+		name = parentItem->GetChildBucketName(index.row());
 	}
 	return name;
 }
@@ -703,9 +367,9 @@ QString
 DS3BrowserModel::GetName(const QModelIndex& index) const
 {
 	QString name;
-	DS3BrowserItem* item = IndexToItem(index);
-	if (item != NULL) {
-		name = item->GetData(NAME).toString();
+	if (index.isValid()) {
+		DS3BrowserItem* parentItem = IndexToParentItem(index);
+		name = parentItem->GetChildData(index.row(), DS3BrowserItem::NAME).toString();
 	}
 	return name;
 }
@@ -714,9 +378,9 @@ QString
 DS3BrowserModel::GetFullName(const QModelIndex& index) const
 {
 	QString name;
-	DS3BrowserItem* item = IndexToItem(index);
-	if (item != NULL) {
-		name = item->GetFullName();
+	if (index.isValid()) {
+		DS3BrowserItem* parentItem = IndexToParentItem(index);
+		name = parentItem->GetChildFullName(index.row());
 	}
 	return name;
 }
@@ -725,21 +389,39 @@ QString
 DS3BrowserModel::GetPath(const QModelIndex& index) const
 {
 	QString path = "/";
-	DS3BrowserItem* item = IndexToItem(index);
-	if (item != NULL) {
-		path = item->GetPath();
+	if (index.isValid()) {
+		DS3BrowserItem* parentItem = IndexToParentItem(index);
+		path = parentItem->GetChildPath(index.row());
 	}
 	return path;
 }
 
 void
-DS3BrowserModel::Refresh(const QModelIndex& index)
+DS3BrowserModel::Refresh(const QModelIndex& index, RefreshMode mode)
 {
-	DS3BrowserItem* item;
-	if (index.isValid()) {
-		item = IndexToItem(index);
-	} else {
-		item = m_rootItem;
+	DS3BrowserItem* item = IndexToItem(index);
+	if (mode == DIFF && index.isValid() && !item->GetCanFetchMore()) {
+		if (item->IsFetching()) {
+			// The rows are about to change anyway
+			return;
+		}
+		// Only list as far as the current children go
+		QString marker;
+		int lastRow = item->GetChildCount() - 1;
+		if (lastRow >= 0 &&
+		    item->GetChildKind(lastRow) == DS3BrowserItem::PAGE_BREAK) {
+			marker = item->GetNextMarker();
+		}
+		item->SetFetching(true);
+		GetListingPageWatcher* watcher = new GetListingPageWatcher(index,
+									   item->GetBucketName());
+		connect(watcher, SIGNAL(finished()), this, SLOT(HandleRefreshResponse()));
+		QFuture<ListingPage*> future = m_client->GetListingPages(item->GetBucketName(),
+									 item->GetPrefix(),
+									 marker,
+									 item->GetOwner());
+		watcher->setFuture(future);
+		return;
 	}
 
 	beginResetModel();
@@ -747,6 +429,35 @@ DS3BrowserModel::Refresh(const QModelIndex& index)
 	endResetModel();
 }
 
+void
+DS3BrowserModel::InvalidateCache(const QModelIndex& index)
+{
+	if (index.isValid()) {
+		DS3BrowserItem* item = IndexToItem(index);
+		m_client->InvalidateListings(item->GetBucketName(),
+					     item->GetPrefix());
+	} else {
+		m_client->InvalidateListings();
+	}
+}
+
+void
+DS3BrowserModel::SetView(QTreeView* view)
+{
+	m_view = view;
+	connect(m_view->verticalScrollBar(), SIGNAL(valueChanged(int)),
+		this, SLOT(PrefetchVisiblePages()));
+}
+
+DS3BrowserItem*
+DS3BrowserModel::IndexToItem(const QModelIndex& index) const
+{
+	if (!index.isValid()) {
+		return m_rootItem;
+	}
+	return IndexToParentItem(index)->GetChildItem(index.row());
+}
+
 void
 DS3BrowserModel::FetchMoreBuckets(const QModelIndex& parent)
 {
@@ -759,30 +470,21 @@ DS3BrowserModel::FetchMoreBuckets(const QModelIndex& parent)
 void
 DS3BrowserModel::FetchMoreObjects(const QModelIndex& parent)
 {
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		// Should never get here since we should never try to
-		// fetch objects at the root level.
-		parentItem = m_rootItem;
-	}
+	// The root item if parent is invalid, which should never happen
+	// since we should never try to fetch objects at the root level.
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 
 	QString bucketName = parentItem->GetBucketName();
 	QString prefix = parentItem->GetPrefix();
-	bool isBucket = parentItem->GetData(KIND) == ITEMKIND_BUCKET;
-	if (!isBucket) {
-		prefix += parentItem->GetData(NAME).toString() + "/";
-	}
 	QString nextMarker = parentItem->GetNextMarker();
 
-	GetBucketWatcher* watcher = new GetBucketWatcher(parent,
-							 bucketName,
-							 prefix);
+	GetListingPageWatcher* watcher = new GetListingPageWatcher(parent,
+								   bucketName);
 	connect(watcher, SIGNAL(finished()), this, SLOT(HandleGetBucketResponse()));
-	QFuture<ds3_get_bucket_response*> future = m_client->GetBucket(bucketName,
-								       prefix,
-								       nextMarker);
+	QFuture<ListingPage*> future = m_client->GetListingPage(bucketName,
+								prefix,
+								nextMarker,
+								parentItem->GetOwner());
 	watcher->setFuture(future);
 }
 
@@ -794,14 +496,9 @@ DS3BrowserModel::HandleGetServiceResponse()
 	GetServiceWatcher* watcher = static_cast<GetServiceWatcher*>(sender());
 	const QModelIndex& parent = watcher->GetParentModelIndex();
 
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		// Should never get here since we should never try to fetch
-		// buckets at the bucket level.
-		parentItem = IndexToItem(parent);
-	} else {
-		parentItem = m_rootItem;
-	}
+	// parent should never be valid since we should never try to fetch
+	// buckets at the bucket level.
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 
 	ds3_get_service_response* response = 0;
 	try {
@@ -823,35 +520,14 @@ DS3BrowserModel::HandleGetServiceResponse()
 
 	if (response) {
 		QString owner = QString::fromUtf8(response->owner->name->value);
+		parentItem->ReserveChildren(numBuckets);
 		for (size_t i = 0; i < response->num_buckets; i++) {
-			QString name;
-			char* rawCreated;
-			QDateTime createdDT;
-			QString created;
-			// The order in which bucketData is filled must match
-			// Column
-			QList<QVariant> bucketData;
-			DS3BrowserItem* bucket;
-
 			ds3_bucket rawBucket = response->buckets[i];
-
-			name = QString::fromUtf8(rawBucket.name->value);
-			bucketData << name;
-			bucketData << owner;
-			bucketData << "--";
-			bucketData << ITEMKIND_BUCKET;
-
-			rawCreated = rawBucket.creation_date->value;
-			createdDT = QDateTime::fromString(QString::fromUtf8(rawCreated),
-							  REST_TIMESTAMP_FORMAT);
-			created = createdDT.toString(VIEW_TIMESTAMP_FORMAT);
-			bucketData << created;
-
-			bucket = new DS3BrowserItem(bucketData,
-						    name,
-						    QString(),
-						    parentItem);
-			parentItem->AppendChild(bucket);
+			QString name = QString::fromUtf8(rawBucket.name->value);
+			qint64 created = DS3BrowserItem::ToTimestamp(rawBucket.creation_date->value);
+			parentItem->AppendChild(DS3BrowserItem::BUCKET, name, owner,
+						DS3BrowserItem::NOT_APPLICABLE,
+						created);
 		}
 	}
 
@@ -860,8 +536,8 @@ DS3BrowserModel::HandleGetServiceResponse()
 	}
 
 	int loadingRow = startRow > 0 ? startRow - 1 : 0;
-	DS3BrowserItem* loadingItem = parentItem->GetChild(loadingRow);
-	if (loadingItem && loadingItem->IsLoadingItem()) {
+	if (loadingRow < parentItem->GetChildCount() &&
+	    parentItem->GetChildKind(loadingRow) == DS3BrowserItem::LOADING) {
 		removeRow(loadingRow, parent);
 	}
 
@@ -877,11 +553,11 @@ DS3BrowserModel::HandleGetBucketResponse()
 {
 	LOG_DEBUG("HandleGetBucketResponse");
 
-	GetBucketWatcher* watcher = static_cast<GetBucketWatcher*>(sender());
-	ds3_get_bucket_response* response = NULL;
+	GetListingPageWatcher* watcher = static_cast<GetListingPageWatcher*>(sender());
+	ListingPage* page = NULL;
 	const QString& bucketName = watcher->GetBucketName();
 	try {
-		response = watcher->result();
+		page = watcher->result();
 	}
 	catch (DS3Error& e) {
 		QString msg;
@@ -894,132 +570,261 @@ DS3BrowserModel::HandleGetBucketResponse()
 	}
 
 	const QModelIndex& parent = watcher->GetParentModelIndex();
-	DS3BrowserItem* parentItem;
-	if (parent.isValid()) {
-		parentItem = IndexToItem(parent);
-	} else {
-		// Should never get here since we should never try to
-		// fetch objects at the root level.
-		parentItem = m_rootItem;
-	}
-
-	QList<DS3BrowserItem*> newChildren;
-	if (response != NULL) {
-		QSet<QString> currentCommonPrefixNames;
-		for (int i = 0; i < parentItem->GetChildCount(); i++) {
-			DS3BrowserItem* object = parentItem->GetChild(i);
-			if (object->GetData(KIND) == ITEMKIND_FOLDER) {
-				currentCommonPrefixNames << object->GetData(NAME).toString();
-			}
-		}
+	// Objects are never fetched at the root level so parent is only
+	// invalid if a refresh removed it while it was listed
+	if (!parent.isValid()) {
+		delete page;
+		delete watcher;
+		return;
+	}
+	DS3BrowserItem* parentItem = IndexToItem(parent);
 
-		const QString& prefix = watcher->GetPrefix();
-		QVariant owner = parentItem->GetData(OWNER);
-
-		for (size_t i = 0; i < response->num_common_prefixes; i++) {
-			ds3_str* rawCommonPrefix = response->common_prefixes[i];
-			// The order in which bucketData is filled must match
-			// Column
-			QList<QVariant> objectData;
-			DS3BrowserItem* object;
-
-			QString nextName = QString::fromUtf8(rawCommonPrefix->value);
-			nextName.replace(QRegularExpression("^" + prefix), "");
-			nextName.replace(QRegularExpression("/$"), "");
-			if (!currentCommonPrefixNames.contains(nextName)) {
-				objectData << nextName;
-				objectData << owner;
-				objectData << "--";
-				objectData << ITEMKIND_FOLDER;
-				objectData << "--";
-				object = new DS3BrowserItem(objectData,
-							    bucketName,
-							    prefix,
-							    parentItem);
-				newChildren << object;
-			}
-		}
+	// The page's rows were prepared by the listing's thread so they're
+	// only spliced in here
+	int numNewChildren = 0;
+	if (page != NULL) {
+		numNewChildren = page->GetRows().GetChildCount();
+	}
+	int startRow = 0;
+	if (numNewChildren > 0) {
+		startRow = rowCount(parent);
+		beginInsertRows(parent, startRow, startRow + numNewChildren - 1);
+		parentItem->AppendChildren(page->GetRows());
+		endInsertRows();
+	}
 
-		for (size_t i = 0; i < response->num_objects; i++) {
-			QString nextName;
-			char* rawCreated;
-			QDateTime createdDT;
-			QString created;
-			// The order in which bucketData is filled must match
-			// Column
-			QList<QVariant> objectData;
-			DS3BrowserItem* object;
+	if (page != NULL && !page->GetNextMarker().isEmpty()) {
+		parentItem->SetNextMarker(page->GetNextMarker());
+	}
 
-			ds3_object rawObject = response->objects[i];
+	int loadingRow = startRow > 0 ? startRow - 1 : 0;
+	if (loadingRow < parentItem->GetChildCount() &&
+	    parentItem->GetChildKind(loadingRow) == DS3BrowserItem::LOADING) {
+		removeRow(loadingRow, parent);
+	}
 
-			nextName = QString::fromUtf8(rawObject.name->value);
-			if (nextName == prefix) {
-				continue;
-			}
-			nextName.replace(QRegularExpression("^" + prefix), "");
-			objectData << nextName;
+	bool truncated = (page != NULL && page->IsTruncated());
+	delete page;
+	delete watcher;
+	parentItem->SetFetching(false);
 
-			objectData << owner;
+	int pagesToPrefetch = parentItem->GetPagesToPrefetch();
+	if (truncated && pagesToPrefetch > 0) {
+		parentItem->SetPagesToPrefetch(pagesToPrefetch - 1);
+		fetchMore(parent);
+	} else {
+		parentItem->SetPagesToPrefetch(0);
+		// The view may still be showing the end of the listing once
+		// it lays out the new rows
+		QTimer::singleShot(0, this, SLOT(PrefetchVisiblePages()));
+	}
+}
 
-			objectData << (quint64)rawObject.size;
+void
+DS3BrowserModel::HandleRefreshResponse()
+{
+	LOG_DEBUG("HandleRefreshResponse");
 
-			objectData << ITEMKIND_OBJECT;
+	GetListingPageWatcher* watcher = static_cast<GetListingPageWatcher*>(sender());
+	ListingPage* pages = NULL;
+	try {
+		pages = watcher->result();
+	}
+	catch (DS3Error& e) {
+		LOG_ERROR("ERROR:       LIST OBJECTS failed, " + e.ToString());
+	}
 
-			if (rawObject.last_modified) {
-				rawCreated = rawObject.last_modified->value;
-				createdDT = QDateTime::fromString(QString::fromUtf8(rawCreated),
-								  REST_TIMESTAMP_FORMAT);
-				created = createdDT.toString(VIEW_TIMESTAMP_FORMAT);
+	const QModelIndex& parent = watcher->GetParentModelIndex();
+	if (parent.isValid()) {
+		DS3BrowserItem* parentItem = IndexToItem(parent);
+		parentItem->SetFetching(false);
+		if (pages != NULL) {
+			ApplyDiff(parent, pages->GetRows());
+			if (pages->IsTruncated()) {
+				parentItem->SetNextMarker(pages->GetNextMarker());
 			}
-			objectData << created;
-
-			object = new DS3BrowserItem(objectData,
-						    bucketName,
-						    prefix,
-						    parentItem);
-			newChildren << object;
 		}
+	}
+	delete pages;
+	delete watcher;
+}
 
-		if (response->next_marker) {
-			parentItem->SetNextMarker(QString::fromUtf8(response->next_marker->value));
+// Both listings are in the server's order, but since every page lists its
+// folders before its objects, they're only sorted page by page.  Instead
+// of merging on names, the children are matched through a hash of the new
+// rows and the rows that both have must be in the same order.  Then one
+// pass removes the runs of old rows, one pass inserts the runs of new rows
+// and updates the changed ones.
+void
+DS3BrowserModel::ApplyDiff(const QModelIndex& parent, const DS3BrowserItem& rows)
+{
+	DS3BrowserItem* parentItem = IndexToItem(parent);
+	int numOld = parentItem->GetChildCount();
+	int numNew = rows.GetChildCount();
+
+	QHash<QString, int> newRows;
+	newRows.reserve(numNew);
+	for (int i = 0; i < numNew; i++) {
+		newRows.insert(diff_key(rows, i), i);
+	}
+
+	QVector<bool> isKept(numNew, false);
+	QVector<bool> isRemoved(numOld, false);
+	int lastKept = -1;
+	int numRanges = 0;
+	for (int i = 0; i < numOld; i++) {
+		int newRow = newRows.value(diff_key(*parentItem, i), -1);
+		if (newRow < 0) {
+			isRemoved[i] = true;
+			if (i == 0 || !isRemoved[i - 1]) {
+				numRanges++;
+			}
+		} else if (newRow <= lastKept) {
+			// Moved, which only happens when page boundaries
+			// shift folders and objects around
+			ReplaceChildren(parent, rows);
+			return;
+		} else {
+			isKept[newRow] = true;
+			lastKept = newRow;
 		}
-
-		if (response->is_truncated) {
-			DS3BrowserItem* pageBreak = new PageBreakItem(parentItem);
-			newChildren << pageBreak;
+	}
+	for (int i = 0; i < numNew; i++) {
+		if (!isKept[i] && (i == 0 || isKept[i - 1])) {
+			numRanges++;
 		}
 	}
+	if (numRanges > MAX_DIFF_RANGES) {
+		ReplaceChildren(parent, rows);
+		return;
+	}
 
-	int numNewChildren = newChildren.count();
-	int startRow = 0;
-	if (numNewChildren > 0) {
-		startRow = rowCount(parent);
-		beginInsertRows(parent, startRow, startRow + numNewChildren - 1);
-		for (int i = 0; i < numNewChildren; i++) {
-			parentItem->AppendChild(newChildren.at(i));
+	// Last to first so the runs' rows don't move
+	for (int end = numOld - 1; end >= 0; end--) {
+		if (!isRemoved[end]) {
+			continue;
+		}
+		int start = end;
+		while (start > 0 && isRemoved[start - 1]) {
+			start--;
+		}
+		beginRemoveRows(parent, start, end);
+		parentItem->RemoveChildren(start, end - start + 1);
+		endRemoveRows();
+		end = start;
+	}
+
+	// What's left are the kept rows in order so the new rows go between
+	// them
+	int row = 0;
+	int firstChanged = -1;
+	for (int i = 0; i <= numNew; i++) {
+		bool changed = (i < numNew && isKept[i] &&
+				parentItem->UpdateChild(row, rows, i));
+		if (!changed && firstChanged >= 0) {
+			emit dataChanged(index(firstChanged, 0, parent),
+					 index(row - 1, DS3BrowserItem::COUNT - 1, parent));
+			firstChanged = -1;
+		} else if (changed && firstChanged < 0) {
+			firstChanged = row;
+		}
+		if (i == numNew) {
+			break;
+		}
+		if (isKept[i]) {
+			row++;
+			continue;
+		}
+		int count = 1;
+		while (i + count < numNew && !isKept[i + count]) {
+			count++;
 		}
+		beginInsertRows(parent, row, row + count - 1);
+		parentItem->InsertChildren(row, rows, i, count);
 		endInsertRows();
+		row += count;
+		i += count - 1;
 	}
+}
 
-	int loadingRow = startRow > 0 ? startRow - 1 : 0;
-	DS3BrowserItem* loadingItem = parentItem->GetChild(loadingRow);
-	if (loadingItem && loadingItem->IsLoadingItem()) {
-		removeRow(loadingRow, parent);
+void
+DS3BrowserModel::ReplaceChildren(const QModelIndex& parent,
+				 const DS3BrowserItem& rows)
+{
+	DS3BrowserItem* parentItem = IndexToItem(parent);
+	int numOld = parentItem->GetChildCount();
+	if (numOld > 0) {
+		beginRemoveRows(parent, 0, numOld - 1);
+		parentItem->RemoveChildren(0, numOld);
+		endRemoveRows();
+	}
+	int numNew = rows.GetChildCount();
+	if (numNew > 0) {
+		beginInsertRows(parent, 0, numNew - 1);
+		parentItem->InsertChildren(0, rows, 0, numNew);
+		endInsertRows();
 	}
+}
 
-	if (response != NULL) {
-		ds3_free_bucket_response(response);
+void
+DS3BrowserModel::PrefetchVisiblePages()
+{
+	if (m_view == NULL) {
+		return;
+	}
+
+	// The last row the view shows, which may be in an expanded folder,
+	// and every listing above it
+	QModelIndex root = m_view->rootIndex();
+	QModelIndex last = m_view->indexAt(QPoint(0, m_view->viewport()->height() - 1));
+	if (!last.isValid()) {
+		// The rows end before the bottom of the view
+		PrefetchIfNearEnd(root, rowCount(root) - 1);
+		return;
+	}
+	for (QModelIndex index = last.sibling(last.row(), 0);
+	     index.isValid() && index != root;
+	     index = index.parent()) {
+		if (PrefetchIfNearEnd(index.parent(), index.row())) {
+			return;
+		}
 	}
-	delete watcher;
-	parentItem->SetFetching(false);
 }
 
+bool
+DS3BrowserModel::PrefetchIfNearEnd(const QModelIndex& parent,
+				   int lastVisibleRow)
+{
+	DS3BrowserItem* parentItem = IndexToItem(parent);
+	int lastRow = parentItem->GetChildCount() - 1;
+	if (lastRow < 0 || parentItem->IsFetching() ||
+	    parentItem->GetChildKind(lastRow) != DS3BrowserItem::PAGE_BREAK ||
+	    lastRow - lastVisibleRow > PREFETCH_ROWS) {
+		return false;
+	}
+	parentItem->SetPagesToPrefetch(PREFETCH_PAGES - 1);
+	fetchMore(parent);
+	return true;
+}
+
+// Leave a metadata thread free so browsing isn't stuck behind a search of
+// every bucket
+const int DS3SearchModel::MAX_ACTIVE_SEARCHES = qMax(1, Client::METADATA_THREADS - 1);
+// Few enough rows that the view can lay them out between two frames
+const int DS3SearchModel::SEARCH_PAGE_ROWS = 1000;
+
 // Model for searches
 DS3SearchModel::DS3SearchModel(Client* client, QObject* parent)
 	: DS3BrowserModel(client, parent),
 	  m_activeSearchCount(0),
-	  m_searchFoundCount(0)
+	  m_searchFoundCount(0),
+	  m_searching(false),
+	  m_resultOffset(0),
+	  m_insertScheduled(false)
 {
+	// Search results are full paths, including the bucket name, so the
+	// bucket results aren't buckets that can be browsed.
+	m_rootItem->SetListsBuckets(false);
 }
 
 // This function makes sure all data isn't fetched for the search tree, just
@@ -1040,60 +845,45 @@ DS3SearchModel::fetchMore(const QModelIndex& parent)
 }
 
 void
-DS3SearchModel::AppendDS3SearchObject(ds3_search_object* obj, QString bucketName) {
-	// Data to go into new item in model
-	QList<QVariant> data;
-
+DS3SearchModel::AppendDS3SearchObject(const Listing::Object& obj, QString bucketName) {
 	// Checks search results, bucketName!="" means files were found
-	if (bucketName != QString("")) {
-		QString name;
-		if (obj->name != NULL) {
-			name = "/"+bucketName+QString("/")+QString::fromUtf8(obj->name->value);
-		} else {
-			name = QString("");
-		}
-		data << name;
+	if (bucketName == QString("")) {
+		return;
+	}
 
-		if (obj->owner != NULL && obj->owner->name != NULL) {
-			data << QString::fromUtf8(obj->owner->name->value);
-		} else {
-			data << QString("");
-		}
+	QString name;
+	if (!obj.name.isNull()) {
+		name = "/"+bucketName+QString("/")+obj.name;
+	} else {
+		name = QString("");
+	}
 
-		QString type(ITEMKIND_OBJECT);
-		if (name == "/"+bucketName+"/") {
-			type = ITEMKIND_BUCKET;
-		} else if (name.endsWith("/")) {
-			type = ITEMKIND_FOLDER;
-		}
+	QString owner = obj.owner;
 
-		qulonglong size = obj->size;
-		// Always report the size for objects when the GetObjects
-		// response includes sizes since empty objects are valid
-		// and we'd want to report them as 0 bytes.
-		// Probably want to do something like:
-		//   if (type == ITEMKIND_OBJECT || size > 0) {
-		if (size > 0) {
-			data << size;
-		} else {
-			data << QString("--");
-		}
+	DS3BrowserItem::Kind kind = DS3BrowserItem::OBJECT;
+	if (name == "/"+bucketName+"/") {
+		kind = DS3BrowserItem::BUCKET;
+	} else if (name.endsWith("/")) {
+		kind = DS3BrowserItem::FOLDER;
+	}
 
-		data << type;
+	// Always report the size for objects when the GetObjects
+	// response includes sizes since empty objects are valid
+	// and we'd want to report them as 0 bytes.
+	// Probably want to do something like:
+	//   if (kind == DS3BrowserItem::OBJECT || size > 0) {
+	qint64 size = DS3BrowserItem::NOT_APPLICABLE;
+	if (obj.size > 0) {
+		size = (qint64)obj.size;
+	}
 
-		if (obj->last_modified != NULL) {
-			data << QDateTime::fromString(QString::fromUtf8(obj->last_modified->value), REST_TIMESTAMP_FORMAT).toString(VIEW_TIMESTAMP_FORMAT);
-		} else {
-			data << QString("");
-		}
+	qint64 created = DS3BrowserItem::NO_TIMESTAMP;
+	if (!obj.lastModified.isEmpty()) {
+		created = DS3BrowserItem::ToTimestamp(obj.lastModified);
 	}
-	// Create the new item
-	DS3BrowserItem* newItem = new DS3BrowserItem(data,
-						     QString(""),
-						     QString(""),
-						     m_rootItem);
+
 	// Append it to the root
-	m_rootItem->AppendChild(newItem);
+	m_rootItem->AppendChild(kind, name, owner, size, created);
 }
 
 void
@@ -1107,21 +897,23 @@ DS3SearchModel::Search(const QModelIndex& index,
 	if (search != "") {
 		// Setting prefix to this since buckets are only at the root
 		// directory
+		// The watcher is deleted, and its response ignored, if the
+		// model is deleted first
 		GetObjectsWatcher* watcher = new GetObjectsWatcher(index,
 								   bucket,
 								   prefix,
-								   NULL);
+								   this);
 		connect(watcher, SIGNAL(finished()), this, SLOT(HandleGetObjectsResponse()));
 		// Would be better to use some sort of "UNKNOWN" type enum
 		// instead of hardcoding a value.
-		QFuture<ds3_get_objects_response*> future = m_client->GetObjects(bucket,
-									         search);
+		QFuture<QSharedPointer<const Listing> > future = m_client->GetObjects(bucket,
+										      search);
 		watcher->setFuture(future);
 	}
 }
 
-// This function retrieves all of the bucket names and calls the search
-// function on each bucket
+// This function retrieves all of the bucket names and queues a search of
+// each bucket
 void
 DS3SearchModel::HandleGetServiceResponse(QString search,
 					 QTreeView* tree,
@@ -1132,6 +924,7 @@ DS3SearchModel::HandleGetServiceResponse(QString search,
 	// search is being done on can be used for indices and object names
 	m_searchedTree = tree;
 	m_searchedModel = model;
+	m_searching = true;
 	// Set index to the root index of the searched tree
 	QModelIndex index = m_searchedTree->rootIndex();
 
@@ -1145,6 +938,13 @@ DS3SearchModel::HandleGetServiceResponse(QString search,
 	// Checks to make sure that there is a response and that the search
 	// isn't empty
 	if (response && search != "") {
+		m_search = "%" + search + "%";
+		m_prefix = m_searchedModel->GetPath(index);
+		// Because of GetPath(), the initial "/" needs to be
+		// removed for searches to work
+		if (m_prefix.startsWith("/")) {
+			m_prefix.remove(0, 1);
+		}
 		// Iterate through buckets
 		for (size_t i = 0; i < response->num_buckets; i++) {
 			QString name;
@@ -1155,20 +955,25 @@ DS3SearchModel::HandleGetServiceResponse(QString search,
 			    !m_searchedModel->GetPath(index).contains(name)) {
 				continue;
 			}
-
-			QString prefix = m_searchedModel->GetPath(index);
-			// Because of GetPath(), the initial "/" needs to be
-			// removed for searches to work
-			if (prefix.startsWith("/")) {
-				prefix.remove(0, 1);
-			}
-			m_activeSearchCount++;
-			Search(index, name, prefix, QString("%"+search+"%"));
+			m_pendingBuckets << name;
 		}
 	}
 	if (response) {
 		ds3_free_service_response(response);
 	}
+	StartSearches();
+	FinishIfDone();
+}
+
+void
+DS3SearchModel::StartSearches()
+{
+	while (m_activeSearchCount < MAX_ACTIVE_SEARCHES &&
+	       !m_pendingBuckets.isEmpty()) {
+		m_activeSearchCount++;
+		Search(QModelIndex(), m_pendingBuckets.takeFirst(), m_prefix,
+		       m_search);
+	}
 }
 
 void
@@ -1176,8 +981,8 @@ DS3SearchModel::HandleGetObjectsResponse()
 {
 	// Get the watcher and response
 	GetObjectsWatcher* watcher = static_cast<GetObjectsWatcher*>(sender());
-	ds3_get_objects_response* response = NULL;
-	const QString& bucketName = watcher->GetBucketName();
+	QSharedPointer<const Listing> response;
+	const QString bucketName = watcher->GetBucketName();
 	try {
 		response = watcher->result();
 	}
@@ -1190,31 +995,81 @@ DS3SearchModel::HandleGetObjectsResponse()
 		}
 		LOG_ERROR("Error listing objects - " + msg);
 	}
+	delete watcher;
+	m_activeSearchCount--;
+	// Search the next bucket before inserting this one's results so its
+	// request is in flight while the view lays them out
+	StartSearches();
+
 	// Checks that response isn't empty
-	if (response != NULL) {
-		for (size_t i = 0; i < response->num_objects; i++) {
-			// Increment the found count and add the object to the
-			// search model
-			m_searchFoundCount++;
-			AppendDS3SearchObject(response->objects[i], bucketName);
+	if (!response.isNull() && !response->objects.isEmpty()) {
+		m_searchFoundCount += response->objects.size();
+		m_results << response;
+		m_resultBuckets << bucketName;
+		if (!m_insertScheduled) {
+			InsertResults();
 		}
 	}
-	bool found = true;
-	m_activeSearchCount--;
+	FinishIfDone();
+}
 
-	if (m_activeSearchCount == 0) {
-		// If no results were found, then create a fake item that tells
-		// this to the user
-		if (m_searchFoundCount == 0) {
-			found = false;
-			DS3BrowserItem* noResultsItem = new NoSearchResultsItem(m_rootItem);
-			m_rootItem->AppendChild(noResultsItem);
+void
+DS3SearchModel::InsertResults()
+{
+	m_insertScheduled = false;
+	int count = 0;
+	for (int i = 0; i < m_results.size() && count < SEARCH_PAGE_ROWS; i++) {
+		int available = m_results[i]->objects.size();
+		if (i == 0) {
+			available -= m_resultOffset;
 		}
-		emit DoneSearching(found);
+		count += qMin(available, SEARCH_PAGE_ROWS - count);
+	}
+
+	if (count > 0) {
+		int first = m_rootItem->GetChildCount();
+		beginInsertRows(QModelIndex(), first, first + count - 1);
+		for (int i = 0; i < count; i++) {
+			const Listing& listing = *m_results.first();
+			AppendDS3SearchObject(listing.objects[m_resultOffset],
+					      m_resultBuckets.first());
+			m_resultOffset++;
+			if (m_resultOffset == listing.objects.size()) {
+				m_results.removeFirst();
+				m_resultBuckets.removeFirst();
+				m_resultOffset = 0;
+			}
+		}
+		endInsertRows();
 	}
 
-	if (response) {
-		ds3_free_objects_response(response);
+	if (!m_results.isEmpty()) {
+		// Let the view paint this page before inserting the next one
+		m_insertScheduled = true;
+		QTimer::singleShot(0, this, SLOT(InsertResults()));
+	} else {
+		FinishIfDone();
 	}
-	delete watcher;
+}
+
+void
+DS3SearchModel::FinishIfDone()
+{
+	if (!m_searching || m_activeSearchCount > 0 ||
+	    !m_pendingBuckets.isEmpty() || !m_results.isEmpty()) {
+		return;
+	}
+	m_searching = false;
+
+	bool found = true;
+	// If no results were found, then create a fake item that tells
+	// this to the user
+	if (m_searchFoundCount == 0) {
+		found = false;
+		int row = m_rootItem->GetChildCount();
+		beginInsertRows(QModelIndex(), row, row);
+		m_rootItem->AppendChild(DS3BrowserItem::NO_SEARCH_RESULTS);
+		endInsertRows();
+	}
+	emit DoneSearching(found);
 }
@@ -20,6 +20,7 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QModelIndexList>
+#include <QSharedPointer>
 #include <QStringList>
 #include <QTreeView>
 #include <ds3.h>
@@ -35,6 +36,21 @@ class DS3BrowserModel : public QAbstractItemModel
 	Q_OBJECT
 
 public:
+	static const int PREFETCH_PAGES;
+	static const int PREFETCH_ROWS;
+	static const int MAX_DIFF_RANGES;
+
+	enum RefreshMode {
+		// Forget the children and let the view fetch them again
+		RESET,
+		// List the children again in the background and only insert,
+		// remove and update the rows that changed, which keeps the
+		// expanded folders, selection and scroll position.  Falls back
+		// to RESET for the buckets and for children that haven't
+		// been listed yet.
+		DIFF
+	};
+
 	DS3BrowserModel(Client* client, QObject* parent = 0);
 	~DS3BrowserModel();
 
@@ -75,21 +91,41 @@ public:
 	QString GetName(const QModelIndex& index) const;
 	QString GetFullName(const QModelIndex& index) const;
 	QString GetPath(const QModelIndex& index) const;
-	void Refresh(const QModelIndex& rootIndex = QModelIndex());
+	// List rootIndex's children again, from the Client's listing cache
+	// if they're still in it
+	void Refresh(const QModelIndex& rootIndex = QModelIndex(),
+		     RefreshMode mode = RESET);
+	// Make the next listings of rootIndex and everything under it come
+	// from the server rather than the Client's listing cache
+	void InvalidateCache(const QModelIndex& rootIndex = QModelIndex());
 	void SetView(QTreeView* view);
 
 public slots:
 	void HandleGetServiceResponse();
 	void HandleGetBucketResponse();
+	void HandleRefreshResponse();
+	// Fetch the next pages of the listings whose ends the view is
+	// within PREFETCH_ROWS rows of
+	void PrefetchVisiblePages();
 
 protected:
 	Client* m_client;
 	DS3BrowserItem* m_rootItem;
+	// The bucket or folder item that index refers to, or the root item
+	// if index is invalid.
 	DS3BrowserItem* IndexToItem(const QModelIndex& index) const;
+	// The item that holds index's row
+	DS3BrowserItem* IndexToParentItem(const QModelIndex& index) const;
 
 private:
 	void FetchMoreBuckets(const QModelIndex& parent);
 	void FetchMoreObjects(const QModelIndex& parent);
+	bool PrefetchIfNearEnd(const QModelIndex& parent, int lastVisibleRow);
+	// Turn parent's children into rows' with the fewest row insertions
+	// and removals
+	void ApplyDiff(const QModelIndex& parent, const DS3BrowserItem& rows);
+	void ReplaceChildren(const QModelIndex& parent,
+			     const DS3BrowserItem& rows);
 
 	QTreeView* m_view;
 };
@@ -100,8 +136,14 @@ class DS3SearchModel : public DS3BrowserModel
 	Q_OBJECT
 
 public:
+	static const int MAX_ACTIVE_SEARCHES;
+	static const int SEARCH_PAGE_ROWS;
+
 	DS3SearchModel(Client* client, QObject* parent);
 	void fetchMore(const QModelIndex& parent);
+	// Search the buckets, at most MAX_ACTIVE_SEARCHES at a time, and
+	// insert each one's results as soon as it responds.  Deleting the
+	// model cancels the buckets that haven't been searched yet.
 	void HandleGetServiceResponse(QString search, QTreeView* tree, DS3BrowserModel* model, GetServiceWatcher* watcher);
 
 public slots:
@@ -110,23 +152,35 @@ public slots:
 signals:
 	void DoneSearching(bool found);
 
+private slots:
+	// Insert up to SEARCH_PAGE_ROWS of the results that are waiting
+	void InsertResults();
+
 private:
-	size_t m_activeSearchCount;
+	int m_activeSearchCount;
 	size_t m_searchFoundCount;
+	bool m_searching;
 	DS3BrowserModel* m_searchedModel;
 	QTreeView* m_searchedTree;
-	void AppendDS3SearchObject(ds3_search_object* obj, QString bucketName);
+	QString m_search;
+	QString m_prefix;
+	QStringList m_pendingBuckets;
+	// The responses whose results haven't all been inserted yet, in the
+	// order they arrived, and how many of the first one's have been
+	QList<QSharedPointer<const Listing> > m_results;
+	QStringList m_resultBuckets;
+	int m_resultOffset;
+	bool m_insertScheduled;
+	void AppendDS3SearchObject(const Listing::Object& obj, QString bucketName);
 	void Search(const QModelIndex& index, QString bucket, QString prefix, QString search);
+	void StartSearches();
+	// Emit DoneSearching once every bucket was searched and every
+	// result inserted
+	void FinishIfDone();
 };
 
-inline void
-DS3BrowserModel::SetView(QTreeView* view)
-{
-	m_view = view;
-}
-
 inline DS3BrowserItem*
-DS3BrowserModel::IndexToItem(const QModelIndex& index) const
+DS3BrowserModel::IndexToParentItem(const QModelIndex& index) const
 {
 	return static_cast<DS3BrowserItem*>(index.internalPointer());
 }
@@ -14,10 +14,12 @@
  * *****************************************************************************
  */
 
-#include <QRegularExpression>
-
+#include "helpers/path_helper.h"
 #include "models/ds3_url.h"
 
+// The path format that GetBucketName and GetObjectName follow.  They're
+// implemented by PathHelper since they're called for every URL of a
+// bulk operation.
 const QString DS3URL::PATH_REGEX = "^/?([^/]+)/?(?:/(.*))?$";
 
 DS3URL::DS3URL()
@@ -39,37 +41,22 @@ DS3URL::DS3URL(const QString& endpoint, const QString& decodedPath)
 QString
 DS3URL::GetBucketName() const
 {
-	QRegularExpression regex(PATH_REGEX);
-	QString bucketName;
-	QRegularExpressionMatch match = regex.match(path());
-	if (match.hasMatch()) {
-		bucketName = match.captured(1);
-	}
-	return bucketName;
+	QString urlPath = path();
+	return PathHelper::GetBucketName(urlPath).toString();
 }
 
 QString
 DS3URL::GetObjectName() const
 {
-	QRegularExpression regex(PATH_REGEX);
-	QString objName;
-	QRegularExpressionMatch match = regex.match(path());
-	if (match.hasMatch()) {
-		objName = match.captured(2);
-	}
-	return objName;
+	QString urlPath = path();
+	return PathHelper::GetObjectName(urlPath).toString();
 }
 
 QString
 DS3URL::GetLastPathPart() const
 {
-	QRegularExpression regex("([^/]+/?)$");
-	QString part;
-	QRegularExpressionMatch match = regex.match(path());
-	if (match.hasMatch()) {
-		part = match.captured(1);
-	}
-	return part;
+	QString urlPath = path();
+	return PathHelper::GetLastPathPart(urlPath).toString();
 }
 
 bool
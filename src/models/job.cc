@@ -21,16 +21,19 @@
 Job::Job()
 	: m_state(INITIALIZING),
 	  m_size(0),
-	  m_bytesTransferred(0)
+	  m_bytesTransferred(0),
+	  m_rate(0),
+	  m_secondsLeft(-1),
+	  m_transferLimit(0)
 {
 }
 
-const QString
-Job::GetURLs() const
+QString
+Job::JoinURLs(const QList<QUrl> urls)
 {
 	QStringList strings;
-	for (int i = 0; i < m_urls.size(); i++) {
-		strings << m_urls[i].path();
+	for (int i = 0; i < urls.size(); i++) {
+		strings << urls[i].path();
 	}
 	return strings.join(",");
 }
@@ -58,10 +58,19 @@ public:
 	const QDateTime& GetTransferStart() const;
 	State GetState() const;
 	const QString& GetHost() const;
-	const QString GetURLs() const;
+	// The paths of the job's URLs, comma separated
+	const QString& GetURLs() const;
 	const QString& GetDestination() const;
 	uint64_t GetSize() const;
 	uint64_t GetBytesTransferred() const;
+	// Smoothed transfer rate in bytes per second and the estimated
+	// seconds left at that rate, or -1 if unknown.  Set by
+	// JobProgressPublisher.
+	uint64_t GetRate() const;
+	qint64 GetSecondsLeft() const;
+	// How many of the job's transfers its ConcurrencyController lets
+	// run at once, or 0 before it has one
+	int GetTransferLimit() const;
 	int GetProgress() const;
 	bool IsFinished() const;
 	bool WasCanceled() const;
@@ -73,9 +82,14 @@ public:
 	void SetState(State state);
 	void SetHost(const QString& host);
 	void SetURLs(const QList<QUrl> urls);
+	void SetURLs(const QString& urls);
+	static QString JoinURLs(const QList<QUrl> urls);
 	void SetDestination(const QString& destination);
 	void SetSize(uint64_t);
 	void SetBytesTransferred(uint64_t);
+	void SetRate(uint64_t rate);
+	void SetSecondsLeft(qint64 secondsLeft);
+	void SetTransferLimit(int limit);
 
 private:
 	QUuid m_id;
@@ -84,10 +98,13 @@ private:
 	QDateTime m_transferStart;
 	State m_state;
 	QString m_host;
-	QList<QUrl> m_urls;
+	QString m_urls;
 	QString m_destination;
 	uint64_t m_size;
 	uint64_t m_bytesTransferred;
+	uint64_t m_rate;
+	qint64 m_secondsLeft;
+	int m_transferLimit;
 };
 
 // Job is used as an argument in a signal/slot connection
@@ -147,6 +164,24 @@ Job::GetBytesTransferred() const
 	return m_bytesTransferred;
 }
 
+inline uint64_t
+Job::GetRate() const
+{
+	return m_rate;
+}
+
+inline qint64
+Job::GetSecondsLeft() const
+{
+	return m_secondsLeft;
+}
+
+inline int
+Job::GetTransferLimit() const
+{
+	return m_transferLimit;
+}
+
 inline bool Job::IsFinished() const
 {
 	return m_state == FINISHED;
@@ -193,8 +228,20 @@ Job::SetHost(const QString& host)
 	m_host = host;
 }
 
+inline const QString&
+Job::GetURLs() const
+{
+	return m_urls;
+}
+
 inline void
 Job::SetURLs(const QList<QUrl> urls)
+{
+	m_urls = JoinURLs(urls);
+}
+
+inline void
+Job::SetURLs(const QString& urls)
 {
 	m_urls = urls;
 }
@@ -217,4 +264,22 @@ Job::SetBytesTransferred(uint64_t bytesTransferred)
 	m_bytesTransferred = bytesTransferred;
 }
 
+inline void
+Job::SetRate(uint64_t rate)
+{
+	m_rate = rate;
+}
+
+inline void
+Job::SetSecondsLeft(qint64 secondsLeft)
+{
+	m_secondsLeft = secondsLeft;
+}
+
+inline void
+Job::SetTransferLimit(int limit)
+{
+	m_transferLimit = limit;
+}
+
 #endif
@@ -0,0 +1,73 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "helpers/path_helper.h"
+#include "models/listing_page.h"
+
+ListingPage::ListingPage(const Listing& listing,
+			 const QString& prefix,
+			 const QString& marker,
+			 const QString& owner)
+	: m_truncated(listing.truncated),
+	  m_nextMarker(listing.nextMarker)
+{
+	m_rows.ReserveChildren(listing.commonPrefixes.size() +
+			       listing.objects.size() + 1);
+	for (int i = 0; i < listing.commonPrefixes.size(); i++) {
+		const QString& commonPrefix = listing.commonPrefixes[i];
+		// The previous page can only have ended with the folder that
+		// this page was listed after
+		if (commonPrefix == marker) {
+			continue;
+		}
+		QStringRef name = PathHelper::StripPrefix(commonPrefix, prefix);
+		if (name.endsWith('/')) {
+			name = name.left(name.size() - 1);
+		}
+		m_rows.AppendChild(DS3BrowserItem::FOLDER, name.toString(), owner);
+	}
+
+	for (int i = 0; i < listing.objects.size(); i++) {
+		const Listing::Object& object = listing.objects[i];
+		// The folder object of the listed folder itself
+		if (object.name == prefix) {
+			continue;
+		}
+
+		qint64 created = DS3BrowserItem::NO_TIMESTAMP;
+		if (!object.lastModified.isEmpty()) {
+			created = DS3BrowserItem::ToTimestamp(object.lastModified);
+		}
+		m_rows.AppendChild(DS3BrowserItem::OBJECT,
+				   PathHelper::StripPrefix(object.name, prefix).toString(),
+				   owner, (qint64)object.size, created);
+	}
+
+	if (m_truncated) {
+		m_rows.AppendChild(DS3BrowserItem::PAGE_BREAK);
+	}
+}
+
+void
+ListingPage::Append(const ListingPage& next)
+{
+	if (m_truncated) {
+		m_rows.RemoveChild(m_rows.GetChildCount() - 1);
+	}
+	m_rows.AppendChildren(next.m_rows);
+	m_truncated = next.m_truncated;
+	m_nextMarker = next.m_nextMarker;
+}
@@ -0,0 +1,72 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef LISTING_PAGE_H
+#define LISTING_PAGE_H
+
+#include <QString>
+
+#include "lib/listing_cache.h"
+#include "models/ds3_browser_item.h"
+
+// ListingPage, one get bucket listing converted into the rows that
+// DS3BrowserModel appends to a bucket or folder.  It's built on the thread
+// that listed the page so the GUI thread only has to splice the rows in.
+class ListingPage
+{
+public:
+	// Convert the listing of prefix that started after marker.  The
+	// children are owned by owner.
+	ListingPage(const Listing& listing,
+		    const QString& prefix,
+		    const QString& marker,
+		    const QString& owner);
+
+	// Add the rows of the page that was listed after this one in place
+	// of this one's page break
+	void Append(const ListingPage& next);
+
+	// The folders, then the objects, then a page break if the listing
+	// was truncated
+	const DS3BrowserItem& GetRows() const;
+	bool IsTruncated() const;
+	QString GetNextMarker() const;
+
+private:
+	DS3BrowserItem m_rows;
+	bool m_truncated;
+	QString m_nextMarker;
+};
+
+inline const DS3BrowserItem&
+ListingPage::GetRows() const
+{
+	return m_rows;
+}
+
+inline bool
+ListingPage::IsTruncated() const
+{
+	return m_truncated;
+}
+
+inline QString
+ListingPage::GetNextMarker() const
+{
+	return m_nextMarker;
+}
+
+#endif
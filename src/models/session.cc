@@ -17,9 +17,19 @@
 #include "models/session.h"
 
 const QString Session::PROTOCOL_NAMES[] = { "http", "https" };
+const QString Session::FILE_IO_MODE_NAMES[] = { "Buffered", "Memory-Mapped" };
+const QString Session::SYNC_MODE_NAMES[] = { "Off", "By Size and Time", "By Content" };
+const QString Session::CHECKSUM_TYPE_NAMES[] = { "None", "CRC32C", "MD5" };
+const int Session::DEFAULT_NUM_TRANSFER_THREADS = 4;
 
 Session::Session()
 	: m_protocol(HTTP),
-	  m_withCertificateVerification(false)
+	  m_withCertificateVerification(false),
+	  m_numTransferThreads(DEFAULT_NUM_TRANSFER_THREADS),
+	  m_fileIOMode(BUFFERED_FILE_IO),
+	  m_packSmallFiles(false),
+	  m_compressObjects(false),
+	  m_syncMode(NO_SYNC),
+	  m_checksumType(NO_CHECKSUM)
 {
 }
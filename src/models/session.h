@@ -26,6 +26,17 @@ class Session
 public:
 	enum Protocol { HTTP, HTTPS };
 	static const QString PROTOCOL_NAMES[];
+	enum FileIOMode { BUFFERED_FILE_IO, MAPPED_FILE_IO };
+	static const QString FILE_IO_MODE_NAMES[];
+	// Whether uploading a folder only sends the files that are new or
+	// changed since it was last uploaded, and how changes are detected
+	enum SyncMode { NO_SYNC, SYNC_BY_TIME, SYNC_BY_CONTENT };
+	static const QString SYNC_MODE_NAMES[];
+	// The checksum that's sent with each uploaded blob for the server to
+	// verify and that downloaded objects are verified against
+	enum ChecksumType { NO_CHECKSUM, CRC32C_CHECKSUM, MD5_CHECKSUM };
+	static const QString CHECKSUM_TYPE_NAMES[];
+	static const int DEFAULT_NUM_TRANSFER_THREADS;
 
 	Session();
 
@@ -52,6 +63,27 @@ public:
 	QString GetSecretKey() const;
 	void SetSecretKey(const QString& secretKey);
 
+	int GetNumTransferThreads() const;
+	void SetNumTransferThreads(int numThreads);
+
+	FileIOMode GetFileIOMode() const;
+	void SetFileIOMode(FileIOMode mode);
+	void SetFileIOMode(int mode);
+
+	bool GetPackSmallFiles() const;
+	void SetPackSmallFiles(bool pack);
+
+	bool GetCompressObjects() const;
+	void SetCompressObjects(bool compress);
+
+	SyncMode GetSyncMode() const;
+	void SetSyncMode(SyncMode mode);
+	void SetSyncMode(int mode);
+
+	ChecksumType GetChecksumType() const;
+	void SetChecksumType(ChecksumType type);
+	void SetChecksumType(int type);
+
 private:
 	QString m_host;
 	Protocol m_protocol;
@@ -64,6 +96,19 @@ private:
 	bool m_withCertificateVerification;
 	QString m_accessId;
 	QString m_secretKey;
+	// The maximum number of objects a single bulk job will transfer
+	// at once.  Each transfer thread uses its own connection.
+	int m_numTransferThreads;
+	// How object data is read from/written to local files.  Buffered
+	// goes through QFile::read/write while mapped copies straight
+	// to/from memory-mapped file pages.
+	FileIOMode m_fileIOMode;
+	// Whether small files in uploaded folders are packed into archive
+	// objects, which downloads unpack again, to save a request per file
+	bool m_packSmallFiles;
+	bool m_compressObjects;
+	SyncMode m_syncMode;
+	ChecksumType m_checksumType;
 };
 
 inline QString
@@ -162,4 +207,94 @@ Session::SetSecretKey(const QString& secretKey)
 	m_secretKey = secretKey;
 }
 
+inline int
+Session::GetNumTransferThreads() const
+{
+	return m_numTransferThreads;
+}
+
+inline void
+Session::SetNumTransferThreads(int numThreads)
+{
+	m_numTransferThreads = numThreads;
+}
+
+inline Session::FileIOMode
+Session::GetFileIOMode() const
+{
+	return m_fileIOMode;
+}
+
+inline void
+Session::SetFileIOMode(Session::FileIOMode mode)
+{
+	m_fileIOMode = mode;
+}
+
+inline void
+Session::SetFileIOMode(int mode)
+{
+	m_fileIOMode = static_cast<FileIOMode>(mode);
+}
+
+inline bool
+Session::GetPackSmallFiles() const
+{
+	return m_packSmallFiles;
+}
+
+inline void
+Session::SetPackSmallFiles(bool pack)
+{
+	m_packSmallFiles = pack;
+}
+
+inline bool
+Session::GetCompressObjects() const
+{
+	return m_compressObjects;
+}
+
+inline void
+Session::SetCompressObjects(bool compress)
+{
+	m_compressObjects = compress;
+}
+
+inline Session::SyncMode
+Session::GetSyncMode() const
+{
+	return m_syncMode;
+}
+
+inline void
+Session::SetSyncMode(Session::SyncMode mode)
+{
+	m_syncMode = mode;
+}
+
+inline void
+Session::SetSyncMode(int mode)
+{
+	m_syncMode = static_cast<SyncMode>(mode);
+}
+
+inline Session::ChecksumType
+Session::GetChecksumType() const
+{
+	return m_checksumType;
+}
+
+inline void
+Session::SetChecksumType(Session::ChecksumType type)
+{
+	m_checksumType = type;
+}
+
+inline void
+Session::SetChecksumType(int type)
+{
+	m_checksumType = static_cast<ChecksumType>(type);
+}
+
 #endif
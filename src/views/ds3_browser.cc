@@ -52,22 +52,24 @@ DS3Browser::DS3Browser(Client* client, JobsView* jobsView,
 	connect(m_treeView, SIGNAL(clicked(const QModelIndex&)),
 		this, SLOT(OnModelItemClick(const QModelIndex&)));
 
-	connect(m_client, SIGNAL(JobProgressUpdate(const Job)),
-		this, SLOT(HandleJobUpdate(const Job)));
+	connect(m_client, SIGNAL(JobProgressUpdates(const QList<Job>)),
+		this, SLOT(HandleJobUpdates(const QList<Job>)));
 
-	connect(m_client, SIGNAL(JobProgressUpdate(const Job)),
-		m_jobsView, SLOT(UpdateJob(const Job)));
+	connect(m_client, SIGNAL(JobProgressUpdates(const QList<Job>)),
+		m_jobsView, SLOT(UpdateJobs(const QList<Job>)));
 
 	connect(m_searchBar, SIGNAL(returnPressed()),
 		this, SLOT(BeginSearch()));
 }
 
 void
-DS3Browser::HandleJobUpdate(const Job job)
+DS3Browser::HandleJobUpdates(const QList<Job> jobs)
 {
-	Job::State state = job.GetState();
-	if (state == Job::FINISHED) {
-		Refresh();
+	for (int i = 0; i < jobs.size(); i++) {
+		if (jobs[i].GetState() == Job::FINISHED) {
+			Refresh();
+			return;
+		}
 	}
 }
 
@@ -81,7 +83,7 @@ DS3Browser::AddCustomToolBarActions()
 
 	m_refreshAction = new QAction(style()->standardIcon(QStyle::SP_BrowserReload),
 				      "Refresh", this);
-	connect(m_refreshAction, SIGNAL(triggered()), this, SLOT(Refresh()));
+	connect(m_refreshAction, SIGNAL(triggered()), this, SLOT(Reload()));
 	m_toolBar->addAction(m_refreshAction);
 
 	QTextCodec* codec = QTextCodec::codecForName("UTF-8");
@@ -163,12 +165,24 @@ DS3Browser::Refresh()
 		return;
 	}
 
-	m_model->Refresh(index);
+	m_model->Refresh(index, DS3BrowserModel::DIFF);
 	QString path = IndexToPath(index);
 	UpdatePathLabel(path);
 	m_treeView->setRootIndex(index);
 }
 
+void
+DS3Browser::Reload()
+{
+	QModelIndex index = m_treeView->rootIndex();
+	if (m_model->IsFetching(index)) {
+		return;
+	}
+
+	m_model->InvalidateCache(index);
+	Refresh();
+}
+
 void
 DS3Browser::OnModelItemClick(const QModelIndex& index)
 {
@@ -253,21 +267,25 @@ DS3Browser::IsBucketSelectedOnly() const
 void
 DS3Browser::BeginSearch()
 {
-	// Recreate the search model and view
+	// Recreate the search model and view.  Deleting the model cancels
+	// the previous search.
 	delete m_searchModel;
 	delete m_searchView;
 	m_searchModel = new DS3SearchModel(m_client, this);
 	m_searchView = new DS3SearchTree();
 	// Remove the focus rectangle around the search view on OSX.
 	m_searchView->setAttribute(Qt::WA_MacShowFocusRect, 0);
-	// Connect the slot to display the search results for later
-	connect(m_searchModel, SIGNAL(DoneSearching(bool)), this, SLOT(CreateSearchTree(bool)));
+	connect(m_searchModel, SIGNAL(DoneSearching(bool)), this, SLOT(FinishSearch(bool)));
 
 	// Retrieve the index for the DS3 view
 	QModelIndex index = m_treeView->rootIndex();
 	// If the current root has children, run the search
 	if(m_model->hasChildren(index)) {
-		GetServiceWatcher* watcher = new GetServiceWatcher(index);
+		// Show the results as they arrive
+		CreateSearchTree();
+		// Parented to the model so a newer search's model doesn't
+		// get this one's buckets
+		GetServiceWatcher* watcher = new GetServiceWatcher(index, m_searchModel);
 		connect(watcher, SIGNAL(finished()), this, SLOT(RunSearch()));
 		QFuture<ds3_get_service_response*> future = m_client->GetService();
 		watcher->setFuture(future);
@@ -285,12 +303,9 @@ DS3Browser::RunSearch() {
 	delete watcher;
 }
 
-// This slot is run when the search model is done searching
+// This slot is run when a search starts
 void
-DS3Browser::CreateSearchTree(bool found) {
-	// If nothing was found, then don't let users drag the warning message off of list
-	if(!found)
-		m_searchView->setDragEnabled(false);
+DS3Browser::CreateSearchTree() {
 	// Set the model and tree to use each other
 	m_searchModel->SetView(m_searchView);
 	m_searchView->setModel(m_searchModel);
@@ -298,6 +313,14 @@ DS3Browser::CreateSearchTree(bool found) {
 	m_layout->addWidget(m_searchView,4,1,1,2);
 }
 
+// This slot is run when the search model is done searching
+void
+DS3Browser::FinishSearch(bool found) {
+	// If nothing was found, then don't let users drag the warning message off of list
+	if(!found)
+		m_searchView->setDragEnabled(false);
+}
+
 DS3SearchTree::DS3SearchTree()
 	: QTreeView()
 {
@@ -53,7 +53,7 @@ signals:
 	void StartTransfer(QMimeData* data);
 
 public slots:
-	void HandleJobUpdate(const Job job);
+	void HandleJobUpdates(const QList<Job> jobs);
 
 protected:
 	void AddCustomToolBarActions();
@@ -71,8 +71,12 @@ protected slots:
 	void BeginSearch();
 	void RunSearch();
 	void Refresh();
+	// Refresh with what's on the server now rather than what the
+	// Client has cached
+	void Reload();
 	void OnModelItemClick(const QModelIndex& index);
-	void CreateSearchTree(bool found);
+	void CreateSearchTree();
+	void FinishSearch(bool found);
 	void PrepareTransfer();
 
 private:
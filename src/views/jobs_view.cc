@@ -59,6 +59,18 @@ JobView::JobView(Job job, QWidget* parent)
 	m_cancelButton->setToolTip("Cancel");
 	connect(m_cancelButton, SIGNAL(clicked()), this, SLOT(Cancel()));
 
+	// Only a job's progress changes once it's created
+	m_host->setText(job.GetHost());
+	QString urlsAndDest = job.GetURLs();
+	QFontMetrics fm(m_urlsAndDestination->font());
+	urlsAndDest = fm.elidedText(urlsAndDest, Qt::ElideRight, MAX_URLS_WIDTH);
+	urlsAndDest += " " + RIGHT_ARROW + " ";
+	QString dest = job.GetDestination();
+	dest = fm.elidedText(dest, Qt::ElideRight, MAX_DEST_WIDTH);
+	urlsAndDest += dest;
+	m_urlsAndDestination->setText(urlsAndDest);
+	m_start->setText(job.GetStart().toLocalTime().toString("M/d/yyyy h:mm AP"));
+	m_type->setText(ToTypeString(job));
 	Update(job);
 
 	m_layout->addWidget(m_type, 0, 0, 2, 1);
@@ -76,19 +88,8 @@ JobView::JobView(Job job, QWidget* parent)
 void
 JobView::Update(Job job)
 {
-	m_host->setText(job.GetHost());
-	QString urlsAndDest = job.GetURLs();
-	QFontMetrics fm(m_urlsAndDestination->font());
-	urlsAndDest = fm.elidedText(urlsAndDest, Qt::ElideRight, MAX_URLS_WIDTH);
-	urlsAndDest += " " + RIGHT_ARROW + " ";
-	QString dest = job.GetDestination();
-	dest = fm.elidedText(dest, Qt::ElideRight, MAX_DEST_WIDTH);
-	urlsAndDest += dest;
-	m_urlsAndDestination->setText(urlsAndDest);
 	m_progressBar->setValue(job.GetProgress());
 	m_progressSummary->setText(ToProgressSummary(job));
-	m_start->setText(job.GetStart().toLocalTime().toString("M/d/yyyy h:mm AP"));
-	m_type->setText(ToTypeString(job));
 }
 
 const QString
@@ -98,20 +99,11 @@ JobView::ToProgressSummary(Job job) const
 	uint64_t rawTransferred = job.GetBytesTransferred();
 	QString transferred = NumberHelper::ToHumanSize(rawTransferred);
 
-	QDateTime transferStartDT = job.GetTransferStart();
-	QString rate;
-	if (transferStartDT.isValid()) {
-		qint64 transferStart = transferStartDT.toMSecsSinceEpoch();
-		qint64 now = QDateTime::currentDateTime().toMSecsSinceEpoch();
-		qint64 elapsed = (now - transferStart) / 1000;
-		if (elapsed > 0) {
-			rate = NumberHelper::ToHumanRate(rawTransferred / elapsed);
-		}
-	}
-
 	QString summary = transferred + " of " + total;
-	if (!rate.isEmpty()) {
-		summary += " - " + rate;
+	if (job.GetState() == Job::INPROGRESS && job.GetSecondsLeft() >= 0) {
+		summary += " - " + NumberHelper::ToHumanRate(job.GetRate());
+		summary += ", " + NumberHelper::ToHumanDuration(job.GetSecondsLeft()) +
+			   " left";
 	}
 	return summary;
 }
@@ -189,6 +181,14 @@ JobsView::UpdateJob(const Job job)
 	m_jobsLock.unlock();
 }
 
+void
+JobsView::UpdateJobs(const QList<Job> jobs)
+{
+	for (int i = 0; i < jobs.size(); i++) {
+		UpdateJob(jobs[i]);
+	}
+}
+
 void
 JobsView::AddDebugJobs()
 {
@@ -39,6 +39,7 @@ public:
 public slots:
 	void CancelJob();
 	void UpdateJob(const Job job);
+	void UpdateJobs(const QList<Job> jobs);
 
 signals:
 	void JobCanceled(QUuid id);
@@ -22,6 +22,7 @@
 #include "global.h"
 #include "lib/client.h"
 #include "lib/logger.h"
+#include "lib/object_compressor.h"
 #include "lib/watchers/get_bucket_watcher.h"
 #include "views/session_dialog.h"
 
@@ -34,6 +35,12 @@ SessionDialog::SessionDialog(QWidget* parent)
 	  m_proxyLineEdit(new QLineEdit),
 	  m_accessIdLineEdit(new QLineEdit),
 	  m_secretKeyLineEdit(new QLineEdit),
+	  m_transferThreadsComboBox(new QComboBox),
+	  m_fileIOModeComboBox(new QComboBox),
+	  m_packSmallFilesCheckBox(new QCheckBox("Pack Small Files")),
+	  m_compressObjectsCheckBox(new QCheckBox("Compress Objects")),
+	  m_syncModeComboBox(new QComboBox),
+	  m_checksumTypeComboBox(new QComboBox),
 	  m_client(NULL),
 	  m_watcher(NULL)
 {
@@ -114,10 +121,79 @@ SessionDialog::SessionDialog(QWidget* parent)
 	m_form->addWidget(m_secretKeyLineEdit, 5, 1);
 	m_form->addWidget(m_secretKeyErrorLabel, 5, 2);
 
+	tip = "The maximum number of objects that each job will " \
+	      "transfer at the same time";
+	m_transferThreadsLabel = new QLabel("Transfer Threads");
+	m_transferThreadsLabel->setToolTip(tip);
+	m_transferThreadsComboBox->addItem("1");
+	m_transferThreadsComboBox->addItem("2");
+	m_transferThreadsComboBox->addItem("4");
+	m_transferThreadsComboBox->addItem("8");
+	m_transferThreadsComboBox->addItem("16");
+	m_transferThreadsComboBox->setToolTip(tip);
+	m_form->addWidget(m_transferThreadsLabel, 6, 0);
+	m_form->addWidget(m_transferThreadsComboBox, 6, 1);
+
+	tip = "How object data is read from and written to local files.  " \
+	      "Memory-Mapped avoids an extra copy per read/write which " \
+	      "can help with large files on fast local storage";
+	m_fileIOModeLabel = new QLabel("File I/O");
+	m_fileIOModeLabel->setToolTip(tip);
+	m_fileIOModeComboBox->addItem(Session::FILE_IO_MODE_NAMES[Session::BUFFERED_FILE_IO]);
+	m_fileIOModeComboBox->addItem(Session::FILE_IO_MODE_NAMES[Session::MAPPED_FILE_IO]);
+	m_fileIOModeComboBox->setToolTip(tip);
+	m_form->addWidget(m_fileIOModeLabel, 7, 0);
+	m_form->addWidget(m_fileIOModeComboBox, 7, 1);
+
+	tip = "Upload the files smaller than 64KB in each folder as a few " \
+	      "zip archive objects rather than one object per file.  " \
+	      "Downloading the folder unpacks the archives again.  " \
+	      "Files aren't packed when uploads are synced";
+	m_packSmallFilesCheckBox->setToolTip(tip);
+	m_form->addWidget(m_packSmallFilesCheckBox, 8, 1);
+
+	tip = "Compress files as they're uploaded and decompress them as " \
+	      "they're downloaded.  Saves bandwidth and storage for " \
+	      "compressible data at the cost of CPU time.  Compressed " \
+	      "files are stored as objects named with a \"" +
+	      ObjectCompressor::SUFFIX + "\" suffix, which other S3 " \
+	      "clients will see, and are saved without it when " \
+	      "downloaded";
+	m_compressObjectsCheckBox->setToolTip(tip);
+	m_form->addWidget(m_compressObjectsCheckBox, 9, 1);
+
+	tip = "Only upload the files in a folder that are new or changed " \
+	      "since the folder was last uploaded to the same place.  " \
+	      "Changes are found by size and modification time, and by " \
+	      "content when only the modification time changed.  " \
+	      "Small files aren't packed into archives while syncing";
+	m_syncModeLabel = new QLabel("Sync Uploads");
+	m_syncModeLabel->setToolTip(tip);
+	m_syncModeComboBox->addItem(Session::SYNC_MODE_NAMES[Session::NO_SYNC]);
+	m_syncModeComboBox->addItem(Session::SYNC_MODE_NAMES[Session::SYNC_BY_TIME]);
+	m_syncModeComboBox->addItem(Session::SYNC_MODE_NAMES[Session::SYNC_BY_CONTENT]);
+	m_syncModeComboBox->setToolTip(tip);
+	m_form->addWidget(m_syncModeLabel, 10, 0);
+	m_form->addWidget(m_syncModeComboBox, 10, 1);
+	connect(m_syncModeComboBox, SIGNAL(currentIndexChanged(int)),
+		this, SLOT(UpdatePackSmallFiles(int)));
+
+	tip = "Send a checksum with each uploaded file for the server to " \
+	      "verify, and verify downloaded files against the checksums " \
+	      "the server has for them";
+	m_checksumTypeLabel = new QLabel("Checksum");
+	m_checksumTypeLabel->setToolTip(tip);
+	m_checksumTypeComboBox->addItem(Session::CHECKSUM_TYPE_NAMES[Session::NO_CHECKSUM]);
+	m_checksumTypeComboBox->addItem(Session::CHECKSUM_TYPE_NAMES[Session::CRC32C_CHECKSUM]);
+	m_checksumTypeComboBox->addItem(Session::CHECKSUM_TYPE_NAMES[Session::MD5_CHECKSUM]);
+	m_checksumTypeComboBox->setToolTip(tip);
+	m_form->addWidget(m_checksumTypeLabel, 11, 0);
+	m_form->addWidget(m_checksumTypeComboBox, 11, 1);
+
 	m_saveSessionCheckBox = new QCheckBox("Save Session");
-	m_form->addWidget(m_saveSessionCheckBox, 6, 1);
+	m_form->addWidget(m_saveSessionCheckBox, 12, 1);
 
-	m_form->addWidget(m_buttonBox, 7, 1, 1, 2);
+	m_form->addWidget(m_buttonBox, 13, 1, 1, 2);
 
 	LoadSession();
 }
@@ -177,6 +253,13 @@ SessionDialog::LoadSession()
 		m_session.SetWithCertificateVerification(settings.value("withCertificateVerification").toBool());
 		m_session.SetAccessId(settings.value("accessID").toString());
 		m_session.SetSecretKey(settings.value("secretKey").toString());
+		m_session.SetNumTransferThreads(settings.value("numTransferThreads",
+							       Session::DEFAULT_NUM_TRANSFER_THREADS).toInt());
+		m_session.SetFileIOMode(settings.value("fileIOMode").toInt());
+		m_session.SetPackSmallFiles(settings.value("packSmallFiles").toBool());
+		m_session.SetCompressObjects(settings.value("compressObjects").toBool());
+		m_session.SetSyncMode(settings.value("syncMode").toInt());
+		m_session.SetChecksumType(settings.value("checksumType").toInt());
 
 		m_saveSessionCheckBox->setChecked(true);
 	}
@@ -190,6 +273,24 @@ SessionDialog::LoadSession()
 	m_proxyLineEdit->setText(m_session.GetProxy());
 	m_accessIdLineEdit->setText(m_session.GetAccessId());
 	m_secretKeyLineEdit->setText(m_session.GetSecretKey());
+	QString numThreads = QString::number(m_session.GetNumTransferThreads());
+	int threadsIndex = m_transferThreadsComboBox->findText(numThreads);
+	if (threadsIndex != -1) {
+		m_transferThreadsComboBox->setCurrentIndex(threadsIndex);
+	}
+	m_fileIOModeComboBox->setCurrentIndex(m_session.GetFileIOMode());
+	m_packSmallFilesCheckBox->setChecked(m_session.GetPackSmallFiles());
+	m_compressObjectsCheckBox->setChecked(m_session.GetCompressObjects());
+	m_syncModeComboBox->setCurrentIndex(m_session.GetSyncMode());
+	m_checksumTypeComboBox->setCurrentIndex(m_session.GetChecksumType());
+}
+
+// Synced uploads compare files with the objects of the same name so the
+// files can't be packed into archives
+void
+SessionDialog::UpdatePackSmallFiles(int syncMode)
+{
+	m_packSmallFilesCheckBox->setEnabled(syncMode == Session::NO_SYNC);
 }
 
 void
@@ -200,6 +301,12 @@ SessionDialog::UpdateSession()
 	m_session.SetProxy(m_proxyLineEdit->text().trimmed().toUtf8().constData());
 	m_session.SetAccessId(m_accessIdLineEdit->text().trimmed().toUtf8().constData());
 	m_session.SetSecretKey(m_secretKeyLineEdit->text().trimmed().toUtf8().constData());
+	m_session.SetNumTransferThreads(m_transferThreadsComboBox->currentText().toInt());
+	m_session.SetFileIOMode(m_fileIOModeComboBox->currentIndex());
+	m_session.SetPackSmallFiles(m_packSmallFilesCheckBox->isChecked());
+	m_session.SetCompressObjects(m_compressObjectsCheckBox->isChecked());
+	m_session.SetSyncMode(m_syncModeComboBox->currentIndex());
+	m_session.SetChecksumType(m_checksumTypeComboBox->currentIndex());
 }
 
 void
@@ -246,6 +353,12 @@ SessionDialog::SaveSession()
 		settings.setValue("withCertificateVerification", m_session.GetWithCertificateVerification());
 		settings.setValue("accessID", m_session.GetAccessId());
 		settings.setValue("secretKey", m_session.GetSecretKey());
+		settings.setValue("numTransferThreads", m_session.GetNumTransferThreads());
+		settings.setValue("fileIOMode", m_session.GetFileIOMode());
+		settings.setValue("packSmallFiles", m_session.GetPackSmallFiles());
+		settings.setValue("compressObjects", m_session.GetCompressObjects());
+		settings.setValue("syncMode", m_session.GetSyncMode());
+		settings.setValue("checksumType", m_session.GetChecksumType());
 	} else {
 		settings.remove("");
 	}
@@ -67,6 +67,16 @@ private:
 	QLabel* m_secretKeyLabel;
 	QLineEdit* m_secretKeyLineEdit;
 	QLabel* m_secretKeyErrorLabel;
+	QLabel* m_transferThreadsLabel;
+	QComboBox* m_transferThreadsComboBox;
+	QLabel* m_fileIOModeLabel;
+	QComboBox* m_fileIOModeComboBox;
+	QCheckBox* m_packSmallFilesCheckBox;
+	QCheckBox* m_compressObjectsCheckBox;
+	QLabel* m_syncModeLabel;
+	QComboBox* m_syncModeComboBox;
+	QLabel* m_checksumTypeLabel;
+	QComboBox* m_checksumTypeComboBox;
 
 	QCheckBox* m_saveSessionCheckBox;
 
@@ -76,6 +86,7 @@ private:
 
 private slots:
 	void CheckAuthenticationResponse();
+	void UpdatePackSmallFiles(int syncMode);
 };
 
 inline const Session&
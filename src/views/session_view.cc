@@ -46,6 +46,10 @@ SessionView::SessionView(Session* session, JobsView* jobsView, QWidget* parent)
 	connect(m_ds3Browser, SIGNAL(StartTransfer(QMimeData*)),
 		this, SLOT(SendToHost(QMimeData*)));
 
+	// Now that the JobsView is listening for job updates, pick up any
+	// jobs that were interrupted the last time the application ran.
+	m_client->ResumeJobs();
+
 	m_splitter = new QSplitter;
 	m_splitter->addWidget(m_hostBrowser);
 	m_splitter->addWidget(m_ds3Browser);
@@ -77,6 +81,12 @@ SessionView::CancelActiveJobs()
 	m_client->CancelActiveJobs();
 }
 
+bool
+SessionView::WaitForActiveJobs(int msecs)
+{
+	return m_client->WaitForActiveJobs(msecs);
+}
+
 void
 SessionView::HostToDS3()
 {
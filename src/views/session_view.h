@@ -41,6 +41,7 @@ public:
 
 	int GetNumActiveJobs() const;
 	void CancelActiveJobs();
+	bool WaitForActiveJobs(int msecs);
 
 private:
 	DS3Browser* m_ds3Browser;
@@ -0,0 +1,61 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "helpers/file_helper_test.h"
+#include "helpers/file_helper.h"
+
+static FileHelperTest instance;
+
+void
+FileHelperTest::TestGetSize()
+{
+	QFile file(QDir(m_dir.path()).filePath("size"));
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write(QByteArray(1234, 'x'));
+	file.close();
+	QCOMPARE(FileHelper::GetSize(QFileInfo(file.fileName())), (qint64)1234);
+}
+
+void
+FileHelperTest::TestPreallocate()
+{
+	QFile file(QDir(m_dir.path()).filePath("preallocated"));
+	QVERIFY(file.open(QIODevice::ReadWrite));
+	file.write("data");
+	file.flush();
+
+	qint64 size = 5 * 1024 * 1024 + 3;
+	QVERIFY(FileHelper::Preallocate(&file, size));
+	QCOMPARE(file.size(), size);
+	// Growing the file keeps what was already written
+	QVERIFY(file.seek(0));
+	QCOMPARE(file.read(4), QByteArray("data"));
+	QVERIFY(file.seek(size - 3));
+	QCOMPARE(file.read(3), QByteArray(3, '\0'));
+
+	// It's already that size
+	QVERIFY(FileHelper::Preallocate(&file, size));
+	QCOMPARE(file.size(), size);
+
+	QVERIFY(FileHelper::Preallocate(&file, 2));
+	QCOMPARE(file.size(), (qint64)2);
+	file.close();
+	QCOMPARE(QFileInfo(file.fileName()).size(), (qint64)2);
+}
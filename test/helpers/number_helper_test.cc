@@ -45,3 +45,16 @@ NumberHelperTest::TestToHumanSize()
 	QCOMPARE(NumberHelper::ToHumanSize(1024 * 1024 * 1024 * 1024LLU * 1.5),
 		 QString("1.5 TB"));
 }
+
+void
+NumberHelperTest::TestToHumanDuration()
+{
+	QCOMPARE(NumberHelper::ToHumanDuration(-5), QString("0s"));
+	QCOMPARE(NumberHelper::ToHumanDuration(0), QString("0s"));
+	QCOMPARE(NumberHelper::ToHumanDuration(59), QString("59s"));
+	QCOMPARE(NumberHelper::ToHumanDuration(60), QString("1m 0s"));
+	QCOMPARE(NumberHelper::ToHumanDuration(125), QString("2m 5s"));
+	QCOMPARE(NumberHelper::ToHumanDuration(3600), QString("1h 0m"));
+	QCOMPARE(NumberHelper::ToHumanDuration(3 * 3600 + 25 * 60 + 59),
+		 QString("3h 25m"));
+}
@@ -25,6 +25,7 @@ class NumberHelperTest : public Test
 
 private slots:
 	void TestToHumanSize();
+	void TestToHumanDuration();
 };
 
 #endif
@@ -0,0 +1,127 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QRegularExpression>
+#include <QString>
+
+#include "helpers/path_helper_test.h"
+#include "helpers/path_helper.h"
+
+static PathHelperTest instance;
+
+// The number of objects in the benchmarked listing.  Since there are a
+// million of them, the reported msecs per iteration is also the number of
+// nanoseconds spent per object.
+static const int NUM_NAMES = 1000000;
+
+void
+PathHelperTest::initTestCase()
+{
+	m_prefix = "photos/2015/";
+	m_names.reserve(NUM_NAMES);
+	for (int i = 0; i < NUM_NAMES; i++) {
+		m_names << m_prefix + "raw/IMG_" + QString::number(i) + ".CR2";
+	}
+}
+
+void
+PathHelperTest::TestGetBucketName()
+{
+	QCOMPARE(PathHelper::GetBucketName("").toString(), QString(""));
+	QCOMPARE(PathHelper::GetBucketName("/").toString(), QString(""));
+	QCOMPARE(PathHelper::GetBucketName("//a").toString(), QString(""));
+	QCOMPARE(PathHelper::GetBucketName("a").toString(), QString("a"));
+	QCOMPARE(PathHelper::GetBucketName("/a").toString(), QString("a"));
+	QCOMPARE(PathHelper::GetBucketName("a/b/").toString(), QString("a"));
+}
+
+void
+PathHelperTest::TestGetObjectName()
+{
+	QCOMPARE(PathHelper::GetObjectName("a").toString(), QString(""));
+	QCOMPARE(PathHelper::GetObjectName("a/").toString(), QString(""));
+	QCOMPARE(PathHelper::GetObjectName("a/b").toString(), QString("b"));
+	QCOMPARE(PathHelper::GetObjectName("/a/b/c/").toString(), QString("b/c/"));
+	QCOMPARE(PathHelper::GetObjectName("a//b").toString(), QString("b"));
+	QCOMPARE(PathHelper::GetObjectName("a///b").toString(), QString("/b"));
+}
+
+void
+PathHelperTest::TestGetLastPathPart()
+{
+	QCOMPARE(PathHelper::GetLastPathPart("").toString(), QString(""));
+	QCOMPARE(PathHelper::GetLastPathPart("/").toString(), QString(""));
+	QCOMPARE(PathHelper::GetLastPathPart("a//").toString(), QString(""));
+	QCOMPARE(PathHelper::GetLastPathPart("a").toString(), QString("a"));
+	QCOMPARE(PathHelper::GetLastPathPart("a/b").toString(), QString("b"));
+	QCOMPARE(PathHelper::GetLastPathPart("a/b/").toString(), QString("b/"));
+}
+
+void
+PathHelperTest::TestStripPrefix()
+{
+	QCOMPARE(PathHelper::StripPrefix("a/b", "a/").toString(), QString("b"));
+	QCOMPARE(PathHelper::StripPrefix("a/b", "").toString(), QString("a/b"));
+	QCOMPARE(PathHelper::StripPrefix("a/b", "b/").toString(), QString("a/b"));
+	QCOMPARE(PathHelper::StripPrefix("a/b", "a/b").toString(), QString(""));
+	// Unlike a "^" + prefix regular expression, the prefix is literal
+	QCOMPARE(PathHelper::StripPrefix("a+b(1)/c", "a+b(1)/").toString(),
+		 QString("c"));
+	QCOMPARE(PathHelper::StripPrefix("aab/c", "a+b/").toString(),
+		 QString("aab/c"));
+}
+
+void
+PathHelperTest::TestSlashes()
+{
+	QCOMPARE(PathHelper::StripLeadingSlash("/a/").toString(), QString("a/"));
+	QCOMPARE(PathHelper::StripLeadingSlash("a/").toString(), QString("a/"));
+	QCOMPARE(PathHelper::StripTrailingSlash("/a/").toString(), QString("/a"));
+	QCOMPARE(PathHelper::StripTrailingSlash("/a").toString(), QString("/a"));
+	QCOMPARE(PathHelper::AddTrailingSlash("a"), QString("a/"));
+	QCOMPARE(PathHelper::AddTrailingSlash("a/"), QString("a/"));
+}
+
+void
+PathHelperTest::BenchmarkStripPrefix_data()
+{
+	QTest::addColumn<bool>("regex");
+	QTest::newRow("regex") << true;
+	QTest::newRow("path helper") << false;
+}
+
+// Strip the folder prefix off of every object in a listing the way the
+// listing code used to, by building a regular expression per object, and
+// the way it does now.
+void
+PathHelperTest::BenchmarkStripPrefix()
+{
+	QFETCH(bool, regex);
+	int totalSize = 0;
+	QBENCHMARK {
+		for (int i = 0; i < m_names.size(); i++) {
+			if (regex) {
+				QString name = m_names[i];
+				name.replace(QRegularExpression("^" + m_prefix), "");
+				totalSize += name.size();
+			} else {
+				QString name = PathHelper::StripPrefix(m_names[i], m_prefix).toString();
+				totalSize += name.size();
+			}
+		}
+	}
+	QVERIFY(totalSize > 0);
+}
@@ -0,0 +1,146 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QUrl>
+#include <QtConcurrent>
+
+#include "lib/bulk_work_item_test.h"
+#include "lib/work_items/bulk_get_work_item.h"
+
+static BulkWorkItemTest instance;
+
+// libcurl hands at most this many bytes to a read/write callback at once
+static const size_t CALLBACK_SIZE = 16 * 1024;
+static const int NUM_CALLBACKS = 64 * 1024;
+static const int NUM_THREADS = 8;
+
+// How progress was counted before the per-thread counters.  Every
+// callback took the same lock twice, once to add the bytes and once to
+// check whether a job update was due.
+struct LockedProgress
+{
+	QMutex lock;
+	uint64_t bytesTransferred;
+	uint64_t bytesTransferredSinceLastJobUpdate;
+};
+
+static int
+locked_callbacks(LockedProgress* progress)
+{
+	int updates = 0;
+	for (int i = 0; i < NUM_CALLBACKS; i++) {
+		progress->lock.lock();
+		progress->bytesTransferred += CALLBACK_SIZE;
+		progress->bytesTransferredSinceLastJobUpdate += CALLBACK_SIZE;
+		progress->lock.unlock();
+
+		progress->lock.lock();
+		if (progress->bytesTransferredSinceLastJobUpdate > BulkWorkItem::UPDATE_THRESHOLD) {
+			progress->bytesTransferredSinceLastJobUpdate = 0;
+			updates++;
+		}
+		progress->lock.unlock();
+	}
+	return updates;
+}
+
+static int
+atomic_callbacks(BulkWorkItem* workItem)
+{
+	int updates = 0;
+	int counter = workItem->GetProgressCounter();
+	for (int i = 0; i < NUM_CALLBACKS; i++) {
+		if (workItem->UpdateBytesTransferred(counter, CALLBACK_SIZE)) {
+			updates++;
+		}
+	}
+	return updates;
+}
+
+static QList<QUrl>
+urls()
+{
+	QList<QUrl> urls;
+	urls << QUrl("ds3://host/bucket/a") << QUrl("ds3://host/bucket/b");
+	return urls;
+}
+
+void
+BulkWorkItemTest::TestUpdateBytesTransferred()
+{
+	BulkGetWorkItem workItem("host", urls(), "/tmp");
+	QList<QFuture<int> > futures;
+	for (int i = 0; i < NUM_THREADS; i++) {
+		futures << QtConcurrent::run(atomic_callbacks, &workItem);
+	}
+	int updates = 0;
+	for (int i = 0; i < futures.size(); i++) {
+		updates += futures[i].result();
+	}
+
+	uint64_t total = (uint64_t)NUM_THREADS * NUM_CALLBACKS * CALLBACK_SIZE;
+	QCOMPARE(workItem.GetBytesTransferred(), total);
+	// Each counter reports every UPDATE_THRESHOLD bytes it counts
+	QVERIFY(updates <= (int)(total / BulkWorkItem::UPDATE_THRESHOLD));
+	QVERIFY(updates >= (int)(total / BulkWorkItem::UPDATE_THRESHOLD) -
+			   BulkWorkItem::NUM_PROGRESS_COUNTERS);
+}
+
+void
+BulkWorkItemTest::TestToJob()
+{
+	BulkGetWorkItem workItem("host", urls(), "/tmp");
+	int counter = workItem.GetProgressCounter();
+	workItem.UpdateBytesTransferred(counter, 1000);
+	Job job = workItem.ToJob();
+	QCOMPARE(job.GetURLs(), QString("/bucket/a,/bucket/b"));
+	QCOMPARE(job.GetBytesTransferred(), (uint64_t)1000);
+}
+
+void
+BulkWorkItemTest::BenchmarkUpdateBytesTransferred_data()
+{
+	QTest::addColumn<bool>("atomic");
+	QTest::newRow("locked") << false;
+	QTest::newRow("atomic") << true;
+}
+
+void
+BulkWorkItemTest::BenchmarkUpdateBytesTransferred()
+{
+	QFETCH(bool, atomic);
+	QBENCHMARK {
+		BulkGetWorkItem workItem("host", urls(), "/tmp");
+		LockedProgress progress;
+		progress.bytesTransferred = 0;
+		progress.bytesTransferredSinceLastJobUpdate = 0;
+		QList<QFuture<int> > futures;
+		for (int i = 0; i < NUM_THREADS; i++) {
+			if (atomic) {
+				futures << QtConcurrent::run(atomic_callbacks, &workItem);
+			} else {
+				futures << QtConcurrent::run(locked_callbacks, &progress);
+			}
+		}
+		for (int i = 0; i < futures.size(); i++) {
+			futures[i].waitForFinished();
+		}
+	}
+}
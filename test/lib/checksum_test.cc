@@ -0,0 +1,157 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <string.h>
+#include <QCryptographicHash>
+
+#include "lib/checksum_test.h"
+#include "lib/checksum.h"
+
+static ChecksumTest instance;
+
+static const int DATA_SIZE = 64 * 1024 * 1024;
+
+void
+ChecksumTest::initTestCase()
+{
+	m_data.resize(DATA_SIZE);
+	for (int i = 0; i < m_data.size(); i++) {
+		m_data[i] = (char)(i % 251);
+	}
+}
+
+void
+ChecksumTest::TestCrc32c()
+{
+	// The check values from RFC 3720
+	QCOMPARE(Checksum::Crc32c(0, "123456789", 9), (uint32_t)0xE3069283);
+	QByteArray zeros(32, '\0');
+	QCOMPARE(Checksum::Crc32c(0, zeros.constData(), zeros.size()),
+		 (uint32_t)0x8A9136AA);
+	QByteArray ones(32, '\xff');
+	QCOMPARE(Checksum::Crc32c(0, ones.constData(), ones.size()),
+		 (uint32_t)0x62A8AB43);
+	QCOMPARE(Checksum::Crc32c(0, "", 0), (uint32_t)0);
+
+	Checksum checksum(Session::CRC32C_CHECKSUM);
+	checksum.Update("123456789", 9);
+	QCOMPARE(checksum.GetResult(), QByteArray::fromHex("E3069283"));
+}
+
+void
+ChecksumTest::TestCrc32cTable()
+{
+	// Whichever implementation Crc32c uses must agree with the table at
+	// every alignment and for every tail length
+	for (int start = 0; start < 16; start++) {
+		for (int size = 0; size < 80; size++) {
+			const char* data = m_data.constData() + start;
+			QCOMPARE(Checksum::Crc32c(0, data, size),
+				 Checksum::Crc32cTable(0, data, size));
+		}
+	}
+	QCOMPARE(Checksum::Crc32c(0, m_data.constData(), 1000003),
+		 Checksum::Crc32cTable(0, m_data.constData(), 1000003));
+}
+
+void
+ChecksumTest::TestIncremental()
+{
+	int size = 1000003;
+	uint32_t whole = Checksum::Crc32c(0, m_data.constData(), size);
+	uint32_t crc = 0;
+	Checksum checksum(Session::CRC32C_CHECKSUM);
+	for (int pos = 0; pos < size; pos += 16381) {
+		int count = qMin(16381, size - pos);
+		crc = Checksum::Crc32c(crc, m_data.constData() + pos, count);
+		checksum.Update(m_data.constData() + pos, count);
+	}
+	QCOMPARE(crc, whole);
+	QCOMPARE(checksum.GetResult().toHex().toUInt(NULL, 16), whole);
+}
+
+void
+ChecksumTest::TestMd5()
+{
+	Checksum checksum(Session::MD5_CHECKSUM);
+	checksum.Update("message ", 8);
+	checksum.Update("digest", 6);
+	QCOMPARE(checksum.GetResult().toHex(),
+		 QByteArray("f96b697d7cb7938d525a2f31aaf161d0"));
+
+	Checksum none(Session::NO_CHECKSUM);
+	none.Update("data", 4);
+	QVERIFY(none.GetResult().isEmpty());
+}
+
+void
+ChecksumTest::TestMatchesETag()
+{
+	QByteArray result = QByteArray::fromHex("e3069283");
+	bool comparable;
+	QVERIFY(Checksum::MatchesETag(result, "e3069283", &comparable));
+	QVERIFY(comparable);
+	QVERIFY(Checksum::MatchesETag(result, "\"E3069283\"", &comparable));
+	QVERIFY(comparable);
+	QVERIFY(Checksum::MatchesETag(result, result.toBase64(), &comparable));
+	QVERIFY(comparable);
+	QVERIFY(!Checksum::MatchesETag(result, "e3069284", &comparable));
+	QVERIFY(comparable);
+
+	// An MD5 or multipart ETag can't be compared with a CRC32C
+	QVERIFY(!Checksum::MatchesETag(result, "f96b697d7cb7938d525a2f31aaf161d0",
+				       &comparable));
+	QVERIFY(!comparable);
+	QVERIFY(!Checksum::MatchesETag(result, "e3069283-2", &comparable));
+	QVERIFY(!comparable);
+	QVERIFY(!Checksum::MatchesETag(result, "", &comparable));
+	QVERIFY(!comparable);
+}
+
+void
+ChecksumTest::BenchmarkChecksum_data()
+{
+	QTest::addColumn<QString>("kind");
+	QTest::newRow("memcpy") << "memcpy";
+	QTest::newRow("CRC32C") << "CRC32C";
+	QTest::newRow("CRC32C table") << "CRC32C table";
+	QTest::newRow("MD5") << "MD5";
+}
+
+// Each row goes over 64MB so its throughput can be compared with memcpy's
+void
+ChecksumTest::BenchmarkChecksum()
+{
+	QFETCH(QString, kind);
+	QByteArray copy(DATA_SIZE, '\0');
+	uint32_t crc = 0;
+	QBENCHMARK {
+		if (kind == "memcpy") {
+			memcpy(copy.data(), m_data.constData(), DATA_SIZE);
+		} else if (kind == "CRC32C") {
+			crc = Checksum::Crc32c(0, m_data.constData(), DATA_SIZE);
+		} else if (kind == "CRC32C table") {
+			crc = Checksum::Crc32cTable(0, m_data.constData(), DATA_SIZE);
+		} else {
+			Checksum checksum(Session::MD5_CHECKSUM);
+			checksum.Update(m_data.constData(), DATA_SIZE);
+			QCOMPARE(checksum.GetResult().size(), 16);
+		}
+	}
+	if (kind == "CRC32C") {
+		QCOMPARE(crc, Checksum::Crc32cTable(0, m_data.constData(), DATA_SIZE));
+	}
+}
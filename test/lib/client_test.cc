@@ -0,0 +1,597 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QUrl>
+
+#include "lib/client_test.h"
+#include "lib/client.h"
+#include "lib/mock_ds3_server.h"
+#include "lib/object_compressor.h"
+#include "lib/small_file_archive.h"
+#include "lib/sync_manifest.h"
+#include "models/ds3_url.h"
+#include "models/listing_page.h"
+
+static ClientTest instance;
+
+static const int JOB_TIMEOUT = 60000;
+
+void
+ClientTest::initTestCase()
+{
+	m_server = new MockDS3Server;
+	QVERIFY(m_server->Start());
+	m_session = m_server->GetSession();
+	m_client = new Client(&m_session);
+}
+
+void
+ClientTest::cleanupTestCase()
+{
+	m_client->CancelActiveJobs();
+	m_client->WaitForActiveJobs();
+	delete m_client;
+	delete m_server;
+}
+
+void
+ClientTest::TestGetService()
+{
+	m_server->AddBucket("service1");
+	m_server->AddBucket("service2");
+	ds3_get_service_response* response = m_client->GetService().result();
+	QVERIFY(response != NULL);
+	QStringList names;
+	for (size_t i = 0; i < response->num_buckets; i++) {
+		names << QString::fromUtf8(response->buckets[i].name->value);
+	}
+	ds3_free_service_response(response);
+	QVERIFY(names.contains("service1"));
+	QVERIFY(names.contains("service2"));
+}
+
+void
+ClientTest::TestGetBucket()
+{
+	for (int i = 0; i < 25; i++) {
+		m_server->AddObject("list", QString("obj%1").arg(i, 2, 10, QChar('0')), i);
+	}
+	m_server->AddObject("list", "dir/a", 1);
+	m_server->AddObject("list", "dir/b", 1);
+	m_server->SetMaxKeys(10);
+
+	QStringList objects;
+	QStringList prefixes;
+	QString marker;
+	int numPages = 0;
+	bool truncated;
+	do {
+		ds3_get_bucket_response* response;
+		response = m_client->GetBucket("list", "", marker, true).result();
+		QVERIFY(response != NULL);
+		for (size_t i = 0; i < response->num_objects; i++) {
+			objects << QString::fromUtf8(response->objects[i].name->value);
+		}
+		for (size_t i = 0; i < response->num_common_prefixes; i++) {
+			prefixes << QString::fromUtf8(response->common_prefixes[i]->value);
+		}
+		truncated = response->is_truncated;
+		if (truncated) {
+			marker = QString::fromUtf8(response->next_marker->value);
+		}
+		ds3_free_bucket_response(response);
+		numPages++;
+	} while (truncated && numPages < 10);
+	m_server->SetMaxKeys(MockDS3Server::DEFAULT_MAX_KEYS);
+
+	// The common prefix counts as a key
+	QCOMPARE(numPages, 3);
+	QCOMPARE(objects.size(), 25);
+	QCOMPARE(objects.first(), QString("obj00"));
+	QCOMPARE(objects.last(), QString("obj24"));
+	QCOMPARE(prefixes, QStringList() << "dir/");
+}
+
+void
+ClientTest::TestListingCache()
+{
+	m_server->AddObject("cache", "dir/a", 1);
+	m_server->AddObject("cache", "dir/b", 2);
+	int numLists = m_server->GetNumRequests("get bucket");
+	ListingPage* page = m_client->GetListingPage("cache", "dir/", "", "alice").result();
+	QCOMPARE(page->GetRows().GetChildCount(), 2);
+	delete page;
+	QCOMPARE(m_server->GetNumRequests("get bucket"), numLists + 1);
+
+	// Listing the folder again doesn't go back to the server
+	page = m_client->GetListingPage("cache", "dir/", "", "alice").result();
+	QCOMPARE(page->GetRows().GetChildCount(), 2);
+	delete page;
+	QCOMPARE(m_server->GetNumRequests("get bucket"), numLists + 1);
+
+	// but putting an object into it does
+	QTemporaryDir dir;
+	QFile file(QDir(dir.path()).filePath("c"));
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write("c");
+	file.close();
+	m_client->BulkPut("cache", "dir", QList<QUrl>() << QUrl::fromLocalFile(file.fileName()));
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+	numLists = m_server->GetNumRequests("get bucket");
+	page = m_client->GetListingPage("cache", "dir/", "", "alice").result();
+	QCOMPARE(page->GetRows().GetChildCount(), 3);
+	QCOMPARE(page->GetRows().GetChildName(2), QString("c"));
+	delete page;
+	QCOMPARE(m_server->GetNumRequests("get bucket"), numLists + 1);
+
+	// as does invalidating it
+	m_client->InvalidateListings("cache", "dir/");
+	page = m_client->GetListingPage("cache", "dir/", "", "alice").result();
+	delete page;
+	QCOMPARE(m_server->GetNumRequests("get bucket"), numLists + 2);
+}
+
+void
+ClientTest::TestBulkPut()
+{
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	QList<qint64> sizes;
+	sizes << 0 << 10 << 3 * 1024 * 1024 + 5;
+	for (int i = 0; i < sizes.size(); i++) {
+		QFile file(QDir(dir.path()).filePath(QString("file%1").arg(i)));
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		QVERIFY(file.resize(sizes[i]));
+		file.close();
+		urls << QUrl::fromLocalFile(file.fileName());
+	}
+	m_server->AddBucket("put");
+	m_server->SetChunkSize(1024 * 1024);
+
+	m_client->BulkPut("put", "", urls);
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	m_server->SetChunkSize(64 * 1024 * 1024);
+	QVERIFY(job.IsFinished());
+
+	QCOMPARE(m_server->GetNumObjects("put"), sizes.size());
+	for (int i = 0; i < sizes.size(); i++) {
+		uint64_t size;
+		QVERIFY(m_server->GetObjectSize("put", QString("file%1").arg(i), &size));
+		QCOMPARE(size, (uint64_t)sizes[i]);
+	}
+	QCOMPARE(m_server->GetNumBytesReceived(), (uint64_t)(sizes[0] + sizes[1] + sizes[2]));
+	// The large file was sent in 1MB blobs
+	QVERIFY(m_server->GetNumRequests("put object") >= 6);
+}
+
+void
+ClientTest::TestBulkGet()
+{
+	uint64_t size = 3 * 1024 * 1024 + 5;
+	m_server->AddObject("get", "dir/large", size);
+	m_server->AddObject("get", "dir/small", 10);
+	m_server->SetChunkSize(1024 * 1024);
+	// The server isn't ready right away
+	m_server->SetRetryAfter(1, 1);
+
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	urls << DS3URL(m_client->GetEndpoint(), "/get/dir/");
+	int numChunkRequests = m_server->GetNumRequests("get available chunks");
+	m_client->BulkGet(urls, dir.path());
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	m_server->SetRetryAfter(0, 0);
+	m_server->SetChunkSize(64 * 1024 * 1024);
+	QVERIFY(job.IsFinished());
+	QVERIFY(m_server->GetNumRequests("get available chunks") - numChunkRequests >= 2);
+
+	QFile file(QDir(dir.path()).filePath("dir/large"));
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QCOMPARE((uint64_t)file.size(), size);
+	QByteArray data = file.readAll();
+	for (int i = 0; i < data.size(); i++) {
+		if (data[i] != MockDS3Server::GetObjectByte(i)) {
+			QFAIL(qPrintable("Byte " + QString::number(i) + " differs"));
+		}
+	}
+	QCOMPARE(QFileInfo(QDir(dir.path()).filePath("dir/small")).size(), (qint64)10);
+}
+
+void
+ClientTest::TestBulkGetTree()
+{
+	QStringList files;
+	files << "tree/a/b/c/deep" << "tree/a/b/sibling" << "tree/a/top"
+	      << "tree/d/other" << "tree/root";
+	for (int i = 0; i < files.size(); i++) {
+		m_server->AddObject("tree", files[i], 1000 * i + 1);
+	}
+	m_server->AddObject("tree", "tree/empty/", 0);
+	// One file is split over several blobs, which reuse its handle
+	m_server->AddObject("tree", "tree/a/large", 3 * 1024 * 1024 + 7);
+	m_server->SetChunkSize(1024 * 1024);
+
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	urls << DS3URL(m_client->GetEndpoint(), "/tree/tree/");
+	m_client->BulkGet(urls, dir.path());
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	m_server->SetChunkSize(64 * 1024 * 1024);
+	QVERIFY(job.IsFinished());
+
+	QDir root(dir.path());
+	for (int i = 0; i < files.size(); i++) {
+		QFileInfo fileInfo(root.filePath(files[i]));
+		QVERIFY(fileInfo.isFile());
+		QCOMPARE(fileInfo.size(), (qint64)(1000 * i + 1));
+	}
+	QVERIFY(QFileInfo(root.filePath("tree/empty")).isDir());
+	QFile large(root.filePath("tree/a/large"));
+	QVERIFY(large.open(QIODevice::ReadOnly));
+	QCOMPARE(large.size(), (qint64)(3 * 1024 * 1024 + 7));
+	QByteArray data = large.readAll();
+	for (int i = 0; i < data.size(); i++) {
+		if (data[i] != MockDS3Server::GetObjectByte(i)) {
+			QFAIL(qPrintable("Byte " + QString::number(i) + " differs"));
+		}
+	}
+}
+
+void
+ClientTest::TestBulkPutSmallFiles()
+{
+	QTemporaryDir dir;
+	QDir root(dir.path());
+	QVERIFY(root.mkpath("packed/sub"));
+	for (int i = 0; i < 200; i++) {
+		QString name = QString(i % 2 ? "packed/" : "packed/sub/") +
+			       QString::number(i);
+		QFile file(root.filePath(name));
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(QByteArray(i * 10, 'x'));
+	}
+	QFile large(root.filePath("packed/large"));
+	QVERIFY(large.open(QIODevice::WriteOnly));
+	QVERIFY(large.resize(SmallFileArchive::MAX_MEMBER_SIZE));
+	large.close();
+
+	Session session = m_session;
+	session.SetPackSmallFiles(true);
+	Client client(&session);
+	m_server->AddBucket("packed");
+	int numPuts = m_server->GetNumRequests("put object");
+	QList<QUrl> urls;
+	urls << QUrl::fromLocalFile(root.filePath("packed"));
+	client.BulkPut("packed", "", urls);
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+
+	// packed/, packed/sub/, packed/large, and an archive and its index
+	QCOMPARE(m_server->GetNumObjects("packed"), 5);
+	QCOMPARE(m_server->GetNumRequests("put object") - numPuts, 5);
+	uint64_t size;
+	QVERIFY(m_server->GetObjectSize("packed", "packed/large", &size));
+	QCOMPARE(size, SmallFileArchive::MAX_MEMBER_SIZE);
+}
+
+void
+ClientTest::TestBulkGetPackedFiles()
+{
+	// An archive of the directory dir that was PUT with its files packed
+	QTemporaryDir source;
+	QDir sourceDir(source.path());
+	QMap<QString, QByteArray> files;
+	files["sub/a"] = "aaa";
+	files["sub/deep/b"] = "bbbb";
+	files["sub/empty"] = "";
+	files["subway"] = "not under sub/";
+	files["top"] = "t";
+	SmallFileArchive archive(sourceDir.filePath("archive.zip"));
+	QVERIFY(archive.Open());
+	QMap<QString, QByteArray>::const_iterator fi;
+	for (fi = files.constBegin(); fi != files.constEnd(); fi++) {
+		QString filePath = sourceDir.filePath(QString::number(archive.GetNumMembers()));
+		QFile file(filePath);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(fi.value());
+		file.close();
+		QVERIFY(archive.Add(fi.key(), filePath));
+	}
+	QVERIFY(archive.Close());
+	QFile archiveFile(archive.GetPath());
+	QVERIFY(archiveFile.open(QIODevice::ReadOnly));
+	QFile indexFile(archive.GetIndexPath());
+	QVERIFY(indexFile.open(QIODevice::ReadOnly));
+	QString archiveName = SmallFileArchive::CreateObjectName("dir/");
+	m_server->AddBucket("packedget");
+	m_server->AddObjectData("packedget", archiveName, archiveFile.readAll());
+	m_server->AddObjectData("packedget", archiveName + SmallFileArchive::INDEX_SUFFIX,
+				indexFile.readAll());
+
+	// A folder under dir only gets the members under it, with ranged
+	// GETs of the archive rather than all of it
+	QTemporaryDir dir;
+	QDir root(dir.path());
+	int numRangedGets = m_server->GetNumRequests("ranged get object");
+	QList<QUrl> urls;
+	urls << DS3URL(m_client->GetEndpoint(), "/packedget/dir/sub/");
+	m_client->BulkGet(urls, dir.path());
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+	QStringList names;
+	names << "sub/a" << "sub/deep/b" << "sub/empty";
+	for (int i = 0; i < names.size(); i++) {
+		QFile file(root.filePath(names[i]));
+		QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(names[i]));
+		QCOMPARE(file.readAll(), files[names[i]]);
+	}
+	QVERIFY(!QFileInfo(root.filePath("subway")).exists());
+	QVERIFY(!QFileInfo(root.filePath("top")).exists());
+	QVERIFY(!QFileInfo(root.filePath(QFileInfo(archiveName).fileName())).exists());
+	// The index and one range of the archive
+	QCOMPARE(m_server->GetNumRequests("ranged get object") - numRangedGets, 2);
+
+	// A single packed file
+	urls.clear();
+	urls << DS3URL(m_client->GetEndpoint(), "/packedget/dir/top");
+	m_client->BulkGet(urls, dir.path());
+	QVERIFY(MockDS3Server::WaitForJob(m_client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+	QFile top(root.filePath("top"));
+	QVERIFY(top.open(QIODevice::ReadOnly));
+	QCOMPARE(top.readAll(), QByteArray("t"));
+}
+
+void
+ClientTest::TestBulkPutCompressed()
+{
+	QTemporaryDir dir;
+	QDir root(dir.path());
+	QVERIFY(root.mkpath("compressed"));
+	QFile text(root.filePath("compressed/text"));
+	QVERIFY(text.open(QIODevice::WriteOnly));
+	text.write(QByteArray(100 * 1000, 'x'));
+	text.close();
+	// Pseudorandom bytes that gzip can't make any smaller
+	QByteArray noise(4096, '\0');
+	quint32 x = 2463534242u;
+	for (int i = 0; i < noise.size(); i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		noise[i] = (char)x;
+	}
+	QFile random(root.filePath("compressed/random"));
+	QVERIFY(random.open(QIODevice::WriteOnly));
+	random.write(noise);
+	random.close();
+
+	Session session = m_session;
+	session.SetCompressObjects(true);
+	Client client(&session);
+	m_server->AddBucket("compressed");
+	QList<QUrl> urls;
+	urls << QUrl::fromLocalFile(root.filePath("compressed"));
+	client.BulkPut("compressed", "", urls);
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+
+	uint64_t size;
+	QVERIFY(m_server->GetObjectSize("compressed",
+					"compressed/text" + ObjectCompressor::SUFFIX,
+					&size));
+	QVERIFY(size < 100 * 1000);
+	QVERIFY(!m_server->GetObjectSize("compressed", "compressed/text", &size));
+	// The random file is stored as is
+	QVERIFY(m_server->GetObjectSize("compressed", "compressed/random", &size));
+	QCOMPARE(size, (uint64_t)noise.size());
+	QVERIFY(!m_server->GetObjectSize("compressed",
+					 "compressed/random" + ObjectCompressor::SUFFIX,
+					 &size));
+}
+
+void
+ClientTest::TestBulkPutSync()
+{
+	QTemporaryDir dir;
+	QDir root(dir.path());
+	QVERIFY(root.mkpath("sync/sub"));
+	QStringList names;
+	names << "a" << "b" << "sub/c" << "old";
+	for (int i = 0; i < names.size(); i++) {
+		QFile file(root.filePath("sync/" + names[i]));
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(QByteArray((i + 1) * 10, 'x'));
+	}
+	// Uploaded before syncing was turned on
+	m_server->AddBucket("sync");
+	m_server->AddObject("sync", "sync/old", 40);
+
+	Session session = m_session;
+	session.SetSyncMode(Session::SYNC_BY_TIME);
+	QFile::remove(SyncManifest::GetPath(session.GetHost(), "sync", "sync/"));
+	Client client(&session);
+	QList<QUrl> urls;
+	urls << QUrl::fromLocalFile(root.filePath("sync"));
+	int numPuts = m_server->GetNumRequests("put object");
+	client.BulkPut("sync", "", urls);
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+
+	// sync/, sync/sub/, and every file but old
+	QCOMPARE(m_server->GetNumObjects("sync"), 6);
+	QCOMPARE(m_server->GetNumRequests("put object") - numPuts, 5);
+
+	// Only the new and changed files are sent again
+	QFile changed(root.filePath("sync/b"));
+	QVERIFY(changed.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	changed.write(QByteArray(25, 'y'));
+	changed.close();
+	QFile added(root.filePath("sync/sub/d"));
+	QVERIFY(added.open(QIODevice::WriteOnly));
+	added.write(QByteArray(5, 'z'));
+	added.close();
+	numPuts = m_server->GetNumRequests("put object");
+	int numDeletes = m_server->GetNumRequests("delete object");
+	client.BulkPut("sync", "", urls);
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+
+	QCOMPARE(m_server->GetNumObjects("sync"), 7);
+	QCOMPARE(m_server->GetNumRequests("put object") - numPuts, 2);
+	QCOMPARE(m_server->GetNumRequests("delete object") - numDeletes, 1);
+	uint64_t size;
+	QVERIFY(m_server->GetObjectSize("sync", "sync/b", &size));
+	QCOMPARE(size, (uint64_t)25);
+
+	// The files that were sent are recorded once they're on the server
+	numPuts = m_server->GetNumRequests("put object");
+	client.BulkPut("sync", "", urls);
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(job.IsFinished());
+	QCOMPARE(m_server->GetNumRequests("put object") - numPuts, 0);
+}
+
+void
+ClientTest::TestBulkPutChecksum()
+{
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	for (int i = 0; i < 3; i++) {
+		QFile file(QDir(dir.path()).filePath(QString("file%1").arg(i)));
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(QByteArray((i + 1) * 1000 * 1000, 'a' + i));
+		file.close();
+		urls << QUrl::fromLocalFile(file.fileName());
+	}
+	m_server->SetChunkSize(1024 * 1024);
+
+	Session::ChecksumType types[] = { Session::CRC32C_CHECKSUM,
+					  Session::MD5_CHECKSUM };
+	for (int i = 0; i < 2; i++) {
+		Session session = m_session;
+		session.SetChecksumType(types[i]);
+		Client client(&session);
+		QString bucket = "checksum" + QString::number(i);
+		m_server->AddBucket(bucket);
+		int numVerified = m_server->GetNumRequests("verified put object");
+		client.BulkPut(bucket, "", urls);
+		Job job;
+		QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+		QVERIFY(job.IsFinished());
+		QCOMPARE(m_server->GetNumObjects(bucket), 3);
+		// 1 + 1 + 3 blobs, each with a checksum that matched
+		QCOMPARE(m_server->GetNumRequests("verified put object") - numVerified, 5);
+	}
+	m_server->SetChunkSize(64 * 1024 * 1024);
+	QCOMPARE(m_server->GetNumRequests("bad digest"), 0);
+}
+
+void
+ClientTest::TestBulkGetChecksum()
+{
+	m_server->AddObject("verify", "dir/a", 1000);
+	m_server->AddObject("verify", "dir/b", 1024 * 1024 + 3);
+	m_server->SetETagType(Session::CRC32C_CHECKSUM);
+
+	Session session = m_session;
+	session.SetChecksumType(Session::CRC32C_CHECKSUM);
+	Client client(&session);
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	urls << DS3URL(client.GetEndpoint(), "/verify/dir/");
+	client.BulkGet(urls, dir.path());
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	m_server->SetETagType(Session::NO_CHECKSUM);
+	QVERIFY(job.IsFinished());
+
+	QDir root(dir.path());
+	QCOMPARE(QFileInfo(root.filePath("dir/a")).size(), (qint64)1000);
+	QCOMPARE(QFileInfo(root.filePath("dir/b")).size(), (qint64)(1024 * 1024 + 3));
+
+	// A download that doesn't match its ETag isn't kept
+	m_server->AddObject("verify", "bad/c", 1000);
+	m_server->SetETagType(Session::CRC32C_CHECKSUM);
+	m_server->SetETagsCorrupt(true);
+	QTemporaryDir badDir;
+	urls.clear();
+	urls << DS3URL(client.GetEndpoint(), "/verify/bad/");
+	client.BulkGet(urls, badDir.path());
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	QVERIFY(!QFile::exists(QDir(badDir.path()).filePath("bad/c")));
+
+	// Nor is one of an object that was selected on its own
+	urls.clear();
+	urls << DS3URL(client.GetEndpoint(), "/verify/bad/c");
+	client.BulkGet(urls, badDir.path());
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	m_server->SetETagsCorrupt(false);
+	m_server->SetETagType(Session::NO_CHECKSUM);
+	QVERIFY(!QFile::exists(QDir(badDir.path()).filePath("c")));
+}
+
+void
+ClientTest::TestTransferConcurrency()
+{
+	// Enough blobs that, over a throttled link, the job lasts a few
+	// controller sample windows
+	const int numObjects = 64;
+	const uint64_t size = 32 * 1024;
+	for (int i = 0; i < numObjects; i++) {
+		m_server->AddObject("throttle", "dir/obj" + QString::number(i), size);
+	}
+	m_server->SetBandwidth(0, numObjects * size / 4);
+	// Every blob fails verification, on this side, so the controllers
+	// should back off
+	m_server->SetETagType(Session::CRC32C_CHECKSUM);
+	m_server->SetETagsCorrupt(true);
+
+	Session session = m_session;
+	session.SetChecksumType(Session::CRC32C_CHECKSUM);
+	session.SetNumTransferThreads(8);
+	Client client(&session);
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	urls << DS3URL(client.GetEndpoint(), "/throttle/dir/");
+	client.BulkGet(urls, dir.path());
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, JOB_TIMEOUT, &job));
+	m_server->SetETagsCorrupt(false);
+	m_server->SetETagType(Session::NO_CHECKSUM);
+	m_server->SetBandwidth(0, 0);
+
+	QVERIFY(job.IsFinished());
+	QVERIFY(job.GetTransferLimit() > 0);
+	QVERIFY(job.GetTransferLimit() <= session.GetNumTransferThreads() / 2);
+	QDir downloaded(QDir(dir.path()).filePath("dir"));
+	QCOMPARE(downloaded.entryList(QDir::Files).size(), 0);
+}
@@ -0,0 +1,54 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef CLIENT_TEST_H
+#define CLIENT_TEST_H
+
+#include "models/session.h"
+#include "test.h"
+
+class Client;
+class MockDS3Server;
+
+class ClientTest : public Test
+{
+	Q_OBJECT
+
+private:
+	MockDS3Server* m_server;
+	Session m_session;
+	Client* m_client;
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void TestGetService();
+	void TestGetBucket();
+	void TestListingCache();
+	void TestBulkPut();
+	void TestBulkGet();
+	void TestBulkGetTree();
+	void TestBulkPutSmallFiles();
+	void TestBulkGetPackedFiles();
+	void TestBulkPutCompressed();
+	void TestBulkPutSync();
+	void TestBulkPutChecksum();
+	void TestBulkGetChecksum();
+	void TestTransferConcurrency();
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/concurrency_controller_test.h"
+#include "lib/concurrency_controller.h"
+
+static ConcurrencyControllerTest instance;
+
+static const uint64_t MB = 1024 * 1024;
+
+// Transfer limit objects at once for one sample window over a link where
+// each transfer gets at most streamRate bytes per second and all of them
+// together at most linkRate.  The window ends at end.
+static void
+transfer_window(ConcurrencyController* controller, qint64 end,
+		uint64_t streamRate, uint64_t linkRate)
+{
+	int limit = controller->GetLimit();
+	uint64_t rate = qMin(streamRate * limit, linkRate);
+	uint64_t bytes = (rate * ConcurrencyController::SAMPLE_INTERVAL) / 1000;
+	for (int i = 0; i < limit; i++) {
+		QVERIFY(controller->Acquire(0));
+	}
+	for (int i = 0; i < limit; i++) {
+		qint64 now = end - (limit - 1 - i);
+		controller->Release(bytes / limit, true, now);
+	}
+}
+
+void
+ConcurrencyControllerTest::TestAcquire()
+{
+	ConcurrencyController controller("test", 2, 1, 4);
+	QVERIFY(controller.Acquire(0));
+	QVERIFY(controller.Acquire(0));
+	QVERIFY(!controller.Acquire(10));
+	QCOMPARE(controller.GetNumInFlight(), 2);
+	controller.Release();
+	QVERIFY(controller.Acquire(0));
+	QCOMPARE(controller.GetNumInFlight(), 2);
+}
+
+void
+ConcurrencyControllerTest::TestBandwidthLimit()
+{
+	// Six transfers fill the link
+	ConcurrencyController controller("test", 2, 1, 16);
+	qint64 now = 0;
+	for (int i = 0; i < 100; i++) {
+		now += ConcurrencyController::SAMPLE_INTERVAL;
+		transfer_window(&controller, now, 10 * MB, 55 * MB);
+	}
+	// Once there, it only ever probes one higher
+	QVERIFY(controller.GetLimit() >= 6);
+	QVERIFY(controller.GetLimit() <= 7);
+
+	// The link got faster
+	for (int i = 0; i < 100; i++) {
+		now += ConcurrencyController::SAMPLE_INTERVAL;
+		transfer_window(&controller, now, 10 * MB, 108 * MB);
+	}
+	QVERIFY(controller.GetLimit() >= 11);
+	QVERIFY(controller.GetLimit() <= 12);
+
+	// Never past the max
+	for (int i = 0; i < 100; i++) {
+		now += ConcurrencyController::SAMPLE_INTERVAL;
+		transfer_window(&controller, now, 10 * MB, 1000 * MB);
+	}
+	QCOMPARE(controller.GetLimit(), 16);
+}
+
+void
+ConcurrencyControllerTest::TestErrors()
+{
+	ConcurrencyController controller("test", 8, 1, 16);
+	for (int i = 0; i < 8; i++) {
+		QVERIFY(controller.Acquire(0));
+	}
+	for (int i = 0; i < 8; i++) {
+		controller.Release(MB, i % 2 == 0, i);
+	}
+	QCOMPARE(controller.GetLimit(), 8);
+	QVERIFY(controller.Acquire(0));
+	controller.Release(MB, true, ConcurrencyController::SAMPLE_INTERVAL);
+	QCOMPARE(controller.GetLimit(), 4);
+}
+
+void
+ConcurrencyControllerTest::TestRetryAfter()
+{
+	ConcurrencyController controller("test", 8, 2, 16);
+	QVERIFY(controller.Acquire(0));
+	controller.Release(MB, true, 0);
+	controller.ReportRetryAfter(30, 100);
+	QCOMPARE(controller.GetLimit(), 8);
+	controller.ReportRetryAfter(30, ConcurrencyController::SAMPLE_INTERVAL);
+	QCOMPARE(controller.GetLimit(), 4);
+
+	// Never below the min
+	qint64 now = ConcurrencyController::SAMPLE_INTERVAL;
+	for (int i = 0; i < 5; i++) {
+		now += ConcurrencyController::SAMPLE_INTERVAL;
+		controller.ReportRetryAfter(30, now);
+	}
+	QCOMPARE(controller.GetLimit(), 2);
+}
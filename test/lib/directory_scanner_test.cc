@@ -0,0 +1,103 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QMap>
+
+#include "lib/directory_scanner_test.h"
+#include "lib/directory_scanner.h"
+
+static DirectoryScannerTest instance;
+
+// Relative path -> size, or -1 for directories
+static QMap<QString, qint64>
+expected_entries()
+{
+	QMap<QString, qint64> entries;
+	entries["a"] = -1;
+	entries["a/b"] = -1;
+	entries["a/b/c"] = -1;
+	entries["a/b/c/deep.txt"] = 3;
+	entries["a/one.txt"] = 10;
+	entries["empty"] = -1;
+	entries["top.txt"] = 0;
+	for (int i = 0; i < 50; i++) {
+		entries["many/file" + QString::number(i)] = i;
+	}
+	entries["many"] = -1;
+	return entries;
+}
+
+void
+DirectoryScannerTest::initTestCase()
+{
+	QDir root(m_dir.path());
+	QMap<QString, qint64> entries = expected_entries();
+	QMap<QString, qint64>::const_iterator ei;
+	for (ei = entries.constBegin(); ei != entries.constEnd(); ei++) {
+		if (ei.value() < 0) {
+			QVERIFY(root.mkpath(ei.key()));
+		}
+	}
+	for (ei = entries.constBegin(); ei != entries.constEnd(); ei++) {
+		if (ei.value() >= 0) {
+			QFile file(root.filePath(ei.key()));
+			QVERIFY(file.open(QIODevice::WriteOnly));
+			file.write(QByteArray(ei.value(), 'x'));
+		}
+	}
+}
+
+void
+DirectoryScannerTest::TestScan_data()
+{
+	QTest::addColumn<int>("numWalkers");
+	QTest::addColumn<int>("maxQueueSize");
+	QTest::newRow("one walker") << 1 << 100;
+	QTest::newRow("many walkers") << 8 << 100;
+	QTest::newRow("tiny queue") << 4 << 1;
+}
+
+void
+DirectoryScannerTest::TestScan()
+{
+	QFETCH(int, numWalkers);
+	QFETCH(int, maxQueueSize);
+
+	DirectoryScanner scanner(m_dir.path(), numWalkers, maxQueueSize);
+	scanner.Start();
+	QMap<QString, qint64> entries;
+	DirectoryScanner::Entry entry;
+	while (scanner.Next(&entry)) {
+		QVERIFY(!entries.contains(entry.relativePath));
+		QCOMPARE(entry.path, QDir(m_dir.path()).filePath(entry.relativePath));
+		entries[entry.relativePath] = entry.isDir ? -1 : (qint64)entry.size;
+	}
+	QCOMPARE(entries, expected_entries());
+}
+
+void
+DirectoryScannerTest::TestCancel()
+{
+	// The walkers are blocked on the full queue when the scanner is
+	// deleted.  This must not hang.
+	DirectoryScanner* scanner = new DirectoryScanner(m_dir.path(), 4, 1);
+	scanner->Start();
+	DirectoryScanner::Entry entry;
+	QVERIFY(scanner->Next(&entry));
+	delete scanner;
+}
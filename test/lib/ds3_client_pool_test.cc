@@ -0,0 +1,97 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent>
+
+#include "lib/ds3_client_pool_test.h"
+#include "lib/ds3_client_pool.h"
+
+static DS3ClientPoolTest instance;
+
+static const QString ENDPOINT = "http://localhost:8080";
+
+void
+DS3ClientPoolTest::initTestCase()
+{
+	m_creds = ds3_create_creds("access", "secret");
+}
+
+void
+DS3ClientPoolTest::cleanupTestCase()
+{
+	ds3_free_creds(m_creds);
+}
+
+void
+DS3ClientPoolTest::TestHitsAndMisses()
+{
+	DS3ClientPool pool(ENDPOINT, "", m_creds, 2, 4, 60000);
+	ds3_client* a = pool.Checkout();
+	ds3_client* b = pool.Checkout();
+	QCOMPARE(pool.GetNumMisses(), (uint64_t)2);
+	QCOMPARE(pool.GetNumCheckedOut(), 2);
+
+	pool.Return(a);
+	pool.Return(b);
+	QCOMPARE(pool.GetNumIdle(), 2);
+
+	// The most recently returned client is reused first
+	QCOMPARE(pool.Checkout(), b);
+	QCOMPARE(pool.GetNumHits(), (uint64_t)1);
+	QCOMPARE(pool.GetNumMisses(), (uint64_t)2);
+	pool.Return(b);
+}
+
+void
+DS3ClientPoolTest::TestSize()
+{
+	DS3ClientPool pool(ENDPOINT, "", m_creds, 1, 4, 60000);
+	ds3_client* a = pool.Checkout();
+	ds3_client* b = pool.Checkout();
+	pool.Return(a);
+	pool.Return(b);
+	QCOMPARE(pool.GetNumIdle(), 1);
+	QCOMPARE(pool.GetNumCheckedOut(), 0);
+}
+
+void
+DS3ClientPoolTest::TestIdleTimeout()
+{
+	DS3ClientPool pool(ENDPOINT, "", m_creds, 2, 4, 10);
+	pool.Return(pool.Checkout());
+	QCOMPARE(pool.GetNumIdle(), 1);
+	QThread::msleep(50);
+	pool.Return(pool.Checkout());
+	QCOMPARE(pool.GetNumHits(), (uint64_t)0);
+	QCOMPARE(pool.GetNumMisses(), (uint64_t)2);
+}
+
+void
+DS3ClientPoolTest::TestMaxClients()
+{
+	DS3ClientPool pool(ENDPOINT, "", m_creds, 1, 1, 60000);
+	ds3_client* a = pool.Checkout();
+	QFuture<ds3_client*> future = QtConcurrent::run(&pool, &DS3ClientPool::Checkout);
+	QThread::msleep(50);
+	QVERIFY(!future.isFinished());
+
+	pool.Return(a);
+	QCOMPARE(future.result(), a);
+	QCOMPARE(pool.GetNumHits(), (uint64_t)1);
+	pool.Return(a);
+}
@@ -0,0 +1,41 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef DS3_CLIENT_POOL_TEST_H
+#define DS3_CLIENT_POOL_TEST_H
+
+#include <ds3.h>
+
+#include "test.h"
+
+class DS3ClientPoolTest : public Test
+{
+	Q_OBJECT
+
+private:
+	ds3_creds* m_creds;
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void TestHitsAndMisses();
+	void TestSize();
+	void TestIdleTimeout();
+	void TestMaxClients();
+};
+
+#endif
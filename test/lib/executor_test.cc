@@ -0,0 +1,106 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QException>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+
+#include "lib/executor_test.h"
+#include "lib/executor.h"
+
+static ExecutorTest instance;
+
+class TestError : public QException
+{
+public:
+	void raise() const { throw *this; }
+	TestError* clone() const { return (new TestError(*this)); }
+};
+
+class Tasks
+{
+public:
+	Tasks() : m_running(0) {}
+
+	int Zero() { return 0; }
+	QString Join(const QString& a, const QString& b) { return a + b; }
+	int Sum(int a, int b, int c, int d, int e) { return a + b + c + d + e; }
+	void Fail() { throw TestError(); }
+	void Block()
+	{
+		m_running.release();
+		m_blocked.acquire();
+	}
+
+	QSemaphore m_running;
+	QSemaphore m_blocked;
+};
+
+void
+ExecutorTest::TestRun()
+{
+	Executor executor("test", 2);
+	Tasks tasks;
+	QCOMPARE(executor.Run(&tasks, &Tasks::Zero).result(), 0);
+	QCOMPARE(executor.Run(&tasks, &Tasks::Join,
+			      QString("a"), QString("b")).result(),
+		 QString("ab"));
+	QCOMPARE(executor.Run(&tasks, &Tasks::Sum, 1, 2, 3, 4, 5).result(), 15);
+	QVERIFY(executor.WaitForDone());
+	QCOMPARE(executor.GetNumFinished(), (uint64_t)3);
+	QCOMPARE(executor.GetNumActive(), 0);
+	QCOMPARE(executor.GetNumQueued(), 0);
+}
+
+void
+ExecutorTest::TestException()
+{
+	Executor executor("test", 1);
+	Tasks tasks;
+	QFuture<void> future = executor.Run(&tasks, &Tasks::Fail);
+	bool thrown = false;
+	try {
+		future.waitForFinished();
+	}
+	catch (TestError&) {
+		thrown = true;
+	}
+	QVERIFY(thrown);
+	QVERIFY(executor.WaitForDone());
+	QCOMPARE(executor.GetNumActive(), 0);
+	QCOMPARE(executor.GetNumFinished(), (uint64_t)1);
+}
+
+void
+ExecutorTest::TestQueueDepth()
+{
+	Executor executor("test", 1, QThread::LowPriority);
+	Tasks tasks;
+	for (int i = 0; i < 4; i++) {
+		executor.Run(&tasks, &Tasks::Block);
+	}
+	tasks.m_running.acquire();
+	QCOMPARE(executor.GetNumActive(), 1);
+	QCOMPARE(executor.GetNumQueued(), 3);
+	// The first task may have started before the last was queued
+	QVERIFY(executor.GetMaxNumQueued() >= 3);
+
+	tasks.m_blocked.release(4);
+	QVERIFY(executor.WaitForDone());
+	QCOMPARE(executor.GetNumQueued(), 0);
+	QCOMPARE(executor.GetNumFinished(), (uint64_t)4);
+}
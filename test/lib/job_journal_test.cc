@@ -0,0 +1,212 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QHash>
+#include <QList>
+#include <QTemporaryDir>
+#include <QUrl>
+
+#include "lib/job_journal_test.h"
+#include "lib/job_journal.h"
+#include "lib/work_items/bulk_put_work_item.h"
+#include "lib/work_items/page_work_item.h"
+
+static JobJournalTest instance;
+
+static BulkPutWorkItem*
+create_work_item()
+{
+	QList<QUrl> urls;
+	urls << QUrl("file:///tmp/dir1");
+	urls << QUrl("file:///tmp/file1");
+	BulkPutWorkItem* workItem = new BulkPutWorkItem("host", urls,
+							"bucket", "prefix");
+	workItem->InsertObjMap("prefix/dir1/", "/tmp/dir1");
+	workItem->InsertObjMap("prefix/dir1/file2", "/tmp/dir1/file2");
+	workItem->SetNumURLsProcessed(1);
+	workItem->SetLastProcessedUrl(QUrl("file:///tmp/dir1"));
+	return workItem;
+}
+
+// Pages without a response have an empty job ID
+static PageWorkItem*
+create_page(BulkWorkItem* workItem)
+{
+	return new PageWorkItem(workItem, "bucket", workItem->GetObjMap(), 1,
+				QUrl("file:///tmp/dir1"), NULL);
+}
+
+void
+JobJournalTest::TestUnfinishedPage()
+{
+	QTemporaryDir dir;
+	QString path = QDir(dir.path()).filePath("job.journal");
+	BulkPutWorkItem* workItem = create_work_item();
+	PageWorkItem* page = create_page(workItem);
+	QHash<QString, QString> etags;
+	etags.insert("prefix/dir1/file2", "e3069283");
+	page->SetETags(etags);
+
+	JobJournal writer(path);
+	QVERIFY(writer.Open());
+	writer.WriteJob(workItem);
+	writer.WritePage(page);
+	writer.WriteBlob("", "prefix/dir1/file2", 1024);
+	writer.WriteChunk("", "chunk1");
+	writer.Close();
+
+	JobJournal reader(path);
+	QVERIFY(reader.Load());
+	QVERIFY(reader.HasPages());
+	QCOMPARE(reader.GetPages().size(), 1);
+	QCOMPARE(reader.GetType(), Job::PUT);
+	QCOMPARE(reader.GetHost(), QString("host"));
+	QCOMPARE(reader.GetBucketName(), QString("bucket"));
+	QCOMPARE(reader.GetPrefix(), QString("prefix"));
+	QCOMPARE(reader.GetURLs(), workItem->GetURLs());
+	QCOMPARE(reader.GetNumURLsDone(), 0);
+	QVERIFY(reader.GetObjectsDone().isEmpty());
+	const JobJournal::Page& readPage = reader.GetPages().first();
+	QCOMPARE(readPage.bucketName, QString("bucket"));
+	QCOMPARE(readPage.numURLsProcessed, 1);
+	QCOMPARE(readPage.lastProcessedUrl, QUrl("file:///tmp/dir1"));
+	QCOMPARE(readPage.objMap.size(), 2);
+	QCOMPARE(readPage.objMap["prefix/dir1/file2"],
+		 QString("/tmp/dir1/file2"));
+	QVERIFY(readPage.chunksDone.contains("chunk1"));
+	QVERIFY(readPage.blobsDone.contains(JobJournal::BlobKey("prefix/dir1/file2", 1024)));
+	QCOMPARE(readPage.etags, etags);
+
+	BulkPutWorkItem resumed("host", reader.GetURLs(), "bucket", "prefix");
+	resumed.Resume(&reader);
+	QCOMPARE(resumed.GetNumURLsProcessed(), 1);
+	QVERIFY(resumed.IsObjectDone("prefix/dir1/"));
+	PageWorkItem resumedPage(&resumed, readPage.bucketName,
+				 readPage.objMap, readPage.numURLsProcessed,
+				 readPage.lastProcessedUrl, NULL);
+	resumedPage.SetDone(readPage.chunksDone, readPage.blobsDone);
+	QVERIFY(resumedPage.IsBlobDone("prefix/dir1/file2", 1024));
+	QVERIFY(!resumedPage.IsBlobDone("prefix/dir1/file2", 0));
+
+	delete page;
+	delete workItem;
+}
+
+void
+JobJournalTest::TestFinishedPage()
+{
+	QTemporaryDir dir;
+	QString path = QDir(dir.path()).filePath("job.journal");
+	BulkPutWorkItem* workItem = create_work_item();
+	PageWorkItem* page = create_page(workItem);
+
+	JobJournal writer(path);
+	QVERIFY(writer.Open());
+	writer.WriteJob(workItem);
+	writer.WritePage(page);
+	writer.WriteChunk("", "chunk1");
+	writer.WritePageDone("");
+	writer.Close();
+
+	JobJournal reader(path);
+	QVERIFY(reader.Load());
+	QVERIFY(!reader.HasPages());
+	QCOMPARE(reader.GetNumURLsDone(), 1);
+	QCOMPARE(reader.GetLastUrlDone(), QUrl("file:///tmp/dir1"));
+	QCOMPARE(reader.GetObjectsDone().size(), 2);
+
+	delete page;
+	delete workItem;
+}
+
+void
+JobJournalTest::TestPartialPage()
+{
+	QTemporaryDir dir;
+	QString path = QDir(dir.path()).filePath("job.journal");
+	BulkPutWorkItem* workItem = create_work_item();
+
+	JobJournal writer(path);
+	QVERIFY(writer.Open());
+	writer.WriteJob(workItem);
+	writer.Close();
+
+	// Simulate the application exiting while it was writing a page
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+	file.write("PAGE\tjob1\tbucket\t1\tfile%3A%2F%2F%2Ftmp%2Fdir1\n");
+	file.write("OBJECT\tprefix%2Fdir1%2F\t%2Ftmp%2Fdir1\n");
+	file.write("OBJECT\tprefix%2Fdir1");
+	file.close();
+
+	JobJournal reader(path);
+	QVERIFY(reader.Load());
+	QVERIFY(!reader.HasPages());
+	QCOMPARE(reader.GetNumURLsDone(), 0);
+
+	delete workItem;
+}
+
+void
+JobJournalTest::TestTwoPages()
+{
+	QTemporaryDir dir;
+	QString path = QDir(dir.path()).filePath("job.journal");
+	BulkPutWorkItem* workItem = create_work_item();
+
+	JobJournal writer(path);
+	QVERIFY(writer.Open());
+	writer.WriteJob(workItem);
+	writer.Close();
+
+	// The second page is created while the first one is transferring
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+	file.write("PAGE\tjob1\tbucket\t1\tfile%3A%2F%2F%2Ftmp%2Fdir1\n");
+	file.write("OBJECT\tprefix%2Fdir1%2F\t%2Ftmp%2Fdir1\n");
+	file.write("PAGE_READY\tjob1\n");
+	file.write("BLOB\tjob1\t0\tprefix%2Fdir1%2F\n");
+	file.write("PAGE\tjob2\tbucket\t2\tfile%3A%2F%2F%2Ftmp%2Ffile1\n");
+	file.write("OBJECT\tprefix%2Ffile1\t%2Ftmp%2Ffile1\n");
+	file.write("CHUNK\tjob1\tchunk1\n");
+	file.write("PAGE_READY\tjob2\n");
+	file.write("PAGE_DONE\tjob1\n");
+	file.write("BLOB\tjob2\t0\tprefix%2Ffile1\n");
+	file.close();
+
+	JobJournal reader(path);
+	QVERIFY(reader.Load());
+	QCOMPARE(reader.GetPages().size(), 1);
+	QCOMPARE(reader.GetNumURLsDone(), 1);
+	QVERIFY(reader.GetObjectsDone().contains("prefix/dir1/"));
+	const JobJournal::Page& readPage = reader.GetPages().first();
+	QCOMPARE(readPage.jobID, QString("job2"));
+	QVERIFY(readPage.chunksDone.isEmpty());
+	QVERIFY(readPage.blobsDone.contains(JobJournal::BlobKey("prefix/file1", 0)));
+
+	BulkPutWorkItem resumed("host", reader.GetURLs(), "bucket", "prefix");
+	resumed.Resume(&reader);
+	QCOMPARE(resumed.GetNumURLsProcessed(), 2);
+	QVERIFY(resumed.IsObjectDone("prefix/dir1/"));
+	QVERIFY(resumed.IsObjectDone("prefix/file1"));
+
+	resumed.Resume(&reader, false);
+	QCOMPARE(resumed.GetNumURLsProcessed(), 1);
+	QVERIFY(!resumed.IsObjectDone("prefix/file1"));
+
+	delete workItem;
+}
@@ -0,0 +1,127 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QList>
+#include <QSignalSpy>
+#include <QUuid>
+
+#include "lib/job_progress_publisher_test.h"
+#include "lib/job_progress_publisher.h"
+
+static JobProgressPublisherTest instance;
+
+static const uint64_t MB = 1024 * 1024;
+
+static Job
+create_job(uint64_t bytesTransferred, Job::State state = Job::INPROGRESS)
+{
+	static const QUuid id = QUuid::createUuid();
+	Job job;
+	job.SetID(id);
+	job.SetState(state);
+	job.SetSize(10 * MB);
+	job.SetBytesTransferred(bytesTransferred);
+	return job;
+}
+
+static QList<Job>
+take_jobs(QSignalSpy& spy)
+{
+	if (spy.isEmpty()) {
+		return QList<Job>();
+	}
+	return spy.takeFirst().at(0).value<QList<Job> >();
+}
+
+void
+JobProgressPublisherTest::initTestCase()
+{
+	qRegisterMetaType<QList<Job> >();
+}
+
+void
+JobProgressPublisherTest::TestCoalesce()
+{
+	JobProgressPublisher publisher;
+	QSignalSpy spy(&publisher, SIGNAL(JobsUpdated(const QList<Job>)));
+	for (int i = 1; i <= 100; i++) {
+		publisher.Publish(create_job(i * 1024));
+	}
+	Job other;
+	other.SetID(QUuid::createUuid());
+	other.SetState(Job::QUEUED);
+	publisher.Publish(other);
+	publisher.Flush(0);
+
+	QCOMPARE(spy.size(), 1);
+	QList<Job> jobs = take_jobs(spy);
+	QCOMPARE(jobs.size(), 2);
+	for (int i = 0; i < jobs.size(); i++) {
+		if (jobs[i].GetID() == other.GetID()) {
+			QCOMPARE(jobs[i].GetState(), Job::QUEUED);
+		} else {
+			QCOMPARE(jobs[i].GetBytesTransferred(), (uint64_t)100 * 1024);
+		}
+	}
+
+	// Only the job that's transferring is updated when nothing was
+	// published
+	publisher.Flush(100);
+	jobs = take_jobs(spy);
+	QCOMPARE(jobs.size(), 1);
+	QCOMPARE(jobs[0].GetState(), Job::INPROGRESS);
+}
+
+void
+JobProgressPublisherTest::TestFinishedNotUndone()
+{
+	JobProgressPublisher publisher;
+	QSignalSpy spy(&publisher, SIGNAL(JobsUpdated(const QList<Job>)));
+	publisher.Publish(create_job(10 * MB, Job::FINISHED));
+	publisher.Publish(create_job(9 * MB));
+	publisher.Flush(0);
+
+	QList<Job> jobs = take_jobs(spy);
+	QCOMPARE(jobs.size(), 1);
+	QVERIFY(jobs[0].IsFinished());
+
+	// Finished jobs are no longer tracked
+	publisher.Flush(100);
+	QVERIFY(spy.isEmpty());
+}
+
+void
+JobProgressPublisherTest::TestRate()
+{
+	JobProgressPublisher publisher;
+	QSignalSpy spy(&publisher, SIGNAL(JobsUpdated(const QList<Job>)));
+	publisher.Publish(create_job(0));
+	publisher.Flush(0);
+	QCOMPARE(take_jobs(spy)[0].GetSecondsLeft(), (qint64)-1);
+
+	publisher.Publish(create_job(1 * MB));
+	publisher.Flush(1000);
+	Job job = take_jobs(spy)[0];
+	QCOMPARE(job.GetRate(), MB);
+	QCOMPARE(job.GetSecondsLeft(), (qint64)9);
+
+	// A stall slows the rate down gradually
+	publisher.Flush(2000);
+	job = take_jobs(spy)[0];
+	uint64_t rate = (1 - JobProgressPublisher::RATE_SMOOTHING) * MB;
+	QCOMPARE(job.GetRate(), rate);
+	QCOMPARE(job.GetSecondsLeft(), (qint64)((9 * MB) / rate));
+}
@@ -0,0 +1,156 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include "lib/listing_cache_test.h"
+#include "lib/listing_cache.h"
+
+static ListingCacheTest instance;
+
+// A listing of numObjects objects
+static QSharedPointer<const Listing>
+make_listing(int numObjects)
+{
+	Listing* listing = new Listing;
+	for (int i = 0; i < numObjects; i++) {
+		Listing::Object object;
+		object.name = QString("object%1").arg(i);
+		object.size = i;
+		listing->objects << object;
+	}
+	return QSharedPointer<const Listing>(listing);
+}
+
+void
+ListingCacheTest::TestGet()
+{
+	ListingCache cache;
+	QSharedPointer<const Listing> listing = make_listing(3);
+	cache.InsertBucketListing("bucket", "dir/", "/", "", listing);
+	QCOMPARE(cache.GetBucketListing("bucket", "dir/", "/", ""), listing);
+	QCOMPARE(cache.GetCost(), 4);
+
+	// Every part of the key matters
+	QVERIFY(cache.GetBucketListing("other", "dir/", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "dir/", "", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "dir/", "/", "dir/a").isNull());
+	QVERIFY(cache.GetSearchListing("bucket", "dir/").isNull());
+	QCOMPARE(cache.GetNumHits(), 1);
+	QCOMPARE(cache.GetNumMisses(), 5);
+
+	// Inserting the same listing again replaces it
+	QSharedPointer<const Listing> newer = make_listing(1);
+	cache.InsertBucketListing("bucket", "dir/", "/", "", newer);
+	QCOMPARE(cache.GetBucketListing("bucket", "dir/", "/", ""), newer);
+	QCOMPARE(cache.GetCost(), 2);
+
+	cache.Clear();
+	QVERIFY(cache.GetBucketListing("bucket", "dir/", "/", "").isNull());
+	QCOMPARE(cache.GetCost(), 0);
+}
+
+void
+ListingCacheTest::TestExpiry()
+{
+	ListingCache cache(100);
+	cache.InsertBucketListing("bucket", "", "/", "", make_listing(1));
+	cache.InsertSearchListing("bucket", "%a%", make_listing(1));
+	QVERIFY(!cache.GetBucketListing("bucket", "", "/", "").isNull());
+	QTest::qWait(200);
+	QVERIFY(cache.GetBucketListing("bucket", "", "/", "").isNull());
+	QVERIFY(cache.GetSearchListing("bucket", "%a%").isNull());
+}
+
+void
+ListingCacheTest::TestInvalidate()
+{
+	ListingCache cache;
+	cache.InsertBucketListing("bucket", "", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/", "/", "a/m", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/", "", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/b/", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "c/", "/", "", make_listing(1));
+	cache.InsertBucketListing("other", "", "/", "", make_listing(1));
+	cache.InsertSearchListing("bucket", "%x%", make_listing(1));
+
+	// Every listing that a new a/x could show up in
+	cache.Invalidate("bucket", "a/x");
+	QVERIFY(cache.GetBucketListing("bucket", "", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "a/", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "a/", "/", "a/m").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "a/", "", "").isNull());
+	QVERIFY(cache.GetSearchListing("bucket", "%x%").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "a/b/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "c/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("other", "", "/", "").isNull());
+
+	cache.InvalidateBucket("bucket");
+	QVERIFY(cache.GetBucketListing("bucket", "a/b/", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "c/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("other", "", "/", "").isNull());
+	QCOMPARE(cache.GetCost(), 2);
+
+	// A listing that was in flight while something was invalidated
+	// could be missing the change so it isn't cached
+	qint64 generation = cache.GetGeneration();
+	cache.Invalidate("bucket", "a/y");
+	cache.InsertBucketListing("bucket", "a/", "/", "", make_listing(1),
+				  generation);
+	QVERIFY(cache.GetBucketListing("bucket", "a/", "/", "").isNull());
+	cache.InsertBucketListing("bucket", "a/", "/", "", make_listing(1),
+				  cache.GetGeneration());
+	QVERIFY(!cache.GetBucketListing("bucket", "a/", "/", "").isNull());
+}
+
+void
+ListingCacheTest::TestInvalidatePrefix()
+{
+	ListingCache cache;
+	cache.InsertBucketListing("bucket", "", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "a/b/", "/", "", make_listing(1));
+	cache.InsertBucketListing("bucket", "ab/", "/", "", make_listing(1));
+
+	cache.InvalidatePrefix("bucket", "a/");
+	QVERIFY(cache.GetBucketListing("bucket", "a/", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "a/b/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "ab/", "/", "").isNull());
+}
+
+void
+ListingCacheTest::TestEviction()
+{
+	ListingCache cache(ListingCache::DEFAULT_TTL, 100);
+	for (int i = 0; i < 10; i++) {
+		cache.InsertBucketListing("bucket", QString("dir%1/").arg(i), "/",
+					  "", make_listing(9));
+	}
+	QCOMPARE(cache.GetCost(), 100);
+
+	// The oldest are evicted to make room
+	cache.InsertBucketListing("bucket", "new/", "/", "", make_listing(9));
+	QVERIFY(cache.GetCost() <= 100);
+	QVERIFY(!cache.GetBucketListing("bucket", "new/", "/", "").isNull());
+	QVERIFY(cache.GetBucketListing("bucket", "dir0/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "dir9/", "/", "").isNull());
+
+	// and listings larger than the whole cache aren't cached at all
+	cache.InsertBucketListing("bucket", "huge/", "/", "", make_listing(100));
+	QVERIFY(cache.GetBucketListing("bucket", "huge/", "/", "").isNull());
+	QVERIFY(!cache.GetBucketListing("bucket", "new/", "/", "").isNull());
+}
@@ -0,0 +1,1288 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThreadPool>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QUuid>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "lib/checksum.h"
+#include "lib/client.h"
+#include "lib/mock_ds3_server.h"
+
+// What the DS3 API lists when a get bucket request doesn't set max-keys
+const int MockDS3Server::DEFAULT_MAX_KEYS = 1000;
+
+// Object data is sent and received in slices this big so transfers can be
+// throttled smoothly
+static const qint64 SLICE_SIZE = 64 * 1024;
+// How long, in milliseconds, a blocking socket call waits before checking
+// whether the server is stopping
+static const int SOCKET_POLL_INTERVAL = 100;
+static const QString TIMESTAMP_FORMAT = "yyyy-MM-ddThh:mm:ss.zzzZ";
+
+static QString
+create_id()
+{
+	return QUuid::createUuid().toString().mid(1, 36);
+}
+
+static QString
+timestamp()
+{
+	return QDateTime::currentDateTimeUtc().toString(TIMESTAMP_FORMAT);
+}
+
+//
+// MockDS3Listener, accepts connections and hands them to the server's
+// connection threads
+//
+
+class MockDS3Listener : public QTcpServer
+{
+public:
+	MockDS3Listener(MockDS3Server* server, QThreadPool* pool);
+
+protected:
+	void incomingConnection(qintptr socketDescriptor);
+
+private:
+	MockDS3Server* m_server;
+	QThreadPool* m_pool;
+};
+
+//
+// MockDS3Connection, reads requests off of a connection and writes the
+// server's responses back until the client closes it
+//
+
+class MockDS3Connection : public QRunnable
+{
+public:
+	MockDS3Connection(MockDS3Server* server, qintptr socketDescriptor);
+
+	void run();
+
+	// Read the request's body, whether it has a Content-Length or is
+	// chunked.  If body is NULL, the bytes are thrown away like object
+	// data, after being added to checksum if there is one.
+	bool ReadBody(const MockDS3Server::Request& request, QByteArray* body,
+		      uint64_t* numBytes = NULL, Checksum* checksum = NULL);
+	bool WriteResponse(int status, const QByteArray& body,
+			   const QList<QByteArray>& headers = QList<QByteArray>());
+	// Write the response headers for a body that's written with
+	// WriteObjectData
+	bool WriteObjectResponse(uint64_t length, int status = 200);
+	// data is all of the object's data, if it has any of its own, or
+	// empty if it's generated from GetObjectByte
+	bool WriteObjectData(uint64_t offset, uint64_t length,
+			     const QByteArray& data = QByteArray());
+	void ContinueIfExpected(const MockDS3Server::Request& request);
+
+private:
+	bool WaitForReadyRead();
+	bool ReadLine(QByteArray* line);
+	bool ReadRequest(MockDS3Server::Request* request);
+	bool Read(uint64_t length, QByteArray* body, uint64_t* numBytes,
+		  Checksum* checksum);
+	bool Flush(qint64 maxBytesToWrite);
+
+	MockDS3Server* m_server;
+	qintptr m_socketDescriptor;
+	QTcpSocket* m_socket;
+	bool m_keepAlive;
+	QElapsedTimer m_streamTimer;
+	uint64_t m_streamBytes;
+};
+
+MockDS3Listener::MockDS3Listener(MockDS3Server* server, QThreadPool* pool)
+	: QTcpServer(),
+	  m_server(server),
+	  m_pool(pool)
+{
+}
+
+void
+MockDS3Listener::incomingConnection(qintptr socketDescriptor)
+{
+	m_pool->start(new MockDS3Connection(m_server, socketDescriptor));
+}
+
+MockDS3Connection::MockDS3Connection(MockDS3Server* server,
+				     qintptr socketDescriptor)
+	: QRunnable(),
+	  m_server(server),
+	  m_socketDescriptor(socketDescriptor),
+	  m_socket(NULL),
+	  m_keepAlive(true),
+	  m_streamBytes(0)
+{
+}
+
+void
+MockDS3Connection::run()
+{
+	QTcpSocket socket;
+	if (!socket.setSocketDescriptor(m_socketDescriptor)) {
+		return;
+	}
+	m_socket = &socket;
+
+	MockDS3Server::Request request;
+	while (m_keepAlive && ReadRequest(&request)) {
+		m_streamTimer.start();
+		m_streamBytes = 0;
+		m_server->HandleRequest(this, request);
+		if (!Flush(0)) {
+			break;
+		}
+	}
+
+	socket.disconnectFromHost();
+	if (socket.state() != QAbstractSocket::UnconnectedState) {
+		socket.waitForDisconnected(SOCKET_POLL_INTERVAL);
+	}
+	m_socket = NULL;
+}
+
+bool
+MockDS3Connection::WaitForReadyRead()
+{
+	while (!m_server->IsStopping()) {
+		if (m_socket->waitForReadyRead(SOCKET_POLL_INTERVAL)) {
+			return true;
+		}
+		if (m_socket->state() != QAbstractSocket::ConnectedState) {
+			return false;
+		}
+	}
+	return false;
+}
+
+bool
+MockDS3Connection::ReadLine(QByteArray* line)
+{
+	while (!m_socket->canReadLine()) {
+		if (!WaitForReadyRead()) {
+			return false;
+		}
+	}
+	*line = m_socket->readLine().trimmed();
+	return true;
+}
+
+bool
+MockDS3Connection::ReadRequest(MockDS3Server::Request* request)
+{
+	QByteArray line;
+	do {
+		if (!ReadLine(&line)) {
+			return false;
+		}
+	} while (line.isEmpty());
+
+	QList<QByteArray> parts = line.split(' ');
+	if (parts.size() < 2) {
+		return false;
+	}
+	request->method = QString::fromLatin1(parts[0]);
+	QUrl url(QString::fromLatin1(parts[1]));
+	request->path = url.path(QUrl::FullyDecoded);
+	request->query.clear();
+	QList<QPair<QString, QString> > items;
+	items = QUrlQuery(url).queryItems(QUrl::FullyDecoded);
+	for (int i = 0; i < items.size(); i++) {
+		request->query[items[i].first.toLower()] = items[i].second;
+	}
+
+	request->headers.clear();
+	while (ReadLine(&line) && !line.isEmpty()) {
+		int colon = line.indexOf(':');
+		if (colon > 0) {
+			QString name = QString::fromLatin1(line.left(colon)).toLower();
+			QString value = QString::fromLatin1(line.mid(colon + 1).trimmed());
+			request->headers[name] = value;
+		}
+	}
+	request->contentLength = request->headers.value("content-length").toULongLong();
+	m_keepAlive = (request->headers.value("connection").toLower() != "close");
+	return (m_socket->state() == QAbstractSocket::ConnectedState ||
+		m_socket->bytesAvailable() > 0);
+}
+
+void
+MockDS3Connection::ContinueIfExpected(const MockDS3Server::Request& request)
+{
+	if (request.headers.value("expect").toLower() == "100-continue") {
+		m_socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+		Flush(0);
+	}
+}
+
+bool
+MockDS3Connection::ReadBody(const MockDS3Server::Request& request,
+			    QByteArray* body, uint64_t* numBytes,
+			    Checksum* checksum)
+{
+	uint64_t numRead = 0;
+	if (numBytes == NULL) {
+		numBytes = &numRead;
+	}
+	*numBytes = 0;
+	if (request.headers.value("transfer-encoding").toLower() != "chunked") {
+		return Read(request.contentLength, body, numBytes, checksum);
+	}
+
+	QByteArray line;
+	for (;;) {
+		if (!ReadLine(&line)) {
+			return false;
+		}
+		bool ok;
+		uint64_t size = line.split(';').first().toULongLong(&ok, 16);
+		if (!ok) {
+			return false;
+		}
+		if (size == 0) {
+			// Skip the trailers
+			while (ReadLine(&line) && !line.isEmpty()) {
+			}
+			return true;
+		}
+		if (!Read(size, body, numBytes, checksum) || !ReadLine(&line)) {
+			return false;
+		}
+	}
+}
+
+bool
+MockDS3Connection::Read(uint64_t length, QByteArray* body, uint64_t* numBytes,
+		       Checksum* checksum)
+{
+	char buffer[SLICE_SIZE];
+	uint64_t remaining = length;
+	while (remaining > 0) {
+		if (m_socket->bytesAvailable() == 0 && !WaitForReadyRead()) {
+			return false;
+		}
+		qint64 size = qMin((uint64_t)SLICE_SIZE, remaining);
+		qint64 numRead = m_socket->read(buffer, size);
+		if (numRead < 0) {
+			return false;
+		}
+		if (body != NULL) {
+			body->append(buffer, numRead);
+		} else {
+			if (checksum != NULL) {
+				checksum->Update(buffer, numRead);
+			}
+			m_server->Throttle(m_streamTimer, &m_streamBytes, numRead);
+		}
+		remaining -= numRead;
+		*numBytes += numRead;
+	}
+	return true;
+}
+
+bool
+MockDS3Connection::WriteResponse(int status, const QByteArray& body,
+				 const QList<QByteArray>& headers)
+{
+	QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + " " +
+			  (status < 300 ? "OK" : "Error") + "\r\n";
+	head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	if (!body.isEmpty()) {
+		head += "Content-Type: application/xml\r\n";
+	}
+	for (int i = 0; i < headers.size(); i++) {
+		head += headers[i] + "\r\n";
+	}
+	head += "\r\n";
+	m_socket->write(head);
+	m_socket->write(body);
+	return Flush(0);
+}
+
+bool
+MockDS3Connection::WriteObjectResponse(uint64_t length, int status)
+{
+	QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + " " +
+			  (status == 206 ? "Partial Content" : "OK") + "\r\n";
+	head += "Content-Length: " + QByteArray::number((qulonglong)length) + "\r\n";
+	head += "Content-Type: application/octet-stream\r\n\r\n";
+	m_socket->write(head);
+	return Flush(0);
+}
+
+bool
+MockDS3Connection::WriteObjectData(uint64_t offset, uint64_t length,
+				   const QByteArray& data)
+{
+	QByteArray slice;
+	uint64_t end = offset + length;
+	for (uint64_t pos = offset; pos < end; pos += slice.size()) {
+		if (!data.isEmpty()) {
+			slice = data.mid(pos, qMin((uint64_t)SLICE_SIZE, end - pos));
+		} else {
+			slice.resize(qMin((uint64_t)SLICE_SIZE, end - pos));
+			for (int i = 0; i < slice.size(); i++) {
+				slice[i] = MockDS3Server::GetObjectByte(pos + i);
+			}
+		}
+		m_server->Throttle(m_streamTimer, &m_streamBytes, slice.size());
+		m_socket->write(slice);
+		// Keep the socket's write buffer from growing without bound
+		if (!Flush(4 * SLICE_SIZE)) {
+			return false;
+		}
+	}
+	return Flush(0);
+}
+
+// Write until at most maxBytesToWrite are left in the socket's buffer
+bool
+MockDS3Connection::Flush(qint64 maxBytesToWrite)
+{
+	while (m_socket->bytesToWrite() > maxBytesToWrite) {
+		if (m_server->IsStopping() ||
+		    m_socket->state() != QAbstractSocket::ConnectedState) {
+			return false;
+		}
+		m_socket->waitForBytesWritten(SOCKET_POLL_INTERVAL);
+	}
+	return true;
+}
+
+//
+// MockDS3Server
+//
+
+MockDS3Server::MockDS3Server(QObject* parent)
+	: QThread(parent),
+	  m_port(0),
+	  m_listening(false),
+	  m_stopping(0),
+	  m_maxKeys(DEFAULT_MAX_KEYS),
+	  m_chunkSize(64 * 1024 * 1024),
+	  m_retryResponses(0),
+	  m_retryAfter(0),
+	  m_numBytesReceived(0),
+	  m_numBytesSent(0),
+	  m_etagType(Session::NO_CHECKSUM),
+	  m_etagsCorrupt(false),
+	  m_streamRate(0),
+	  m_linkRate(0),
+	  m_linkBusyUntil(0)
+{
+	m_lastModified = timestamp();
+	m_clock.start();
+}
+
+MockDS3Server::~MockDS3Server()
+{
+	Stop();
+}
+
+bool
+MockDS3Server::Start()
+{
+	m_lock.lock();
+	start();
+	m_started.wait(&m_lock);
+	bool listening = m_listening;
+	m_lock.unlock();
+	return listening;
+}
+
+void
+MockDS3Server::Stop()
+{
+	m_stopping.storeRelease(1);
+	quit();
+	wait();
+}
+
+void
+MockDS3Server::run()
+{
+	QThreadPool connectionPool;
+	// Every connection blocks a thread for as long as it's open
+	connectionPool.setMaxThreadCount(256);
+	MockDS3Listener listener(this, &connectionPool);
+
+	m_lock.lock();
+	m_listening = listener.listen(QHostAddress::LocalHost);
+	m_port = listener.serverPort();
+	m_started.wakeAll();
+	m_lock.unlock();
+
+	if (m_listening) {
+		exec();
+	}
+	listener.close();
+	connectionPool.waitForDone();
+}
+
+bool
+MockDS3Server::IsStopping() const
+{
+	return (m_stopping.loadAcquire() != 0);
+}
+
+quint16
+MockDS3Server::GetPort() const
+{
+	m_lock.lock();
+	quint16 port = m_port;
+	m_lock.unlock();
+	return port;
+}
+
+Session
+MockDS3Server::GetSession() const
+{
+	Session session;
+	session.SetHost("127.0.0.1");
+	session.SetPort(QString::number(GetPort()));
+	session.SetProtocol(Session::HTTP);
+	session.SetAccessId("mock");
+	session.SetSecretKey("mock");
+	return session;
+}
+
+QByteArray
+MockDS3Server::GetObjectChecksum(Session::ChecksumType type, uint64_t size)
+{
+	Checksum checksum(type);
+	QByteArray slice;
+	for (uint64_t pos = 0; pos < size; pos += slice.size()) {
+		slice.resize(qMin((uint64_t)SLICE_SIZE, size - pos));
+		for (int i = 0; i < slice.size(); i++) {
+			slice[i] = GetObjectByte(pos + i);
+		}
+		checksum.Update(slice.constData(), slice.size());
+	}
+	return checksum.GetResult();
+}
+
+bool
+MockDS3Server::WaitForJob(Client* client, int msecs, Job* job)
+{
+	qRegisterMetaType<QList<Job> >();
+	QSignalSpy spy(client, SIGNAL(JobProgressUpdates(const QList<Job>)));
+	QElapsedTimer timer;
+	timer.start();
+	while (timer.elapsed() < msecs) {
+		if (spy.isEmpty() && !spy.wait((int)(msecs - timer.elapsed()))) {
+			return false;
+		}
+		QList<Job> jobs = spy.takeFirst().at(0).value<QList<Job> >();
+		for (int i = 0; i < jobs.size(); i++) {
+			if (jobs[i].IsFinished() || jobs[i].WasCanceled()) {
+				if (job != NULL) {
+					*job = jobs[i];
+				}
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void
+MockDS3Server::AddBucket(const QString& bucket)
+{
+	m_lock.lock();
+	if (!m_buckets.contains(bucket)) {
+		m_buckets.insert(bucket, QMap<QString, uint64_t>());
+	}
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::AddObject(const QString& bucket, const QString& name,
+			 uint64_t size)
+{
+	m_lock.lock();
+	m_buckets[bucket][name] = size;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::AddObjectData(const QString& bucket, const QString& name,
+			     const QByteArray& data)
+{
+	m_lock.lock();
+	m_buckets[bucket][name] = data.size();
+	m_objectData[qMakePair(bucket, name)] = data;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::RemoveObject(const QString& bucket, const QString& name)
+{
+	m_lock.lock();
+	if (m_buckets.contains(bucket)) {
+		m_buckets[bucket].remove(name);
+	}
+	m_objectData.remove(qMakePair(bucket, name));
+	m_lock.unlock();
+}
+
+bool
+MockDS3Server::GetObjectSize(const QString& bucket, const QString& name,
+			     uint64_t* size) const
+{
+	bool found = false;
+	m_lock.lock();
+	QMap<QString, QMap<QString, uint64_t> >::const_iterator bi;
+	bi = m_buckets.constFind(bucket);
+	if (bi != m_buckets.constEnd() && bi->contains(name)) {
+		*size = bi->value(name);
+		found = true;
+	}
+	m_lock.unlock();
+	return found;
+}
+
+int
+MockDS3Server::GetNumObjects(const QString& bucket) const
+{
+	m_lock.lock();
+	int numObjects = m_buckets.value(bucket).size();
+	m_lock.unlock();
+	return numObjects;
+}
+
+void
+MockDS3Server::SetMaxKeys(int maxKeys)
+{
+	m_lock.lock();
+	m_maxKeys = maxKeys;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::SetChunkSize(uint64_t chunkSize)
+{
+	m_lock.lock();
+	m_chunkSize = qMax((uint64_t)1, chunkSize);
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::SetRetryAfter(int numResponses, int seconds)
+{
+	m_lock.lock();
+	m_retryResponses = numResponses;
+	m_retryAfter = seconds;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::SetBandwidth(uint64_t streamRate, uint64_t linkRate)
+{
+	m_lock.lock();
+	m_streamRate = streamRate;
+	m_linkRate = linkRate;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::SetETagType(Session::ChecksumType type)
+{
+	m_lock.lock();
+	m_etagType = type;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::SetETagsCorrupt(bool corrupt)
+{
+	m_lock.lock();
+	m_etagsCorrupt = corrupt;
+	m_lock.unlock();
+}
+
+int
+MockDS3Server::GetNumRequests(const QString& operation) const
+{
+	m_lock.lock();
+	int numRequests = m_numRequests.value(operation);
+	m_lock.unlock();
+	return numRequests;
+}
+
+uint64_t
+MockDS3Server::GetNumBytesReceived() const
+{
+	m_lock.lock();
+	uint64_t numBytes = m_numBytesReceived;
+	m_lock.unlock();
+	return numBytes;
+}
+
+uint64_t
+MockDS3Server::GetNumBytesSent() const
+{
+	m_lock.lock();
+	uint64_t numBytes = m_numBytesSent;
+	m_lock.unlock();
+	return numBytes;
+}
+
+void
+MockDS3Server::CountRequest(const QString& operation)
+{
+	m_lock.lock();
+	m_numRequests[operation]++;
+	m_lock.unlock();
+}
+
+void
+MockDS3Server::Throttle(const QElapsedTimer& streamTimer,
+			uint64_t* streamBytes, uint64_t bytes)
+{
+	m_lock.lock();
+	uint64_t streamRate = m_streamRate;
+	qint64 wait = 0;
+	if (m_linkRate > 0) {
+		qint64 now = m_clock.nsecsElapsed() / 1000;
+		m_linkBusyUntil = qMax(m_linkBusyUntil, now) +
+				  (bytes * 1000000) / m_linkRate;
+		wait = m_linkBusyUntil - now;
+	}
+	m_lock.unlock();
+
+	*streamBytes += bytes;
+	if (streamRate > 0) {
+		qint64 due = (*streamBytes * 1000000) / streamRate;
+		wait = qMax(wait, due - streamTimer.nsecsElapsed() / 1000);
+	}
+	if (wait > 0) {
+		QThread::usleep(wait);
+	}
+}
+
+void
+MockDS3Server::HandleRequest(MockDS3Connection* connection,
+			     const Request& request)
+{
+	QStringList parts = request.path.mid(1).split('/');
+	QString bucket = parts[0];
+	QString object = request.path.mid(bucket.size() + 2);
+	Response response;
+	response.status = 0;
+
+	if (bucket == "_rest_") {
+		QString resource = parts.value(1);
+		QByteArray body;
+		connection->ContinueIfExpected(request);
+		if (!connection->ReadBody(request, &body)) {
+			return;
+		}
+		if (resource == "bucket" && request.method == "PUT") {
+			response = Bulk(parts.value(2), request, body);
+		} else if (resource == "job_chunk" && request.method == "GET") {
+			response = GetAvailableChunks(request);
+		} else if (resource == "job" && request.method == "GET") {
+			response = GetJob(parts.value(2));
+		} else if (resource == "object" && request.method == "GET") {
+			response = GetObjects(request);
+		} else {
+			response = Error(404, "NotFound", request.path);
+		}
+	} else if (request.method == "GET" && bucket.isEmpty()) {
+		response = GetService();
+	} else if (request.method == "GET" && object.isEmpty()) {
+		response = GetBucket(bucket, request);
+	} else if (request.method == "PUT" && object.isEmpty()) {
+		response = PutBucket(bucket);
+	} else if (request.method == "GET" || request.method == "PUT") {
+		bool isGet = (request.method == "GET");
+		CountRequest(isGet ? "get object" : "put object");
+		uint64_t offset = request.query.value("offset").toULongLong();
+		uint64_t size = 0;
+		int blob = -1;
+		QString jobID = request.query.value("job");
+		m_lock.lock();
+		QHash<QString, BulkJob>::const_iterator job = m_jobs.constFind(jobID);
+		if (job != m_jobs.constEnd() && job->isGet == isGet) {
+			blob = FindBlob(*job, object, offset);
+			if (blob >= 0) {
+				size = job->blobs[blob].length;
+			}
+		}
+		m_lock.unlock();
+
+		QString expectedChecksum;
+		Session::ChecksumType checksumType = Session::NO_CHECKSUM;
+		if (request.headers.contains("content-crc32c")) {
+			checksumType = Session::CRC32C_CHECKSUM;
+			expectedChecksum = request.headers.value("content-crc32c");
+		} else if (request.headers.contains("content-md5")) {
+			checksumType = Session::MD5_CHECKSUM;
+			expectedChecksum = request.headers.value("content-md5");
+		}
+		Checksum checksum(checksumType);
+		if (!isGet) {
+			connection->ContinueIfExpected(request);
+			uint64_t numBytes = 0;
+			if (!connection->ReadBody(request, NULL, &numBytes,
+						  &checksum)) {
+				return;
+			}
+			m_lock.lock();
+			m_numBytesReceived += numBytes;
+			m_lock.unlock();
+		}
+
+		int status = 200;
+		if (blob < 0 && isGet && jobID.isEmpty() &&
+		    request.headers.contains("range") &&
+		    GetObjectSize(bucket, object, &size)) {
+			// bytes=first-last
+			QStringList range = request.headers.value("range").mid(6).split('-');
+			uint64_t first = range.value(0).toULongLong();
+			uint64_t last = range.value(1).toULongLong();
+			if (range.size() != 2 || first > last || last >= size) {
+				response = Error(416, "InvalidRange", request.path);
+				connection->WriteResponse(response.status, response.body);
+				return;
+			}
+			CountRequest("ranged get object");
+			offset = first;
+			size = last - first + 1;
+			status = 206;
+		}
+		if (blob < 0 && (!jobID.isEmpty() || !isGet ||
+				 (status != 206 &&
+				  !GetObjectSize(bucket, object, &size)))) {
+			response = Error(404, "NotFound", request.path);
+		} else if (isGet) {
+			m_lock.lock();
+			QByteArray data = m_objectData.value(qMakePair(bucket, object));
+			m_lock.unlock();
+			if (!connection->WriteObjectResponse(size, status) ||
+			    !connection->WriteObjectData(offset, size, data)) {
+				return;
+			}
+			m_lock.lock();
+			m_numBytesSent += size;
+			m_lock.unlock();
+			FinishBlob(jobID, blob);
+			return;
+		} else if (checksumType != Session::NO_CHECKSUM &&
+			   checksum.GetResult().toBase64() != expectedChecksum.toLatin1()) {
+			CountRequest("bad digest");
+			response = Error(400, "BadDigest", request.path);
+		} else {
+			if (checksumType != Session::NO_CHECKSUM) {
+				CountRequest("verified put object");
+			}
+			FinishBlob(jobID, blob);
+			response.status = 200;
+		}
+	} else if (request.method == "DELETE" && !object.isEmpty()) {
+		response = DeleteObject(bucket, object);
+	} else {
+		response = Error(405, "MethodNotAllowed", request.method);
+	}
+
+	connection->WriteResponse(response.status, response.body,
+				  response.headers);
+}
+
+MockDS3Server::Response
+MockDS3Server::GetService()
+{
+	CountRequest("get service");
+	Response response;
+	response.status = 200;
+	QXmlStreamWriter xml(&response.body);
+	xml.writeStartDocument();
+	xml.writeStartElement("ListAllMyBucketsResult");
+	xml.writeStartElement("Owner");
+	xml.writeTextElement("ID", "mock");
+	xml.writeTextElement("DisplayName", "mock");
+	xml.writeEndElement();
+	xml.writeStartElement("Buckets");
+	m_lock.lock();
+	QStringList buckets = m_buckets.keys();
+	m_lock.unlock();
+	for (int i = 0; i < buckets.size(); i++) {
+		xml.writeStartElement("Bucket");
+		xml.writeTextElement("CreationDate", timestamp());
+		xml.writeTextElement("Name", buckets[i]);
+		xml.writeEndElement();
+	}
+	xml.writeEndElement();
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::GetBucket(const QString& bucket, const Request& request)
+{
+	CountRequest("get bucket");
+	QString prefix = request.query.value("prefix");
+	QString delimiter = request.query.value("delimiter");
+	QString marker = request.query.value("marker");
+
+	m_lock.lock();
+	QMap<QString, QMap<QString, uint64_t> >::const_iterator bi;
+	bi = m_buckets.constFind(bucket);
+	if (bi == m_buckets.constEnd()) {
+		m_lock.unlock();
+		return Error(404, "NoSuchBucket", bucket);
+	}
+	Session::ChecksumType etagType = m_etagType;
+	// The checksum of one more byte than the object has
+	uint64_t etagExtra = m_etagsCorrupt ? 1 : 0;
+	int maxKeys = m_maxKeys;
+	if (request.query.contains("max-keys")) {
+		maxKeys = qMin(maxKeys, request.query.value("max-keys").toInt());
+	}
+
+	Response response;
+	response.status = 200;
+	QXmlStreamWriter xml(&response.body);
+	xml.writeStartDocument();
+	xml.writeStartElement("ListBucketResult");
+	xml.writeTextElement("CreationDate", timestamp());
+	xml.writeTextElement("Delimiter", delimiter);
+	xml.writeTextElement("Marker", marker);
+	xml.writeTextElement("MaxKeys", QString::number(maxKeys));
+	xml.writeTextElement("Name", bucket);
+	xml.writeTextElement("Prefix", prefix);
+
+	// Objects under a common prefix that was the marker were already
+	// listed
+	bool skipMarkerPrefix = !delimiter.isEmpty() && marker.endsWith(delimiter);
+	QMap<QString, uint64_t>::const_iterator oi = bi->lowerBound(qMax(marker, prefix));
+	QStringList commonPrefixes;
+	QString nextMarker;
+	int numKeys = 0;
+	bool truncated = false;
+	for (; oi != bi->constEnd(); oi++) {
+		const QString& key = oi.key();
+		if (!key.startsWith(prefix)) {
+			break;
+		}
+		if (key == marker ||
+		    (skipMarkerPrefix && key.startsWith(marker))) {
+			continue;
+		}
+		QString commonPrefix;
+		if (!delimiter.isEmpty()) {
+			int end = key.indexOf(delimiter, prefix.size());
+			if (end >= 0) {
+				commonPrefix = key.left(end + delimiter.size());
+			}
+		}
+		if (!commonPrefix.isEmpty() && !commonPrefixes.isEmpty() &&
+		    commonPrefixes.last() == commonPrefix) {
+			continue;
+		}
+		if (numKeys >= maxKeys) {
+			truncated = true;
+			break;
+		}
+		numKeys++;
+		if (!commonPrefix.isEmpty()) {
+			commonPrefixes << commonPrefix;
+			nextMarker = commonPrefix;
+			continue;
+		}
+		nextMarker = key;
+		xml.writeStartElement("Contents");
+		QString etag;
+		QHash<QPair<QString, QString>, QByteArray>::const_iterator di;
+		di = m_objectData.constFind(qMakePair(bucket, key));
+		if (etagType != Session::NO_CHECKSUM && di != m_objectData.constEnd()) {
+			Checksum checksum(etagType);
+			checksum.Update(di->constData(), di->size());
+			etag = "\"" + checksum.GetResult().toHex() + "\"";
+		} else if (etagType != Session::NO_CHECKSUM) {
+			etag = "\"" + GetObjectChecksum(etagType, oi.value() + etagExtra).toHex() + "\"";
+		}
+		xml.writeTextElement("ETag", etag);
+		xml.writeTextElement("Key", key);
+		xml.writeTextElement("LastModified", m_lastModified);
+		xml.writeStartElement("Owner");
+		xml.writeTextElement("DisplayName", "mock");
+		xml.writeTextElement("ID", "mock");
+		xml.writeEndElement();
+		xml.writeTextElement("Size", QString::number(oi.value()));
+		xml.writeTextElement("StorageClass", "");
+		xml.writeEndElement();
+	}
+	m_lock.unlock();
+
+	for (int i = 0; i < commonPrefixes.size(); i++) {
+		xml.writeStartElement("CommonPrefixes");
+		xml.writeTextElement("Prefix", commonPrefixes[i]);
+		xml.writeEndElement();
+	}
+	xml.writeTextElement("IsTruncated", truncated ? "true" : "false");
+	xml.writeTextElement("NextMarker", truncated ? nextMarker : "");
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::GetObjects(const Request& request)
+{
+	CountRequest("get objects");
+	QString bucket = request.query.value("bucketid",
+					     request.query.value("bucket_id"));
+	QStringList nameParts = request.query.value("name", "%").split('%');
+	for (int i = 0; i < nameParts.size(); i++) {
+		nameParts[i] = QRegularExpression::escape(nameParts[i]);
+	}
+	QRegularExpression name("^" + nameParts.join(".*") + "$");
+
+	m_lock.lock();
+	QMap<QString, QMap<QString, uint64_t> >::const_iterator bi;
+	bi = m_buckets.constFind(bucket);
+	if (bi == m_buckets.constEnd()) {
+		m_lock.unlock();
+		return Error(404, "NoSuchBucket", bucket);
+	}
+
+	Response response;
+	response.status = 200;
+	QXmlStreamWriter xml(&response.body);
+	xml.writeStartDocument();
+	xml.writeStartElement("Data");
+	QMap<QString, uint64_t>::const_iterator oi;
+	for (oi = bi->constBegin(); oi != bi->constEnd(); oi++) {
+		if (!name.match(oi.key()).hasMatch()) {
+			continue;
+		}
+		xml.writeStartElement("S3Object");
+		xml.writeTextElement("BucketId", bucket);
+		xml.writeTextElement("LastModified", m_lastModified);
+		xml.writeTextElement("Name", oi.key());
+		xml.writeStartElement("Owner");
+		xml.writeTextElement("DisplayName", "mock");
+		xml.writeTextElement("ID", "mock");
+		xml.writeEndElement();
+		xml.writeTextElement("Size", QString::number(oi.value()));
+		xml.writeTextElement("Type", "DATA");
+		xml.writeEndElement();
+	}
+	m_lock.unlock();
+
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::PutBucket(const QString& bucket)
+{
+	CountRequest("put bucket");
+	m_lock.lock();
+	bool exists = m_buckets.contains(bucket);
+	m_lock.unlock();
+	if (exists) {
+		return Error(409, "BucketAlreadyExists", bucket);
+	}
+	AddBucket(bucket);
+	Response response;
+	response.status = 200;
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::DeleteObject(const QString& bucket, const QString& object)
+{
+	CountRequest("delete object");
+	m_lock.lock();
+	bool removed = (m_buckets.contains(bucket) &&
+			m_buckets[bucket].remove(object) > 0);
+	m_objectData.remove(qMakePair(bucket, object));
+	m_lock.unlock();
+	if (!removed) {
+		return Error(404, "NotFound", bucket + "/" + object);
+	}
+	Response response;
+	response.status = 204;
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::Bulk(const QString& bucket, const Request& request,
+		    const QByteArray& body)
+{
+	QString operation = request.query.value("operation").toLower();
+	bool isGet;
+	if (operation == "start_bulk_get") {
+		isGet = true;
+	} else if (operation == "start_bulk_put") {
+		isGet = false;
+	} else {
+		return Error(400, "InvalidOperation", operation);
+	}
+	CountRequest(isGet ? "bulk get" : "bulk put");
+
+	QList<QPair<QString, uint64_t> > objects;
+	QXmlStreamReader xml(body);
+	while (!xml.atEnd()) {
+		if (xml.readNext() == QXmlStreamReader::StartElement &&
+		    xml.name() == "Object") {
+			QXmlStreamAttributes attrs = xml.attributes();
+			objects << qMakePair(attrs.value("Name").toString(),
+					     attrs.value("Size").toULongLong());
+		}
+	}
+	if (xml.hasError()) {
+		return Error(400, "MalformedXML", xml.errorString());
+	}
+
+	m_lock.lock();
+	if (!m_buckets.contains(bucket)) {
+		m_lock.unlock();
+		return Error(404, "NoSuchBucket", bucket);
+	}
+	QMap<QString, uint64_t>& bucketObjects = m_buckets[bucket];
+
+	BulkJob job;
+	job.id = create_id();
+	job.bucket = bucket;
+	job.isGet = isGet;
+	job.size = 0;
+	job.numChunkRequests = 0;
+	Chunk chunk;
+	uint64_t chunkSize = 0;
+	for (int i = 0; i < objects.size(); i++) {
+		const QString& name = objects[i].first;
+		uint64_t size = objects[i].second;
+		if (isGet) {
+			if (!bucketObjects.contains(name)) {
+				m_lock.unlock();
+				return Error(404, "NotFound", name);
+			}
+			size = bucketObjects.value(name);
+		} else {
+			if (bucketObjects.contains(name)) {
+				m_lock.unlock();
+				return Error(409, "ObjectAlreadyExists",
+					     "(" + bucket + ", " + name +
+					     ") already exists");
+			}
+			bucketObjects[name] = size;
+		}
+		job.size += size;
+
+		uint64_t offset = 0;
+		do {
+			Blob blob;
+			blob.name = name;
+			blob.offset = offset;
+			blob.length = qMin(m_chunkSize, size - offset);
+			blob.done = false;
+			if (!chunk.blobs.isEmpty() &&
+			    chunkSize + blob.length > m_chunkSize) {
+				job.chunks << chunk;
+				chunk.blobs.clear();
+				chunkSize = 0;
+			}
+			if (chunk.blobs.isEmpty()) {
+				chunk.id = create_id();
+			}
+			chunk.blobs << job.blobs.size();
+			job.blobIndex.insert(qMakePair(name, (quint64)offset),
+					     job.blobs.size());
+			job.blobs << blob;
+			chunkSize += blob.length;
+			offset += blob.length;
+		} while (offset < size);
+	}
+	if (!chunk.blobs.isEmpty()) {
+		job.chunks << chunk;
+	}
+	m_jobs.insert(job.id, job);
+
+	QList<int> chunks;
+	for (int i = 0; i < job.chunks.size(); i++) {
+		chunks << i;
+	}
+	Response response;
+	response.status = 200;
+	response.body = ToMasterObjectList(job, chunks);
+	m_lock.unlock();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::GetAvailableChunks(const Request& request)
+{
+	CountRequest("get available chunks");
+	QString jobID = request.query.value("job");
+	Response response;
+	m_lock.lock();
+	QHash<QString, BulkJob>::iterator job = m_jobs.find(jobID);
+	if (job == m_jobs.end()) {
+		m_lock.unlock();
+		return Error(404, "NotFound", jobID);
+	}
+
+	// Chunks are reported until all of their blobs have been transferred
+	QList<int> chunks;
+	if (job->numChunkRequests++ < m_retryResponses) {
+		response.headers << ("Retry-After: " +
+				     QByteArray::number(m_retryAfter));
+	} else {
+		for (int i = 0; i < job->chunks.size(); i++) {
+			const QList<int>& blobs = job->chunks[i].blobs;
+			for (int j = 0; j < blobs.size(); j++) {
+				if (!job->blobs[blobs[j]].done) {
+					chunks << i;
+					break;
+				}
+			}
+		}
+	}
+	response.status = 200;
+	response.body = ToMasterObjectList(*job, chunks);
+	m_lock.unlock();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::GetJob(const QString& jobID)
+{
+	CountRequest("get job");
+	Response response;
+	m_lock.lock();
+	QHash<QString, BulkJob>::const_iterator job = m_jobs.constFind(jobID);
+	if (job == m_jobs.constEnd()) {
+		m_lock.unlock();
+		return Error(404, "NotFound", jobID);
+	}
+	QList<int> chunks;
+	for (int i = 0; i < job->chunks.size(); i++) {
+		chunks << i;
+	}
+	response.status = 200;
+	response.body = ToMasterObjectList(*job, chunks);
+	m_lock.unlock();
+	return response;
+}
+
+MockDS3Server::Response
+MockDS3Server::Error(int status, const QString& code,
+		     const QString& message) const
+{
+	Response response;
+	response.status = status;
+	QXmlStreamWriter xml(&response.body);
+	xml.writeStartDocument();
+	xml.writeStartElement("Error");
+	xml.writeTextElement("Code", code);
+	xml.writeTextElement("HttpErrorCode", QString::number(status));
+	xml.writeTextElement("Message", message);
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return response;
+}
+
+// Must be called with m_lock held
+QByteArray
+MockDS3Server::ToMasterObjectList(const BulkJob& job,
+				  const QList<int>& chunks) const
+{
+	static const QString NODE_ID = create_id();
+	QByteArray body;
+	QXmlStreamWriter xml(&body);
+	xml.writeStartDocument();
+	xml.writeStartElement("MasterObjectList");
+	xml.writeAttribute("BucketName", job.bucket);
+	xml.writeAttribute("CachedSizeInBytes", "0");
+	xml.writeAttribute("ChunkClientProcessingOrderGuarantee", "NONE");
+	xml.writeAttribute("CompletedSizeInBytes", "0");
+	xml.writeAttribute("JobId", job.id);
+	xml.writeAttribute("OriginalSizeInBytes", QString::number(job.size));
+	xml.writeAttribute("Priority", "NORMAL");
+	xml.writeAttribute("RequestType", job.isGet ? "GET" : "PUT");
+	xml.writeAttribute("StartDate", timestamp());
+	xml.writeAttribute("Status", "IN_PROGRESS");
+	xml.writeAttribute("UserId", NODE_ID);
+	xml.writeAttribute("UserName", "mock");
+	xml.writeAttribute("WriteOptimization", "CAPACITY");
+	xml.writeStartElement("Nodes");
+	xml.writeStartElement("Node");
+	xml.writeAttribute("EndPoint", "127.0.0.1");
+	xml.writeAttribute("HttpPort", QString::number(m_port));
+	xml.writeAttribute("Id", NODE_ID);
+	xml.writeEndElement();
+	xml.writeEndElement();
+	for (int i = 0; i < chunks.size(); i++) {
+		const Chunk& chunk = job.chunks[chunks[i]];
+		xml.writeStartElement("Objects");
+		xml.writeAttribute("ChunkId", chunk.id);
+		xml.writeAttribute("ChunkNumber", QString::number(chunks[i]));
+		xml.writeAttribute("NodeId", NODE_ID);
+		for (int j = 0; j < chunk.blobs.size(); j++) {
+			const Blob& blob = job.blobs[chunk.blobs[j]];
+			xml.writeStartElement("Object");
+			xml.writeAttribute("InCache", job.isGet ? "true" : "false");
+			xml.writeAttribute("Length", QString::number(blob.length));
+			xml.writeAttribute("Name", blob.name);
+			xml.writeAttribute("Offset", QString::number(blob.offset));
+			xml.writeEndElement();
+		}
+		xml.writeEndElement();
+	}
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return body;
+}
+
+// Must be called with m_lock held
+int
+MockDS3Server::FindBlob(const BulkJob& job, const QString& name,
+			uint64_t offset) const
+{
+	return job.blobIndex.value(qMakePair(name, (quint64)offset), -1);
+}
+
+void
+MockDS3Server::FinishBlob(const QString& jobID, int blob)
+{
+	if (blob < 0) {
+		return;
+	}
+	m_lock.lock();
+	QHash<QString, BulkJob>::iterator job = m_jobs.find(jobID);
+	if (job != m_jobs.end()) {
+		job->blobs[blob].done = true;
+	}
+	m_lock.unlock();
+}
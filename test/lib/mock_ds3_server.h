@@ -0,0 +1,244 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef MOCK_DS3_SERVER_H
+#define MOCK_DS3_SERVER_H
+
+#include <stdint.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "models/job.h"
+#include "models/session.h"
+
+class Client;
+class MockDS3Connection;
+
+// MockDS3Server, a DS3 endpoint on a free localhost port that Client can be
+// pointed at.  It implements just enough of the DS3 API for the browser's
+// listings and bulk transfers:
+//
+//   GET    /                           get service
+//   GET    /bucket                     get bucket (prefix, delimiter,
+//                                      marker, max-keys and truncation)
+//   PUT    /bucket                     put bucket
+//   PUT    /_rest_/bucket/bucket       bulk get/put (operation=start_bulk_*)
+//   GET    /_rest_/job_chunk?job=      get available chunks (Retry-After)
+//   GET    /_rest_/job/id              get job
+//   GET    /bucket/object?job&offset   get object (Range without a job)
+//   PUT    /bucket/object?job&offset   put object (verifies Content-MD5
+//                                      and Content-CRC32C)
+//   DELETE /bucket/object              delete object
+//
+// Objects only have a size.  Listings can give them the checksum of their
+// data as their ETag.  Their data is generated from GetObjectByte
+// when downloaded and counted, but not kept, when uploaded, so workloads of
+// any size can be simulated.  Objects added with AddObjectData are the
+// exception and are downloaded with the data they were given.  Requests
+// aren't authenticated.
+//
+// Every connection is served by its own thread with blocking socket I/O.
+// Their transfers can be throttled per connection and all together to
+// simulate a bandwidth limited link.
+class MockDS3Server : public QThread
+{
+	Q_OBJECT
+
+public:
+	static const int DEFAULT_MAX_KEYS;
+
+	MockDS3Server(QObject* parent = 0);
+	~MockDS3Server();
+
+	// Start listening.  Returns false if no port could be listened on.
+	bool Start();
+	void Stop();
+	quint16 GetPort() const;
+	// A session for this server
+	Session GetSession() const;
+
+	void AddBucket(const QString& bucket);
+	void AddObject(const QString& bucket, const QString& name,
+		       uint64_t size);
+	// An object that's downloaded with data instead of generated data
+	void AddObjectData(const QString& bucket, const QString& name,
+			   const QByteArray& data);
+	void RemoveObject(const QString& bucket, const QString& name);
+	bool GetObjectSize(const QString& bucket, const QString& name,
+			   uint64_t* size) const;
+	int GetNumObjects(const QString& bucket) const;
+
+	// The most objects and common prefixes a get bucket response lists
+	// when the request doesn't ask for fewer
+	void SetMaxKeys(int maxKeys);
+	// The most bytes a job chunk covers.  Larger objects are split into
+	// blobs of this size.
+	void SetChunkSize(uint64_t chunkSize);
+	// Answer the first numResponses get available chunks requests of
+	// every job with no chunks and a Retry-After of seconds
+	void SetRetryAfter(int numResponses, int seconds);
+	// Bytes per second that each connection and all of them together
+	// can transfer.  0 means unlimited.
+	void SetBandwidth(uint64_t streamRate, uint64_t linkRate);
+	// The checksum that get bucket responses list as objects' ETags, in
+	// hex.  NO_CHECKSUM, the default, lists empty ETags.
+	void SetETagType(Session::ChecksumType type);
+	// List ETags that don't match the objects' data
+	void SetETagsCorrupt(bool corrupt);
+
+	// Requests served, by operation, e.g. "get bucket"
+	int GetNumRequests(const QString& operation) const;
+	uint64_t GetNumBytesReceived() const;
+	uint64_t GetNumBytesSent() const;
+
+	// The byte at offset of every object's data
+	static char GetObjectByte(uint64_t offset);
+	// The checksum of the data of an object of size bytes
+	static QByteArray GetObjectChecksum(Session::ChecksumType type,
+					    uint64_t size);
+
+	// Wait up to msecs for client to report that one of its jobs
+	// finished or was canceled.  Needs the calling thread's event loop
+	// since that's where the job updates are delivered.
+	static bool WaitForJob(Client* client, int msecs, Job* job = NULL);
+
+protected:
+	void run();
+
+private:
+	struct Blob
+	{
+		QString name;
+		uint64_t offset;
+		uint64_t length;
+		bool done;
+	};
+
+	struct Chunk
+	{
+		QString id;
+		QList<int> blobs;
+	};
+
+	struct BulkJob
+	{
+		QString id;
+		QString bucket;
+		bool isGet;
+		uint64_t size;
+		QList<Blob> blobs;
+		// Index of each blob by object name and offset
+		QHash<QPair<QString, quint64>, int> blobIndex;
+		QList<Chunk> chunks;
+		int numChunkRequests;
+	};
+
+	struct Request
+	{
+		QString method;
+		QString path;
+		QHash<QString, QString> query;
+		QHash<QString, QString> headers;
+		uint64_t contentLength;
+	};
+
+	struct Response
+	{
+		int status;
+		QByteArray body;
+		QList<QByteArray> headers;
+	};
+
+	friend class MockDS3Connection;
+	friend class MockDS3Listener;
+
+	bool IsStopping() const;
+
+	void HandleRequest(MockDS3Connection* connection, const Request& request);
+	Response GetService();
+	Response GetBucket(const QString& bucket, const Request& request);
+	// Search a bucket's object names with a name that, like SQL LIKE,
+	// matches any run of characters with %
+	Response GetObjects(const Request& request);
+	Response PutBucket(const QString& bucket);
+	Response DeleteObject(const QString& bucket, const QString& object);
+	Response Bulk(const QString& bucket, const Request& request,
+		      const QByteArray& body);
+	Response GetAvailableChunks(const Request& request);
+	Response GetJob(const QString& jobID);
+	Response Error(int status, const QString& code,
+		       const QString& message) const;
+	QByteArray ToMasterObjectList(const BulkJob& job,
+				      const QList<int>& chunks) const;
+	// The blob of a job that an object request is for or -1
+	int FindBlob(const BulkJob& job, const QString& name, uint64_t offset) const;
+	void FinishBlob(const QString& jobID, int blob);
+	void CountRequest(const QString& operation);
+
+	// Sleep as long as it takes for a connection that has transferred
+	// streamBytes since streamTimer started to transfer bytes more
+	// without exceeding the bandwidth limits
+	void Throttle(const QElapsedTimer& streamTimer, uint64_t* streamBytes,
+		      uint64_t bytes);
+
+	mutable QMutex m_lock;
+	QWaitCondition m_started;
+	quint16 m_port;
+	bool m_listening;
+	QAtomicInt m_stopping;
+
+	QMap<QString, QMap<QString, uint64_t> > m_buckets;
+	// The data of the objects added with AddObjectData, by bucket and
+	// name
+	QHash<QPair<QString, QString>, QByteArray> m_objectData;
+	// Every object's last modified time so listings of unchanged
+	// objects are the same every time
+	QString m_lastModified;
+	QHash<QString, BulkJob> m_jobs;
+	int m_maxKeys;
+	uint64_t m_chunkSize;
+	int m_retryResponses;
+	int m_retryAfter;
+	QHash<QString, int> m_numRequests;
+	uint64_t m_numBytesReceived;
+	uint64_t m_numBytesSent;
+	Session::ChecksumType m_etagType;
+	bool m_etagsCorrupt;
+
+	uint64_t m_streamRate;
+	uint64_t m_linkRate;
+	QElapsedTimer m_clock;
+	// When, in microseconds on m_clock, the link is done with the bytes
+	// that were scheduled on it so far
+	qint64 m_linkBusyUntil;
+};
+
+inline char
+MockDS3Server::GetObjectByte(uint64_t offset)
+{
+	return (char)(offset % 251);
+}
+
+#endif
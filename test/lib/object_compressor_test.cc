@@ -0,0 +1,209 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+
+#include "lib/executor.h"
+#include "lib/object_compressor.h"
+#include "lib/object_compressor_test.h"
+#include "lib/object_decompressor.h"
+
+static ObjectCompressorTest instance;
+
+// Decompress all of data at once
+static bool
+decompress(const QByteArray& data, QByteArray* result)
+{
+	QBuffer buffer(result);
+	buffer.open(QIODevice::WriteOnly);
+	ObjectDecompressor decompressor(&buffer);
+	return decompressor.Write(data.constData(), data.size()) &&
+	       decompressor.Finish();
+}
+
+QString
+ObjectCompressorTest::WriteFile(const QString& name, const QByteArray& data)
+{
+	QString filePath = QDir(m_dir.path()).filePath(name);
+	QFile file(filePath);
+	file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	file.write(data);
+	file.close();
+	return filePath;
+}
+
+QByteArray
+ObjectCompressorTest::ReadAll(ObjectCompressor* compressor)
+{
+	QByteArray result;
+	char buffer[10000];
+	qint64 numRead;
+	while ((numRead = compressor->Read(buffer, sizeof(buffer))) > 0) {
+		result.append(buffer, numRead);
+	}
+	return numRead == 0 ? result : QByteArray();
+}
+
+void
+ObjectCompressorTest::initTestCase()
+{
+	m_executor = new Executor("test", 4);
+	// Compressible, but not trivially so, and not a multiple of the
+	// block size
+	qint64 size = 3 * ObjectCompressor::BLOCK_SIZE + 12345;
+	m_data.reserve(size);
+	for (qint64 i = 0; m_data.size() < size; i++) {
+		m_data.append(QByteArray::number(i * 7919 % 100003));
+		m_data.append(i % 13 == 0 ? '\n' : ' ');
+	}
+	m_data.truncate(size);
+	m_filePath = WriteFile("data", m_data);
+
+	ObjectCompressor compressor(m_filePath, m_executor);
+	m_compressed = ReadAll(&compressor);
+	QVERIFY(!m_compressed.isEmpty());
+	QVERIFY(m_compressed.size() < m_data.size());
+}
+
+void
+ObjectCompressorTest::cleanupTestCase()
+{
+	delete m_executor;
+}
+
+void
+ObjectCompressorTest::TestNames()
+{
+	QString name = "dir/file.txt" + ObjectCompressor::SUFFIX;
+	QVERIFY(ObjectCompressor::IsCompressed(name));
+	QVERIFY(!ObjectCompressor::IsCompressed("dir/file.txt"));
+	QCOMPARE(ObjectCompressor::RemoveSuffix(name), QString("dir/file.txt"));
+	QCOMPARE(ObjectCompressor::RemoveSuffix("dir/file.txt"),
+		 QString("dir/file.txt"));
+}
+
+void
+ObjectCompressorTest::TestCompressedSize()
+{
+	ObjectCompressor compressor(m_filePath, m_executor);
+	uint64_t size;
+	QVERIFY(compressor.GetCompressedSize(&size));
+	QCOMPARE(size, (uint64_t)m_compressed.size());
+
+	ObjectCompressor missing(QDir(m_dir.path()).filePath("missing"),
+				 m_executor);
+	QVERIFY(!missing.GetCompressedSize(&size));
+}
+
+void
+ObjectCompressorTest::TestRoundTrip()
+{
+	QByteArray result;
+	QVERIFY(decompress(m_compressed, &result));
+	QCOMPARE(result.size(), m_data.size());
+	QVERIFY(result == m_data);
+}
+
+void
+ObjectCompressorTest::TestSeek()
+{
+	QList<qint64> offsets;
+	offsets << 0 << 1 << m_compressed.size() / 3
+		<< m_compressed.size() / 2 << m_compressed.size() - 1
+		<< m_compressed.size();
+	for (int i = 0; i < offsets.size(); i++) {
+		ObjectCompressor compressor(m_filePath, m_executor);
+		QVERIFY(compressor.Seek(offsets[i]));
+		QCOMPARE(ReadAll(&compressor), m_compressed.mid(offsets[i]));
+	}
+}
+
+void
+ObjectCompressorTest::TestBlockSizes()
+{
+	ObjectCompressor measured(m_filePath, m_executor);
+	uint64_t size;
+	QVERIFY(measured.GetCompressedSize(&size));
+	QList<qint64> blockSizes = measured.GetBlockSizes();
+	QCOMPARE(blockSizes.size(), 4);
+
+	// A file that only differs in its first block.  Seeking past that
+	// block with the sizes measured above mustn't compress it again.
+	QByteArray changed = m_data;
+	changed.replace(0, ObjectCompressor::BLOCK_SIZE,
+			QByteArray(ObjectCompressor::BLOCK_SIZE, '\0'));
+	QString filePath = WriteFile("changed", changed);
+	uint64_t offset = size - blockSizes.last() / 2;
+	ObjectCompressor compressor(filePath, m_executor);
+	compressor.SetBlockSizes(blockSizes);
+	QVERIFY(compressor.Seek(offset));
+	QCOMPARE(ReadAll(&compressor), m_compressed.mid(offset));
+}
+
+void
+ObjectCompressorTest::TestDecompressInPieces()
+{
+	QByteArray result;
+	QBuffer buffer(&result);
+	buffer.open(QIODevice::WriteOnly);
+	ObjectDecompressor decompressor(&buffer);
+	// Odd sized pieces so gzip headers and trailers get split
+	for (int pos = 0; pos < m_compressed.size(); pos += 997) {
+		QByteArray piece = m_compressed.mid(pos, 997);
+		QVERIFY(decompressor.Write(piece.constData(), piece.size()));
+	}
+	QVERIFY(decompressor.Finish());
+	QVERIFY(result == m_data);
+}
+
+void
+ObjectCompressorTest::TestDecompressFile()
+{
+	QString source = WriteFile("data" + ObjectCompressor::SUFFIX +
+				   ObjectDecompressor::PART_SUFFIX, m_compressed);
+	QString destination = QDir(m_dir.path()).filePath("decompressed");
+	QVERIFY(ObjectDecompressor::DecompressFile(source, destination));
+	QFile file(destination);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QVERIFY(file.readAll() == m_data);
+}
+
+void
+ObjectCompressorTest::TestTruncated()
+{
+	QByteArray result;
+	QVERIFY(!decompress(m_compressed.left(m_compressed.size() - 10),
+			    &result));
+	QByteArray corrupt = m_compressed;
+	corrupt[corrupt.size() / 2] = ~corrupt[corrupt.size() / 2];
+	QVERIFY(!decompress(corrupt, &result));
+}
+
+void
+ObjectCompressorTest::TestEmptyFile()
+{
+	QString filePath = WriteFile("empty", QByteArray());
+	ObjectCompressor compressor(filePath, m_executor);
+	uint64_t size;
+	QVERIFY(compressor.GetCompressedSize(&size));
+	QByteArray compressed = ReadAll(&compressor);
+	QCOMPARE(size, (uint64_t)compressed.size());
+	QByteArray result;
+	QVERIFY(decompress(compressed, &result));
+	QVERIFY(result.isEmpty());
+}
@@ -0,0 +1,58 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef OBJECT_COMPRESSOR_TEST_H
+#define OBJECT_COMPRESSOR_TEST_H
+
+#include <QByteArray>
+#include <QTemporaryDir>
+
+#include "test.h"
+
+class Executor;
+class ObjectCompressor;
+
+class ObjectCompressorTest : public Test
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_dir;
+	Executor* m_executor;
+	// A few blocks of compressible data and its compressed form
+	QString m_filePath;
+	QByteArray m_data;
+	QByteArray m_compressed;
+
+	QString WriteFile(const QString& name, const QByteArray& data);
+	QByteArray ReadAll(ObjectCompressor* compressor);
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void TestNames();
+	void TestCompressedSize();
+	void TestRoundTrip();
+	void TestSeek();
+	void TestBlockSizes();
+	void TestDecompressInPieces();
+	void TestDecompressFile();
+	void TestTruncated();
+	void TestEmptyFile();
+};
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <string.h>
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "lib/object_work_item_test.h"
+#include "lib/checksum.h"
+#include "lib/work_items/object_work_item.h"
+
+static ObjectWorkItemTest instance;
+
+// libcurl hands at most this many bytes to a read/write callback at once
+static const size_t CALLBACK_SIZE = 16 * 1024;
+static const int FILE_SIZE = 64 * 1024 * 1024;
+
+void
+ObjectWorkItemTest::initTestCase()
+{
+	m_data.resize(FILE_SIZE);
+	for (int i = 0; i < m_data.size(); i++) {
+		m_data[i] = (char)(i % 251);
+	}
+	QVERIFY(m_file.open());
+	QCOMPARE(m_file.write(m_data), (qint64)m_data.size());
+	m_file.close();
+}
+
+void
+ObjectWorkItemTest::TestMappedReadFile()
+{
+	uint64_t offset = 1000;
+	uint64_t length = 100000;
+	ObjectWorkItem workItem("bucket", "object", m_file.fileName());
+	QVERIFY(workItem.OpenFile(QIODevice::ReadOnly));
+	QVERIFY(workItem.MapFile(offset, length));
+	QVERIFY(workItem.IsFileMapped());
+
+	QByteArray read;
+	char buffer[CALLBACK_SIZE];
+	size_t bytesRead;
+	while ((bytesRead = workItem.ReadFile(buffer, 1, CALLBACK_SIZE)) > 0) {
+		read.append(buffer, bytesRead);
+	}
+	QCOMPARE(read, m_data.mid(offset, length));
+}
+
+void
+ObjectWorkItemTest::TestMappedWriteFile()
+{
+	QTemporaryDir dir;
+	QString fileName = QDir(dir.path()).filePath("object");
+	uint64_t offset = 4096;
+	uint64_t length = 3 * CALLBACK_SIZE + 10;
+	{
+		ObjectWorkItem workItem("bucket", "object", fileName);
+		QVERIFY(workItem.OpenFile(QIODevice::ReadWrite));
+		QVERIFY(workItem.MapFile(offset, length));
+		for (uint64_t pos = 0; pos < length; pos += CALLBACK_SIZE) {
+			size_t count = qMin((uint64_t)CALLBACK_SIZE, length - pos);
+			QCOMPARE(workItem.WriteFile(m_data.data() + pos, 1, count),
+				 count);
+		}
+		// Nothing past the end of the object may be written
+		QCOMPARE(workItem.WriteFile(m_data.data(), 1, 1), (size_t)0);
+	}
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QCOMPARE(file.size(), (qint64)(offset + length));
+	file.seek(offset);
+	QCOMPARE(file.readAll(), m_data.left(length));
+}
+
+void
+ObjectWorkItemTest::TestComputeChecksum()
+{
+	uint64_t offset = 1000;
+	uint64_t length = 3 * ObjectWorkItem::CHECKSUM_BUFFER_SIZE + 10;
+	uint32_t expected = Checksum::Crc32c(0, m_data.constData() + offset,
+					     length);
+	for (int mapped = 0; mapped < 2; mapped++) {
+		ObjectWorkItem workItem("bucket", "object", m_file.fileName());
+		QVERIFY(workItem.OpenFile(QIODevice::ReadOnly));
+		if (mapped) {
+			QVERIFY(workItem.MapFile(offset, length));
+		} else {
+			QVERIFY(workItem.SeekFile(offset));
+		}
+		Checksum checksum(Session::CRC32C_CHECKSUM);
+		QVERIFY(workItem.ComputeChecksum(&checksum, length));
+		QCOMPARE(checksum.GetResult().toHex().toUInt(NULL, 16), expected);
+
+		// The blob is still read from its start
+		char buffer[CALLBACK_SIZE];
+		QCOMPARE(workItem.ReadFile(buffer, 1, CALLBACK_SIZE), CALLBACK_SIZE);
+		QVERIFY(memcmp(buffer, m_data.constData() + offset,
+			       CALLBACK_SIZE) == 0);
+
+		// Past the end of the file
+		Checksum tooLong(Session::CRC32C_CHECKSUM);
+		QVERIFY(!workItem.ComputeChecksum(&tooLong, FILE_SIZE));
+	}
+}
+
+void
+ObjectWorkItemTest::BenchmarkReadFile_data()
+{
+	QTest::addColumn<bool>("mapped");
+	QTest::newRow("buffered") << false;
+	QTest::newRow("mapped") << true;
+}
+
+void
+ObjectWorkItemTest::BenchmarkReadFile()
+{
+	QFETCH(bool, mapped);
+	char buffer[CALLBACK_SIZE];
+	QBENCHMARK {
+		ObjectWorkItem workItem("bucket", "object", m_file.fileName());
+		workItem.OpenFile(QIODevice::ReadOnly);
+		if (mapped) {
+			QVERIFY(workItem.MapFile(0, FILE_SIZE));
+		}
+		while (workItem.ReadFile(buffer, 1, CALLBACK_SIZE) > 0) {
+		}
+	}
+}
+
+void
+ObjectWorkItemTest::BenchmarkWriteFile_data()
+{
+	BenchmarkReadFile_data();
+}
+
+void
+ObjectWorkItemTest::BenchmarkWriteFile()
+{
+	QFETCH(bool, mapped);
+	QTemporaryDir dir;
+	QString fileName = QDir(dir.path()).filePath("object");
+	QBENCHMARK {
+		ObjectWorkItem workItem("bucket", "object", fileName);
+		workItem.OpenFile(QIODevice::ReadWrite);
+		if (mapped) {
+			QVERIFY(workItem.MapFile(0, FILE_SIZE));
+		}
+		for (int pos = 0; pos < FILE_SIZE; pos += CALLBACK_SIZE) {
+			workItem.WriteFile(m_data.data() + pos, 1, CALLBACK_SIZE);
+		}
+	}
+}
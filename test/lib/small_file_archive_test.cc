@@ -0,0 +1,157 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "lib/small_file_archive_test.h"
+#include "lib/small_file_archive.h"
+
+static SmallFileArchiveTest instance;
+
+// Member name -> contents
+static QMap<QString, QByteArray>
+expected_members()
+{
+	QMap<QString, QByteArray> members;
+	members["empty"] = QByteArray();
+	members["one.txt"] = "one";
+	members["sub/dir/deep.bin"] = QByteArray(40000, '\x7f');
+	members[QString::fromUtf8("sub/\xc3\xbcnicode")] = "unicode";
+	return members;
+}
+
+void
+SmallFileArchiveTest::initTestCase()
+{
+	QDir files(m_dir.path());
+	QVERIFY(files.mkpath("files"));
+	QVERIFY(files.cd("files"));
+	SmallFileArchive archive(QDir(m_dir.path()).filePath("archive.zip"));
+	QVERIFY(archive.Open());
+	QMap<QString, QByteArray> members = expected_members();
+	QMap<QString, QByteArray>::const_iterator mi;
+	for (mi = members.constBegin(); mi != members.constEnd(); mi++) {
+		QString filePath = files.filePath(QString::number(archive.GetNumMembers()));
+		QFile file(filePath);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(mi.value());
+		file.close();
+		QVERIFY(archive.Add(mi.key(), filePath));
+	}
+	QCOMPARE(archive.GetNumMembers(), members.size());
+	QVERIFY(archive.Close());
+	QCOMPARE((qint64)archive.GetSize(), QFileInfo(archive.GetPath()).size());
+	QVERIFY(QFileInfo(archive.GetIndexPath()).exists());
+}
+
+void
+SmallFileArchiveTest::TestNames()
+{
+	QString name = SmallFileArchive::CreateObjectName("dir/");
+	QVERIFY(name.startsWith("dir/" + SmallFileArchive::NAME_PREFIX));
+	QVERIFY(SmallFileArchive::IsArchive(name));
+	QVERIFY(!SmallFileArchive::IsIndex(name));
+	QVERIFY(SmallFileArchive::IsIndex(name + SmallFileArchive::INDEX_SUFFIX));
+	QVERIFY(!SmallFileArchive::IsArchive(name + SmallFileArchive::INDEX_SUFFIX));
+	QCOMPARE(SmallFileArchive::GetArchiveName(name + SmallFileArchive::INDEX_SUFFIX),
+		 name);
+	QVERIFY(name != SmallFileArchive::CreateObjectName("dir/"));
+
+	QVERIFY(!SmallFileArchive::IsArchive("dir/photos.zip"));
+	QVERIFY(!SmallFileArchive::IsArchive(SmallFileArchive::NAME_PREFIX + "x.zip/file"));
+}
+
+void
+SmallFileArchiveTest::TestCanPack()
+{
+	QVERIFY(SmallFileArchive::CanPack("a", 0));
+	QVERIFY(SmallFileArchive::CanPack("a", SmallFileArchive::MAX_MEMBER_SIZE - 1));
+	QVERIFY(!SmallFileArchive::CanPack("a", SmallFileArchive::MAX_MEMBER_SIZE));
+	QVERIFY(!SmallFileArchive::CanPack("a\tb", 1));
+	QVERIFY(!SmallFileArchive::CanPack("a\nb", 1));
+}
+
+void
+SmallFileArchiveTest::TestExtractMember()
+{
+	QFile archive(QDir(m_dir.path()).filePath("archive.zip"));
+	QVERIFY(archive.open(QIODevice::ReadOnly));
+	QByteArray data = archive.readAll();
+	QFile index(archive.fileName() + SmallFileArchive::INDEX_SUFFIX);
+	QVERIFY(index.open(QIODevice::ReadOnly));
+	QByteArray indexData = index.readAll();
+	QList<SmallFileArchive::Member> members;
+	QVERIFY(SmallFileArchive::ReadIndex(indexData, &members));
+	QMap<QString, QByteArray> expected = expected_members();
+	QCOMPARE(members.size(), expected.size());
+	QList<SmallFileArchive::Member> truncated;
+	QVERIFY(!SmallFileArchive::ReadIndex(indexData.left(indexData.size() - 1),
+					     &truncated));
+
+	QTemporaryDir dir;
+	for (int i = 0; i < members.size(); i++) {
+		const SmallFileArchive::Member& member = members[i];
+		QVERIFY(expected.contains(member.name));
+		QString fileName = QDir(dir.path()).filePath(QString::number(i));
+		QVERIFY(SmallFileArchive::ExtractMember(data, 0, member, fileName));
+		QFile file(fileName);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QCOMPARE(file.readAll(), expected[member.name]);
+		file.close();
+
+		// Just the member's byte range, as a ranged GET reads it
+		QByteArray range = data.mid(member.offset, member.size);
+		QVERIFY(SmallFileArchive::ExtractMember(range, member.offset,
+							member, fileName));
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QCOMPARE(file.readAll(), expected[member.name]);
+		if (member.size > 0) {
+			QVERIFY(!SmallFileArchive::ExtractMember(range.left(range.size() - 1),
+								 member.offset,
+								 member, fileName));
+		}
+	}
+}
+
+void
+SmallFileArchiveTest::TestExtract()
+{
+	QString archivePath = QDir(m_dir.path()).filePath("archive.zip");
+	QTemporaryDir dir;
+	QDir root(dir.path());
+	QFile existing(root.filePath("one.txt"));
+	QVERIFY(existing.open(QIODevice::WriteOnly));
+	existing.write("keep");
+	existing.close();
+
+	QStringList skipped;
+	QVERIFY(SmallFileArchive::Extract(archivePath, dir.path(), &skipped));
+	QCOMPARE(skipped, QStringList() << "one.txt");
+
+	QMap<QString, QByteArray> expected = expected_members();
+	expected["one.txt"] = "keep";
+	QMap<QString, QByteArray>::const_iterator mi;
+	for (mi = expected.constBegin(); mi != expected.constEnd(); mi++) {
+		QFile file(root.filePath(mi.key()));
+		QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(mi.key()));
+		QCOMPARE(file.readAll(), mi.value());
+	}
+}
@@ -0,0 +1,173 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDir>
+#include <QFile>
+
+#include "lib/sync_manifest.h"
+#include "lib/sync_manifest_test.h"
+
+static SyncManifestTest instance;
+
+QString
+SyncManifestTest::WriteFile(const QString& name, const QByteArray& data)
+{
+	QString filePath = QDir(m_dir.path()).filePath(name);
+	QFile file(filePath);
+	file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	file.write(data);
+	file.close();
+	return filePath;
+}
+
+void
+SyncManifestTest::TestGetPath()
+{
+	QString path = SyncManifest::GetPath("host", "bucket", "dir/");
+	QVERIFY(path.startsWith(SyncManifest::GetDir()));
+	QCOMPARE(SyncManifest::GetPath("host", "bucket", "dir/"), path);
+	QVERIFY(SyncManifest::GetPath("host", "bucket", "other/") != path);
+	QVERIFY(SyncManifest::GetPath("host", "other", "dir/") != path);
+	QVERIFY(SyncManifest::GetPath("other", "bucket", "dir/") != path);
+}
+
+void
+SyncManifestTest::TestCompare()
+{
+	QString path = QDir(m_dir.path()).filePath("compare.manifest");
+	{
+		SyncManifest manifest(path, false);
+		QVERIFY(manifest.Open());
+		QCOMPARE(manifest.Compare("a", "", 10, 1000), SyncManifest::NEW);
+		QCOMPARE(manifest.Compare("b", "", 20, 2000), SyncManifest::NEW);
+		QCOMPARE(manifest.Compare("sub/c", "", 30, 3000), SyncManifest::NEW);
+		manifest.Commit("a");
+		manifest.Commit("b");
+		manifest.Commit("sub/c");
+	}
+
+	// The records are kept when the manifest is reopened
+	SyncManifest manifest(path, false);
+	QVERIFY(manifest.Open());
+	QCOMPARE(manifest.Compare("a", "", 10, 1000), SyncManifest::UNCHANGED);
+	QCOMPARE(manifest.Compare("b", "", 21, 2000), SyncManifest::CHANGED);
+	QCOMPARE(manifest.Compare("sub/c", "", 30, 3001), SyncManifest::CHANGED);
+	QCOMPARE(manifest.Compare("d", "", 0, 0), SyncManifest::NEW);
+	QCOMPARE(manifest.GetNumUnchanged(), 1);
+	manifest.Commit("b");
+	manifest.Commit("sub/c");
+	QVERIFY(manifest.Flush());
+
+	// and updated to the committed files' latest state
+	QCOMPARE(manifest.Compare("b", "", 21, 2000), SyncManifest::UNCHANGED);
+	QCOMPARE(manifest.Compare("sub/c", "", 30, 3001), SyncManifest::UNCHANGED);
+	QCOMPARE(manifest.Compare("d", "", 0, 0), SyncManifest::NEW);
+}
+
+void
+SyncManifestTest::TestUncommitted()
+{
+	QString path = QDir(m_dir.path()).filePath("uncommitted.manifest");
+	{
+		SyncManifest manifest(path, false);
+		QVERIFY(manifest.Open());
+		manifest.Compare("a", "", 10, 1000);
+		manifest.Commit("a");
+	}
+
+	// Files that weren't sent keep their old records
+	{
+		SyncManifest manifest(path, false);
+		QVERIFY(manifest.Open());
+		QCOMPARE(manifest.Compare("a", "", 11, 1001), SyncManifest::CHANGED);
+		QCOMPARE(manifest.Compare("b", "", 20, 2000), SyncManifest::NEW);
+		manifest.Discard("a");
+	}
+
+	SyncManifest manifest(path, false);
+	QVERIFY(manifest.Open());
+	QCOMPARE(manifest.Compare("a", "", 11, 1001), SyncManifest::CHANGED);
+	QCOMPARE(manifest.Compare("b", "", 20, 2000), SyncManifest::NEW);
+	QCOMPARE(manifest.Compare("a", "", 10, 1000), SyncManifest::UNCHANGED);
+}
+
+void
+SyncManifestTest::TestCompareContents()
+{
+	QString filePath = WriteFile("contents", "contents");
+	QString path = QDir(m_dir.path()).filePath("contents.manifest");
+	SyncManifest manifest(path, true);
+	QVERIFY(manifest.Open());
+	QCOMPARE(manifest.Compare("contents", filePath, 8, 1000),
+		 SyncManifest::NEW);
+	manifest.Commit("contents");
+	QVERIFY(manifest.Flush());
+
+	// Touched but not changed
+	QCOMPARE(manifest.Compare("contents", filePath, 8, 2000),
+		 SyncManifest::UNCHANGED);
+	manifest.Commit("contents");
+	QVERIFY(manifest.Flush());
+
+	WriteFile("contents", "CONTENTS");
+	QCOMPARE(manifest.Compare("contents", filePath, 8, 3000),
+		 SyncManifest::CHANGED);
+}
+
+void
+SyncManifestTest::TestServerObjects()
+{
+	QString path = QDir(m_dir.path()).filePath("server.manifest");
+	SyncManifest manifest(path, false);
+	QVERIFY(manifest.Open());
+	manifest.AddServerObject("dir/", 0);
+	manifest.AddServerObject("dir/a", 10);
+	uint64_t size;
+	QVERIFY(manifest.GetServerObjectSize("dir/a", &size));
+	QCOMPARE(size, (uint64_t)10);
+	QVERIFY(manifest.GetServerObjectSize("dir/", &size));
+	QVERIFY(!manifest.GetServerObjectSize("dir/b", &size));
+
+	manifest.ClearServerObjects();
+	QVERIFY(!manifest.GetServerObjectSize("dir/a", &size));
+}
+
+void
+SyncManifestTest::TestManyFiles()
+{
+	// More than can be buffered at once
+	int numFiles = 3 * SyncManifest::FLUSH_ROWS + 1;
+	QString path = QDir(m_dir.path()).filePath("many.manifest");
+	{
+		SyncManifest manifest(path, false);
+		QVERIFY(manifest.Open());
+		for (int i = 0; i < numFiles; i++) {
+			manifest.AddServerObject("dir/" + QString::number(i), i);
+			manifest.Compare(QString::number(i), "", i, i);
+			manifest.Commit(QString::number(i));
+		}
+	}
+
+	SyncManifest manifest(path, false);
+	QVERIFY(manifest.Open());
+	for (int i = 0; i < numFiles; i++) {
+		manifest.Compare(QString::number(i), "", i, i % 2 ? i : i + 1);
+	}
+	QCOMPARE(manifest.GetNumUnchanged(), numFiles / 2);
+	uint64_t size;
+	QVERIFY(manifest.GetServerObjectSize("dir/" + QString::number(numFiles - 1), &size));
+	QCOMPARE(size, (uint64_t)numFiles - 1);
+}
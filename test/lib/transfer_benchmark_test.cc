@@ -0,0 +1,132 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <stdint.h>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QTemporaryDir>
+#include <QUrl>
+
+#include "lib/transfer_benchmark_test.h"
+#include "lib/client.h"
+#include "lib/mock_ds3_server.h"
+#include "models/ds3_url.h"
+
+static TransferBenchmarkTest instance;
+
+static const uint64_t KB = 1024;
+static const uint64_t MB = 1024 * KB;
+static const uint64_t GB = 1024 * MB;
+// The longest a workload may take, in milliseconds
+static const int WORKLOAD_TIMEOUT = 24 * 60 * 60 * 1000;
+
+static void
+add_workload(const QString& name, int numObjects, uint64_t objectSize,
+	     Session::ChecksumType checksumType = Session::NO_CHECKSUM)
+{
+	QTest::newRow(qPrintable("PUT " + name)) << false << numObjects
+						 << (qulonglong)objectSize
+						 << (int)checksumType;
+	QTest::newRow(qPrintable("GET " + name)) << true << numObjects
+						 << (qulonglong)objectSize
+						 << (int)checksumType;
+}
+
+void
+TransferBenchmarkTest::BenchmarkTransfer_data()
+{
+	QTest::addColumn<bool>("isGet");
+	QTest::addColumn<int>("numObjects");
+	QTest::addColumn<qulonglong>("objectSize");
+	QTest::addColumn<int>("checksumType");
+
+	add_workload("1000 x 4KB", 1000, 4 * KB);
+	add_workload("4 x 64MB", 4, 64 * MB);
+	add_workload("4 x 64MB CRC32C", 4, 64 * MB, Session::CRC32C_CHECKSUM);
+	add_workload("4 x 64MB MD5", 4, 64 * MB, Session::MD5_CHECKSUM);
+	if (!qgetenv("DS3_BROWSER_FULL_BENCHMARKS").isEmpty()) {
+		add_workload("1M x 4KB", 1000000, 4 * KB);
+		add_workload("10 x 50GB", 10, 50 * GB);
+	}
+}
+
+void
+TransferBenchmarkTest::BenchmarkTransfer()
+{
+	QFETCH(bool, isGet);
+	QFETCH(int, numObjects);
+	QFETCH(qulonglong, objectSize);
+	QFETCH(int, checksumType);
+
+	MockDS3Server server;
+	QVERIFY(server.Start());
+	server.AddBucket("bench");
+	server.SetETagType((Session::ChecksumType)checksumType);
+	Session session = server.GetSession();
+	session.SetChecksumType(checksumType);
+	Client client(&session);
+
+	QTemporaryDir dir;
+	QList<QUrl> urls;
+	if (isGet) {
+		for (int i = 0; i < numObjects; i++) {
+			server.AddObject("bench", "objects/" + QString::number(i),
+					 objectSize);
+		}
+		urls << DS3URL(client.GetEndpoint(), "/bench/objects/");
+	} else {
+		// Sparse files so setting up doesn't take longer than the
+		// transfer
+		QDir objects(dir.path());
+		objects.mkdir("objects");
+		objects.cd("objects");
+		for (int i = 0; i < numObjects; i++) {
+			QFile file(objects.filePath(QString::number(i)));
+			QVERIFY(file.open(QIODevice::WriteOnly));
+			QVERIFY(file.resize(objectSize));
+		}
+		urls << QUrl::fromLocalFile(objects.path());
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	if (isGet) {
+		client.BulkGet(urls, dir.path() + "/get");
+	} else {
+		client.BulkPut("bench", "", urls);
+	}
+	Job job;
+	QVERIFY(MockDS3Server::WaitForJob(&client, WORKLOAD_TIMEOUT, &job));
+	qint64 total = timer.elapsed();
+	QVERIFY(job.IsFinished());
+
+	uint64_t numBytes = (uint64_t)numObjects * objectSize;
+	QCOMPARE(isGet ? server.GetNumBytesSent() : server.GetNumBytesReceived(),
+		 numBytes);
+
+	// Job updates reach the GUI thread up to one publish interval late
+	qint64 prep = job.GetStart().msecsTo(job.GetTransferStart());
+	qint64 transfer = qMax((qint64)1, total - prep);
+	double seconds = total / 1000.0;
+	qDebug() << QTest::currentDataTag() << ":"
+		 << qPrintable(QString::number(numObjects / seconds, 'f', 1)) << "objects/s,"
+		 << qPrintable(QString::number(numBytes / MB / seconds, 'f', 1)) << "MB/s,"
+		 << "prep" << prep << "ms, transfer" << transfer << "ms";
+	QTest::setBenchmarkResult(numBytes / seconds, QTest::BytesPerSecond);
+}
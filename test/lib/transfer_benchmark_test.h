@@ -0,0 +1,37 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#ifndef TRANSFER_BENCHMARK_TEST_H
+#define TRANSFER_BENCHMARK_TEST_H
+
+#include "test.h"
+
+// End to end bulk transfer benchmarks through Client against a
+// MockDS3Server.  Each workload reports objects/s, MB/s and how long the
+// job spent preparing its first page versus transferring.  The full size
+// workloads, e.g. 1M x 4KB and 10 x 50GB, need that much local disk space
+// and only run if DS3_BROWSER_FULL_BENCHMARKS is set.  The checksum
+// workloads show what computing and verifying blob checksums costs.
+class TransferBenchmarkTest : public Test
+{
+	Q_OBJECT
+
+private slots:
+	void BenchmarkTransfer_data();
+	void BenchmarkTransfer();
+};
+
+#endif
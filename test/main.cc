@@ -15,13 +15,26 @@
  */
 
 #include <qDebug>
+#include <QApplication>
+#include <QStandardPaths>
 #include <QTest>
 
 #include "test.h"
+#include "views/console.h"
 
 int
-main(int /*argc*/, char** /*argv[]*/)
+main(int argc, char** argv)
 {
+	// Code under test logs to the Console widget
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QApplication app(argc, argv);
+	QStandardPaths::setTestModeEnabled(true);
+	// Create it in the main thread before any code under test logs from
+	// another thread
+	Console::Instance();
+
 	int failed = 0;
 
 	for (int i = 0; i < Test::s_tests.size(); i++) {
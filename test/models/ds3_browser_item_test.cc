@@ -0,0 +1,257 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QDateTime>
+#include <QList>
+#include <QVariant>
+
+#include "models/ds3_browser_item_test.h"
+#include "models/ds3_browser_item.h"
+
+static DS3BrowserItemTest instance;
+
+// Objects that BenchmarkListing adds to the bucket, about as many as the
+// largest buckets that the browser has to show
+static const int NUM_OBJECTS = 1000000;
+
+void
+DS3BrowserItemTest::TestAppendChild()
+{
+	DS3BrowserItem bucket("books", "");
+	qint64 created = DS3BrowserItem::ToTimestamp("2015-06-01T10:30:00.000Z");
+	bucket.AppendChild(DS3BrowserItem::FOLDER, "fiction", "alice");
+	bucket.AppendChild(DS3BrowserItem::OBJECT, "ulysses.txt", "alice",
+			   2048, created);
+	bucket.AppendChild(DS3BrowserItem::OBJECT, "empty", "bob", 0);
+	bucket.AppendChild(DS3BrowserItem::PAGE_BREAK);
+
+	QCOMPARE(bucket.GetChildCount(), 4);
+	QCOMPARE(bucket.GetChildKind(0), DS3BrowserItem::FOLDER);
+	QVERIFY(bucket.IsChildBucketOrFolder(0));
+	QVERIFY(!bucket.IsChildBucketOrFolder(1));
+
+	QCOMPARE(bucket.GetChildData(0, DS3BrowserItem::NAME).toString(), QString("fiction"));
+	QCOMPARE(bucket.GetChildData(0, DS3BrowserItem::SIZE_COL).toString(), QString("--"));
+	QCOMPARE(bucket.GetChildData(0, DS3BrowserItem::KIND).toString(), QString("Folder"));
+	QCOMPARE(bucket.GetChildData(0, DS3BrowserItem::CREATED).toString(), QString("--"));
+
+	QCOMPARE(bucket.GetChildData(1, DS3BrowserItem::NAME).toString(), QString("ulysses.txt"));
+	QCOMPARE(bucket.GetChildData(1, DS3BrowserItem::OWNER).toString(), QString("alice"));
+	QCOMPARE(bucket.GetChildData(1, DS3BrowserItem::SIZE_COL).toString(), QString("2 KB"));
+	QCOMPARE(bucket.GetChildData(1, DS3BrowserItem::KIND).toString(), QString("Object"));
+	QCOMPARE(bucket.GetChildData(1, DS3BrowserItem::CREATED).toString(),
+		 QString("June 1, 2015 10:30 AM"));
+	QCOMPARE(bucket.GetChildFullName(1), QString("ulysses.txt"));
+	QCOMPARE(bucket.GetChildPath(1), QString("/books/ulysses.txt"));
+
+	QCOMPARE(bucket.GetChildData(2, DS3BrowserItem::OWNER).toString(), QString("bob"));
+	QCOMPARE(bucket.GetChildData(2, DS3BrowserItem::SIZE_COL).toString(), QString("0 Bytes"));
+	QCOMPARE(bucket.GetChildData(2, DS3BrowserItem::CREATED).toString(), QString("--"));
+
+	QCOMPARE(bucket.GetChildData(3, DS3BrowserItem::NAME).toString(),
+		 QString("Click to load more"));
+	QVERIFY(!bucket.GetChildData(3, DS3BrowserItem::KIND).isValid());
+
+	QCOMPARE(DS3BrowserItem::ToTimestamp("not a timestamp"),
+		 DS3BrowserItem::NO_TIMESTAMP);
+}
+
+void
+DS3BrowserItemTest::TestRemoveChild()
+{
+	DS3BrowserItem root;
+	root.AppendChild(DS3BrowserItem::BUCKET, "a", "alice");
+	root.AppendChild(DS3BrowserItem::LOADING);
+	root.AppendChild(DS3BrowserItem::BUCKET, "b", "alice");
+	DS3BrowserItem* b = root.GetChildItem(2);
+	QCOMPARE(b->GetRow(), 2);
+
+	root.RemoveChild(1);
+	QCOMPARE(root.GetChildCount(), 2);
+	QCOMPARE(root.GetChildName(1), QString("b"));
+	QCOMPARE(b->GetRow(), 1);
+	QCOMPARE(root.GetChildItem(1), b);
+
+	root.Reset();
+	QCOMPARE(root.GetChildCount(), 0);
+}
+
+void
+DS3BrowserItemTest::TestAppendChildren()
+{
+	DS3BrowserItem bucket("books", "");
+	bucket.AppendChild(DS3BrowserItem::OBJECT, "first", "alice", 1);
+
+	DS3BrowserItem rows;
+	rows.AppendChild(DS3BrowserItem::FOLDER, "fiction", "bob");
+	rows.AppendChild(DS3BrowserItem::OBJECT, "second", "alice", 2);
+	rows.AppendChild(DS3BrowserItem::PAGE_BREAK);
+	bucket.AppendChildren(rows);
+	bucket.AppendChildren(rows);
+
+	QCOMPARE(bucket.GetChildCount(), 7);
+	QCOMPARE(bucket.GetChildName(0), QString("first"));
+	QCOMPARE(bucket.GetChildKind(1), DS3BrowserItem::FOLDER);
+	QCOMPARE(bucket.GetChildName(1), QString("fiction"));
+	QCOMPARE(bucket.GetChildOwner(1), QString("bob"));
+	QCOMPARE(bucket.GetChildName(5), QString("second"));
+	QCOMPARE(bucket.GetChildOwner(5), QString("alice"));
+	QCOMPARE(bucket.GetChildData(5, DS3BrowserItem::SIZE_COL).toString(),
+		 QString("2 Bytes"));
+	QCOMPARE(bucket.GetChildKind(6), DS3BrowserItem::PAGE_BREAK);
+	QCOMPARE(bucket.GetChildItem(4)->GetPrefix(), QString("fiction/"));
+}
+
+void
+DS3BrowserItemTest::TestInsertChildren()
+{
+	DS3BrowserItem bucket("books", "");
+	bucket.AppendChild(DS3BrowserItem::FOLDER, "fiction", "alice");
+	bucket.AppendChild(DS3BrowserItem::OBJECT, "a", "alice", 1);
+	bucket.AppendChild(DS3BrowserItem::OBJECT, "d", "alice", 4);
+	DS3BrowserItem* fiction = bucket.GetChildItem(0);
+	DS3BrowserItem* d = bucket.GetChildItem(2);
+
+	DS3BrowserItem rows;
+	rows.AppendChild(DS3BrowserItem::OBJECT, "b", "bob", 2);
+	rows.AppendChild(DS3BrowserItem::OBJECT, "c", "alice", 3);
+	rows.AppendChild(DS3BrowserItem::OBJECT, "d", "alice", 40);
+	bucket.InsertChildren(2, rows, 0, 2);
+	QCOMPARE(bucket.GetChildCount(), 5);
+	QCOMPARE(bucket.GetChildName(1), QString("a"));
+	QCOMPARE(bucket.GetChildName(2), QString("b"));
+	QCOMPARE(bucket.GetChildOwner(2), QString("bob"));
+	QCOMPARE(bucket.GetChildName(3), QString("c"));
+	QCOMPARE(bucket.GetChildName(4), QString("d"));
+	QCOMPARE(fiction->GetRow(), 0);
+	QCOMPARE(d->GetRow(), 4);
+	QCOMPARE(bucket.GetChildItem(4), d);
+
+	QVERIFY(bucket.UpdateChild(4, rows, 2));
+	QVERIFY(!bucket.UpdateChild(4, rows, 2));
+	QCOMPARE(bucket.GetChildData(4, DS3BrowserItem::SIZE_COL).toString(),
+		 QString("40 Bytes"));
+
+	bucket.RemoveChildren(1, 2);
+	QCOMPARE(bucket.GetChildCount(), 3);
+	QCOMPARE(bucket.GetChildName(0), QString("fiction"));
+	QCOMPARE(bucket.GetChildName(1), QString("c"));
+	QCOMPARE(bucket.GetChildName(2), QString("d"));
+	QCOMPARE(d->GetRow(), 2);
+	QCOMPARE(bucket.GetChildItem(0), fiction);
+
+	// Replacing the children over and over, as refreshing does, doesn't
+	// grow the names arena
+	DS3BrowserItem listing;
+	for (int i = 0; i < 100; i++) {
+		listing.AppendChild(DS3BrowserItem::OBJECT,
+				    "object" + QString::number(i), "alice", i);
+	}
+	for (int i = 0; i < 10; i++) {
+		bucket.RemoveChildren(0, bucket.GetChildCount());
+		bucket.InsertChildren(0, listing, 0, listing.GetChildCount());
+		bucket.RemoveChildren(50, 10);
+	}
+	QVERIFY(bucket.GetNamesSize() <= 2 * listing.GetNamesSize());
+	QCOMPARE(bucket.GetChildCount(), 90);
+	QCOMPARE(bucket.GetChildName(49), QString("object49"));
+	QCOMPARE(bucket.GetChildName(50), QString("object60"));
+	QCOMPARE(bucket.GetChildName(89), QString("object99"));
+}
+
+void
+DS3BrowserItemTest::TestGetChildItem()
+{
+	DS3BrowserItem root;
+	root.AppendChild(DS3BrowserItem::BUCKET, "books", "alice");
+	DS3BrowserItem* bucket = root.GetChildItem(0);
+	QCOMPARE(bucket->GetParent(), &root);
+	QCOMPARE(bucket->GetBucketName(), QString("books"));
+	QCOMPARE(bucket->GetPrefix(), QString(""));
+	QCOMPARE(bucket->GetOwner(), QString("alice"));
+	QCOMPARE(root.GetChildPath(0), QString("/books"));
+
+	bucket->AppendChild(DS3BrowserItem::FOLDER, "fiction", "alice");
+	DS3BrowserItem* folder = bucket->GetChildItem(0);
+	QCOMPARE(folder->GetBucketName(), QString("books"));
+	QCOMPARE(folder->GetPrefix(), QString("fiction/"));
+
+	folder->AppendChild(DS3BrowserItem::OBJECT, "ulysses.txt", "alice", 1);
+	QCOMPARE(folder->GetChildBucketName(0), QString("books"));
+	QCOMPARE(folder->GetChildFullName(0), QString("fiction/ulysses.txt"));
+	QCOMPARE(folder->GetChildPath(0), QString("/books/fiction/ulysses.txt"));
+}
+
+void
+DS3BrowserItemTest::TestSearchResults()
+{
+	DS3BrowserItem root;
+	root.SetListsBuckets(false);
+	root.AppendChild(DS3BrowserItem::BUCKET, "/books/", "alice");
+	QCOMPARE(root.GetChildBucketName(0), QString(""));
+	QCOMPARE(root.GetChildFullName(0), QString("/books/"));
+}
+
+void
+DS3BrowserItemTest::BenchmarkListing_data()
+{
+	QTest::addColumn<bool>("variants");
+	QTest::newRow("variants per object") << true;
+	QTest::newRow("columns") << false;
+}
+
+// List a million objects into a bucket and read back the columns the view
+// shows, once with the QList<QVariant> per object that the model used to
+// keep and once with DS3BrowserItem's columns.
+void
+DS3BrowserItemTest::BenchmarkListing()
+{
+	QFETCH(bool, variants);
+	QString owner = "alice";
+	qint64 created = DS3BrowserItem::ToTimestamp("2015-06-01T10:30:00.000Z");
+	QString createdS = QDateTime::fromMSecsSinceEpoch(created).toString("MMMM d, yyyy h:mm AP");
+	int totalSize = 0;
+	QBENCHMARK {
+		if (variants) {
+			QList<QList<QVariant>*> objects;
+			for (int i = 0; i < NUM_OBJECTS; i++) {
+				QList<QVariant>* data = new QList<QVariant>;
+				*data << "IMG_" + QString::number(i) + ".CR2";
+				*data << owner;
+				*data << (quint64)i;
+				*data << "Object";
+				*data << QString(createdS);
+				objects << data;
+			}
+			for (int i = 0; i < NUM_OBJECTS; i++) {
+				totalSize += objects.at(i)->at(0).toString().size();
+			}
+			qDeleteAll(objects);
+		} else {
+			DS3BrowserItem bucket("photos");
+			bucket.ReserveChildren(NUM_OBJECTS);
+			for (int i = 0; i < NUM_OBJECTS; i++) {
+				bucket.AppendChild(DS3BrowserItem::OBJECT,
+						   "IMG_" + QString::number(i) + ".CR2",
+						   owner, i, created);
+			}
+			for (int i = 0; i < NUM_OBJECTS; i++) {
+				totalSize += bucket.GetChildData(i, DS3BrowserItem::NAME).toString().size();
+			}
+		}
+	}
+	QVERIFY(totalSize > 0);
+}
@@ -0,0 +1,304 @@
+/*
+ * *****************************************************************************
+ *   Copyright 2014-2015 Spectra Logic Corporation. All Rights Reserved.
+ *   Licensed under the Apache License, Version 2.0 (the "License"). You may not
+ *   use this file except in compliance with the License. A copy of the License
+ *   is located at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   or in the "license" file accompanying this file.
+ *   This file is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ *   CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ *   specific language governing permissions and limitations under the License.
+ * *****************************************************************************
+ */
+
+#include <QSignalSpy>
+#include <QTreeView>
+
+#include "lib/client.h"
+#include "lib/listing_cache.h"
+#include "lib/mock_ds3_server.h"
+#include "models/ds3_browser_item.h"
+#include "models/ds3_browser_model.h"
+#include "models/ds3_browser_model_test.h"
+#include "models/listing_page.h"
+
+static DS3BrowserModelTest instance;
+
+static const int LISTING_TIMEOUT = 10000;
+
+// Search every bucket for the objects whose names contain search
+static void
+start_search(Client* client, DS3SearchModel* searchModel, const QString& search)
+{
+	DS3BrowserModel model(client);
+	QTreeView view;
+	GetServiceWatcher watcher((QModelIndex()));
+	watcher.setFuture(client->GetService());
+	watcher.waitForFinished();
+	searchModel->HandleGetServiceResponse(search, &view, &model, &watcher);
+}
+
+void
+DS3BrowserModelTest::initTestCase()
+{
+	m_server = new MockDS3Server;
+	QVERIFY(m_server->Start());
+	m_session = m_server->GetSession();
+	m_client = new Client(&m_session);
+}
+
+void
+DS3BrowserModelTest::cleanupTestCase()
+{
+	delete m_client;
+	delete m_server;
+}
+
+void
+DS3BrowserModelTest::TestListingPage()
+{
+	m_server->AddObject("pages", "dir/", 0);
+	m_server->AddObject("pages", "dir/a", 1);
+	m_server->AddObject("pages", "dir/b", 2);
+	m_server->AddObject("pages", "dir/sub/c", 3);
+	ds3_get_bucket_response* response = m_client->GetBucket("pages", "dir/", "").result();
+	QVERIFY(response != NULL);
+	Listing listing(response);
+	ds3_free_bucket_response(response);
+
+	ListingPage page(listing, "dir/", "", "alice");
+	const DS3BrowserItem& rows = page.GetRows();
+	QCOMPARE(rows.GetChildCount(), 3);
+	QCOMPARE(rows.GetChildKind(0), DS3BrowserItem::FOLDER);
+	QCOMPARE(rows.GetChildName(0), QString("sub"));
+	QCOMPARE(rows.GetChildKind(1), DS3BrowserItem::OBJECT);
+	QCOMPARE(rows.GetChildName(1), QString("a"));
+	QCOMPARE(rows.GetChildOwner(1), QString("alice"));
+	QCOMPARE(rows.GetChildName(2), QString("b"));
+	QVERIFY(!page.IsTruncated());
+
+	// A page that was listed after a folder doesn't list it again
+	ListingPage next(listing, "dir/", "dir/sub/", "alice");
+	QCOMPARE(next.GetRows().GetChildCount(), 2);
+	QCOMPARE(next.GetRows().GetChildName(0), QString("a"));
+}
+
+void
+DS3BrowserModelTest::TestPrefetch()
+{
+	int pageSize = MockDS3Server::DEFAULT_MAX_KEYS;
+	int numObjects = (DS3BrowserModel::PREFETCH_PAGES + 1) * pageSize + 10;
+	for (int i = 0; i < numObjects; i++) {
+		m_server->AddObject("prefetch", QString("object%1").arg(i, 6, 10, QChar('0')), 1);
+	}
+
+	DS3BrowserModel model(m_client);
+	QTreeView view;
+	model.SetView(&view);
+	view.setModel(&model);
+	view.resize(400, 300);
+	view.show();
+
+	QModelIndex root;
+	if (model.canFetchMore(root)) {
+		model.fetchMore(root);
+	}
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(root) && model.rowCount(root) > 0,
+				 LISTING_TIMEOUT);
+	QModelIndex bucket;
+	for (int i = 0; i < model.rowCount(root); i++) {
+		if (model.GetName(model.index(i, 0, root)) == "prefetch") {
+			bucket = model.index(i, 0, root);
+		}
+	}
+	QVERIFY(bucket.isValid());
+
+	view.setRootIndex(bucket);
+	if (model.canFetchMore(bucket)) {
+		model.fetchMore(bucket);
+	}
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(bucket) &&
+				 model.rowCount(bucket) == pageSize + 1,
+				 LISTING_TIMEOUT);
+	// Nothing more is fetched while the view is far from the end
+	QTest::qWait(200);
+	QCOMPARE(model.rowCount(bucket), pageSize + 1);
+	QVERIFY(model.IsPageBreak(model.index(pageSize, 0, bucket)));
+
+	// Coming near the end fetches a bounded number of pages in a row
+	view.scrollToBottom();
+	int prefetched = DS3BrowserModel::PREFETCH_PAGES * pageSize;
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(bucket) &&
+				 model.rowCount(bucket) == pageSize + prefetched,
+				 LISTING_TIMEOUT);
+	QTest::qWait(200);
+	QCOMPARE(model.rowCount(bucket), pageSize + prefetched);
+
+	view.scrollToBottom();
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(bucket) &&
+				 model.rowCount(bucket) == numObjects,
+				 LISTING_TIMEOUT);
+	QVERIFY(!model.IsPageBreak(model.index(numObjects - 1, 0, bucket)));
+	QCOMPARE(model.GetName(model.index(numObjects - 1, 0, bucket)),
+		 QString("object%1").arg(numObjects - 1, 6, 10, QChar('0')));
+}
+
+void
+DS3BrowserModelTest::TestDiffRefresh()
+{
+	m_server->AddObject("diff", "dir/x", 1);
+	m_server->AddObject("diff", "a", 1);
+	m_server->AddObject("diff", "b", 2);
+	m_server->AddObject("diff", "c", 3);
+
+	DS3BrowserModel model(m_client);
+	QTreeView view;
+	model.SetView(&view);
+	view.setModel(&model);
+
+	QModelIndex root;
+	if (model.canFetchMore(root)) {
+		model.fetchMore(root);
+	}
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(root) && model.rowCount(root) > 0,
+				 LISTING_TIMEOUT);
+	QModelIndex bucket;
+	for (int i = 0; i < model.rowCount(root); i++) {
+		if (model.GetName(model.index(i, 0, root)) == "diff") {
+			bucket = model.index(i, 0, root);
+		}
+	}
+	QVERIFY(bucket.isValid());
+	if (model.canFetchMore(bucket)) {
+		model.fetchMore(bucket);
+	}
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(bucket) &&
+				 model.rowCount(bucket) == 4,
+				 LISTING_TIMEOUT);
+	view.setRootIndex(bucket);
+	QModelIndex dir = model.index(0, 0, bucket);
+	QCOMPARE(model.GetName(dir), QString("dir"));
+	view.expand(dir);
+	if (model.canFetchMore(dir)) {
+		model.fetchMore(dir);
+	}
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(dir) && model.rowCount(dir) == 1,
+				 LISTING_TIMEOUT);
+	QPersistentModelIndex c(model.index(3, 0, bucket));
+	QCOMPARE(model.GetName(c), QString("c"));
+
+	m_server->RemoveObject("diff", "a");
+	m_server->AddObject("diff", "b2", 5);
+	m_server->AddObject("diff", "c", 30);
+	m_client->InvalidateListings("diff");
+	QSignalSpy removed(&model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)));
+	QSignalSpy inserted(&model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+	QSignalSpy changed(&model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)));
+	QSignalSpy reset(&model, SIGNAL(modelReset()));
+	model.Refresh(bucket, DS3BrowserModel::DIFF);
+	QTRY_VERIFY_WITH_TIMEOUT(!model.IsFetching(bucket), LISTING_TIMEOUT);
+
+	QCOMPARE(model.rowCount(bucket), 4);
+	QCOMPARE(model.GetName(model.index(1, 0, bucket)), QString("b"));
+	QCOMPARE(model.GetName(model.index(2, 0, bucket)), QString("b2"));
+	QCOMPARE(removed.count(), 1);
+	QCOMPARE(removed.at(0).at(1).toInt(), 1);
+	QCOMPARE(inserted.count(), 1);
+	QCOMPARE(inserted.at(0).at(1).toInt(), 2);
+	QCOMPARE(changed.count(), 1);
+	QCOMPARE(reset.count(), 0);
+
+	// The unchanged folder is still expanded and the changed object's
+	// index followed it
+	QVERIFY(view.isExpanded(model.index(0, 0, bucket)));
+	QCOMPARE(model.rowCount(model.index(0, 0, bucket)), 1);
+	QVERIFY(c.isValid());
+	QCOMPARE(c.row(), 3);
+	QCOMPARE(model.data(c.sibling(3, DS3BrowserItem::SIZE_COL)).toString(),
+		 QString("30 Bytes"));
+}
+
+void
+DS3BrowserModelTest::TestSearch()
+{
+	const int numBuckets = DS3SearchModel::MAX_ACTIVE_SEARCHES * 3;
+	for (int i = 0; i < numBuckets; i++) {
+		QString bucket = "search" + QString::number(i);
+		m_server->AddObject(bucket, "dir/needle" + QString::number(i), 1);
+		m_server->AddObject(bucket, "straw", 1);
+	}
+
+	DS3SearchModel model(m_client, NULL);
+	QTreeView view;
+	model.SetView(&view);
+	view.setModel(&model);
+	QSignalSpy done(&model, SIGNAL(DoneSearching(bool)));
+	QSignalSpy inserted(&model, SIGNAL(rowsInserted(const QModelIndex&, int, int)));
+	QSignalSpy reset(&model, SIGNAL(modelReset()));
+	start_search(m_client, &model, "needle");
+	QTRY_COMPARE_WITH_TIMEOUT(done.count(), 1, LISTING_TIMEOUT);
+	QVERIFY(done.at(0).at(0).toBool());
+	QCOMPARE(model.rowCount(QModelIndex()), numBuckets);
+	// Each bucket's results were inserted as it responded
+	QCOMPARE(inserted.count(), numBuckets);
+	QCOMPARE(reset.count(), 0);
+
+	DS3SearchModel empty(m_client, NULL);
+	QSignalSpy emptyDone(&empty, SIGNAL(DoneSearching(bool)));
+	start_search(m_client, &empty, "nothing like it");
+	QTRY_COMPARE_WITH_TIMEOUT(emptyDone.count(), 1, LISTING_TIMEOUT);
+	QVERIFY(!emptyDone.at(0).at(0).toBool());
+	QCOMPARE(empty.rowCount(QModelIndex()), 1);
+
+	// Deleting the model cancels the buckets it hasn't searched yet
+	QVERIFY(m_client->WaitForActiveJobs(LISTING_TIMEOUT));
+	int numSearches = m_server->GetNumRequests("get objects");
+	DS3SearchModel* cancelled = new DS3SearchModel(m_client, NULL);
+	start_search(m_client, cancelled, "straw");
+	delete cancelled;
+	QVERIFY(m_client->WaitForActiveJobs(LISTING_TIMEOUT));
+	QVERIFY(m_server->GetNumRequests("get objects") - numSearches <=
+		DS3SearchModel::MAX_ACTIVE_SEARCHES);
+}
+
+void
+DS3BrowserModelTest::BenchmarkPage_data()
+{
+	QTest::addColumn<bool>("convert");
+	QTest::newRow("convert and splice") << true;
+	QTest::newRow("splice") << false;
+}
+
+// The GUI thread time per page of MockDS3Server::DEFAULT_MAX_KEYS objects,
+// when it converts the listing itself and when the listing's thread has
+// already converted it
+void
+DS3BrowserModelTest::BenchmarkPage()
+{
+	QFETCH(bool, convert);
+	if (m_server->GetNumObjects("benchpage") == 0) {
+		for (int i = 0; i < MockDS3Server::DEFAULT_MAX_KEYS; i++) {
+			m_server->AddObject("benchpage", "IMG_" + QString::number(i) + ".CR2", i);
+		}
+	}
+	ds3_get_bucket_response* response = m_client->GetBucket("benchpage", "", "").result();
+	QVERIFY(response != NULL);
+	Listing listing(response);
+	ds3_free_bucket_response(response);
+	ListingPage page(listing, "", "", "alice");
+	int numChildren = 0;
+	QBENCHMARK {
+		DS3BrowserItem bucket("benchpage");
+		if (convert) {
+			ListingPage converted(listing, "", "", "alice");
+			bucket.AppendChildren(converted.GetRows());
+		} else {
+			bucket.AppendChildren(page.GetRows());
+		}
+		numChildren = bucket.GetChildCount();
+	}
+	QCOMPARE(numChildren, MockDS3Server::DEFAULT_MAX_KEYS);
+}
@@ -13,11 +13,11 @@
 ################################################################################
 
 include(../common.pri)
+include(../vendor/quazip/quazip.pri)
 
 TARGET = test
 
-QT += testlib
-QT -= gui
+QT += network testlib
 CONFIG += console
 CONFIG -= app_bundle
 
@@ -26,15 +26,60 @@ MOC_DIR = moc
 RCC_DIR = qrc
 UI_DIR = ui
 
+win32 {
+	DEFINES += QUAZIP_STATIC
+	DEFINES += QUAZIP_BUILD
+}
+
 HEADERS += \
 	test.h \
+	helpers/file_helper_test.h \
 	helpers/number_helper_test.h \
+	helpers/path_helper_test.h \
+	lib/bulk_work_item_test.h \
+	lib/checksum_test.h \
+	lib/client_test.h \
+	lib/concurrency_controller_test.h \
+	lib/directory_scanner_test.h \
+	lib/ds3_client_pool_test.h \
+	lib/executor_test.h \
+	lib/job_journal_test.h \
+	lib/job_progress_publisher_test.h \
+	lib/listing_cache_test.h \
 	lib/mime_data_test.h \
+	lib/mock_ds3_server.h \
+	lib/object_compressor_test.h \
+	lib/object_work_item_test.h \
+	lib/small_file_archive_test.h \
+	lib/sync_manifest_test.h \
+	lib/transfer_benchmark_test.h \
+	models/ds3_browser_item_test.h \
+	models/ds3_browser_model_test.h \
 	models/ds3_url_test.h
 
 SOURCES += \
 	main.cc \
 	test.cc \
+	helpers/file_helper_test.cc \
 	helpers/number_helper_test.cc \
+	helpers/path_helper_test.cc \
+	lib/bulk_work_item_test.cc \
+	lib/checksum_test.cc \
+	lib/client_test.cc \
+	lib/concurrency_controller_test.cc \
+	lib/directory_scanner_test.cc \
+	lib/ds3_client_pool_test.cc \
+	lib/executor_test.cc \
+	lib/job_journal_test.cc \
+	lib/job_progress_publisher_test.cc \
+	lib/listing_cache_test.cc \
 	lib/mime_data_test.cc \
+	lib/mock_ds3_server.cc \
+	lib/object_compressor_test.cc \
+	lib/object_work_item_test.cc \
+	lib/small_file_archive_test.cc \
+	lib/sync_manifest_test.cc \
+	lib/transfer_benchmark_test.cc \
+	models/ds3_browser_item_test.cc \
+	models/ds3_browser_model_test.cc \
 	models/ds3_url_test.cc